@@ -1182,6 +1182,7 @@ mlan_status wlan_11d_set_universaltable(mlan_private *pmpriv, t_u16 band)
 		pmadapter->universal_channel[i].band = BAND_A;
 		i++;
 	}
+	wlan_update_region_chan_idx(pmadapter, pmadapter->universal_channel);
 
 	LEAVE();
 	return MLAN_STATUS_SUCCESS;
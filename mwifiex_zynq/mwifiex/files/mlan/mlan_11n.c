@@ -996,13 +996,11 @@ static void wlan_update_all_stations_ampdu(mlan_private *priv)
 	int i = 0;
 
 	ENTER();
-	pmadapter->callbacks.moal_spin_lock(pmadapter->pmoal_handle,
-					    priv->wmm.ra_list_spinlock);
+	wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 	sta_ptr = (sta_node *)util_peek_list(pmadapter->pmoal_handle,
 					     &priv->sta_list, MNULL, MNULL);
 	if (!sta_ptr) {
-		pmadapter->callbacks.moal_spin_unlock(
-			pmadapter->pmoal_handle, priv->wmm.ra_list_spinlock);
+		wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 		LEAVE();
 		return;
 	}
@@ -1014,8 +1012,7 @@ static void wlan_update_all_stations_ampdu(mlan_private *priv)
 		}
 		sta_ptr = sta_ptr->pnext;
 	}
-	pmadapter->callbacks.moal_spin_unlock(pmadapter->pmoal_handle,
-					      priv->wmm.ra_list_spinlock);
+	wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 	LEAVE();
 	return;
 }
@@ -3084,16 +3081,13 @@ int wlan_get_rxreorder_tbl(mlan_private *priv, rx_reorder_tbl *buf)
 	RxReorderTbl *rx_reorder_tbl_ptr;
 	int count = 0;
 	ENTER();
-	priv->adapter->callbacks.moal_spin_lock(priv->adapter->pmoal_handle,
-						priv->rx_reorder_tbl_ptr.plock);
+	wlan_spin_lock(priv->adapter, priv->rx_reorder_tbl_ptr.plock);
 	rx_reorder_tbl_ptr =
 		(RxReorderTbl *)util_peek_list(priv->adapter->pmoal_handle,
 					       &priv->rx_reorder_tbl_ptr, MNULL,
 					       MNULL);
 	if (!rx_reorder_tbl_ptr) {
-		priv->adapter->callbacks.moal_spin_unlock(
-			priv->adapter->pmoal_handle,
-			priv->rx_reorder_tbl_ptr.plock);
+		wlan_spin_unlock(priv->adapter, priv->rx_reorder_tbl_ptr.plock);
 		LEAVE();
 		return count;
 	}
@@ -3118,8 +3112,7 @@ int wlan_get_rxreorder_tbl(mlan_private *priv, rx_reorder_tbl *buf)
 		if (count >= MLAN_MAX_RX_BASTREAM_SUPPORTED)
 			break;
 	}
-	priv->adapter->callbacks.moal_spin_unlock(
-		priv->adapter->pmoal_handle, priv->rx_reorder_tbl_ptr.plock);
+	wlan_spin_unlock(priv->adapter, priv->rx_reorder_tbl_ptr.plock);
 	LEAVE();
 	return count;
 }
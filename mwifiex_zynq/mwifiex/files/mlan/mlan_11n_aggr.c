@@ -429,6 +429,9 @@ mlan_status wlan_11n_deaggregate_pkt(mlan_private *priv, pmlan_buffer pmbuf)
 	t_u32 copy_delay = 0;
 	t_u32 delay = 0;
 	t_u8 num_subframes = 0;
+	t_u8 zcopy = RX_AMSDU_ZCOPY_DISABLE;
+	t_u32 align = 0;
+	t_u32 head_room = 0;
 
 	ENTER();
 
@@ -498,7 +501,15 @@ mlan_status wlan_11n_deaggregate_pkt(mlan_private *priv, pmlan_buffer pmbuf)
 			goto done;
 		}
 	}
+	/* Subframes can only share a parent which MOAL is able to clone */
+	if (pmbuf->pdesc)
+		zcopy = pmadapter->rx_amsdu_zcopy;
+	/* Leave TxPD room so forwarded subframes go back to FW as is */
+	if (forward && pmadapter->uap_fwd_zcopy)
+		head_room = Tx_PD_SIZEOF(pmadapter) + priv->intf_hr_len +
+			    DMA_ALIGNMENT;
 	while (total_pkt_len >= hdr_len) {
+		align = 0;
 		prx_pkt = (RxPacketHdr_t *)data;
 		/* Length will be in network format, change it to host */
 		pkt_len = mlan_ntohs(
@@ -523,37 +534,66 @@ mlan_status wlan_11n_deaggregate_pkt(mlan_private *priv, pmlan_buffer pmbuf)
 				(2 * MLAN_MAC_ADDR_LENGTH));
 			data += LLC_SNAP_LEN;
 			pkt_len += sizeof(Eth803Hdr_t) - LLC_SNAP_LEN;
+			/* A shared subframe can't get MLAN_NET_IP_ALIGN headroom,
+			 * so shift it into the freed LLC space if the IP header
+			 * would be misaligned */
+			if (zcopy == RX_AMSDU_ZCOPY_ALIGN)
+				align = (t_u32)((t_ptr)(data + sizeof(Eth803Hdr_t)) &
+						3);
+			if (align) {
+				memmove(pmadapter, data - align, data, pkt_len);
+				data -= align;
+			}
 		} else {
 			*(t_u16 *)(data + (2 * MLAN_MAC_ADDR_LENGTH)) =
 				(t_u16)0;
 			pkt_len += sizeof(Eth803Hdr_t);
 		}
-		daggr_mbuf = wlan_alloc_mlan_buffer(pmadapter,
-						    pkt_len + MLAN_NET_IP_ALIGN,
-						    0, MOAL_ALLOC_MLAN_BUFFER);
+		if (zcopy)
+			daggr_mbuf = wlan_alloc_mlan_buffer(pmadapter, 0, 0,
+							    MOAL_MALLOC_BUFFER);
+		else
+			daggr_mbuf = wlan_alloc_mlan_buffer(
+				pmadapter, pkt_len + MLAN_NET_IP_ALIGN,
+				head_room, MOAL_ALLOC_MLAN_BUFFER);
 		if (daggr_mbuf == MNULL) {
 			PRINTM(MERROR, "Error allocating daggr mlan_buffer\n");
 			ret = MLAN_STATUS_FAILURE;
 			break;
 		}
-		daggr_mbuf->data_offset += MLAN_NET_IP_ALIGN;
+		if (zcopy) {
+			/* view into the parent, freed in
+			 * wlan_recv_packet_complete */
+			daggr_mbuf->pbuf = pmbuf->pbuf;
+			daggr_mbuf->data_offset = (t_u32)(data - pmbuf->pbuf);
+			daggr_mbuf->flags =
+				pmbuf->flags | MLAN_BUF_FLAG_MALLOC_BUF |
+				MLAN_BUF_FLAG_RX_VIEW;
+		} else {
+			daggr_mbuf->data_offset += MLAN_NET_IP_ALIGN;
+			daggr_mbuf->flags = pmbuf->flags;
+		}
 		daggr_mbuf->bss_index = pmbuf->bss_index;
 		daggr_mbuf->buf_type = pmbuf->buf_type;
 		daggr_mbuf->data_len = pkt_len;
 		daggr_mbuf->in_ts_sec = pmbuf->in_ts_sec;
 		daggr_mbuf->in_ts_usec = pmbuf->in_ts_usec;
-		daggr_mbuf->flags = pmbuf->flags;
 		daggr_mbuf->extra_ts_sec = pmbuf->extra_ts_sec;
 		daggr_mbuf->extra_ts_usec = pmbuf->extra_ts_usec;
+		memcpy_ext(pmadapter, daggr_mbuf->rx_lat_ts, pmbuf->rx_lat_ts,
+			   sizeof(pmbuf->rx_lat_ts),
+			   sizeof(daggr_mbuf->rx_lat_ts));
+		daggr_mbuf->rx_lat_tid = pmbuf->rx_lat_tid;
 		daggr_mbuf->pparent = pmbuf;
 		daggr_mbuf->priority = pmbuf->priority;
 		if (pmadapter->tp_state_on)
 			pmadapter->callbacks.moal_get_system_time(
 				pmadapter->pmoal_handle, &in_copy_ts_sec,
 				&in_copy_ts_usec);
-		memcpy_ext(pmadapter,
-			   daggr_mbuf->pbuf + daggr_mbuf->data_offset, data,
-			   pkt_len, daggr_mbuf->data_len);
+		if (!zcopy)
+			memcpy_ext(pmadapter,
+				   daggr_mbuf->pbuf + daggr_mbuf->data_offset,
+				   data, pkt_len, daggr_mbuf->data_len);
 		if (pmadapter->tp_state_on) {
 			pmadapter->callbacks.moal_get_system_time(
 				pmadapter->pmoal_handle, &out_copy_ts_sec,
@@ -589,7 +629,7 @@ mlan_status wlan_11n_deaggregate_pkt(mlan_private *priv, pmlan_buffer pmbuf)
 						MLAN_EVENT_ID_DRV_DEFER_HANDLING,
 						MNULL);
 				wlan_free_mlan_buffer(pmadapter, daggr_mbuf);
-				data += pkt_len + pad;
+				data += pkt_len + pad + align;
 				continue;
 			}
 			/**process tdls packet*/
@@ -614,6 +654,9 @@ mlan_status wlan_11n_deaggregate_pkt(mlan_private *priv, pmlan_buffer pmbuf)
 #endif /* UAP_SUPPORT */
 		switch (ret) {
 		case MLAN_STATUS_PENDING:
+			/* MOAL never takes ownership of a view */
+			if (daggr_mbuf->flags & MLAN_BUF_FLAG_RX_VIEW)
+				wlan_free_mlan_buffer(pmadapter, daggr_mbuf);
 			break;
 		case MLAN_STATUS_FAILURE:
 			PRINTM(MERROR, "Deaggr, send to moal failed\n");
@@ -626,7 +669,7 @@ mlan_status wlan_11n_deaggregate_pkt(mlan_private *priv, pmlan_buffer pmbuf)
 			break;
 		}
 
-		data += pkt_len + pad;
+		data += pkt_len + pad + align;
 	}
 	if (pmadapter->tp_state_on) {
 		pmadapter->callbacks.moal_get_system_time(
@@ -685,8 +728,7 @@ static int wlan_send_amsdu_subframe_list(mlan_private *priv,
 	if (pmbuf_src) {
 		pmbuf_first = pmbuf_src;
 	} else {
-		pmadapter->callbacks.moal_spin_unlock(
-			pmadapter->pmoal_handle, priv->wmm.ra_list_spinlock);
+		wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 		goto exit;
 	}
 
@@ -710,15 +752,20 @@ static int wlan_send_amsdu_subframe_list(mlan_private *priv,
 
 		/* decrement for every PDU taken from the list */
 		priv->wmm.pkts_queued[ptrindex]--;
-		util_scalar_decrement(pmadapter->pmoal_handle,
-				      &priv->wmm.tx_pkts_queued, MNULL, MNULL);
+		util_scalar_atomic_sub(pmadapter->pmoal_handle,
+				       &priv->wmm.tx_pkts_queued, 1,
+				       wlan_atomic_sub_cb(pmadapter),
+				       MNULL, MNULL);
 
-		pmadapter->callbacks.moal_spin_unlock(
-			pmadapter->pmoal_handle, priv->wmm.ra_list_spinlock);
+		wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 
 		if (pmbuf_src) {
+			wlan_tx_lat_stamp(pmadapter, pmbuf_src,
+					  MLAN_TX_LAT_DEQ);
 			pkt_size += wlan_form_amsdu_subframe(pmadapter,
 							     pmbuf_src, &pad);
+			wlan_tx_lat_stamp(pmadapter, pmbuf_src,
+					  MLAN_TX_LAT_AGGR);
 			util_enqueue_list_tail(pmadapter->pmoal_handle,
 					       &pmadapter->amsdu_txq,
 					       (pmlan_linked_list)pmbuf_src,
@@ -727,13 +774,10 @@ static int wlan_send_amsdu_subframe_list(mlan_private *priv,
 			priv->msdu_in_tx_amsdu_cnt++;
 			msdu_in_tx_amsdu_cnt++;
 		}
-		pmadapter->callbacks.moal_spin_lock(pmadapter->pmoal_handle,
-						    priv->wmm.ra_list_spinlock);
+		wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 
 		if (!wlan_is_ralist_valid(priv, pra_list, ptrindex)) {
-			pmadapter->callbacks.moal_spin_unlock(
-				pmadapter->pmoal_handle,
-				priv->wmm.ra_list_spinlock);
+			wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 			LEAVE();
 			return MLAN_STATUS_FAILURE;
 		}
@@ -744,8 +788,7 @@ static int wlan_send_amsdu_subframe_list(mlan_private *priv,
 						     MNULL);
 	}
 
-	pmadapter->callbacks.moal_spin_unlock(pmadapter->pmoal_handle,
-					      priv->wmm.ra_list_spinlock);
+	wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 	if (!pmbuf_last) {
 		PRINTM(MERROR,
 		       "SG_AGGR ERROR: pkt_size=%d max_msdu_count=%d max_amsdu_size=%d msdu_in_tx_amsdu_cnt=%d\n",
@@ -776,16 +819,14 @@ static int wlan_send_amsdu_subframe_list(mlan_private *priv,
 					    msdu_in_tx_amsdu_cnt, pkt_size);
 
 	if (ret != MLAN_STATUS_RESOURCE) {
-		pmadapter->callbacks.moal_spin_lock(pmadapter->pmoal_handle,
-						    priv->wmm.ra_list_spinlock);
+		wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 		if (wlan_is_ralist_valid(priv, pra_list, ptrindex)) {
 			priv->wmm.packets_out[ptrindex]++;
 			priv->wmm.tid_tbl_ptr[ptrindex].ra_list_curr = pra_list;
 		}
 		wlan_advance_bss_on_pkt_push(
 			pmadapter, &pmadapter->bssprio_tbl[priv->bss_priority]);
-		pmadapter->callbacks.moal_spin_unlock(
-			pmadapter->pmoal_handle, priv->wmm.ra_list_spinlock);
+		wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 	}
 
 	PRINTM_GET_SYS_TIME(MDATA, &sec, &usec);
@@ -849,9 +890,7 @@ int wlan_11n_aggregate_pkt(mlan_private *priv, raListTbl *pra_list,
 				MOAL_MEM_FLAG_ATOMIC);
 		if (!pmbuf_aggr) {
 			PRINTM(MERROR, "Error allocating mlan_buffer\n");
-			pmadapter->callbacks.moal_spin_unlock(
-				pmadapter->pmoal_handle,
-				priv->wmm.ra_list_spinlock);
+			wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 			LEAVE();
 			return MLAN_STATUS_FAILURE;
 		}
@@ -886,8 +925,7 @@ int wlan_11n_aggregate_pkt(mlan_private *priv, raListTbl *pra_list,
 #endif
 		priv->msdu_in_tx_amsdu_cnt++;
 	} else {
-		pmadapter->callbacks.moal_spin_unlock(
-			pmadapter->pmoal_handle, priv->wmm.ra_list_spinlock);
+		wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 		goto exit;
 	}
 
@@ -909,13 +947,25 @@ int wlan_11n_aggregate_pkt(mlan_private *priv, raListTbl *pra_list,
 
 		/* decrement for every PDU taken from the list */
 		priv->wmm.pkts_queued[ptrindex]--;
-		util_scalar_decrement(pmadapter->pmoal_handle,
-				      &priv->wmm.tx_pkts_queued, MNULL, MNULL);
+		util_scalar_atomic_sub(pmadapter->pmoal_handle,
+				       &priv->wmm.tx_pkts_queued, 1,
+				       wlan_atomic_sub_cb(pmadapter),
+				       MNULL, MNULL);
 
-		pmadapter->callbacks.moal_spin_unlock(
-			pmadapter->pmoal_handle, priv->wmm.ra_list_spinlock);
+		wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 
 		if (pmbuf_src) {
+			/* The AMSDU is traced with the first subframe's time
+			 * stamps, the subframes are not reported on their own
+			 */
+			wlan_tx_lat_stamp(pmadapter, pmbuf_src,
+					  MLAN_TX_LAT_DEQ);
+			if (pkt_size == Tx_PD_SIZEOF(pmadapter))
+				memcpy_ext(pmadapter, pmbuf_aggr->tx_lat_ts,
+					   pmbuf_src->tx_lat_ts,
+					   sizeof(pmbuf_src->tx_lat_ts),
+					   sizeof(pmbuf_aggr->tx_lat_ts));
+			pmbuf_src->tx_lat_ts[MLAN_TX_LAT_XMIT] = 0;
 			pkt_size += wlan_11n_form_amsdu_pkt(
 				pmadapter, (data + pkt_size),
 				pmbuf_src->pbuf + pmbuf_src->data_offset,
@@ -927,13 +977,10 @@ int wlan_11n_aggregate_pkt(mlan_private *priv, raListTbl *pra_list,
 						 MLAN_STATUS_SUCCESS);
 		}
 
-		pmadapter->callbacks.moal_spin_lock(pmadapter->pmoal_handle,
-						    priv->wmm.ra_list_spinlock);
+		wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 
 		if (!wlan_is_ralist_valid(priv, pra_list, ptrindex)) {
-			pmadapter->callbacks.moal_spin_unlock(
-				pmadapter->pmoal_handle,
-				priv->wmm.ra_list_spinlock);
+			wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 			LEAVE();
 			return MLAN_STATUS_FAILURE;
 		}
@@ -946,8 +993,7 @@ int wlan_11n_aggregate_pkt(mlan_private *priv, raListTbl *pra_list,
 		msdu_in_tx_amsdu_cnt++;
 	}
 
-	pmadapter->callbacks.moal_spin_unlock(pmadapter->pmoal_handle,
-					      priv->wmm.ra_list_spinlock);
+	wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 
 	/* Last AMSDU packet does not need padding */
 	pkt_size -= pad;
@@ -955,6 +1001,7 @@ int wlan_11n_aggregate_pkt(mlan_private *priv, raListTbl *pra_list,
 	wlan_11n_update_pktlen_amsdu_txpd(priv, pmbuf_aggr);
 	pmbuf_aggr->data_len += headroom;
 	pmbuf_aggr->pbuf = data - headroom;
+	wlan_tx_lat_stamp(pmadapter, pmbuf_aggr, MLAN_TX_LAT_AGGR);
 	tx_param.next_pkt_len =
 		((pmbuf_src) ? pmbuf_src->data_len + Tx_PD_SIZEOF(pmadapter) :
 			       0);
@@ -970,9 +1017,11 @@ int wlan_11n_aggregate_pkt(mlan_private *priv, raListTbl *pra_list,
 	if (pmadapter->tp_state_drop_point == 4) {
 		wlan_write_data_complete(pmadapter, pmbuf_aggr, ret);
 		goto exit;
-	} else
+	} else {
+		wlan_tx_lat_stamp(pmadapter, pmbuf_aggr, MLAN_TX_LAT_BUS);
 		ret = pmadapter->ops.host_to_card(priv, MLAN_TYPE_DATA,
 						  pmbuf_aggr, &tx_param);
+	}
 	switch (ret) {
 #ifdef USB
 	case MLAN_STATUS_PRESOURCE:
@@ -980,13 +1029,10 @@ int wlan_11n_aggregate_pkt(mlan_private *priv, raListTbl *pra_list,
 		break;
 #endif
 	case MLAN_STATUS_RESOURCE:
-		pmadapter->callbacks.moal_spin_lock(pmadapter->pmoal_handle,
-						    priv->wmm.ra_list_spinlock);
+		wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 
 		if (!wlan_is_ralist_valid(priv, pra_list, ptrindex)) {
-			pmadapter->callbacks.moal_spin_unlock(
-				pmadapter->pmoal_handle,
-				priv->wmm.ra_list_spinlock);
+			wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 			pmbuf_aggr->status_code = MLAN_ERROR_PKT_INVALID;
 			wlan_write_data_complete(pmadapter, pmbuf_aggr,
 						 MLAN_STATUS_FAILURE);
@@ -1012,11 +1058,12 @@ int wlan_11n_aggregate_pkt(mlan_private *priv, raListTbl *pra_list,
 
 		/* add back only one: aggregated packet is requeued as one */
 		priv->wmm.pkts_queued[ptrindex]++;
-		util_scalar_increment(pmadapter->pmoal_handle,
-				      &priv->wmm.tx_pkts_queued, MNULL, MNULL);
+		util_scalar_atomic_add(pmadapter->pmoal_handle,
+				       &priv->wmm.tx_pkts_queued, 1,
+				       wlan_atomic_add_cb(pmadapter),
+				       MNULL, MNULL);
 		pmbuf_aggr->flags |= MLAN_BUF_FLAG_REQUEUED_PKT;
-		pmadapter->callbacks.moal_spin_unlock(
-			pmadapter->pmoal_handle, priv->wmm.ra_list_spinlock);
+		wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 		PRINTM(MINFO, "MLAN_STATUS_RESOURCE is returned\n");
 		pmbuf_aggr->status_code = MLAN_ERROR_PKT_INVALID;
 		break;
@@ -1034,8 +1081,7 @@ int wlan_11n_aggregate_pkt(mlan_private *priv, raListTbl *pra_list,
 		break;
 	}
 	if (ret != MLAN_STATUS_RESOURCE) {
-		pmadapter->callbacks.moal_spin_lock(pmadapter->pmoal_handle,
-						    priv->wmm.ra_list_spinlock);
+		wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 		if (wlan_is_ralist_valid(priv, pra_list, ptrindex)) {
 			priv->wmm.packets_out[ptrindex]++;
 			priv->wmm.tid_tbl_ptr[ptrindex].ra_list_curr = pra_list;
@@ -1044,8 +1090,7 @@ int wlan_11n_aggregate_pkt(mlan_private *priv, raListTbl *pra_list,
 		wlan_advance_bss_on_pkt_push(
 			pmadapter, &pmadapter->bssprio_tbl[priv->bss_priority]);
 
-		pmadapter->callbacks.moal_spin_unlock(
-			pmadapter->pmoal_handle, priv->wmm.ra_list_spinlock);
+		wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 	}
 	PRINTM_GET_SYS_TIME(MDATA, &sec, &usec);
 	PRINTM_NETINTF(MDATA, priv);
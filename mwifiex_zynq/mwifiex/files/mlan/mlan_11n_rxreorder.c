@@ -74,27 +74,22 @@ static mlan_status wlan_11n_dispatch_amsdu_pkt(mlan_private *priv,
 }
 
 /**
- *  @brief This function will process the rx packet and
- *         forward it to kernel/upper layer
+ *  @brief This function runs the late rx stage (AMSDU deaggregation,
+ *         802.3 conversion) and forwards the packet to kernel/upper layer
  *
  *  @param priv     A pointer to mlan_private
  *  @param payload  A pointer to rx packet payload
- *  @param rx_reor_tbl_ptr       pointer to RxReorderTbl
  *
  *  @return         MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
  */
-static mlan_status wlan_11n_dispatch_pkt(t_void *priv, t_void *payload,
-					 RxReorderTbl *rx_reor_tbl_ptr)
+mlan_status wlan_11n_rx_late_process(t_void *priv, t_void *payload)
 {
 	mlan_status ret = MLAN_STATUS_SUCCESS;
-#ifdef STA_SUPPORT
 	pmlan_adapter pmadapter = ((pmlan_private)priv)->adapter;
-#endif
 	ENTER();
-	if (payload == (t_void *)RX_PKT_DROPPED_IN_FW) {
-		LEAVE();
-		return ret;
-	}
+
+	wlan_rx_lat_stamp(pmadapter, (pmlan_buffer)payload,
+			  MLAN_RX_LAT_DEAGGR);
 
 #ifdef UAP_SUPPORT
 	if (GET_BSS_ROLE((mlan_private *)priv) == MLAN_BSS_ROLE_UAP) {
@@ -123,6 +118,75 @@ static mlan_status wlan_11n_dispatch_pkt(t_void *priv, t_void *payload,
 	return ret;
 }
 
+/**
+ *  @brief This function will process the rx packet and
+ *         forward it to kernel/upper layer
+ *
+ *  Packets are handed to MOAL through moal_rx_late_queue so the late
+ *  stage can run on another CPU. The flow id is derived from TA/TID
+ *  whether or not a block ack stream is set up, so all packets of one
+ *  TA/TID land on the same worker and keep the order set by the reorder
+ *  table across block ack setup and teardown. A queued packet stays
+ *  counted in rx_pkts_queued until mlan_rx_late_process is done with it,
+ *  so the HIGH_RX_PENDING back pressure covers the workers too. When
+ *  the worker's queue is full the packet is dropped: processing it
+ *  inline would deliver it ahead of the packets still queued.
+ *
+ *  @param priv     A pointer to mlan_private
+ *  @param payload  A pointer to rx packet payload
+ *  @param ta       Transmitter address of the packet
+ *  @param tid      TID of the packet
+ *
+ *  @return         MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status wlan_11n_dispatch_pkt(t_void *priv, t_void *payload,
+					 t_u8 *ta, int tid)
+{
+	mlan_status ret = MLAN_STATUS_SUCCESS;
+	pmlan_adapter pmadapter = ((pmlan_private)priv)->adapter;
+	pmlan_callbacks pcb = &pmadapter->callbacks;
+	mlan_status status;
+	t_u32 flow;
+
+	ENTER();
+	if (payload == (t_void *)RX_PKT_DROPPED_IN_FW) {
+		LEAVE();
+		return ret;
+	}
+	wlan_rx_lat_stamp(pmadapter, (pmlan_buffer)payload,
+			  MLAN_RX_LAT_REORDER);
+
+	if (pcb->moal_rx_late_queue) {
+		flow = ((t_u32)ta[3] << 16) | ((t_u32)ta[4] << 8) | ta[5];
+		flow = (flow ^ (flow >> 8) ^ (flow >> 16)) * 8 + (tid & 0x7);
+		/* Count the packet before the worker can complete it */
+		wlan_spin_lock(pmadapter, pmadapter->rx_data_queue.plock);
+		pmadapter->rx_pkts_queued++;
+		wlan_spin_unlock(pmadapter, pmadapter->rx_data_queue.plock);
+		status = pcb->moal_rx_late_queue(pmadapter->pmoal_handle, flow,
+						 (pmlan_buffer)payload);
+		if (status == MLAN_STATUS_SUCCESS) {
+			LEAVE();
+			return ret;
+		}
+		wlan_spin_lock(pmadapter, pmadapter->rx_data_queue.plock);
+		if (pmadapter->rx_pkts_queued)
+			pmadapter->rx_pkts_queued--;
+		wlan_spin_unlock(pmadapter, pmadapter->rx_data_queue.plock);
+		if (status == MLAN_STATUS_RESOURCE) {
+			pmadapter->ops.data_complete(pmadapter,
+						     (pmlan_buffer)payload,
+						     MLAN_STATUS_FAILURE);
+			LEAVE();
+			return MLAN_STATUS_FAILURE;
+		}
+	}
+
+	ret = wlan_11n_rx_late_process(priv, payload);
+	LEAVE();
+	return ret;
+}
+
 /**
  *  @brief This function restarts the reordering timeout timer
  *
@@ -181,22 +245,20 @@ static mlan_status wlan_11n_dispatch_pkt_until_start_win(
 				 rx_reor_tbl_ptr->win_size;
 
 	for (i = 0; i < no_pkt_to_send; ++i) {
-		pmpriv->adapter->callbacks.moal_spin_lock(
-			pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
+		wlan_spin_lock(pmpriv->adapter, pmpriv->rx_pkt_lock);
 		rx_tmp_ptr = MNULL;
 		if (rx_reor_tbl_ptr->rx_reorder_ptr[i]) {
 			rx_tmp_ptr = rx_reor_tbl_ptr->rx_reorder_ptr[i];
 			rx_reor_tbl_ptr->rx_reorder_ptr[i] = MNULL;
 		}
-		pmpriv->adapter->callbacks.moal_spin_unlock(
-			pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
+		wlan_spin_unlock(pmpriv->adapter, pmpriv->rx_pkt_lock);
 		if (rx_tmp_ptr)
 			wlan_11n_dispatch_pkt(priv, rx_tmp_ptr,
-					      rx_reor_tbl_ptr);
+					      rx_reor_tbl_ptr->ta,
+					      rx_reor_tbl_ptr->tid);
 	}
 
-	pmpriv->adapter->callbacks.moal_spin_lock(pmpriv->adapter->pmoal_handle,
-						  pmpriv->rx_pkt_lock);
+	wlan_spin_lock(pmpriv->adapter, pmpriv->rx_pkt_lock);
 	/*
 	 * We don't have a circular buffer, hence use rotation to simulate
 	 * circular buffer
@@ -216,8 +278,7 @@ static mlan_status wlan_11n_dispatch_pkt_until_start_win(
 		rx_reor_tbl_ptr->bitmap = 0;
 
 	rx_reor_tbl_ptr->start_win = start_win;
-	pmpriv->adapter->callbacks.moal_spin_unlock(
-		pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
+	wlan_spin_unlock(pmpriv->adapter, pmpriv->rx_pkt_lock);
 
 	LEAVE();
 	return ret;
@@ -263,23 +324,19 @@ static mlan_status wlan_11n_scan_and_dispatch(t_void *priv,
 	ENTER();
 
 	for (i = 0; i < rx_reor_tbl_ptr->win_size; ++i) {
-		pmpriv->adapter->callbacks.moal_spin_lock(
-			pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
+		wlan_spin_lock(pmpriv->adapter, pmpriv->rx_pkt_lock);
 		if (!rx_reor_tbl_ptr->rx_reorder_ptr[i]) {
-			pmpriv->adapter->callbacks.moal_spin_unlock(
-				pmpriv->adapter->pmoal_handle,
-				pmpriv->rx_pkt_lock);
+			wlan_spin_unlock(pmpriv->adapter, pmpriv->rx_pkt_lock);
 			break;
 		}
 		rx_tmp_ptr = rx_reor_tbl_ptr->rx_reorder_ptr[i];
 		rx_reor_tbl_ptr->rx_reorder_ptr[i] = MNULL;
-		pmpriv->adapter->callbacks.moal_spin_unlock(
-			pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
-		wlan_11n_dispatch_pkt(priv, rx_tmp_ptr, rx_reor_tbl_ptr);
+		wlan_spin_unlock(pmpriv->adapter, pmpriv->rx_pkt_lock);
+		wlan_11n_dispatch_pkt(priv, rx_tmp_ptr, rx_reor_tbl_ptr->ta,
+				      rx_reor_tbl_ptr->tid);
 	}
 
-	pmpriv->adapter->callbacks.moal_spin_lock(pmpriv->adapter->pmoal_handle,
-						  pmpriv->rx_pkt_lock);
+	wlan_spin_lock(pmpriv->adapter, pmpriv->rx_pkt_lock);
 	/*
 	 * We don't have a circular buffer, hence use rotation to simulate
 	 * circular buffer
@@ -302,8 +359,7 @@ static mlan_status wlan_11n_scan_and_dispatch(t_void *priv,
 	rx_reor_tbl_ptr->start_win =
 		(rx_reor_tbl_ptr->start_win + i) & (MAX_TID_VALUE - 1);
 
-	pmpriv->adapter->callbacks.moal_spin_unlock(
-		pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
+	wlan_spin_unlock(pmpriv->adapter, pmpriv->rx_pkt_lock);
 	LEAVE();
 	return ret;
 }
@@ -351,8 +407,7 @@ static t_void wlan_11n_delete_rxreorder_tbl_entry(mlan_private *priv,
 	PRINTM(MDAT_D, "Delete rx_reor_tbl_ptr: %p\n", rx_reor_tbl_ptr);
 	util_unlink_list(pmadapter->pmoal_handle, &priv->rx_reorder_tbl_ptr,
 			 (pmlan_linked_list)rx_reor_tbl_ptr,
-			 pmadapter->callbacks.moal_spin_lock,
-			 pmadapter->callbacks.moal_spin_unlock);
+			 wlan_lock_cb(pmadapter), wlan_unlock_cb(pmadapter));
 
 	pmadapter->callbacks.moal_mfree(
 		pmadapter->pmoal_handle,
@@ -512,8 +567,8 @@ static t_void wlan_11n_create_rxreorder_tbl(mlan_private *priv, t_u8 *ta,
 	util_enqueue_list_tail(pmadapter->pmoal_handle,
 			       &priv->rx_reorder_tbl_ptr,
 			       (pmlan_linked_list)new_node,
-			       pmadapter->callbacks.moal_spin_lock,
-			       pmadapter->callbacks.moal_spin_unlock);
+			       wlan_lock_cb(pmadapter),
+			       wlan_unlock_cb(pmadapter));
 	new_node->tid = tid;
 	memcpy_ext(pmadapter, new_node->ta, ta, MLAN_MAC_ADDR_LENGTH,
 		   MLAN_MAC_ADDR_LENGTH);
@@ -744,10 +799,12 @@ mlan_status wlan_cmd_11n_addba_rspgen(mlan_private *priv,
 #endif
 #ifdef UAP_SUPPORT
 	    || ((GET_BSS_ROLE(priv) == MLAN_BSS_ROLE_UAP) &&
-		(util_scalar_read(priv->adapter->pmoal_handle,
-				  &priv->adapter->pending_bridge_pkts,
-				  priv->adapter->callbacks.moal_spin_lock,
-				  priv->adapter->callbacks.moal_spin_unlock) >
+		(util_scalar_atomic_read(
+			 priv->adapter->pmoal_handle,
+			 &priv->adapter->pending_bridge_pkts,
+			 wlan_atomic_read_cb(priv->adapter),
+			 wlan_lock_cb(priv->adapter),
+			 wlan_unlock_cb(priv->adapter)) >
 		 RX_LOW_THRESHOLD))
 #endif
 	)
@@ -844,11 +901,13 @@ mlan_status mlan_11n_rxreorder_pkt(void *priv, t_u16 seq_num, t_u16 tid,
 
 	ENTER();
 
+	if (payload != (t_void *)RX_PKT_DROPPED_IN_FW)
+		((pmlan_buffer)payload)->rx_lat_tid = (t_u8)tid;
 	rx_reor_tbl_ptr =
 		wlan_11n_get_rxreorder_tbl((mlan_private *)priv, tid, ta);
 	if (!rx_reor_tbl_ptr || rx_reor_tbl_ptr->win_size <= 1) {
 		if (pkt_type != PKT_TYPE_BAR)
-			wlan_11n_dispatch_pkt(priv, payload, rx_reor_tbl_ptr);
+			wlan_11n_dispatch_pkt(priv, payload, ta, tid);
 
 		LEAVE();
 		return ret;
@@ -859,7 +918,7 @@ mlan_status mlan_11n_rxreorder_pkt(void *priv, t_u16 seq_num, t_u16 tid,
 			wlan_start_flush_data(priv, rx_reor_tbl_ptr);
 		}
 		if ((pkt_type == PKT_TYPE_AMSDU) && !rx_reor_tbl_ptr->amsdu) {
-			wlan_11n_dispatch_pkt(priv, payload, rx_reor_tbl_ptr);
+			wlan_11n_dispatch_pkt(priv, payload, ta, tid);
 			LEAVE();
 			return ret;
 		}
@@ -892,7 +951,7 @@ mlan_status mlan_11n_rxreorder_pkt(void *priv, t_u16 seq_num, t_u16 tid,
 						if (pkt_type != PKT_TYPE_BAR)
 							wlan_11n_dispatch_pkt(
 								priv, payload,
-								rx_reor_tbl_ptr);
+								ta, tid);
 					}
 					LEAVE();
 					return ret;
@@ -1295,8 +1354,8 @@ void wlan_11n_cleanup_reorder_tbl(mlan_private *priv)
 
 	while ((del_tbl_ptr = (RxReorderTbl *)util_peek_list(
 			priv->adapter->pmoal_handle, &priv->rx_reorder_tbl_ptr,
-			priv->adapter->callbacks.moal_spin_lock,
-			priv->adapter->callbacks.moal_spin_unlock))) {
+			wlan_lock_cb(priv->adapter),
+			wlan_unlock_cb(priv->adapter)))) {
 		wlan_11n_delete_rxreorder_tbl_entry(priv, del_tbl_ptr);
 	}
 
@@ -1420,8 +1479,7 @@ static void wlan_set_rxreorder_tbl_no_drop_flag(mlan_private *priv, t_u8 flag)
 
 	rx_reor_tbl_ptr = (RxReorderTbl *)util_peek_list(
 		priv->adapter->pmoal_handle, &priv->rx_reorder_tbl_ptr,
-		priv->adapter->callbacks.moal_spin_lock,
-		priv->adapter->callbacks.moal_spin_unlock);
+		wlan_lock_cb(priv->adapter), wlan_unlock_cb(priv->adapter));
 	if (!rx_reor_tbl_ptr) {
 		LEAVE();
 		return;
@@ -1472,8 +1530,7 @@ static void wlan_flush_priv_rxreorder_tbl(mlan_private *priv)
 
 	rx_reor_tbl_ptr = (RxReorderTbl *)util_peek_list(
 		priv->adapter->pmoal_handle, &priv->rx_reorder_tbl_ptr,
-		priv->adapter->callbacks.moal_spin_lock,
-		priv->adapter->callbacks.moal_spin_unlock);
+		wlan_lock_cb(priv->adapter), wlan_unlock_cb(priv->adapter));
 	if (!rx_reor_tbl_ptr) {
 		LEAVE();
 		return;
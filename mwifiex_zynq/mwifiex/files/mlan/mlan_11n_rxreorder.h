@@ -77,6 +77,7 @@ Change log:
 /** Indicate packet has been dropped in FW */
 #define RX_PKT_DROPPED_IN_FW 0xffffffff
 
+mlan_status wlan_11n_rx_late_process(t_void *priv, t_void *payload);
 mlan_status mlan_11n_rxreorder_pkt(void *priv, t_u16 seqNum, t_u16 tid,
 				   t_u8 *ta, t_u8 pkttype, void *payload);
 void mlan_11n_delete_bastream_tbl(mlan_private *priv, int tid,
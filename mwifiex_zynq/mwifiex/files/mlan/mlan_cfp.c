@@ -989,11 +989,79 @@ t_u8 SupportedRates_A[A_SUPPORTED_RATES] = {0x0c, 0x12, 0x18, 0x24, 0xb0,
 /**
  * The rates supported by the card
  */
-static t_u16 WlanDataRates[WLAN_SUPPORTED_RATES_EXT] = {
+static const t_u16 WlanDataRates[WLAN_SUPPORTED_RATES_EXT] = {
 	0x02, 0x04, 0x0B, 0x16, 0x00, 0x0C, 0x12, 0x18, 0x24,  0x30, 0x48,
 	0x60, 0x6C, 0x90, 0x0D, 0x1A, 0x27, 0x34, 0x4E, 0x68,  0x75, 0x82,
 	0x0C, 0x1B, 0x36, 0x51, 0x6C, 0xA2, 0xD8, 0xF3, 0x10E, 0x00};
 
+/**
+ * WlanDataRates index for each rate byte, used by
+ * wlan_data_rate_to_index(). Built from WlanDataRates by
+ * wlan_init_data_rate_index().
+ */
+static t_u8 WlanDataRateIndex[256];
+
+#define MCS_NUM_SUPP 16
+/** HT MCS0-15 rates, indexed by [2 * (1 - bw) + gi][mcs]
+ * note: the value in the table is 2 multiplier of the actual rate
+ */
+static const t_u16 ht_mcs_rate[4][MCS_NUM_SUPP] = {
+	{0x1b, 0x36, 0x51, 0x6c, 0xa2, 0xd8, 0xf3, 0x10e, 0x36, 0x6c, 0xa2,
+	 0xd8, 0x144, 0x1b0, 0x1e6, 0x21c}, /*LG 40M*/
+	{0x1e, 0x3c, 0x5a, 0x78, 0xb4, 0xf0, 0x10e, 0x12c, 0x3c, 0x78, 0xb4,
+	 0xf0, 0x168, 0x1e0, 0x21c, 0x258}, /*SG 40M */
+	{0x0d, 0x1a, 0x27, 0x34, 0x4e, 0x68, 0x75, 0x82, 0x1a, 0x34, 0x4e,
+	 0x68, 0x9c, 0xd0, 0xea, 0x104}, /*LG 20M */
+	{0x0e, 0x1c, 0x2b, 0x39, 0x56, 0x73, 0x82, 0x90, 0x1c, 0x39, 0x56,
+	 0x73, 0xad, 0xe7, 0x104, 0x120}}; /*SG 20M */
+
+/** HT MCS32 rate, indexed by gi */
+static const t_u16 ht_mcs32_rate[2] = {0x0C, 0x0D};
+
+#define MCS_NUM_AC 10
+/** VHT rates, indexed by [nss - 1][2 * (3 - bw) + gi][mcs]
+ * note: the value in the table is 2 multiplier of the actual rate
+ * in other words, it is in the unit of 500 Kbs
+ */
+static const t_u16 ac_mcs_rate[2][8][MCS_NUM_AC] = {
+	{
+		{0x75, 0xEA, 0x15F, 0x1D4, 0x2BE, 0x3A8, 0x41D, 0x492, 0x57C,
+		 0x618}, /* LG 160M*/
+		{0x82, 0x104, 0x186, 0x208, 0x30C, 0x410, 0x492, 0x514, 0x618,
+		 0x6C6}, /* SG 160M*/
+		{0x3B, 0x75, 0xB0, 0xEA, 0x15F, 0x1D4, 0x20F, 0x249, 0x2BE,
+		 0x30C}, /* LG 80M */
+		{0x41, 0x82, 0xC3, 0x104, 0x186, 0x208, 0x249, 0x28A, 0x30C,
+		 0x363}, /* SG 80M */
+		{0x1B, 0x36, 0x51, 0x6C, 0xA2, 0xD8, 0xF3, 0x10E, 0x144,
+		 0x168}, /* LG 40M */
+		{0x1E, 0x3C, 0x5A, 0x78, 0xB4, 0xF0, 0x10E, 0x12C, 0x168,
+		 0x190}, /* SG 40M */
+		{0xD, 0x1A, 0x27, 0x34, 0x4E, 0x68, 0x75, 0x82, 0x9C,
+		 0x00}, /* LG 20M */
+		{0xF, 0x1D, 0x2C, 0x3A, 0x57, 0x74, 0x82, 0x91, 0xAE,
+		 0x00}, /* SG 20M */
+	},
+	{
+		{0xEA, 0x1D4, 0x2BE, 0x3A8, 0x57C, 0x750, 0x83A, 0x924, 0xAF8,
+		 0xC30}, /*LG 160M*/
+		{0x104, 0x208, 0x30C, 0x410, 0x618, 0x820, 0x924, 0xA28, 0xC30,
+		 0xD8B}, /*SG 160M*/
+		{0x75, 0xEA, 0x15F, 0x1D4, 0x2BE, 0x3A8, 0x41D, 0x492, 0x57C,
+		 0x618}, /*LG 80M*/
+		{0x82, 0x104, 0x186, 0x208, 0x30C, 0x410, 0x492, 0x514, 0x618,
+		 0x6C6}, /*SG 80M*/
+		{0x36, 0x6C, 0xA2, 0xD8, 0x144, 0x1B0, 0x1E6, 0x21C, 0x288,
+		 0x2D0}, /*LG 40M*/
+		{0x3C, 0x78, 0xB4, 0xF0, 0x168, 0x1E0, 0x21C, 0x258, 0x2D0,
+		 0x320}, /*SG 40M*/
+		{0x1A, 0x34, 0x4A, 0x68, 0x9C, 0xD0, 0xEA, 0x104, 0x138,
+		 0x00}, /*LG 20M*/
+		{0x1D, 0x3A, 0x57, 0x74, 0xAE, 0xE6, 0x104, 0x121, 0x15B,
+		 0x00}, /*SG 20M*/
+	},
+};
+
 /**
  * The rates supported in B mode
  */
@@ -1020,7 +1088,7 @@ t_u8 SupportedRates_N[N_SUPPORTED_RATES] = {0x02, 0x04, 0};
 #define MCS_NUM_AX 12
 // for MCS0/MCS1/MCS3/MCS4 have 4 additional DCM=1 value
 // note: the value in the table is 2 multiplier of the actual rate
-static t_u16 ax_mcs_rate_nss1[12][MCS_NUM_AX + 4] = {
+static const t_u16 ax_mcs_rate_nss1[12][MCS_NUM_AX + 4] = {
 	{0x90, 0x48, 0x120, 0x90, 0x1B0, 0x240, 0x120, 0x360, 0x1B0, 0x481,
 	 0x511, 0x5A1, 0x6C1, 0x781, 0x871, 0x962}, /*SG 160M*/
 	{0x88, 0x44, 0x110, 0x88, 0x198, 0x220, 0x110, 0x330, 0x198, 0x440,
@@ -1072,7 +1140,7 @@ t_u16 ax_tone_ru_rate_nss1[9][MCS_NUM_AX + 4] = {
 #endif
 
 // note: the value in the table is 2 multiplier of the actual rate
-static t_u16 ax_mcs_rate_nss2[12][MCS_NUM_AX + 4] = {
+static const t_u16 ax_mcs_rate_nss2[12][MCS_NUM_AX + 4] = {
 	{0x120, 0x90, 0x240, 0x120, 0x360, 0x481, 0x240, 0x61C, 0x360, 0x901,
 	 0xA22, 0xB42, 0xD82, 0xF03, 0x10E3, 0x12C3}, /*SG 160M*/
 	{0x110, 0x88, 0x220, 0x110, 0x330, 0x440, 0x220, 0x661, 0x330, 0x881,
@@ -1099,6 +1167,15 @@ static t_u16 ax_mcs_rate_nss2[12][MCS_NUM_AX + 4] = {
 	 0x124, 0x15F, 0x186, 0x1B6, 0x1E7} /*LG 20M*/
 };
 
+/** HE rate tables, indexed by nss - 1 */
+static const t_u16 (*const ax_mcs_rate[2])[MCS_NUM_AX + 4] = {
+	ax_mcs_rate_nss1, ax_mcs_rate_nss2};
+
+/** Column of ax_mcs_rate_nss1/2 for each HE MCS, indexed by [mcs][dcm] */
+static const t_u8 ax_mcs_rate_col[MCS_NUM_AX][2] = {
+	{0, 1},	  {2, 3},   {4, 4},   {5, 6},	{7, 8},	  {9, 9},
+	{10, 10}, {11, 11}, {12, 12}, {13, 13}, {14, 14}, {15, 15}};
+
 #if 0
 // note: the value in the table is 2 multiplier of the actual rate
 t_u16 ax_tone_ru_rate_nss2[9][MCS_NUM_AX + 4] = {
@@ -1126,34 +1203,6 @@ t_u16 ax_tone_ru_rate_nss2[9][MCS_NUM_AX + 4] = {
 /********************************************************
  *			Local Functions
  ********************************************************/
-/**
- *  @brief Find a character in a string.
- *
- *  @param pmadapter    A pointer to mlan_adapter structure
- *  @param s            A pointer to string
- *  @param c            Character to be located
- *  @param n            The length of string
- *
- *  @return        A pointer to the first occurrence of c in string, or MNULL if
- * c is not found.
- */
-static void *wlan_memchr(pmlan_adapter pmadapter, void *s, int c, int n)
-{
-	const t_u8 *p = (t_u8 *)s;
-
-	ENTER();
-
-	while (n--) {
-		if ((t_u8)c == *p++) {
-			LEAVE();
-			return (void *)(p - 1);
-		}
-	}
-
-	LEAVE();
-	return MNULL;
-}
-
 /**
  *  @brief This function finds the CFP in
  *          cfp_table_BG/A based on region/code and band parameter.
@@ -1542,68 +1591,11 @@ t_u8 wlan_convert_v14_rx_rate_info(pmlan_private pmpriv, t_u8 v14_rate_info)
 t_u32 wlan_index_to_data_rate(pmlan_adapter pmadapter, t_u8 index,
 			      t_u8 tx_rate_info, t_u8 ext_rate_info)
 {
-#define MCS_NUM_SUPP 16
-	t_u16 mcs_rate[4][MCS_NUM_SUPP] = {
-		{0x1b, 0x36, 0x51, 0x6c, 0xa2, 0xd8, 0xf3, 0x10e, 0x36, 0x6c,
-		 0xa2, 0xd8, 0x144, 0x1b0, 0x1e6, 0x21c}, /*LG 40M*/
-		{0x1e, 0x3c, 0x5a, 0x78, 0xb4, 0xf0, 0x10e, 0x12c, 0x3c, 0x78,
-		 0xb4, 0xf0, 0x168, 0x1e0, 0x21c, 0x258}, /*SG 40M */
-		{0x0d, 0x1a, 0x27, 0x34, 0x4e, 0x68, 0x75, 0x82, 0x1a, 0x34,
-		 0x4e, 0x68, 0x9c, 0xd0, 0xea, 0x104}, /*LG 20M */
-		{0x0e, 0x1c, 0x2b, 0x39, 0x56, 0x73, 0x82, 0x90, 0x1c, 0x39,
-		 0x56, 0x73, 0xad, 0xe7, 0x104, 0x120}}; /*SG 20M */
-
-#define MCS_NUM_AC 10
-	/* NSS 1. note: the value in the table is 2 multiplier of the actual
-	 * rate in other words, it is in the unit of 500 Kbs
-	 */
-	t_u16 ac_mcs_rate_nss1[8][MCS_NUM_AC] = {
-		{0x75, 0xEA, 0x15F, 0x1D4, 0x2BE, 0x3A8, 0x41D, 0x492, 0x57C,
-		 0x618}, /* LG 160M*/
-		{0x82, 0x104, 0x186, 0x208, 0x30C, 0x410, 0x492, 0x514, 0x618,
-		 0x6C6}, /* SG 160M*/
-		{0x3B, 0x75, 0xB0, 0xEA, 0x15F, 0x1D4, 0x20F, 0x249, 0x2BE,
-		 0x30C}, /* LG 80M */
-		{0x41, 0x82, 0xC3, 0x104, 0x186, 0x208, 0x249, 0x28A, 0x30C,
-		 0x363}, /* SG 80M */
-		{0x1B, 0x36, 0x51, 0x6C, 0xA2, 0xD8, 0xF3, 0x10E, 0x144,
-		 0x168}, /* LG 40M */
-		{0x1E, 0x3C, 0x5A, 0x78, 0xB4, 0xF0, 0x10E, 0x12C, 0x168,
-		 0x190}, /* SG 40M */
-		{0xD, 0x1A, 0x27, 0x34, 0x4E, 0x68, 0x75, 0x82, 0x9C,
-		 0x00}, /* LG 20M */
-		{0xF, 0x1D, 0x2C, 0x3A, 0x57, 0x74, 0x82, 0x91, 0xAE,
-		 0x00}, /* SG 20M */
-	};
-	/* NSS 2. note: the value in the table is 2 multiplier of the actual
-	 * rate
-	 */
-	t_u16 ac_mcs_rate_nss2[8][MCS_NUM_AC] = {
-		{0xEA, 0x1D4, 0x2BE, 0x3A8, 0x57C, 0x750, 0x83A, 0x924, 0xAF8,
-		 0xC30}, /*LG 160M*/
-		{0x104, 0x208, 0x30C, 0x410, 0x618, 0x820, 0x924, 0xA28, 0xC30,
-		 0xD8B}, /*SG 160M*/
-
-		{0x75, 0xEA, 0x15F, 0x1D4, 0x2BE, 0x3A8, 0x41D, 0x492, 0x57C,
-		 0x618}, /*LG 80M*/
-		{0x82, 0x104, 0x186, 0x208, 0x30C, 0x410, 0x492, 0x514, 0x618,
-		 0x6C6}, /*SG 80M*/
-		{0x36, 0x6C, 0xA2, 0xD8, 0x144, 0x1B0, 0x1E6, 0x21C, 0x288,
-		 0x2D0}, /*LG 40M*/
-		{0x3C, 0x78, 0xB4, 0xF0, 0x168, 0x1E0, 0x21C, 0x258, 0x2D0,
-		 0x320}, /*SG 40M*/
-		{0x1A, 0x34, 0x4A, 0x68, 0x9C, 0xD0, 0xEA, 0x104, 0x138,
-		 0x00}, /*LG 20M*/
-		{0x1D, 0x3A, 0x57, 0x74, 0xAE, 0xE6, 0x104, 0x121, 0x15B,
-		 0x00}, /*SG 20M*/
-	};
-
 	t_u32 rate = 0;
 	t_u8 mcs_index = 0;
 	t_u8 he_dcm = 0;
-	//	t_u8 he_tone = 0;
 	t_u8 stbc = 0;
-
+	t_u8 nss = 0;
 	t_u8 bw = 0;
 	t_u8 gi = 0;
 
@@ -1612,33 +1604,19 @@ t_u32 wlan_index_to_data_rate(pmlan_adapter pmadapter, t_u8 index,
 	PRINTM(MINFO, "%s:index=%d, tx_rate_info=%d, ext_rate_info=%d\n",
 	       __func__, index, tx_rate_info, ext_rate_info);
 
-	if ((tx_rate_info & 0x3) == MLAN_RATE_FORMAT_VHT) {
-		/* VHT rate */
-		mcs_index = index & 0xF;
-
-		if (mcs_index > 9)
-			mcs_index = 9;
-
+	switch (tx_rate_info & 0x3) {
+	case MLAN_RATE_FORMAT_VHT:
+		mcs_index = MIN(index & 0xF, MCS_NUM_AC - 1);
 		/* 20M: bw=0, 40M: bw=1, 80M: bw=2, 160M: bw=3 */
 		bw = (tx_rate_info & 0xC) >> 2;
 		/* LGI: gi =0, SGI: gi = 1 */
 		gi = (tx_rate_info & 0x10) >> 4;
-		if ((index >> 4) == 1) {
-			/* NSS = 2 */
-			rate = ac_mcs_rate_nss2[2 * (3 - bw) + gi][mcs_index];
-		} else
-			/* NSS = 1 */
-			rate = ac_mcs_rate_nss1[2 * (3 - bw) + gi][mcs_index];
-	} else
-
-		if ((tx_rate_info & 0x3) == MLAN_RATE_FORMAT_HE) {
-		/* VHT rate */
-		mcs_index = index & 0xF;
+		nss = ((index >> 4) == 1) ? 1 : 0;
+		rate = ac_mcs_rate[nss][2 * (3 - bw) + gi][mcs_index];
+		break;
+	case MLAN_RATE_FORMAT_HE:
+		mcs_index = MIN(index & 0xF, MCS_NUM_AX - 1);
 		he_dcm = ext_rate_info & MBIT(0);
-
-		if (mcs_index > MCS_NUM_AX - 1)
-			mcs_index = MCS_NUM_AX - 1;
-
 		/* 20M: bw=0, 40M: bw=1, 80M: bw=2, 160M: bw=3 */
 		bw = (tx_rate_info & (MBIT(3) | MBIT(2))) >> 2;
 		/* BIT7:BIT4 0:0= 0.8us,0:1= 0.8us, 1:0=1.6us, 1:1=3.2us or
@@ -1648,152 +1626,35 @@ t_u32 wlan_index_to_data_rate(pmlan_adapter pmadapter, t_u8 index,
 		     (tx_rate_info & MBIT(7)) >> 6;
 		/* STBC: BIT5 in tx rate info */
 		stbc = (tx_rate_info & MBIT(5)) >> 5;
-
-		if (gi > 3) {
-			PRINTM(MERROR, "Invalid gi value");
-			return 0;
-		}
-
 		if ((gi == 3) && stbc && he_dcm) {
 			gi = 0;
-			stbc = 0;
 			he_dcm = 0;
 		}
 		/* map to gi 0:0.8us,1:1.6us 2:3.2us*/
 		if (gi > 0)
 			gi = gi - 1;
-
-		//#ifdef ENABLE_802_11AX
-		// TODO: hardcode he_tone here, wait for FW value ready.
-		//		he_tone = 4;
-
-		// he_tone = (ext_rate_info & 0xE) >> 1;
-		//#endif
-
-		if ((index >> 4) == 1) {
-			switch (mcs_index) {
-			case 0:
-			case 1:
-				// #if 0
-				// if (he_tone < 3) {
-				//	rate =
-				//ax_tone_ru_rate_nss2[3*(2-he_tone)+gi][mcs_index*2
-				//+ he_dcm];
-				// } else {
-				// #endif
-				rate = ax_mcs_rate_nss2[3 * (3 - bw) + gi]
-						       [mcs_index * 2 + he_dcm];
-				break;
-			case 2:
-				// #if 0
-				// if (he_tone < 3) {
-				//	rate =
-				//ax_tone_ru_rate_nss2[3*(2-he_tone)+gi][mcs_index*2];
-				// } else {
-				// #endif
-				rate = ax_mcs_rate_nss2[3 * (3 - bw) + gi]
-						       [mcs_index * 2];
-				break;
-			case 3:
-			case 4:
-				// #if 0
-				// if (he_tone < 3) {
-				//	rate =
-				//ax_tone_ru_rate_nss2[3*(2-he_tone)+gi][mcs_index*2
-				//- 1 + he_dcm];
-				// } else {
-				// #endif
-				rate = ax_mcs_rate_nss2[3 * (3 - bw) + gi]
-						       [mcs_index * 2 - 1 +
-							he_dcm];
-				break;
-
-			default:
-				// #if 0
-				// if (he_tone < 3) {
-				//	rate =
-				//ax_tone_ru_rate_nss2[3*(2-he_tone)+gi][mcs_index
-				//+ 4];
-				// } else {
-				// #endif
-				rate = ax_mcs_rate_nss2[3 * (3 - bw) + gi]
-						       [mcs_index + 4];
-				break;
-			}
-		} else {
-			switch (mcs_index) {
-			case 0:
-			case 1:
-				// #if 0
-				// if (he_tone < 3) {
-				//	rate =
-				//ax_tone_ru_rate_nss1[3*(2-he_tone)+gi][mcs_index*2
-				//+ he_dcm];
-				// } else {
-				// #endif
-				rate = ax_mcs_rate_nss1[3 * (3 - bw) + gi]
-						       [mcs_index * 2 + he_dcm];
-				break;
-			case 2:
-				// #if 0
-				// if (he_tone < 3) {
-				//	rate =
-				//ax_tone_ru_rate_nss1[3*(2-he_tone)+gi][mcs_index*2];
-				// } else {
-				// #endif
-				rate = ax_mcs_rate_nss1[3 * (3 - bw) + gi]
-						       [mcs_index * 2];
-				break;
-			case 3:
-			case 4:
-				// #if 0
-				// if (he_tone < 3) {
-				//	rate =
-				//ax_tone_ru_rate_nss1[3*(2-he_tone)+gi][mcs_index*2
-				//- 1 + he_dcm];
-				// } else {
-				// #endif
-				rate = ax_mcs_rate_nss1[3 * (3 - bw) + gi]
-						       [mcs_index * 2 - 1 +
-							he_dcm];
-				break;
-
-			default:
-				// #if 0
-				// if (he_tone < 3) {
-				//	rate =
-				//ax_tone_ru_rate_nss1[3*(2-he_tone)+gi][mcs_index
-				//+ 4];
-				// } else {
-				// #endif
-				rate = ax_mcs_rate_nss1[3 * (3 - bw) + gi]
-						       [mcs_index + 4];
-				break;
-			}
-		}
-	} else if ((tx_rate_info & 0x3) == MLAN_RATE_FORMAT_HT) {
-		/* HT rate */
+		nss = ((index >> 4) == 1) ? 1 : 0;
+		rate = ax_mcs_rate[nss][3 * (3 - bw) + gi]
+				  [ax_mcs_rate_col[mcs_index][he_dcm]];
+		break;
+	case MLAN_RATE_FORMAT_HT:
 		/* 20M: bw=0, 40M: bw=1 */
 		bw = (tx_rate_info & 0xC) >> 2;
 		/* LGI: gi =0, SGI: gi = 1 */
 		gi = (tx_rate_info & 0x10) >> 4;
-		if (index == MLAN_RATE_BITMAP_MCS0) {
-			if (gi == 1)
-				rate = 0x0D; /* MCS 32 SGI rate */
-			else
-				rate = 0x0C; /* MCS 32 LGI rate */
-		} else if (index < MCS_NUM_SUPP) {
-			if (bw <= 1)
-				rate = mcs_rate[2 * (1 - bw) + gi][index];
-			else
-				rate = WlanDataRates[0];
-		} else
+		if (index == MLAN_RATE_BITMAP_MCS0)
+			rate = ht_mcs32_rate[gi];
+		else if (index < MCS_NUM_SUPP && bw <= 1)
+			rate = ht_mcs_rate[2 * (1 - bw) + gi][index];
+		else
 			rate = WlanDataRates[0];
-	} else {
+		break;
+	default:
 		/* 11n non HT rates */
 		if (index >= WLAN_SUPPORTED_RATES_EXT)
 			index = 0;
 		rate = WlanDataRates[index];
+		break;
 	}
 	LEAVE();
 	return rate;
@@ -1809,19 +1670,25 @@ t_u32 wlan_index_to_data_rate(pmlan_adapter pmadapter, t_u8 index,
  */
 t_u8 wlan_data_rate_to_index(pmlan_adapter pmadapter, t_u32 rate)
 {
-	t_u16 *ptr;
+	return WlanDataRateIndex[(t_u8)rate];
+}
 
-	ENTER();
-	if (rate) {
-		ptr = wlan_memchr(pmadapter, WlanDataRates, (t_u8)rate,
-				  sizeof(WlanDataRates));
-		if (ptr) {
-			LEAVE();
-			return (t_u8)(ptr - WlanDataRates);
-		}
-	}
-	LEAVE();
-	return 0;
+/**
+ *  @brief Build the rate to index table from WlanDataRates. A rate maps to
+ *         the entry holding the first byte of WlanDataRates equal to the
+ *         low byte of the rate, as the byte search it replaces did, or to
+ *         0 when there is none.
+ *
+ *  @return                     N/A
+ */
+t_void wlan_init_data_rate_index(t_void)
+{
+	const t_u8 *p = (const t_u8 *)WlanDataRates;
+	int i;
+
+	/* Walk backwards so the first occurrence is written last */
+	for (i = sizeof(WlanDataRates) - 1; i >= 0; i--)
+		WlanDataRateIndex[p[i]] = (t_u8)(i / sizeof(WlanDataRates[0]));
 }
 
 /**
@@ -1927,6 +1794,128 @@ t_u8 wlan_get_txpwr_of_chan_from_cfp(mlan_private *pmpriv, t_u16 band,
 	return tx_power;
 }
 
+/**
+ *  @brief Get the channel lookup table that belongs to a region channel array
+ *
+ *  @param pmadapter            A pointer to mlan_adapter structure
+ *  @param region_channel       A pointer to region_chan_t array
+ *
+ *  @return                     A pointer to region_chan_idx_t or MNULL
+ */
+static region_chan_idx_t *
+wlan_get_region_chan_idx(pmlan_adapter pmadapter,
+			 region_chan_t *region_channel)
+{
+	if (region_channel == pmadapter->region_channel)
+		return &pmadapter->region_chan_idx;
+#ifdef STA_SUPPORT
+	if (region_channel == pmadapter->universal_channel)
+		return &pmadapter->universal_chan_idx;
+#endif
+	return MNULL;
+}
+
+/**
+ *  @brief Rebuild the direct-indexed channel lookup table of a region
+ *  channel array. Must be called whenever the array is reprogrammed.
+ *
+ *  @param pmadapter            A pointer to mlan_adapter structure
+ *  @param region_channel       A pointer to region_chan_t array
+ *
+ *  @return                     N/A
+ */
+t_void wlan_update_region_chan_idx(pmlan_adapter pmadapter,
+				   region_chan_t *region_channel)
+{
+	region_chan_idx_t *pidx;
+	region_chan_t *rc;
+	t_u16 chan;
+	t_u8 i;
+	int j;
+
+	pidx = wlan_get_region_chan_idx(pmadapter, region_channel);
+	if (!pidx)
+		return;
+
+	memset(pmadapter, pidx, 0, sizeof(region_chan_idx_t));
+	for (j = 0; j < MAX_REGION_CHANNEL_NUM; j++) {
+		rc = &region_channel[j];
+		pidx->pcfp[j] = rc->pcfp;
+		pidx->num_cfp[j] = rc->num_cfp;
+		if (!rc->pcfp)
+			continue;
+		/* Walk backwards so the first entry of a channel wins */
+		for (i = rc->num_cfp; i > 0; i--) {
+			chan = rc->pcfp[i - 1].channel;
+			if (chan < MAX_CFP_CHAN_IDX)
+				pidx->idx[j][chan] = i;
+		}
+	}
+}
+
+/**
+ *  @brief Look up a channel in one entry of a region channel array
+ *
+ *  @param pmadapter            A pointer to mlan_adapter structure
+ *  @param region_channel       A pointer to region_chan_t array
+ *  @param rc_idx               Index of the entry in region_channel
+ *  @param channel              The channel to search for
+ *
+ *  @return                     A pointer to chan_freq_power_t structure or
+ * MNULL if not found.
+ */
+static chan_freq_power_t *wlan_region_chan_lookup(pmlan_adapter pmadapter,
+						  region_chan_t *region_channel,
+						  int rc_idx, t_u16 channel)
+{
+	region_chan_t *rc = &region_channel[rc_idx];
+	region_chan_idx_t *pidx;
+	t_u8 i;
+
+	if (!rc->pcfp)
+		return MNULL;
+
+	pidx = wlan_get_region_chan_idx(pmadapter, region_channel);
+	if (!pidx) {
+		for (i = 0; i < rc->num_cfp; i++) {
+			if (rc->pcfp[i].channel == channel)
+				return &rc->pcfp[i];
+		}
+		return MNULL;
+	}
+	/* Table reprogrammed without an explicit rebuild */
+	if (pidx->pcfp[rc_idx] != rc->pcfp ||
+	    pidx->num_cfp[rc_idx] != rc->num_cfp)
+		wlan_update_region_chan_idx(pmadapter, region_channel);
+
+	if (channel >= MAX_CFP_CHAN_IDX)
+		return MNULL;
+	i = pidx->idx[rc_idx][channel];
+	return i ? &rc->pcfp[i - 1] : MNULL;
+}
+
+/**
+ *  @brief Look up a channel in the first region channel entry matching band
+ *
+ *  @param pmadapter    A pointer to mlan_adapter structure
+ *  @param band         Band to check
+ *  @param chan         Channel to check
+ *
+ *  @return             A pointer to chan_freq_power_t structure or MNULL
+ */
+static chan_freq_power_t *wlan_get_region_cfp_by_chan(pmlan_adapter pmadapter,
+						      t_u16 band, t_u8 chan)
+{
+	int i;
+
+	for (i = 0; i < MAX_REGION_CHANNEL_NUM; i++) {
+		if (pmadapter->region_channel[i].band & band)
+			return wlan_region_chan_lookup(
+				pmadapter, pmadapter->region_channel, i, chan);
+	}
+	return MNULL;
+}
+
 /**
  *  @brief Get the channel frequency power info for a specific channel
  *
@@ -1945,7 +1934,7 @@ wlan_get_cfp_by_band_and_channel(pmlan_adapter pmadapter, t_u16 band,
 {
 	region_chan_t *rc;
 	chan_freq_power_t *cfp = MNULL;
-	int i, j;
+	int j;
 
 	ENTER();
 
@@ -1994,14 +1983,9 @@ wlan_get_cfp_by_band_and_channel(pmlan_adapter pmadapter, t_u16 band,
 		}
 		if (channel == FIRST_VALID_CHANNEL)
 			cfp = &rc->pcfp[0];
-		else {
-			for (i = 0; i < rc->num_cfp; i++) {
-				if (rc->pcfp[i].channel == channel) {
-					cfp = &rc->pcfp[i];
-					break;
-				}
-			}
-		}
+		else
+			cfp = wlan_region_chan_lookup(pmadapter, region_channel,
+						      j, channel);
 	}
 
 	if (!cfp && channel)
@@ -2711,6 +2695,7 @@ mlan_status wlan_set_regiontable(mlan_private *pmpriv, t_u8 region, t_u16 band)
 		}
 		i++;
 	}
+	wlan_update_region_chan_idx(pmadapter, pmadapter->region_channel);
 	LEAVE();
 	return MLAN_STATUS_SUCCESS;
 }
@@ -2727,36 +2712,18 @@ mlan_status wlan_set_regiontable(mlan_private *pmpriv, t_u8 region, t_u16 band)
  */
 t_bool wlan_get_cfp_radar_detect(mlan_private *priv, t_u8 chnl)
 {
-	int i, j;
 	t_bool required = MFALSE;
-	chan_freq_power_t *pcfp = MNULL;
+	chan_freq_power_t *cfp;
 
 	ENTER();
 
-	/*get the cfp table first*/
-	for (i = 0; i < MAX_REGION_CHANNEL_NUM; i++) {
-		if (priv->adapter->region_channel[i].band == BAND_A) {
-			pcfp = priv->adapter->region_channel[i].pcfp;
-			break;
-		}
-	}
-
-	if (!pcfp) {
-		/* This means operation in BAND-A is not support, we can
-		 * just return false here, it's harmless
-		 */
-		goto done;
-	}
-
-	/*get the radar detection requirements according to chan num*/
-	for (j = 0; j < priv->adapter->region_channel[i].num_cfp; j++) {
-		if (pcfp[j].channel == chnl) {
-			required = pcfp[j].passive_scan_or_radar_detect;
-			break;
-		}
-	}
+	/* MNULL also means operation in BAND-A is not supported, it's
+	 * harmless to return false here
+	 */
+	cfp = wlan_get_region_cfp_by_chan(priv->adapter, BAND_A, chnl);
+	if (cfp)
+		required = cfp->passive_scan_or_radar_detect;
 
-done:
 	LEAVE();
 	return required;
 }
@@ -2773,36 +2740,15 @@ done:
  */
 t_bool wlan_bg_scan_type_is_passive(mlan_private *priv, t_u8 chnl)
 {
-	int i, j;
 	t_bool passive = MFALSE;
-	chan_freq_power_t *pcfp = MNULL;
+	chan_freq_power_t *cfp;
 
 	ENTER();
 
-	/*get the cfp table first*/
-	for (i = 0; i < MAX_REGION_CHANNEL_NUM; i++) {
-		if (priv->adapter->region_channel[i].band & (BAND_B | BAND_G)) {
-			pcfp = priv->adapter->region_channel[i].pcfp;
-			break;
-		}
-	}
-
-	if (!pcfp) {
-		/*This means operation in BAND-B or BAND_G is not support, we
-		 * can just return false here
-		 */
-		goto done;
-	}
+	cfp = wlan_get_region_cfp_by_chan(priv->adapter, BAND_B | BAND_G, chnl);
+	if (cfp)
+		passive = cfp->passive_scan_or_radar_detect;
 
-	/*get the bg scan type according to chan num*/
-	for (j = 0; j < priv->adapter->region_channel[i].num_cfp; j++) {
-		if (pcfp[j].channel == chnl) {
-			passive = pcfp[j].passive_scan_or_radar_detect;
-			break;
-		}
-	}
-
-done:
 	LEAVE();
 	return passive;
 }
@@ -2821,30 +2767,14 @@ done:
 
 t_bool wlan_is_chan_passive(mlan_private *priv, t_u16 band, t_u8 chan)
 {
-	int i, j;
 	t_bool passive = MFALSE;
-	chan_freq_power_t *pcfp = MNULL;
+	chan_freq_power_t *cfp;
 
 	ENTER();
 
-	/* get the cfp table first */
-	for (i = 0; i < MAX_REGION_CHANNEL_NUM; i++) {
-		if (priv->adapter->region_channel[i].band & band) {
-			pcfp = priv->adapter->region_channel[i].pcfp;
-			break;
-		}
-	}
-
-	if (pcfp) {
-		/* check table according to chan num */
-		for (j = 0; j < priv->adapter->region_channel[i].num_cfp; j++) {
-			if (pcfp[j].channel == chan) {
-				if (pcfp[j].dynamic.flags & NXP_CHANNEL_PASSIVE)
-					passive = MTRUE;
-				break;
-			}
-		}
-	}
+	cfp = wlan_get_region_cfp_by_chan(priv->adapter, band, chan);
+	if (cfp && (cfp->dynamic.flags & NXP_CHANNEL_PASSIVE))
+		passive = MTRUE;
 
 	LEAVE();
 	return passive;
@@ -2864,31 +2794,14 @@ t_bool wlan_is_chan_passive(mlan_private *priv, t_u16 band, t_u8 chan)
 
 t_bool wlan_is_chan_disabled(mlan_private *priv, t_u16 band, t_u8 chan)
 {
-	int i, j;
 	t_bool disabled = MFALSE;
-	chan_freq_power_t *pcfp = MNULL;
+	chan_freq_power_t *cfp;
 
 	ENTER();
 
-	/* get the cfp table first */
-	for (i = 0; i < MAX_REGION_CHANNEL_NUM; i++) {
-		if (priv->adapter->region_channel[i].band & band) {
-			pcfp = priv->adapter->region_channel[i].pcfp;
-			break;
-		}
-	}
-
-	if (pcfp) {
-		/* check table according to chan num */
-		for (j = 0; j < priv->adapter->region_channel[i].num_cfp; j++) {
-			if (pcfp[j].channel == chan) {
-				if (pcfp[j].dynamic.flags &
-				    NXP_CHANNEL_DISABLED)
-					disabled = MTRUE;
-				break;
-			}
-		}
-	}
+	cfp = wlan_get_region_cfp_by_chan(priv->adapter, band, chan);
+	if (cfp && (cfp->dynamic.flags & NXP_CHANNEL_DISABLED))
+		disabled = MTRUE;
 
 	LEAVE();
 	return disabled;
@@ -2908,29 +2821,14 @@ t_bool wlan_is_chan_disabled(mlan_private *priv, t_u16 band, t_u8 chan)
 
 t_bool wlan_is_chan_blacklisted(mlan_private *priv, t_u16 band, t_u8 chan)
 {
-	int i, j;
 	t_bool blacklist = MFALSE;
-	chan_freq_power_t *pcfp = MNULL;
+	chan_freq_power_t *cfp;
 
 	ENTER();
 
-	/*get the cfp table first*/
-	for (i = 0; i < MAX_REGION_CHANNEL_NUM; i++) {
-		if (priv->adapter->region_channel[i].band & band) {
-			pcfp = priv->adapter->region_channel[i].pcfp;
-			break;
-		}
-	}
-
-	if (pcfp) {
-		/*check table according to chan num*/
-		for (j = 0; j < priv->adapter->region_channel[i].num_cfp; j++) {
-			if (pcfp[j].channel == chan) {
-				blacklist = pcfp[j].dynamic.blacklist;
-				break;
-			}
-		}
-	}
+	cfp = wlan_get_region_cfp_by_chan(priv->adapter, band, chan);
+	if (cfp)
+		blacklist = cfp->dynamic.blacklist;
 
 	LEAVE();
 	return blacklist;
@@ -2952,29 +2850,15 @@ t_bool wlan_is_chan_blacklisted(mlan_private *priv, t_u16 band, t_u8 chan)
 t_bool wlan_set_chan_blacklist(mlan_private *priv, t_u16 band, t_u8 chan,
 			       t_bool bl)
 {
-	int i, j;
 	t_bool set_bl = MFALSE;
-	chan_freq_power_t *pcfp = MNULL;
+	chan_freq_power_t *cfp;
 
 	ENTER();
 
-	/*get the cfp table first*/
-	for (i = 0; i < MAX_REGION_CHANNEL_NUM; i++) {
-		if (priv->adapter->region_channel[i].band & band) {
-			pcfp = priv->adapter->region_channel[i].pcfp;
-			break;
-		}
-	}
-
-	if (pcfp) {
-		/*check table according to chan num*/
-		for (j = 0; j < priv->adapter->region_channel[i].num_cfp; j++) {
-			if (pcfp[j].channel == chan) {
-				pcfp[j].dynamic.blacklist = bl;
-				set_bl = MTRUE;
-				break;
-			}
-		}
+	cfp = wlan_get_region_cfp_by_chan(priv->adapter, band, chan);
+	if (cfp) {
+		cfp->dynamic.blacklist = bl;
+		set_bl = MTRUE;
 	}
 
 	LEAVE();
@@ -2994,28 +2878,13 @@ t_bool wlan_set_chan_blacklist(mlan_private *priv, t_u16 band, t_u8 chan,
 t_void wlan_set_chan_dfs_state(mlan_private *priv, t_u16 band, t_u8 chan,
 			       dfs_state_t dfs_state)
 {
-	int i, j;
-	chan_freq_power_t *pcfp = MNULL;
+	chan_freq_power_t *cfp;
 
 	ENTER();
 
-	/*get the cfp table first*/
-	for (i = 0; i < MAX_REGION_CHANNEL_NUM; i++) {
-		if (priv->adapter->region_channel[i].band & band) {
-			pcfp = priv->adapter->region_channel[i].pcfp;
-			break;
-		}
-	}
-
-	if (pcfp) {
-		/*check table according to chan num*/
-		for (j = 0; j < priv->adapter->region_channel[i].num_cfp; j++) {
-			if (pcfp[j].channel == chan) {
-				pcfp[j].dynamic.dfs_state = dfs_state;
-				break;
-			}
-		}
-	}
+	cfp = wlan_get_region_cfp_by_chan(priv->adapter, band, chan);
+	if (cfp)
+		cfp->dynamic.dfs_state = dfs_state;
 
 	LEAVE();
 }
@@ -3031,29 +2900,14 @@ t_void wlan_set_chan_dfs_state(mlan_private *priv, t_u16 band, t_u8 chan,
  */
 dfs_state_t wlan_get_chan_dfs_state(mlan_private *priv, t_u16 band, t_u8 chan)
 {
-	int i, j;
-	chan_freq_power_t *pcfp = MNULL;
+	chan_freq_power_t *cfp;
 	dfs_state_t dfs_state = DFS_USABLE;
 
 	ENTER();
 
-	/*get the cfp table first*/
-	for (i = 0; i < MAX_REGION_CHANNEL_NUM; i++) {
-		if (priv->adapter->region_channel[i].band & band) {
-			pcfp = priv->adapter->region_channel[i].pcfp;
-			break;
-		}
-	}
-
-	if (pcfp) {
-		/*check table according to chan num*/
-		for (j = 0; j < priv->adapter->region_channel[i].num_cfp; j++) {
-			if (pcfp[j].channel == chan) {
-				dfs_state = pcfp[j].dynamic.dfs_state;
-				break;
-			}
-		}
-	}
+	cfp = wlan_get_region_cfp_by_chan(priv->adapter, band, chan);
+	if (cfp)
+		dfs_state = cfp->dynamic.dfs_state;
 
 	LEAVE();
 	return dfs_state;
@@ -3729,6 +3583,7 @@ void wlan_add_fw_cfp_tables(pmlan_private pmpriv, t_u8 *buf, t_u16 buf_left)
 		wlan_sort_cfp_otp_table(pmadapter);
 	wlan_set_otp_cfp_max_tx_pwr(pmadapter, MFALSE);
 out:
+	wlan_update_region_chan_idx(pmadapter, pmadapter->region_channel);
 	LEAVE();
 }
 
@@ -556,10 +556,11 @@ static t_void wlan_dump_info(mlan_adapter *pmadapter, t_u8 reason)
 	PRINTM(MERROR, "scan_processing = %d\n", pmadapter->scan_processing);
 	PRINTM(MERROR, "scan_state = 0x%x\n", pmadapter->scan_state);
 	PRINTM(MERROR, "bypass_pkt_count=%d\n",
-	       util_scalar_read(pmadapter->pmoal_handle,
-				&pmadapter->bypass_pkt_count,
-				pmadapter->callbacks.moal_spin_lock,
-				pmadapter->callbacks.moal_spin_unlock));
+	       util_scalar_atomic_read(pmadapter->pmoal_handle,
+				       &pmadapter->bypass_pkt_count,
+				       wlan_atomic_read_cb(pmadapter),
+				       pmadapter->callbacks.moal_spin_lock,
+				       pmadapter->callbacks.moal_spin_unlock));
 #ifdef SDIO
 	if (IS_SD(pmadapter->card_type)) {
 		mp_aggr_pkt_limit = pmadapter->pcard_sd->mp_aggr_pkt_limit;
@@ -937,6 +938,117 @@ static void wlan_init_cmd_node(pmlan_private pmpriv, cmd_ctrl_node *pcmd_node,
 	LEAVE();
 }
 
+/**
+ *  @brief This function frees an array of command nodes and the
+ *          buffers attached to them.
+ *
+ *  @param pmadapter    A pointer to mlan_adapter structure
+ *  @param pcmd_array   A pointer to cmd_ctrl_node array
+ *  @param num          Number of nodes in the array
+ *
+ *  @return             N/A
+ */
+static t_void wlan_free_cmd_nodes(mlan_adapter *pmadapter,
+				  cmd_ctrl_node *pcmd_array, t_u32 num)
+{
+	mlan_callbacks *pcb = (mlan_callbacks *)&pmadapter->callbacks;
+	t_u32 i;
+
+	ENTER();
+
+	for (i = 0; i < num; i++) {
+#ifdef USB
+		if (IS_USB(pmadapter->card_type) && pcmd_array[i].cmdbuf) {
+			PRINTM(MINFO, "Free all the USB command buffer.\n");
+			wlan_free_mlan_buffer(pmadapter, pcmd_array[i].cmdbuf);
+			pcmd_array[i].cmdbuf = MNULL;
+		}
+#endif
+#if defined(SDIO) || defined(PCIE)
+		if (!IS_USB(pmadapter->card_type) && pcmd_array[i].pmbuf) {
+			PRINTM(MINFO, "Free all the command buffer.\n");
+			wlan_free_mlan_buffer(pmadapter, pcmd_array[i].pmbuf);
+			pcmd_array[i].pmbuf = MNULL;
+		}
+#endif
+		if (pcmd_array[i].respbuf) {
+#ifdef USB
+			if (IS_USB(pmadapter->card_type))
+				pmadapter->callbacks.moal_recv_complete(
+					pmadapter->pmoal_handle,
+					pcmd_array[i].respbuf,
+					pmadapter->rx_cmd_ep,
+					MLAN_STATUS_SUCCESS);
+#endif
+#if defined(SDIO) || defined(PCIE)
+			if (!IS_USB(pmadapter->card_type))
+				wlan_free_mlan_buffer(pmadapter,
+						      pcmd_array[i].respbuf);
+#endif
+			pcmd_array[i].respbuf = MNULL;
+		}
+	}
+	pcb->moal_mfree(pmadapter->pmoal_handle, (t_u8 *)pcmd_array);
+
+	LEAVE();
+}
+
+/**
+ *  @brief This function allocates an array of command nodes together
+ *          with their command buffers.
+ *
+ *  @param pmadapter    A pointer to mlan_adapter structure
+ *  @param num          Number of nodes to allocate
+ *  @param ppcmd_array  A pointer to return the cmd_ctrl_node array
+ *
+ *  @return             MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status wlan_alloc_cmd_nodes(mlan_adapter *pmadapter, t_u32 num,
+					cmd_ctrl_node **ppcmd_array)
+{
+	mlan_status ret = MLAN_STATUS_SUCCESS;
+	mlan_callbacks *pcb = (mlan_callbacks *)&pmadapter->callbacks;
+	cmd_ctrl_node *pcmd_array = MNULL;
+#if defined(PCIE) || defined(SDIO)
+	t_u32 i;
+#endif
+
+	ENTER();
+
+	ret = pcb->moal_malloc(pmadapter->pmoal_handle,
+			       sizeof(cmd_ctrl_node) * num,
+			       MLAN_MEM_DEF | MLAN_MEM_DMA,
+			       (t_u8 **)&pcmd_array);
+	if (ret != MLAN_STATUS_SUCCESS || !pcmd_array) {
+		PRINTM(MERROR,
+		       "ALLOC_CMD_BUF: Failed to allocate pcmd_array\n");
+		ret = MLAN_STATUS_FAILURE;
+		goto done;
+	}
+
+#if defined(PCIE) || defined(SDIO)
+	if (!IS_USB(pmadapter->card_type)) {
+		/* Allocate and initialize command buffers */
+		for (i = 0; i < num; i++) {
+			pcmd_array[i].pmbuf = wlan_alloc_mlan_buffer(
+				pmadapter, MRVDRV_SIZE_OF_CMD_BUFFER, 0,
+				MOAL_MALLOC_BUFFER);
+			if (!pcmd_array[i].pmbuf) {
+				PRINTM(MERROR,
+				       "ALLOC_CMD_BUF: Failed to allocate command buffer\n");
+				wlan_free_cmd_nodes(pmadapter, pcmd_array, num);
+				ret = MLAN_STATUS_FAILURE;
+				goto done;
+			}
+		}
+	}
+#endif
+	*ppcmd_array = pcmd_array;
+done:
+	LEAVE();
+	return ret;
+}
+
 /**
  *  @brief This function gets a free command node if available in
  *              command free queue.
@@ -992,6 +1104,8 @@ static t_void wlan_clean_cmd_node(pmlan_adapter pmadapter,
 	pcmd_node->cmd_flag = 0;
 	pcmd_node->pioctl_buf = MNULL;
 	pcmd_node->pdata_buf = MNULL;
+	pcmd_node->pnext_ioctl = MNULL;
+	pcmd_node->in_ioctl_hash = MFALSE;
 
 #ifdef USB
 	if (IS_USB(pmadapter->card_type) && pcmd_node->cmdbuf) {
@@ -1010,6 +1124,85 @@ static t_void wlan_clean_cmd_node(pmlan_adapter pmadapter,
 	return;
 }
 
+/**
+ *  @brief This function returns the priority class of a command
+ *
+ *  @param command      Command id
+ *  @param action       Command action
+ *
+ *  @return             Command class
+ */
+static t_u8 wlan_get_cmd_class(t_u16 command, t_u16 action)
+{
+	switch (command) {
+	case HostCmd_CMD_802_11_PS_MODE_ENH:
+	case HostCmd_CMD_802_11_HS_CFG_ENH:
+		return CMD_CLASS_PS;
+	case HostCmd_CMD_11N_ADDBA_REQ:
+	case HostCmd_CMD_11N_ADDBA_RSP:
+	case HostCmd_CMD_11N_DELBA:
+	case HostCmd_CMD_802_11_KEY_MATERIAL:
+	case HostCmd_CMD_TX_RATE_CFG:
+	case HostCmd_CMD_RECONFIGURE_TX_BUFF:
+	case HostCmd_CMD_AMSDU_AGGR_CTRL:
+	case HostCmd_CMD_MAC_CONTROL:
+	case HostCmd_CMD_WMM_ADDTS_REQ:
+	case HostCmd_CMD_WMM_DELTS_REQ:
+		return CMD_CLASS_DATA;
+	default:
+		break;
+	}
+	if (action == HostCmd_ACT_GEN_GET)
+		return CMD_CLASS_GET;
+	return CMD_CLASS_MGMT;
+}
+
+/**
+ *  @brief This function returns a usec time stamp for queue statistics
+ *
+ *  @param pmadapter    A pointer to mlan_adapter
+ *
+ *  @return             Time stamp in usec, wraps around
+ */
+static t_u32 wlan_get_cmd_time_stamp(pmlan_adapter pmadapter)
+{
+	t_u32 sec = 0, usec = 0;
+
+	pmadapter->callbacks.moal_get_system_time(pmadapter->pmoal_handle,
+						  &sec, &usec);
+	return sec * 1000000 + usec;
+}
+
+/**
+ *  @brief This function removes a command node from cmd_pending_q,
+ *          the pending ioctl hash and the class queue depth.
+ *          Caller must hold cmd lock.
+ *
+ *  @param pmadapter    A pointer to mlan_adapter
+ *  @param pcmd_node    A pointer to cmd_ctrl_node
+ *
+ *  @return             N/A
+ */
+static t_void wlan_unlink_cmd_from_pending_q(pmlan_adapter pmadapter,
+					     cmd_ctrl_node *pcmd_node)
+{
+	cmd_ctrl_node **pp;
+
+	util_unlink_list(pmadapter->pmoal_handle, &pmadapter->cmd_pending_q,
+			 (pmlan_linked_list)pcmd_node, MNULL, MNULL);
+	if (pcmd_node->in_ioctl_hash) {
+		pp = &pmadapter->ioctl_cmd_hash[pcmd_node->ioctl_hash_idx];
+		while (*pp && *pp != pcmd_node)
+			pp = &(*pp)->pnext_ioctl;
+		if (*pp)
+			*pp = pcmd_node->pnext_ioctl;
+		pcmd_node->pnext_ioctl = MNULL;
+		pcmd_node->in_ioctl_hash = MFALSE;
+	}
+	if (pmadapter->cmd_stats[pcmd_node->cmd_class].queued)
+		pmadapter->cmd_stats[pcmd_node->cmd_class].queued--;
+}
+
 #ifdef STA_SUPPORT
 /**
  *  @brief This function will return the pointer to the first entry in
@@ -1060,20 +1253,13 @@ static cmd_ctrl_node *wlan_get_pending_ioctl_cmd(pmlan_adapter pmadapter,
 
 	ENTER();
 
-	pcmd_node = (cmd_ctrl_node *)util_peek_list(pmadapter->pmoal_handle,
-						    &pmadapter->cmd_pending_q,
-						    MNULL, MNULL);
-	if (!pcmd_node) {
-		LEAVE();
-		return MNULL;
-	}
-	while (pcmd_node != (cmd_ctrl_node *)&pmadapter->cmd_pending_q) {
-		if (pcmd_node->pioctl_buf &&
-		    (pcmd_node->pioctl_buf == pioctl_req)) {
+	pcmd_node = pmadapter->ioctl_cmd_hash[CMD_IOCTL_HASH(pioctl_req)];
+	while (pcmd_node) {
+		if (pcmd_node->pioctl_buf == pioctl_req) {
 			LEAVE();
 			return pcmd_node;
 		}
-		pcmd_node = pcmd_node->pnext;
+		pcmd_node = pcmd_node->pnext_ioctl;
 	}
 	LEAVE();
 	return MNULL;
@@ -1093,24 +1279,19 @@ static cmd_ctrl_node *wlan_get_bss_pending_ioctl_cmd(pmlan_adapter pmadapter,
 {
 	cmd_ctrl_node *pcmd_node = MNULL;
 	mlan_ioctl_req *pioctl_buf = MNULL;
+	t_u32 i;
 	ENTER();
 
-	pcmd_node = (cmd_ctrl_node *)util_peek_list(pmadapter->pmoal_handle,
-						    &pmadapter->cmd_pending_q,
-						    MNULL, MNULL);
-	if (!pcmd_node) {
-		LEAVE();
-		return MNULL;
-	}
-	while (pcmd_node != (cmd_ctrl_node *)&pmadapter->cmd_pending_q) {
-		if (pcmd_node->pioctl_buf) {
+	for (i = 0; i < CMD_IOCTL_HASH_SIZE; i++) {
+		pcmd_node = pmadapter->ioctl_cmd_hash[i];
+		while (pcmd_node) {
 			pioctl_buf = (mlan_ioctl_req *)pcmd_node->pioctl_buf;
-			if (pioctl_buf->bss_index == bss_index) {
+			if (pioctl_buf && pioctl_buf->bss_index == bss_index) {
 				LEAVE();
 				return pcmd_node;
 			}
+			pcmd_node = pcmd_node->pnext_ioctl;
 		}
-		pcmd_node = pcmd_node->pnext;
 	}
 	LEAVE();
 	return MNULL;
@@ -1627,7 +1808,8 @@ mlan_status wlan_recv_event(pmlan_private priv, mlan_event_id event_id,
 
 /**
  *  @brief This function allocates the command buffer and links
- *          it to command free queue.
+ *          it to command free queue. The whole bounded pool is
+ *          allocated here so the command path never allocates.
  *
  *  @param pmadapter    A pointer to mlan_adapter structure
  *
@@ -1636,45 +1818,24 @@ mlan_status wlan_recv_event(pmlan_private priv, mlan_event_id event_id,
 mlan_status wlan_alloc_cmd_buffer(mlan_adapter *pmadapter)
 {
 	mlan_status ret = MLAN_STATUS_SUCCESS;
-	mlan_callbacks *pcb = (mlan_callbacks *)&pmadapter->callbacks;
 	cmd_ctrl_node *pcmd_array = MNULL;
-	t_u32 buf_size;
 	t_u32 i;
 
 	ENTER();
 
 	/* Allocate and initialize cmd_ctrl_node */
-	buf_size = sizeof(cmd_ctrl_node) * MRVDRV_NUM_OF_CMD_BUFFER;
-	ret = pcb->moal_malloc(pmadapter->pmoal_handle, buf_size,
-			       MLAN_MEM_DEF | MLAN_MEM_DMA,
-			       (t_u8 **)&pcmd_array);
-	if (ret != MLAN_STATUS_SUCCESS || !pcmd_array) {
-		PRINTM(MERROR,
-		       "ALLOC_CMD_BUF: Failed to allocate pcmd_array\n");
-		ret = MLAN_STATUS_FAILURE;
+	ret = wlan_alloc_cmd_nodes(pmadapter, MRVDRV_CMD_POOL_SIZE,
+				   &pcmd_array);
+	if (ret != MLAN_STATUS_SUCCESS)
 		goto done;
-	}
 
 	pmadapter->cmd_pool = pcmd_array;
+	pmadapter->cmd_pool_size = MRVDRV_CMD_POOL_SIZE;
+	memset(pmadapter, pmadapter->cmd_stats, 0,
+	       sizeof(pmadapter->cmd_stats));
 
-#if defined(PCIE) || defined(SDIO)
-	if (!IS_USB(pmadapter->card_type)) {
-		/* Allocate and initialize command buffers */
-		for (i = 0; i < MRVDRV_NUM_OF_CMD_BUFFER; i++) {
-			pcmd_array[i].pmbuf = wlan_alloc_mlan_buffer(
-				pmadapter, MRVDRV_SIZE_OF_CMD_BUFFER, 0,
-				MOAL_MALLOC_BUFFER);
-			if (!pcmd_array[i].pmbuf) {
-				PRINTM(MERROR,
-				       "ALLOC_CMD_BUF: Failed to allocate command buffer\n");
-				ret = MLAN_STATUS_FAILURE;
-				goto done;
-			}
-		}
-	}
-#endif
 	wlan_request_cmd_lock(pmadapter);
-	for (i = 0; i < MRVDRV_NUM_OF_CMD_BUFFER; i++)
+	for (i = 0; i < MRVDRV_CMD_POOL_SIZE; i++)
 		wlan_insert_cmd_to_free_q(pmadapter, &pcmd_array[i]);
 	wlan_release_cmd_lock(pmadapter);
 	ret = MLAN_STATUS_SUCCESS;
@@ -1692,10 +1853,6 @@ done:
  */
 mlan_status wlan_free_cmd_buffer(mlan_adapter *pmadapter)
 {
-	mlan_callbacks *pcb = (mlan_callbacks *)&pmadapter->callbacks;
-	cmd_ctrl_node *pcmd_array;
-	t_u32 i;
-
 	ENTER();
 
 	/* Need to check if cmd pool is allocated or not */
@@ -1704,48 +1861,14 @@ mlan_status wlan_free_cmd_buffer(mlan_adapter *pmadapter)
 		goto done;
 	}
 
-	pcmd_array = pmadapter->cmd_pool;
-
-	/* Release shared memory buffers */
-	for (i = 0; i < MRVDRV_NUM_OF_CMD_BUFFER; i++) {
-#ifdef USB
-		if (IS_USB(pmadapter->card_type) && pcmd_array[i].cmdbuf) {
-			PRINTM(MINFO, "Free all the USB command buffer.\n");
-			wlan_free_mlan_buffer(pmadapter, pcmd_array[i].cmdbuf);
-			pcmd_array[i].cmdbuf = MNULL;
-		}
-#endif
-#if defined(SDIO) || defined(PCIE)
-		if (!IS_USB(pmadapter->card_type) && pcmd_array[i].pmbuf) {
-			PRINTM(MINFO, "Free all the command buffer.\n");
-			wlan_free_mlan_buffer(pmadapter, pcmd_array[i].pmbuf);
-			pcmd_array[i].pmbuf = MNULL;
-		}
-#endif
-		if (pcmd_array[i].respbuf) {
-#ifdef USB
-			if (IS_USB(pmadapter->card_type))
-				pmadapter->callbacks.moal_recv_complete(
-					pmadapter->pmoal_handle,
-					pcmd_array[i].respbuf,
-					pmadapter->rx_cmd_ep,
-					MLAN_STATUS_SUCCESS);
-#endif
-#if defined(SDIO) || defined(PCIE)
-			if (!IS_USB(pmadapter->card_type))
-				wlan_free_mlan_buffer(pmadapter,
-						      pcmd_array[i].respbuf);
-#endif
-			pcmd_array[i].respbuf = MNULL;
-		}
-	}
 	/* Release cmd_ctrl_node */
-	if (pmadapter->cmd_pool) {
-		PRINTM(MINFO, "Free command pool.\n");
-		pcb->moal_mfree(pmadapter->pmoal_handle,
-				(t_u8 *)pmadapter->cmd_pool);
-		pmadapter->cmd_pool = MNULL;
-	}
+	PRINTM(MINFO, "Free command pool.\n");
+	wlan_free_cmd_nodes(pmadapter, pmadapter->cmd_pool,
+			    MRVDRV_CMD_POOL_SIZE);
+	pmadapter->cmd_pool = MNULL;
+	pmadapter->cmd_pool_size = 0;
+	memset(pmadapter, pmadapter->cmd_stats, 0,
+	       sizeof(pmadapter->cmd_stats));
 
 done:
 	LEAVE();
@@ -2116,7 +2239,9 @@ t_void wlan_insert_cmd_to_pending_q(mlan_adapter *pmadapter,
 				    cmd_ctrl_node *pcmd_node, t_u32 add_tail)
 {
 	HostCmd_DS_COMMAND *pcmd = MNULL;
+	cmd_class_stats *pstats = MNULL;
 	t_u16 command;
+	t_u16 action;
 
 	ENTER();
 
@@ -2129,6 +2254,7 @@ t_void wlan_insert_cmd_to_pending_q(mlan_adapter *pmadapter,
 				      pcmd_node->cmdbuf->data_offset);
 
 	command = wlan_le16_to_cpu(pcmd->command);
+	action = wlan_le16_to_cpu(*(t_u16 *)((t_u8 *)pcmd + S_DS_GEN));
 
 	/* Exit_PS command needs to be queued in the header always. */
 	if (command == HostCmd_CMD_802_11_PS_MODE_ENH) {
@@ -2151,6 +2277,24 @@ t_void wlan_insert_cmd_to_pending_q(mlan_adapter *pmadapter,
 				       MNULL);
 	}
 
+	/* Index the node by its ioctl for cancel and lookup */
+	if (pcmd_node->pioctl_buf) {
+		pcmd_node->ioctl_hash_idx =
+			CMD_IOCTL_HASH(pcmd_node->pioctl_buf);
+		pcmd_node->pnext_ioctl =
+			pmadapter->ioctl_cmd_hash[pcmd_node->ioctl_hash_idx];
+		pmadapter->ioctl_cmd_hash[pcmd_node->ioctl_hash_idx] =
+			pcmd_node;
+		pcmd_node->in_ioctl_hash = MTRUE;
+	}
+
+	pcmd_node->cmd_class = wlan_get_cmd_class(command, action);
+	pcmd_node->queue_time = wlan_get_cmd_time_stamp(pmadapter);
+	pstats = &pmadapter->cmd_stats[pcmd_node->cmd_class];
+	pstats->queued++;
+	if (pstats->queued > pstats->max_queued)
+		pstats->max_queued = pstats->queued;
+
 	PRINTM_NETINTF(MCMND, pcmd_node->priv);
 	PRINTM(MCMND, "QUEUE_CMD: %s [0x%x] is queued\n",
 	       wlan_hostcmd_get_name(command), command);
@@ -2173,8 +2317,10 @@ mlan_status wlan_exec_next_cmd(mlan_adapter *pmadapter)
 {
 	mlan_private *priv = MNULL;
 	cmd_ctrl_node *pcmd_node = MNULL;
+	cmd_class_stats *pstats = MNULL;
 	mlan_status ret = MLAN_STATUS_SUCCESS;
 	HostCmd_DS_COMMAND *pcmd;
+	t_u32 wait;
 
 	ENTER();
 
@@ -2210,9 +2356,14 @@ mlan_status wlan_exec_next_cmd(mlan_adapter *pmadapter)
 			goto done;
 		}
 
-		util_unlink_list(pmadapter->pmoal_handle,
-				 &pmadapter->cmd_pending_q,
-				 (pmlan_linked_list)pcmd_node, MNULL, MNULL);
+		wlan_unlink_cmd_from_pending_q(pmadapter, pcmd_node);
+		wait = wlan_get_cmd_time_stamp(pmadapter) -
+		       pcmd_node->queue_time;
+		pstats = &pmadapter->cmd_stats[pcmd_node->cmd_class];
+		pstats->dispatched++;
+		pstats->total_wait += wait;
+		if (wait > pstats->max_wait)
+			pstats->max_wait = wait;
 		wlan_release_cmd_lock(pmadapter);
 		ret = wlan_dnld_cmd_to_fw(priv, pcmd_node);
 		priv = wlan_get_priv(pmadapter, MLAN_BSS_ROLE_ANY);
@@ -2747,9 +2898,7 @@ mlan_status wlan_cancel_pending_scan_cmd(pmlan_adapter pmadapter,
 	while ((pcmd_node = wlan_get_pending_scan_cmd(pmadapter)) != MNULL) {
 		PRINTM(MIOCTL,
 		       "wlan_cancel_scan: find scan command in cmd_pending_q\n");
-		util_unlink_list(pmadapter->pmoal_handle,
-				 &pmadapter->cmd_pending_q,
-				 (pmlan_linked_list)pcmd_node, MNULL, MNULL);
+		wlan_unlink_cmd_from_pending_q(pmadapter, pcmd_node);
 		wlan_insert_cmd_to_free_q(pmadapter, pcmd_node);
 	}
 	wlan_release_cmd_lock(pmadapter);
@@ -2832,9 +2981,7 @@ t_void wlan_cancel_all_pending_cmd(pmlan_adapter pmadapter, t_u8 flag)
 	while ((pcmd_node = (cmd_ctrl_node *)util_peek_list(
 			pmadapter->pmoal_handle, &pmadapter->cmd_pending_q,
 			MNULL, MNULL))) {
-		util_unlink_list(pmadapter->pmoal_handle,
-				 &pmadapter->cmd_pending_q,
-				 (pmlan_linked_list)pcmd_node, MNULL, MNULL);
+		wlan_unlink_cmd_from_pending_q(pmadapter, pcmd_node);
 		if (pcmd_node->pioctl_buf) {
 			pioctl_buf = (mlan_ioctl_req *)pcmd_node->pioctl_buf;
 			pioctl_buf->status_code = MLAN_ERROR_CMD_CANCEL;
@@ -2908,9 +3055,7 @@ t_void wlan_cancel_bss_pending_cmd(pmlan_adapter pmadapter, t_u32 bss_index)
 	}
 	while ((pcmd_node = wlan_get_bss_pending_ioctl_cmd(
 			pmadapter, bss_index)) != MNULL) {
-		util_unlink_list(pmadapter->pmoal_handle,
-				 &pmadapter->cmd_pending_q,
-				 (pmlan_linked_list)pcmd_node, MNULL, MNULL);
+		wlan_unlink_cmd_from_pending_q(pmadapter, pcmd_node);
 		pioctl_buf = (mlan_ioctl_req *)pcmd_node->pioctl_buf;
 		pcmd_node->pioctl_buf = MNULL;
 #ifdef STA_SUPPORT
@@ -2992,9 +3137,7 @@ t_void wlan_cancel_pending_ioctl(pmlan_adapter pmadapter,
 
 	while ((pcmd_node = wlan_get_pending_ioctl_cmd(pmadapter,
 						       pioctl_req)) != MNULL) {
-		util_unlink_list(pmadapter->pmoal_handle,
-				 &pmadapter->cmd_pending_q,
-				 (pmlan_linked_list)pcmd_node, MNULL, MNULL);
+		wlan_unlink_cmd_from_pending_q(pmadapter, pcmd_node);
 		pcmd_node->pioctl_buf = MNULL;
 		find = MTRUE;
 		wlan_insert_cmd_to_free_q(pmadapter, pcmd_node);
@@ -5700,53 +5843,42 @@ mlan_status wlan_process_vdll_event(pmlan_private pmpriv, pmlan_buffer pevent)
  *  @brief This function handle the csi event
  *
  *  @param pmpriv       A pointer to mlan_private structure
+ *  @param pevent       A pointer to the event buffer of the caller, with
+ *                      room for MAX_EVENT_SIZE bytes of event_buf
  *
- *  @return             MLAN_STATUS_SUCCESS
+ *  @return             MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
  */
-mlan_status wlan_process_csi_event(pmlan_private pmpriv)
+mlan_status wlan_process_csi_event(pmlan_private pmpriv, pmlan_event pevent)
 {
 	pmlan_adapter pmadapter = pmpriv->adapter;
-	mlan_status status;
+	mlan_status status = MLAN_STATUS_SUCCESS;
 	t_u32 eventcause = pmadapter->event_cause;
-	t_u8 *evt_buf = MNULL;
 	pmlan_buffer pmbuf = pmadapter->pmlan_buffer_event;
-	pmlan_callbacks pcb = &pmadapter->callbacks;
-	pmlan_event pevent;
+	pcsi_record_ds csi_record;
+	t_u16 csi_sig;
 
 	ENTER();
 
-	/* Allocate memory for event buffer */
-	status = pcb->moal_malloc(pmadapter->pmoal_handle, MAX_EVENT_SIZE,
-				  MLAN_MEM_DEF, &evt_buf);
-	if ((status == MLAN_STATUS_SUCCESS) && evt_buf) {
-		t_u16 csi_sig;
-		pcsi_record_ds csi_record =
-			(pcsi_record_ds)(pmbuf->pbuf + pmbuf->data_offset +
-					 sizeof(eventcause));
-		/* Check CSI signature */
-		csi_sig = csi_record->CSI_Sign;
-		if (csi_sig != CSI_SIGNATURE) {
-			PRINTM(MERROR,
-			       "Wrong CSI signature 0x%04x. Should be 0x%04x",
-			       csi_sig, CSI_SIGNATURE);
-			status = MLAN_STATUS_FAILURE;
-		} else {
-			/* Send event to moal */
-			pevent = (pmlan_event)evt_buf;
-			pevent->bss_index = pmpriv->bss_index;
-			pevent->event_id = MLAN_EVENT_ID_CSI;
-			/* Event length is the CSI record length in byte */
-			pevent->event_len = csi_record->Len * 4;
-			if (pevent->event_len >
-			    pmbuf->data_len - sizeof(eventcause))
-				pevent->event_len =
-					pmbuf->data_len - sizeof(eventcause);
-			memcpy_ext(pmadapter, (t_u8 *)pevent->event_buf,
-				   csi_record, pevent->event_len,
-				   pevent->event_len);
-			wlan_recv_event(pmpriv, pevent->event_id, pevent);
-		}
-		pcb->moal_mfree(pmadapter->pmoal_handle, evt_buf);
+	csi_record = (pcsi_record_ds)(pmbuf->pbuf + pmbuf->data_offset +
+				      sizeof(eventcause));
+	/* Check CSI signature */
+	csi_sig = csi_record->CSI_Sign;
+	if (csi_sig != CSI_SIGNATURE) {
+		PRINTM(MERROR, "Wrong CSI signature 0x%04x. Should be 0x%04x",
+		       csi_sig, CSI_SIGNATURE);
+		status = MLAN_STATUS_FAILURE;
+	} else {
+		/* Send event to moal */
+		pevent->bss_index = pmpriv->bss_index;
+		pevent->event_id = MLAN_EVENT_ID_CSI;
+		/* Event length is the CSI record length in byte */
+		pevent->event_len = csi_record->Len * 4;
+		if (pevent->event_len > pmbuf->data_len - sizeof(eventcause))
+			pevent->event_len =
+				pmbuf->data_len - sizeof(eventcause);
+		memcpy_ext(pmadapter, (t_u8 *)pevent->event_buf, csi_record,
+			   pevent->event_len, MAX_EVENT_SIZE);
+		wlan_recv_event(pmpriv, pevent->event_id, pevent);
 	}
 
 	LEAVE();
@@ -11296,8 +11428,7 @@ mlan_status wlan_ret_sta_tx_rate(pmlan_private pmpriv, HostCmd_DS_COMMAND *resp,
 	const t_s32 entry_size = sizeof(info->entry[0]);
 	t_s32 size = resp->size - S_DS_GEN;
 
-	pmadapter->callbacks.moal_spin_lock(pmadapter->pmoal_handle,
-					    pmpriv->wmm.ra_list_spinlock);
+	wlan_spin_lock(pmadapter, pmpriv->wmm.ra_list_spinlock);
 
 	for (i = 0; i < NELEMENTS(info->entry) && size >= entry_size;
 	     i++, size -= entry_size) {
@@ -11305,8 +11436,7 @@ mlan_status wlan_ret_sta_tx_rate(pmlan_private pmpriv, HostCmd_DS_COMMAND *resp,
 					    &info->entry[i].rate);
 	}
 
-	pmadapter->callbacks.moal_spin_unlock(pmadapter->pmoal_handle,
-					      pmpriv->wmm.ra_list_spinlock);
+	wlan_spin_unlock(pmadapter, pmpriv->wmm.ra_list_spinlock);
 
 	return MLAN_STATUS_SUCCESS;
 }
@@ -1264,6 +1264,11 @@ typedef enum _ENH_PS_MODES {
 /** Buffer Constants */
 /** Number of command buffers */
 #define MRVDRV_NUM_OF_CMD_BUFFER 40
+/** Number of spare command buffers for command bursts */
+#define MRVDRV_CMD_POOL_RESERVE 20
+/** Total number of command buffers allocated at init */
+#define MRVDRV_CMD_POOL_SIZE                                                   \
+	(MRVDRV_NUM_OF_CMD_BUFFER + MRVDRV_CMD_POOL_RESERVE)
 /** Maximum number of BSS Descriptors */
 #define MRVDRV_MAX_BSSID_LIST 200
 
@@ -654,6 +654,8 @@ t_void wlan_init_adapter(pmlan_adapter pmadapter)
 	pmadapter->delay_task_flag = MFALSE;
 	pmadapter->data_sent = MFALSE;
 	pmadapter->data_sent_cnt = 0;
+	memset(pmadapter, pmadapter->cmd_stats, 0,
+	       sizeof(pmadapter->cmd_stats));
 
 #ifdef SDIO
 	if (IS_SD(pmadapter->card_type)) {
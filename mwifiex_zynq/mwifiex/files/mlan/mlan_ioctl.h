@@ -2289,6 +2289,8 @@ typedef struct {
 
 /** Debug command number */
 #define DBG_CMD_NUM 10
+/** Number of command priority classes */
+#define MLAN_CMD_CLASS_NUM 4
 
 #ifdef SDIO
 /** sdio mp debug number */
@@ -2318,6 +2320,26 @@ typedef struct _tdls_peer_info {
 	t_u8 he_cap[IEEE_MAX_IE_SIZE];
 } tdls_peer_info;
 
+/** Maximum stations in the debug info station counters */
+#define MLAN_MAX_STA_STATS MAX_STA_COUNT
+/** Station host counters */
+typedef struct _sta_stats_info {
+	/** station mac address */
+	t_u8 mac_addr[MLAN_MAC_ADDR_LENGTH];
+	/** SNR */
+	t_s8 snr;
+	/** Noise Floor */
+	t_s8 nf;
+	/** station stats */
+	sta_stats stats;
+	/** tx packets dropped by AQM */
+	t_u32 tx_aqm_drops;
+	/** tx packets ECN marked by AQM */
+	t_u32 tx_aqm_marks;
+	/** times the station queue limit stopped the AC queue */
+	t_u32 tx_aqm_overlimit;
+} sta_stats_info;
+
 /** max ralist num */
 #define MLAN_MAX_RALIST_NUM 8
 /** ralist info */
@@ -2360,6 +2382,14 @@ typedef struct _mlan_debug_info {
 	t_u32 tdls_peer_num;
 	/** TDLS peer list*/
 	tdls_peer_info tdls_peer_list[MLAN_MAX_TDLS_PEER_SUPPORTED];
+	/** Caller buffer for the station counters, MNULL to skip them */
+	sta_stats_info *psta_stats_list;
+	/** Number of entries in psta_stats_list */
+	t_u32 sta_stats_max;
+	/** Number of stations filled in psta_stats_list */
+	t_u32 sta_stats_num;
+	/** Station list generation, changes on station add and delete */
+	t_u32 sta_list_gen;
 	/** ralist num */
 	t_u32 ralist_num;
 	/** ralist info */
@@ -2529,6 +2559,18 @@ typedef struct _mlan_debug_info {
 	t_u16 pending_cmd;
 	/** time stamp for dnld last cmd */
 	t_u32 dnld_cmd_in_secs;
+	/** Number of command nodes in the pool */
+	t_u32 cmd_pool_size;
+	/** Commands currently pending, per class */
+	t_u32 cmd_class_queued[MLAN_CMD_CLASS_NUM];
+	/** Peak pending commands, per class */
+	t_u32 cmd_class_max_queued[MLAN_CMD_CLASS_NUM];
+	/** Commands sent to firmware, per class */
+	t_u32 cmd_class_dispatched[MLAN_CMD_CLASS_NUM];
+	/** Average pending time in usec, per class */
+	t_u32 cmd_class_avg_wait[MLAN_CMD_CLASS_NUM];
+	/** Longest pending time in usec, per class */
+	t_u32 cmd_class_max_wait[MLAN_CMD_CLASS_NUM];
 	/** Corresponds to data_sent member of mlan_adapter */
 	t_u8 data_sent;
 	/** Corresponds to data_sent_cnt member of mlan_adapter */
@@ -2582,6 +2624,14 @@ typedef struct _mlan_debug_info {
 	t_u16 num_bridge_pkts;
 	/**  dropped pkts */
 	t_u32 num_drop_pkts;
+	/**  intra-BSS pkts forwarded from the rx buffer */
+	t_u32 num_bridge_zcopy;
+	/**  intra-BSS pkts forwarded through a copy */
+	t_u32 num_bridge_copy;
+	/**  average intra-BSS forward latency in usec */
+	t_u32 bridge_fwd_lat_avg;
+	/**  max intra-BSS forward latency in usec */
+	t_u32 bridge_fwd_lat_max;
 #endif
 	/** FW hang report */
 	t_u8 fw_hang_report;
@@ -30,6 +30,10 @@ Change log:
 #ifndef _MLAN_MAIN_H_
 #define _MLAN_MAIN_H_
 
+#if defined(MLAN_INLINE_OS) || defined(MLAN_TRACE)
+#include "mlan_os.h"
+#endif
+
 
 #define STA_SUPPORT 1 
 
@@ -165,6 +169,23 @@ extern t_u32 mlan_drvdbg;
 			print_callback(MNULL, MSCH_D, msg);                    \
 	} while (0)
 
+#ifdef MLAN_TRACE
+/* The data path levels go to the trace ring, one NOP while disabled.
+ * MENTRY and MINFO stay compiled out below DEBUG_LEVEL2 */
+#undef PRINTM_MINTR
+#undef PRINTM_MDATA
+#undef PRINTM_MDAT_D
+#ifdef DEBUG_LEVEL2
+#undef PRINTM_MENTRY
+#undef PRINTM_MINFO
+#define PRINTM_MENTRY(msg...) MLAN_TRACE_LOG(MENTRY, msg)
+#define PRINTM_MINFO(msg...) MLAN_TRACE_LOG(MINFO, msg)
+#endif
+#define PRINTM_MINTR(msg...) MLAN_TRACE_LOG(MINTR, msg)
+#define PRINTM_MDATA(msg...) MLAN_TRACE_LOG(MDATA, msg)
+#define PRINTM_MDAT_D(msg...) MLAN_TRACE_LOG(MDAT_D, msg)
+#endif /* MLAN_TRACE */
+
 #define PRINTM(level, msg...) PRINTM_##level((char *)msg)
 
 /** Log debug message */
@@ -243,20 +264,39 @@ extern t_u32 mlan_drvdbg;
 #ifdef memset
 #undef memset
 #endif
-/** Memset routine */
-#define memset(adapter, s, c, len)                                             \
-	(adapter->callbacks.moal_memset(adapter->pmoal_handle, s, c, len))
-
 #ifdef memmove
 #undef memmove
 #endif
-/** Memmove routine */
-#define memmove(adapter, dest, src, len)                                       \
-	(adapter->callbacks.moal_memmove(adapter->pmoal_handle, dest, src, len))
-
 #ifdef memcpy
 #undef memcpy
 #endif
+#ifdef memcmp
+#undef memcmp
+#endif
+
+#ifdef MLAN_INLINE_OS
+/** Memset routine */
+#define memset(adapter, s, c, len)                                             \
+	(mlan_os_memset(adapter->pmoal_handle, s, c, len))
+/** Memmove routine */
+#define memmove(adapter, dest, src, len)                                       \
+	(mlan_os_memmove(adapter->pmoal_handle, dest, src, len))
+/** Memcpy routine */
+#define memcpy(adapter, to, from, len)                                         \
+	(mlan_os_memcpy(adapter->pmoal_handle, to, from, len))
+/* memcpy_ext rountine */
+#define memcpy_ext(adapter, to, from, len, size)                               \
+	(mlan_os_memcpy_ext(adapter->pmoal_handle, to, from, len, size))
+/** Memcmp routine */
+#define memcmp(adapter, s1, s2, len)                                           \
+	(mlan_os_memcmp(adapter->pmoal_handle, s1, s2, len))
+#else
+/** Memset routine */
+#define memset(adapter, s, c, len)                                             \
+	(adapter->callbacks.moal_memset(adapter->pmoal_handle, s, c, len))
+/** Memmove routine */
+#define memmove(adapter, dest, src, len)                                       \
+	(adapter->callbacks.moal_memmove(adapter->pmoal_handle, dest, src, len))
 /** Memcpy routine */
 #define memcpy(adapter, to, from, len)                                         \
 	(adapter->callbacks.moal_memcpy(adapter->pmoal_handle, to, from, len))
@@ -264,13 +304,31 @@ extern t_u32 mlan_drvdbg;
 #define memcpy_ext(adapter, to, from, len, size)                               \
 	(adapter->callbacks.moal_memcpy_ext(adapter->pmoal_handle, to, from,   \
 					    len, size))
-
-#ifdef memcmp
-#undef memcmp
-#endif
 /** Memcmp routine */
 #define memcmp(adapter, s1, s2, len)                                           \
 	(adapter->callbacks.moal_memcmp(adapter->pmoal_handle, s1, s2, len))
+#endif /* MLAN_INLINE_OS */
+
+#ifdef MLAN_INLINE_OS
+/** Spin lock handlers passed to the util list helpers */
+#define wlan_lock_cb(adapter) (mlan_os_spin_lock)
+#define wlan_unlock_cb(adapter) (mlan_os_spin_unlock)
+/** Atomic handlers passed to the util_scalar_atomic helpers */
+#define wlan_atomic_add_cb(adapter) (mlan_os_atomic_add)
+#define wlan_atomic_sub_cb(adapter) (mlan_os_atomic_sub)
+#define wlan_atomic_read_cb(adapter) (mlan_os_atomic_read)
+#define wlan_atomic_cmpxchg_cb(adapter) (mlan_os_atomic_cmpxchg)
+#else
+/** Spin lock handlers passed to the util list helpers */
+#define wlan_lock_cb(adapter) ((adapter)->callbacks.moal_spin_lock)
+#define wlan_unlock_cb(adapter) ((adapter)->callbacks.moal_spin_unlock)
+/** Atomic handlers passed to the util_scalar_atomic helpers */
+#define wlan_atomic_add_cb(adapter) ((adapter)->callbacks.moal_atomic_add)
+#define wlan_atomic_sub_cb(adapter) ((adapter)->callbacks.moal_atomic_sub)
+#define wlan_atomic_read_cb(adapter) ((adapter)->callbacks.moal_atomic_read)
+#define wlan_atomic_cmpxchg_cb(adapter)                                        \
+	((adapter)->callbacks.moal_atomic_cmpxchg)
+#endif
 
 /** Find number of elements */
 #ifndef NELEMENTS
@@ -806,6 +864,22 @@ struct _raListTbl {
 	t_u8 queue;
 	struct wmm_sta_table *sta;
 	mlan_linked_list pending_txq_entry;
+
+	/** CoDel state */
+	struct {
+		/** Time the sojourn time stays above target until, in usec */
+		t_u64 first_above_us;
+		/** Time of the next drop, in usec */
+		t_u64 drop_next_us;
+		/** Drops since entering the dropping state */
+		t_u32 count;
+		/** count when the dropping state was last left */
+		t_u32 lastcount;
+		/** In dropping state */
+		t_u8 dropping;
+		/** Kernel queues this list stopped over tx_aqm_limit */
+		t_u8 stop_mask;
+	} aqm;
 };
 
 /** TID table */
@@ -850,6 +924,14 @@ struct wmm_sta_table {
 		t_u32 queue_packets;
 		t_s32 bytes[MAX_NUM_TID];
 		t_s32 mpdus[MAX_NUM_TID];
+		/** Charge estimated airtime instead of bytes */
+		t_bool airtime;
+		/** Preamble, SIFS and ACK of a PPDU with one MPDU in usec */
+		t_u16 ppdu_overhead_us;
+		/** Preamble, SIFS and BlockAck of an A-MPDU in usec */
+		t_u16 ampdu_overhead_us;
+		/** Airtime deficit in usec */
+		t_s32 airtime_us[MAX_NUM_TID];
 	} budget;
 };
 
@@ -915,6 +997,10 @@ typedef struct _wmm_desc {
 	raListTbl *selected_ra_list;
 	t_u64 next_rate_update;
 	t_bool is_rate_update_pending;
+	/** Kernel queues stopped by an RA list over tx_aqm_limit */
+	t_u8 aqm_stop;
+	/** Kernel queues released on dequeue, MOAL not told yet */
+	t_u8 aqm_wake;
 
 } wmm_desc_t;
 
@@ -1016,6 +1102,19 @@ typedef struct _region_chan_t {
 	chan_freq_power_t *pcfp;
 } region_chan_t;
 
+/** Size of the direct-indexed channel lookup table */
+#define MAX_CFP_CHAN_IDX 256
+
+/** Channel to chan_freq_power_t lookup for a region_chan_t array */
+typedef struct _region_chan_idx_t {
+	/** pcfp each lookup row was built from */
+	chan_freq_power_t *pcfp[MAX_REGION_CHANNEL_NUM];
+	/** num_cfp each lookup row was built from */
+	t_u8 num_cfp[MAX_REGION_CHANNEL_NUM];
+	/** Index + 1 of the channel in pcfp, 0 if not present */
+	t_u8 idx[MAX_REGION_CHANNEL_NUM][MAX_CFP_CHAN_IDX];
+} region_chan_idx_t;
+
 /** State of 11d */
 typedef enum _state_11d_t {
 	DISABLE_11D = 0,
@@ -1311,6 +1410,8 @@ typedef struct _mlan_private {
 	t_u8 osen_ie_len;
 	/** Pointer to the station table */
 	mlan_list_head sta_list;
+	/** Bumped on every station add and delete */
+	t_u32 sta_list_gen;
 	/** tdls pending queue */
 	mlan_list_head tdls_pending_txq;
 	t_u16 tdls_idle_time;
@@ -1536,6 +1637,39 @@ struct _mlan_bssprio_tbl {
 	mlan_bssprio_node *bssprio_cur;
 };
 
+/** Command priority class */
+typedef enum _cmd_class_e {
+	/** Power save and host sleep control */
+	CMD_CLASS_PS = 0,
+	/** Data path control: BA setup, keys, rate and tx buffer config */
+	CMD_CLASS_DATA,
+	/** Other set commands */
+	CMD_CLASS_MGMT,
+	/** Get/info queries */
+	CMD_CLASS_GET,
+} cmd_class_e;
+
+/** Per class statistics of cmd_pending_q */
+typedef struct _cmd_class_stats {
+	/** Commands currently in cmd_pending_q */
+	t_u32 queued;
+	/** Peak of queued */
+	t_u32 max_queued;
+	/** Commands sent to firmware */
+	t_u32 dispatched;
+	/** Sum of time in cmd_pending_q of dispatched commands (usec) */
+	t_u64 total_wait;
+	/** Longest time in cmd_pending_q (usec) */
+	t_u32 max_wait;
+} cmd_class_stats;
+
+/** Number of buckets of the pending ioctl command hash */
+#define CMD_IOCTL_HASH_SIZE 16
+/** Bucket of pending ioctl command hash */
+#define CMD_IOCTL_HASH(pioctl)                                                 \
+	((((t_ptr)(pioctl) >> 4) ^ ((t_ptr)(pioctl) >> 8)) &                   \
+	 (CMD_IOCTL_HASH_SIZE - 1))
+
 /** cmd_ctrl_node */
 typedef struct _cmd_ctrl_node cmd_ctrl_node;
 
@@ -1563,6 +1697,16 @@ struct _cmd_ctrl_node {
 	/** pre_allocated mlan_buffer for cmd */
 	mlan_buffer *pmbuf;
 #endif
+	/** Next node in the same pending ioctl hash bucket */
+	cmd_ctrl_node *pnext_ioctl;
+	/** Pending ioctl hash bucket, valid when in_ioctl_hash is set */
+	t_u8 ioctl_hash_idx;
+	/** Node is linked in the pending ioctl hash */
+	t_u8 in_ioctl_hash;
+	/** Command priority class */
+	t_u8 cmd_class;
+	/** Time the node entered cmd_pending_q (usec) */
+	t_u32 queue_time;
 };
 
 /** default tdls wmm qosinfo */
@@ -1657,6 +1801,12 @@ struct _sta_node {
 	/** station band mode */
 	t_u16 bandmode;
 	sta_stats stats;
+	/** tx packets dropped by AQM */
+	t_u32 tx_aqm_drops;
+	/** tx packets ECN marked by AQM */
+	t_u32 tx_aqm_marks;
+	/** times the station queue limit stopped the AC queue */
+	t_u32 tx_aqm_overlimit;
 	/** station aid */
 	t_u16 aid;
 	/** apple device based on OUI in assoc req */
@@ -2632,6 +2782,12 @@ struct _mlan_adapter {
 	t_u16 seq_num;
 	/** Command controller nodes */
 	cmd_ctrl_node *cmd_pool;
+	/** Total number of command controller nodes */
+	t_u32 cmd_pool_size;
+	/** Pending command nodes with an ioctl, hashed by ioctl pointer */
+	cmd_ctrl_node *ioctl_cmd_hash[CMD_IOCTL_HASH_SIZE];
+	/** Per class statistics of cmd_pending_q */
+	cmd_class_stats cmd_stats[MLAN_CMD_CLASS_NUM];
 	/** Current Command */
 	cmd_ctrl_node *curr_cmd;
 	/** mlan_lock for command */
@@ -2691,6 +2847,8 @@ struct _mlan_adapter {
 	t_u16 region_code;
 	/** Region Channel data */
 	region_chan_t region_channel[MAX_REGION_CHANNEL_NUM];
+	/** Channel lookup table for region_channel */
+	region_chan_idx_t region_chan_idx;
 	/** CFP table code for 2.4GHz */
 	t_u8 cfp_code_bg;
 	/** CFP table code for 5GHz */
@@ -2701,6 +2859,8 @@ struct _mlan_adapter {
 #ifdef STA_SUPPORT
 	/** Universal Channel data */
 	region_chan_t universal_channel[MAX_REGION_CHANNEL_NUM];
+	/** Channel lookup table for universal_channel */
+	region_chan_idx_t universal_chan_idx;
 	/** Parsed region channel */
 	parsed_region_chan_11d_t parsed_region_chan;
 #endif /* STA_SUPPORT */
@@ -2924,6 +3084,16 @@ struct _mlan_adapter {
 
 	/** RX pending for forwarding packets */
 	mlan_scalar pending_bridge_pkts;
+	/** intra-BSS packets forwarded from the rx buffer */
+	t_u32 bridge_zcopy_pkts;
+	/** intra-BSS packets forwarded through a copy */
+	t_u32 bridge_copy_pkts;
+	/** forwarded packets sent to firmware */
+	t_u32 bridge_fwd_done;
+	/** total queue-to-completion latency of forwarded packets, usec */
+	t_u64 bridge_fwd_lat;
+	/** max queue-to-completion latency of forwarded packets, usec */
+	t_u32 bridge_fwd_lat_max;
 
 #ifdef STA_SUPPORT
 	/** ARP filter buffer */
@@ -3014,10 +3184,29 @@ struct _mlan_adapter {
 	t_u32 tp_state_on;
 	/** Packet drop point */
 	t_u32 tp_state_drop_point;
+	/** RX latency trace on/off */
+	t_u8 rx_lat_on;
+	/** Boot time in ns of the first interrupt not yet serviced */
+	t_u64 rx_lat_irq_ts;
+	/** Boot time in ns of the interrupt the bus reads are serving */
+	t_u64 rx_lat_cur_irq_ts;
+	/** Data path lock operations since the last tp accounting report,
+	 *  updated with the atomic scalar helpers only */
+	mlan_scalar tp_lock_ops;
 	/** second mac flag */
 	t_u8 second_mac;
 	/** napi */
 	t_u8 napi;
+	/** AMSDU zero-copy deaggregation mode, RX_AMSDU_ZCOPY_* */
+	t_u8 rx_amsdu_zcopy;
+	/** Forward intra-BSS uAP multicast and AMSDU subframes in place */
+	t_u8 uap_fwd_zcopy;
+	/** CoDel queue management on RA lists */
+	t_u8 tx_aqm;
+	/** Packets one RA list may hold when tx_aqm is on */
+	t_u32 tx_aqm_limit;
+	/** Some interface has aqm_wake set */
+	t_u8 tx_aqm_wake;
 	/* lower 8 bytes of uuid */
 	t_u64 uuid_lo;
 
@@ -3129,6 +3318,8 @@ typedef MLAN_PACK_START struct {
 #define MLAN_ETHER_PKT_TYPE_WAPI (0x88B4)
 /** Ethernet packet type for IP */
 #define MLAN_ETHER_PKT_TYPE_IP (0x0800)
+/** Ethernet packet type for IPv6 */
+#define MLAN_ETHER_PKT_TYPE_IPV6 (0x86DD)
 /** Ethernet packet type for 1905.1a (EASYMESH) */
 #define MLAN_ETHER_PKT_TYPE_1905 (0x893a)
 /** Ethernet packet type offset */
@@ -3290,7 +3481,7 @@ mlan_status wlan_misc_ssu(pmlan_adapter pmadapter, pmlan_ioctl_req pioctl_req);
 mlan_status wlan_misc_csi(pmlan_adapter pmadapter, pmlan_ioctl_req pioctl_req);
 mlan_status wlan_cmd_csi(pmlan_private pmpriv, HostCmd_DS_COMMAND *cmd,
 			 t_u16 cmd_action, t_u16 *pdata_buf);
-mlan_status wlan_process_csi_event(pmlan_private pmpriv);
+mlan_status wlan_process_csi_event(pmlan_private pmpriv, pmlan_event pevent);
 
 mlan_status wlan_misc_hal_phy_cfg(pmlan_adapter pmadapter,
 				  pmlan_ioctl_req pioctl_req);
@@ -3302,6 +3493,7 @@ mlan_status wlan_find_bss(mlan_private *pmpriv, pmlan_ioctl_req pioctl_req);
 void mlan_block_main_process(mlan_adapter *pmadapter, t_u8 block);
 /* block rx process */
 void mlan_block_rx_process(mlan_adapter *pmadapter, t_u8 block);
+t_u8 wlan_rx_pending_pause(mlan_adapter *pmadapter, t_u32 *pflag);
 /** check pending command */
 int wlan_check_pending_cmd(mlan_adapter *pmadapter);
 /** Allocate memory for adapter structure members */
@@ -3873,6 +4065,9 @@ mlan_status wlan_ret_802_11_bgscan_query(mlan_private *pmpriv,
 					 HostCmd_DS_COMMAND *resp,
 					 mlan_ioctl_req *pioctl_buf);
 
+/** Rebuild the channel lookup table of a region channel array */
+t_void wlan_update_region_chan_idx(pmlan_adapter pmadapter,
+				   region_chan_t *region_channel);
 /** Get Channel-Frequency-Power by band and channel */
 chan_freq_power_t *
 wlan_get_cfp_by_band_and_channel(pmlan_adapter pmadapter, t_u16 band,
@@ -3910,6 +4105,8 @@ t_u32 wlan_get_supported_rates(mlan_private *pmpriv, t_u32 bss_mode,
 			       t_u16 config_bands, WLAN_802_11_RATES rates);
 /** Convert data rate to index */
 t_u8 wlan_data_rate_to_index(pmlan_adapter pmadapter, t_u32 rate);
+/** Build the table used by wlan_data_rate_to_index */
+t_void wlan_init_data_rate_index(t_void);
 /** Check if rate is auto */
 t_u8 wlan_is_rate_auto(mlan_private *pmpriv);
 /** Get rate index */
@@ -4347,6 +4544,8 @@ mlan_status wlan_ret_802_11_mac_address(pmlan_private pmpriv,
 					mlan_ioctl_req *pioctl_buf);
 
 int wlan_get_tdls_list(mlan_private *priv, tdls_peer_info *buf);
+int wlan_get_sta_stats_list(mlan_private *priv, sta_stats_info *buf,
+			    t_u32 max);
 t_void wlan_hold_tdls_packets(pmlan_private priv, t_u8 *mac);
 t_void wlan_restore_tdls_packets(pmlan_private priv, t_u8 *mac,
 				 tdlsStatus_e status);
@@ -4858,6 +5057,118 @@ static INLINE mlan_private *wlan_get_priv_by_id(mlan_adapter *pmadapter,
 	return MNULL;
 }
 
+/**
+ *  @brief This function takes a data path spin lock
+ *
+ *  @param pmadapter A pointer to mlan_adapter
+ *  @param plock     A pointer to the lock
+ *
+ *  @return          N/A
+ */
+static INLINE t_void wlan_spin_lock(mlan_adapter *pmadapter, t_void *plock)
+{
+	if (pmadapter->tp_state_on)
+		util_scalar_atomic_add(pmadapter->pmoal_handle,
+				       &pmadapter->tp_lock_ops, 1,
+				       wlan_atomic_add_cb(pmadapter), MNULL,
+				       MNULL);
+#ifdef MLAN_INLINE_OS
+	mlan_os_spin_lock(pmadapter->pmoal_handle, plock);
+#else
+	pmadapter->callbacks.moal_spin_lock(pmadapter->pmoal_handle, plock);
+#endif
+}
+
+/**
+ *  @brief This function releases a data path spin lock
+ *
+ *  @param pmadapter A pointer to mlan_adapter
+ *  @param plock     A pointer to the lock
+ *
+ *  @return          N/A
+ */
+static INLINE t_void wlan_spin_unlock(mlan_adapter *pmadapter, t_void *plock)
+{
+#ifdef MLAN_INLINE_OS
+	mlan_os_spin_unlock(pmadapter->pmoal_handle, plock);
+#else
+	pmadapter->callbacks.moal_spin_unlock(pmadapter->pmoal_handle, plock);
+#endif
+}
+
+/**
+ *  @brief This function stamps a TX latency trace point on a packet,
+ *  only packets stamped by MOAL at MLAN_TX_LAT_XMIT are traced
+ *
+ *  @param pmadapter A pointer to mlan_adapter
+ *  @param pmbuf     A pointer to mlan_buffer
+ *  @param stage     Trace point, MLAN_TX_LAT_*
+ *
+ *  @return          N/A
+ */
+static INLINE t_void wlan_tx_lat_stamp(mlan_adapter *pmadapter,
+				       pmlan_buffer pmbuf, t_u32 stage)
+{
+	if (pmbuf->tx_lat_ts[MLAN_TX_LAT_XMIT])
+		pmadapter->callbacks.moal_get_boot_ktime(
+			pmadapter->pmoal_handle, &pmbuf->tx_lat_ts[stage]);
+}
+
+/**
+ *  @brief This function starts the RX latency trace of a packet read
+ *  from the bus, with the interrupt it was read for
+ *
+ *  @param pmadapter A pointer to mlan_adapter
+ *  @param pmbuf     A pointer to mlan_buffer
+ *
+ *  @return          N/A
+ */
+static INLINE t_void wlan_rx_lat_start(mlan_adapter *pmadapter,
+				       pmlan_buffer pmbuf)
+{
+	if (!pmadapter->rx_lat_on)
+		return;
+	pmbuf->rx_lat_ts[MLAN_RX_LAT_INT] = pmadapter->rx_lat_cur_irq_ts;
+	pmadapter->callbacks.moal_get_boot_ktime(
+		pmadapter->pmoal_handle, &pmbuf->rx_lat_ts[MLAN_RX_LAT_BUS]);
+}
+
+/**
+ *  @brief This function stamps a RX latency trace point on a packet,
+ *  only packets started by wlan_rx_lat_start are traced
+ *
+ *  @param pmadapter A pointer to mlan_adapter
+ *  @param pmbuf     A pointer to mlan_buffer
+ *  @param stage     Trace point, MLAN_RX_LAT_*
+ *
+ *  @return          N/A
+ */
+static INLINE t_void wlan_rx_lat_stamp(mlan_adapter *pmadapter,
+				       pmlan_buffer pmbuf, t_u32 stage)
+{
+	if (pmbuf->rx_lat_ts[MLAN_RX_LAT_BUS])
+		pmadapter->callbacks.moal_get_boot_ktime(
+			pmadapter->pmoal_handle, &pmbuf->rx_lat_ts[stage]);
+}
+
+/**
+ *  @brief This function takes the interrupt time stamp for the bus
+ *  reads that follow, a later interrupt starts a new one
+ *
+ *  @param pmadapter A pointer to mlan_adapter
+ *
+ *  @return          N/A
+ */
+static INLINE t_void wlan_rx_lat_take_irq(mlan_adapter *pmadapter)
+{
+	if (!pmadapter->rx_lat_on)
+		return;
+	wlan_spin_lock(pmadapter, pmadapter->pint_lock);
+	pmadapter->rx_lat_cur_irq_ts = pmadapter->rx_lat_irq_ts;
+	pmadapter->rx_lat_irq_ts = 0;
+	wlan_spin_unlock(pmadapter, pmadapter->pint_lock);
+}
+
 /**
  *  @brief This function returns first available priv
  *  based on the BSS role
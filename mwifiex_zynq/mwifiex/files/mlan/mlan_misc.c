@@ -539,6 +539,12 @@ mlan_status wlan_get_info_debug_info(pmlan_adapter pmadapter,
 			wlan_get_ralist_info(pmpriv, debug_info->ralist);
 		debug_info->tdls_peer_num =
 			wlan_get_tdls_list(pmpriv, debug_info->tdls_peer_list);
+		debug_info->sta_stats_num = 0;
+		if (debug_info->psta_stats_list)
+			debug_info->sta_stats_num = wlan_get_sta_stats_list(
+				pmpriv, debug_info->psta_stats_list,
+				debug_info->sta_stats_max);
+		debug_info->sta_list_gen = pmpriv->sta_list_gen;
 		debug_info->ps_mode = pmadapter->ps_mode;
 		debug_info->ps_state = pmadapter->ps_state;
 #ifdef STA_SUPPORT
@@ -557,10 +563,12 @@ mlan_status wlan_get_info_debug_info(pmlan_adapter pmadapter,
 		debug_info->port_open = pmpriv->port_open;
 		debug_info->tx_pause = pmpriv->tx_pause;
 		debug_info->bypass_pkt_count =
-			util_scalar_read(pmadapter->pmoal_handle,
-					 &pmadapter->bypass_pkt_count,
-					 pmadapter->callbacks.moal_spin_lock,
-					 pmadapter->callbacks.moal_spin_unlock);
+			util_scalar_atomic_read(
+				pmadapter->pmoal_handle,
+				&pmadapter->bypass_pkt_count,
+				wlan_atomic_read_cb(pmadapter),
+				wlan_lock_cb(pmadapter),
+				wlan_unlock_cb(pmadapter));
 		debug_info->scan_processing = pmadapter->scan_processing;
 		debug_info->scan_state = pmadapter->scan_state;
 		debug_info->mlan_processing = pmadapter->mlan_processing;
@@ -623,6 +631,23 @@ mlan_status wlan_get_info_debug_info(pmlan_adapter pmadapter,
 					[pmadapter->dbg.last_cmd_index] :
 				0;
 		debug_info->dnld_cmd_in_secs = pmadapter->dnld_cmd_in_secs;
+		debug_info->cmd_pool_size = pmadapter->cmd_pool_size;
+		for (i = 0; i < MLAN_CMD_CLASS_NUM; i++) {
+			cmd_class_stats *pstats = &pmadapter->cmd_stats[i];
+
+			debug_info->cmd_class_queued[i] = pstats->queued;
+			debug_info->cmd_class_max_queued[i] =
+				pstats->max_queued;
+			debug_info->cmd_class_dispatched[i] =
+				pstats->dispatched;
+			debug_info->cmd_class_avg_wait[i] =
+				pstats->dispatched ?
+					(t_u32)pmadapter->callbacks.moal_do_div(
+						pstats->total_wait,
+						pstats->dispatched) :
+					0;
+			debug_info->cmd_class_max_wait[i] = pstats->max_wait;
+		}
 #ifdef SDIO
 		if (IS_SD(pmadapter->card_type)) {
 			debug_info->num_cmdevt_card_to_host_failure =
@@ -736,16 +761,29 @@ mlan_status wlan_get_info_debug_info(pmlan_adapter pmadapter,
 		debug_info->cmd_sent = pmadapter->cmd_sent;
 		debug_info->cmd_resp_received = pmadapter->cmd_resp_received;
 		debug_info->tx_pkts_queued =
-			util_scalar_read(pmadapter->pmoal_handle,
-					 &pmpriv->wmm.tx_pkts_queued, MNULL,
-					 MNULL);
+			util_scalar_atomic_read(
+				pmadapter->pmoal_handle,
+				&pmpriv->wmm.tx_pkts_queued,
+				wlan_atomic_read_cb(pmadapter), MNULL,
+				MNULL);
 #ifdef UAP_SUPPORT
 		debug_info->num_bridge_pkts =
-			util_scalar_read(pmadapter->pmoal_handle,
-					 &pmadapter->pending_bridge_pkts,
-					 pmadapter->callbacks.moal_spin_lock,
-					 pmadapter->callbacks.moal_spin_unlock);
+			util_scalar_atomic_read(
+				pmadapter->pmoal_handle,
+				&pmadapter->pending_bridge_pkts,
+				wlan_atomic_read_cb(pmadapter),
+				wlan_lock_cb(pmadapter),
+				wlan_unlock_cb(pmadapter));
 		debug_info->num_drop_pkts = pmpriv->num_drop_pkts;
+		debug_info->num_bridge_zcopy = pmadapter->bridge_zcopy_pkts;
+		debug_info->num_bridge_copy = pmadapter->bridge_copy_pkts;
+		debug_info->bridge_fwd_lat_avg = 0;
+		if (pmadapter->bridge_fwd_done)
+			debug_info->bridge_fwd_lat_avg =
+				(t_u32)pmadapter->callbacks.moal_do_div(
+					pmadapter->bridge_fwd_lat,
+					pmadapter->bridge_fwd_done);
+		debug_info->bridge_fwd_lat_max = pmadapter->bridge_fwd_lat_max;
 #endif
 		debug_info->fw_hang_report = pmadapter->fw_hang_report;
 		debug_info->mlan_processing = pmadapter->mlan_processing;
@@ -1257,11 +1295,12 @@ t_void wlan_free_mlan_buffer(mlan_adapter *pmadapter, pmlan_buffer pmbuf)
 
 	if (pcb && pmbuf && pmadapter->pmoal_handle) {
 		if (pmbuf->flags & MLAN_BUF_FLAG_BRIDGE_BUF)
-			util_scalar_decrement(
+			util_scalar_atomic_sub(
 				pmadapter->pmoal_handle,
-				&pmadapter->pending_bridge_pkts,
-				pmadapter->callbacks.moal_spin_lock,
-				pmadapter->callbacks.moal_spin_unlock);
+				&pmadapter->pending_bridge_pkts, 1,
+				wlan_atomic_sub_cb(pmadapter),
+				wlan_lock_cb(pmadapter),
+				wlan_unlock_cb(pmadapter));
 		if (pmbuf->flags & MLAN_BUF_FLAG_MALLOC_BUF)
 			pcb->moal_mfree(pmadapter->pmoal_handle, (t_u8 *)pmbuf);
 		else
@@ -1965,8 +2004,8 @@ t_u8 wlan_is_station_list_empty(mlan_private *priv)
 {
 	ENTER();
 	if (!(util_peek_list(priv->adapter->pmoal_handle, &priv->sta_list,
-			     priv->adapter->callbacks.moal_spin_lock,
-			     priv->adapter->callbacks.moal_spin_unlock))) {
+			     wlan_lock_cb(priv->adapter),
+			     wlan_unlock_cb(priv->adapter)))) {
 		LEAVE();
 		return MTRUE;
 	}
@@ -2037,8 +2076,9 @@ sta_node *wlan_add_station_entry(mlan_private *priv, t_u8 *mac)
 		   MLAN_MAC_ADDR_LENGTH);
 	util_enqueue_list_tail(priv->adapter->pmoal_handle, &priv->sta_list,
 			       (pmlan_linked_list)sta_ptr,
-			       priv->adapter->callbacks.moal_spin_lock,
-			       priv->adapter->callbacks.moal_spin_unlock);
+			       wlan_lock_cb(priv->adapter),
+			       wlan_unlock_cb(priv->adapter));
+	priv->sta_list_gen++;
 done:
 	LEAVE();
 	return sta_ptr;
@@ -2095,10 +2135,11 @@ t_void wlan_delete_station_entry(mlan_private *priv, t_u8 *mac)
 			wlan_delete_iPhone_entry(priv, mac);
 		util_unlink_list(priv->adapter->pmoal_handle, &priv->sta_list,
 				 (pmlan_linked_list)sta_ptr,
-				 priv->adapter->callbacks.moal_spin_lock,
-				 priv->adapter->callbacks.moal_spin_unlock);
+				 wlan_lock_cb(priv->adapter),
+				 wlan_unlock_cb(priv->adapter));
 		priv->adapter->callbacks.moal_mfree(priv->adapter->pmoal_handle,
 						    (t_u8 *)sta_ptr);
+		priv->sta_list_gen++;
 	}
 
 	LEAVE();
@@ -2119,15 +2160,57 @@ t_void wlan_delete_station_list(pmlan_private priv)
 	ENTER();
 	while ((sta_ptr = (sta_node *)util_dequeue_list(
 			priv->adapter->pmoal_handle, &priv->sta_list,
-			priv->adapter->callbacks.moal_spin_lock,
-			priv->adapter->callbacks.moal_spin_unlock))) {
+			wlan_lock_cb(priv->adapter),
+			wlan_unlock_cb(priv->adapter)))) {
 		priv->adapter->callbacks.moal_mfree(priv->adapter->pmoal_handle,
 						    (t_u8 *)sta_ptr);
 	}
+	priv->sta_list_gen++;
 	LEAVE();
 	return;
 }
 
+/**
+ *  @brief Get the host counters of the stations in the station list
+ *
+ *  @param priv         A pointer to mlan_private structure
+ *  @param buf          A pointer to sta_stats_info buf
+ *  @param max          Number of entries in buf
+ *  @return             number of stations
+ */
+int wlan_get_sta_stats_list(mlan_private *priv, sta_stats_info *buf,
+			    t_u32 max)
+{
+	sta_stats_info *info = buf;
+	sta_node *sta_ptr = MNULL;
+	int count = 0;
+
+	ENTER();
+	/* Hold the list lock for the whole walk, a station unlinked by
+	 * wlan_delete_station_entry is only freed after it gets the lock */
+	wlan_spin_lock(priv->adapter, priv->sta_list.plock);
+	sta_ptr = (sta_node *)util_peek_list(priv->adapter->pmoal_handle,
+					     &priv->sta_list, MNULL, MNULL);
+	while (sta_ptr && (sta_ptr != (sta_node *)&priv->sta_list) &&
+	       count < (int)max) {
+		memcpy_ext(priv->adapter, info->mac_addr, sta_ptr->mac_addr,
+			   MLAN_MAC_ADDR_LENGTH, MLAN_MAC_ADDR_LENGTH);
+		info->snr = sta_ptr->snr;
+		info->nf = sta_ptr->nf;
+		memcpy_ext(priv->adapter, &info->stats, &sta_ptr->stats,
+			   sizeof(sta_stats), sizeof(info->stats));
+		info->tx_aqm_drops = sta_ptr->tx_aqm_drops;
+		info->tx_aqm_marks = sta_ptr->tx_aqm_marks;
+		info->tx_aqm_overlimit = sta_ptr->tx_aqm_overlimit;
+		info++;
+		count++;
+		sta_ptr = sta_ptr->pnext;
+	}
+	wlan_spin_unlock(priv->adapter, priv->sta_list.plock);
+	LEAVE();
+	return count;
+}
+
 /**
  *  @brief Get tdls peer list
  *
@@ -2148,8 +2231,7 @@ int wlan_get_tdls_list(mlan_private *priv, tdls_peer_info *buf)
 	}
 	sta_ptr = (sta_node *)util_peek_list(
 		priv->adapter->pmoal_handle, &priv->sta_list,
-		priv->adapter->callbacks.moal_spin_lock,
-		priv->adapter->callbacks.moal_spin_unlock);
+		wlan_lock_cb(priv->adapter), wlan_unlock_cb(priv->adapter));
 	if (!sta_ptr) {
 		LEAVE();
 		return count;
@@ -29,6 +29,9 @@ Change log:
 #include <linux/module.h>
 #include "mlan_decl.h"
 #include "mlan_ioctl.h"
+#ifdef MLAN_TRACE
+#include "mlan_os.h"
+#endif
 #ifdef PCIE
 EXPORT_SYMBOL(mlan_process_pcie_interrupt_cb);
 #endif
@@ -46,7 +49,10 @@ EXPORT_SYMBOL(mlan_send_packet);
 EXPORT_SYMBOL(mlan_ioctl);
 EXPORT_SYMBOL(mlan_main_process);
 EXPORT_SYMBOL(mlan_rx_process);
+EXPORT_SYMBOL(mlan_rx_late_process);
 EXPORT_SYMBOL(mlan_select_wmm_queue);
+EXPORT_SYMBOL(mlan_is_tx_queue_overlimit);
+EXPORT_SYMBOL(mlan_tx_queue_can_wake);
 EXPORT_SYMBOL(mlan_process_deaggr_pkt);
 #if defined(SDIO) || defined(PCIE)
 EXPORT_SYMBOL(mlan_interrupt);
@@ -57,11 +63,25 @@ EXPORT_SYMBOL(mlan_hs_callback);
 
 EXPORT_SYMBOL(mlan_pm_wakeup_card);
 EXPORT_SYMBOL(mlan_is_main_process_running);
+EXPORT_SYMBOL(mlan_set_rx_lat);
 #ifdef PCIE
 EXPORT_SYMBOL(mlan_set_int_mode);
 #endif
 EXPORT_SYMBOL(mlan_disable_host_int);
 EXPORT_SYMBOL(mlan_enable_host_int);
+#ifdef MLAN_TRACE
+EXPORT_SYMBOL(mlan_trace_key_MENTRY);
+EXPORT_SYMBOL(mlan_trace_key_MINFO);
+EXPORT_SYMBOL(mlan_trace_key_MINTR);
+EXPORT_SYMBOL(mlan_trace_key_MDATA);
+EXPORT_SYMBOL(mlan_trace_key_MDAT_D);
+EXPORT_SYMBOL(mlan_trace_init);
+EXPORT_SYMBOL(mlan_trace_exit);
+EXPORT_SYMBOL(mlan_trace_set_mask);
+EXPORT_SYMBOL(mlan_trace_log);
+EXPORT_SYMBOL(mlan_trace_snapshot);
+EXPORT_SYMBOL(mlan_trace_reset);
+#endif
 
 MODULE_DESCRIPTION("M-WLAN MLAN Driver");
 MODULE_AUTHOR("NXP");
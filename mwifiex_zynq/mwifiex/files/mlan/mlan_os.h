@@ -0,0 +1,283 @@
+/** @file mlan_os.h
+ *
+ *  @brief This file contains the inline OS primitives that MLAN can be
+ *  bound to at build time (MLAN_INLINE_OS) instead of calling them
+ *  through mlan_callbacks, and the data path trace ring (MLAN_TRACE).
+ *
+ *
+ *  Copyright 2026 NXP
+ *
+ *  This software file (the File) is distributed by NXP
+ *  under the terms of the GNU General Public License Version 2, June 1991
+ *  (the License).  You may use, redistribute and/or modify the File in
+ *  accordance with the terms and conditions of the License, a copy of which
+ *  is available by writing to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA or on the
+ *  worldwide web at http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *  THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE EXPRESSLY DISCLAIMED.  The License provides additional details about
+ *  this warranty disclaimer.
+ *
+ */
+
+/******************************************************
+Change log:
+    10/18/2026: initial version
+******************************************************/
+
+#ifndef _MLAN_OS_H_
+#define _MLAN_OS_H_
+
+#ifdef LINUX
+#include <linux/atomic.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+
+/** moal_lock, shared by MOAL and the inline lock primitives */
+typedef struct _moal_lock {
+	/** Lock */
+	spinlock_t lock;
+	/** Flags */
+	unsigned long flags;
+} moal_lock;
+
+/**
+ *  @brief Acquire a moal_lock with interrupts saved
+ *
+ *  @param pmoal    Pointer to the MOAL context
+ *  @param plock    Pointer to the lock
+ *
+ *  @return         MLAN_STATUS_SUCCESS
+ */
+static inline mlan_status mlan_os_spin_lock(t_void *pmoal, t_void *plock)
+{
+	moal_lock *mlock = (moal_lock *)plock;
+	unsigned long flags = 0;
+
+	spin_lock_irqsave(&mlock->lock, flags);
+	mlock->flags = flags;
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief Release a moal_lock and restore interrupts
+ *
+ *  @param pmoal    Pointer to the MOAL context
+ *  @param plock    Pointer to the lock
+ *
+ *  @return         MLAN_STATUS_SUCCESS
+ */
+static inline mlan_status mlan_os_spin_unlock(t_void *pmoal, t_void *plock)
+{
+	moal_lock *mlock = (moal_lock *)plock;
+
+	spin_unlock_irqrestore(&mlock->lock, mlock->flags);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief Copy memory, bounded by the destination size
+ *
+ *  @param pmoal     Pointer to the MOAL context
+ *  @param pdest     Pointer to the dest memory
+ *  @param psrc      Pointer to the src memory
+ *  @param num       Number of bytes to copy
+ *  @param dest_size Size of the dest memory
+ *
+ *  @return          Pointer to the dest memory
+ */
+static inline t_void *mlan_os_memcpy_ext(t_void *pmoal, t_void *pdest,
+					 const t_void *psrc, t_u32 num,
+					 t_u32 dest_size)
+{
+	if (pdest && psrc && num && dest_size)
+		memcpy(pdest, psrc, num < dest_size ? num : dest_size);
+	return pdest;
+}
+
+/**
+ *  @brief Copy memory
+ *
+ *  @param pmoal    Pointer to the MOAL context
+ *  @param pdest    Pointer to the dest memory
+ *  @param psrc     Pointer to the src memory
+ *  @param num      Number of bytes to copy
+ *
+ *  @return         Pointer to the dest memory
+ */
+static inline t_void *mlan_os_memcpy(t_void *pmoal, t_void *pdest,
+				     const t_void *psrc, t_u32 num)
+{
+	if (pdest && psrc && num)
+		memcpy(pdest, psrc, num);
+	return pdest;
+}
+
+/**
+ *  @brief Move memory
+ *
+ *  @param pmoal    Pointer to the MOAL context
+ *  @param pdest    Pointer to the dest memory
+ *  @param psrc     Pointer to the src memory
+ *  @param num      Number of bytes to move
+ *
+ *  @return         Pointer to the dest memory
+ */
+static inline t_void *mlan_os_memmove(t_void *pmoal, t_void *pdest,
+				      const t_void *psrc, t_u32 num)
+{
+	if (pdest && psrc && num)
+		memmove(pdest, psrc, num);
+	return pdest;
+}
+
+/**
+ *  @brief Fill memory
+ *
+ *  @param pmoal    Pointer to the MOAL context
+ *  @param pmem     Pointer to the memory
+ *  @param byte     Value to fill with
+ *  @param num      Number of bytes to fill
+ *
+ *  @return         Pointer to the memory
+ */
+static inline t_void *mlan_os_memset(t_void *pmoal, t_void *pmem, t_u8 byte,
+				     t_u32 num)
+{
+	if (pmem && num)
+		memset(pmem, byte, num);
+	return pmem;
+}
+
+/**
+ *  @brief Compare memory
+ *
+ *  @param pmoal    Pointer to the MOAL context
+ *  @param pmem1    Pointer to the first memory
+ *  @param pmem2    Pointer to the second memory
+ *  @param num      Number of bytes to compare
+ *
+ *  @return         Compare result, 0 if equal
+ */
+static inline t_s32 mlan_os_memcmp(t_void *pmoal, const t_void *pmem1,
+				   const t_void *pmem2, t_u32 num)
+{
+	return memcmp(pmem1, pmem2, num);
+}
+
+/*
+ * The atomic primitives below work on the t_s32 value of an mlan_scalar,
+ * which has the same layout as atomic_t.
+ */
+
+/**
+ *  @brief Atomically add to a counter
+ *
+ *  @param pmoal    Pointer to the MOAL context
+ *  @param pval     Pointer to the counter
+ *  @param i        Value to add
+ *
+ *  @return         New value of the counter
+ */
+static inline t_s32 mlan_os_atomic_add(t_void *pmoal, t_s32 *pval, t_s32 i)
+{
+	return atomic_add_return(i, (atomic_t *)pval);
+}
+
+/**
+ *  @brief Atomically subtract from a counter
+ *
+ *  @param pmoal    Pointer to the MOAL context
+ *  @param pval     Pointer to the counter
+ *  @param i        Value to subtract
+ *
+ *  @return         New value of the counter
+ */
+static inline t_s32 mlan_os_atomic_sub(t_void *pmoal, t_s32 *pval, t_s32 i)
+{
+	return atomic_sub_return(i, (atomic_t *)pval);
+}
+
+/**
+ *  @brief Read a counter
+ *
+ *  @param pmoal    Pointer to the MOAL context
+ *  @param pval     Pointer to the counter
+ *
+ *  @return         Value of the counter
+ */
+static inline t_s32 mlan_os_atomic_read(t_void *pmoal, t_s32 *pval)
+{
+	return atomic_read((atomic_t *)pval);
+}
+
+/**
+ *  @brief Atomically compare and exchange a counter
+ *
+ *  @param pmoal    Pointer to the MOAL context
+ *  @param pval     Pointer to the counter
+ *  @param old      Expected value
+ *  @param new_val  Value to store if the counter equals old
+ *
+ *  @return         Value of the counter before the operation
+ */
+static inline t_s32 mlan_os_atomic_cmpxchg(t_void *pmoal, t_s32 *pval,
+					   t_s32 old, t_s32 new_val)
+{
+	return atomic_cmpxchg((atomic_t *)pval, old, new_val);
+}
+
+#ifdef MLAN_TRACE
+#include <linux/jump_label.h>
+
+/** Records per CPU in the trace ring, must be a power of 2 */
+#define MLAN_TRACE_RING_SIZE 128
+/** Max message length of a trace record, including the NUL */
+#define MLAN_TRACE_MSG_LEN 112
+
+/** Trace ring record */
+typedef struct _mlan_trace_rec {
+	/** local_clock() timestamp in ns */
+	t_u64 ts;
+	/** Sequence number, 0 while the record is being written */
+	t_u32 seq;
+	/** Debug level */
+	t_u32 level;
+	/** Formatted message */
+	char msg[MLAN_TRACE_MSG_LEN];
+} mlan_trace_rec;
+
+/** Debug levels that are logged to the trace ring instead of printk */
+#define MLAN_TRACE_LEVELS (MENTRY | MINFO | MINTR | MDATA | MDAT_D)
+
+DECLARE_STATIC_KEY_FALSE(mlan_trace_key_MENTRY);
+DECLARE_STATIC_KEY_FALSE(mlan_trace_key_MINFO);
+DECLARE_STATIC_KEY_FALSE(mlan_trace_key_MINTR);
+DECLARE_STATIC_KEY_FALSE(mlan_trace_key_MDATA);
+DECLARE_STATIC_KEY_FALSE(mlan_trace_key_MDAT_D);
+
+/** Log to the trace ring, a single NOP while the level is disabled */
+#define MLAN_TRACE_LOG(level, msg...)                                          \
+	do {                                                                   \
+		if (static_branch_unlikely(&mlan_trace_key_##level))           \
+			mlan_trace_log(level, msg);                            \
+	} while (0)
+
+/** Allocate the trace ring and enable the levels set in mask */
+mlan_status mlan_trace_init(t_u32 mask);
+/** Disable all levels and free the trace ring */
+void mlan_trace_exit(void);
+/** Enable the trace levels set in mask and disable the others */
+void mlan_trace_set_mask(t_u32 mask);
+/** Write one record to the trace ring of the current CPU */
+void mlan_trace_log(t_u32 level, char *fmt, ...);
+/** Copy the valid records of one CPU, oldest first */
+t_u32 mlan_trace_snapshot(t_u32 cpu, mlan_trace_rec *prec, t_u32 num);
+/** Drop the records logged so far from later snapshots */
+void mlan_trace_reset(void);
+#endif /* MLAN_TRACE */
+#endif /* LINUX */
+
+#endif /* !_MLAN_OS_H_ */
@@ -2138,8 +2138,7 @@ static mlan_status wlan_pcie_send_data_complete(mlan_adapter *pmadapter)
 			ptx_bd_buf->flags = 0;
 			ptx_bd_buf->frag_len = 0;
 			ptx_bd_buf->offset = 0;
-			pcb->moal_spin_lock(pmadapter->pmoal_handle,
-					    pmadapter->pmlan_pcie_lock);
+			wlan_spin_lock(pmadapter, pmadapter->pmlan_pcie_lock);
 			pmadapter->pcard_pcie->txbd_rdptr++;
 			if ((pmadapter->pcard_pcie->txbd_rdptr &
 			     txrx_rw_ptr_mask) == num_tx_buffs)
@@ -2147,8 +2146,7 @@ static mlan_status wlan_pcie_send_data_complete(mlan_adapter *pmadapter)
 					((pmadapter->pcard_pcie->txbd_rdptr &
 					  txrx_rw_ptr_rollover_ind) ^
 					 txrx_rw_ptr_rollover_ind);
-			pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-					      pmadapter->pmlan_pcie_lock);
+			wlan_spin_unlock(pmadapter, pmadapter->pmlan_pcie_lock);
 		}
 #endif
 #if defined(PCIE9098) || defined(PCIE9097) || defined(PCIEAW693) ||            \
@@ -2162,13 +2160,11 @@ static mlan_status wlan_pcie_send_data_complete(mlan_adapter *pmadapter)
 			padma_bd_buf->flags = 0;
 			padma_bd_buf->pkt_size = 0;
 			padma_bd_buf->reserved = 0;
-			pcb->moal_spin_lock(pmadapter->pmoal_handle,
-					    pmadapter->pmlan_pcie_lock);
+			wlan_spin_lock(pmadapter, pmadapter->pmlan_pcie_lock);
 			pmadapter->pcard_pcie->txbd_rdptr++;
 			pmadapter->pcard_pcie->txbd_rdptr &=
 				ADMA_RW_PTR_WRAP_MASK;
-			pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-					      pmadapter->pmlan_pcie_lock);
+			wlan_spin_unlock(pmadapter, pmadapter->pmlan_pcie_lock);
 		}
 #endif
 	}
@@ -2184,8 +2180,7 @@ static mlan_status wlan_pcie_send_data_complete(mlan_adapter *pmadapter)
 	}
 #endif
 done:
-	pcb->moal_spin_lock(pmadapter->pmoal_handle,
-			    pmadapter->pmlan_pcie_lock);
+	wlan_spin_lock(pmadapter, pmadapter->pmlan_pcie_lock);
 	pmadapter->pcard_pcie->txbd_pending -= unmap_count;
 	if (unmap_count) {
 #ifdef PCIEAW693
@@ -2196,8 +2191,7 @@ done:
 #endif
 			pmadapter->data_sent = MFALSE;
 	}
-	pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-			      pmadapter->pmlan_pcie_lock);
+	wlan_spin_unlock(pmadapter, pmadapter->pmlan_pcie_lock);
 
 	LEAVE();
 	return ret;
@@ -2213,32 +2207,27 @@ done:
  */
 static void wlan_pcie_process_tx_complete(mlan_adapter *pmadapter)
 {
-	pmlan_callbacks pcb = &pmadapter->callbacks;
 	ENTER();
-	pcb->moal_spin_lock(pmadapter->pmoal_handle, pmadapter->pmlan_tx_lock);
+	wlan_spin_lock(pmadapter, pmadapter->pmlan_tx_lock);
 	if (pmadapter->pcie_tx_processing) {
 		pmadapter->more_tx_task_flag = MTRUE;
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->pmlan_tx_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->pmlan_tx_lock);
 		goto exit_tx_proc;
 	} else {
 		pmadapter->pcie_tx_processing = MTRUE;
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->pmlan_tx_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->pmlan_tx_lock);
 	}
 tx_process_start:
 	wlan_pcie_send_data_complete(pmadapter);
 
-	pcb->moal_spin_lock(pmadapter->pmoal_handle, pmadapter->pmlan_tx_lock);
+	wlan_spin_lock(pmadapter, pmadapter->pmlan_tx_lock);
 	if (pmadapter->more_tx_task_flag) {
 		pmadapter->more_tx_task_flag = MFALSE;
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->pmlan_tx_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->pmlan_tx_lock);
 		goto tx_process_start;
 	}
 	pmadapter->pcie_tx_processing = MFALSE;
-	pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-			      pmadapter->pmlan_tx_lock);
+	wlan_spin_unlock(pmadapter, pmadapter->pmlan_tx_lock);
 exit_tx_proc:
 	LEAVE();
 	return;
@@ -2357,12 +2346,10 @@ static mlan_status wlan_pcie_send_adma_data(mlan_adapter *pmadapter,
 		PRINTM(MDAT_D,
 		       "SEND DATA: Attach pmbuf %p at tx_ring[%d], txbd_wrptr=0x%x\n",
 		       pmbuf, wrindx, pmadapter->pcard_pcie->txbd_wrptr);
-		pcb->moal_spin_lock(pmadapter->pmoal_handle,
-				    pmadapter->pmlan_pcie_lock);
+		wlan_spin_lock(pmadapter, pmadapter->pmlan_pcie_lock);
 		pmadapter->pcard_pcie->tx_buf_list[wrindx] = pmbuf;
 		pmadapter->pcard_pcie->txbd_pending++;
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->pmlan_pcie_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->pmlan_pcie_lock);
 
 		wr_ptr_start = ADMA_WPTR_START;
 		padma_bd_buf = (adma_dual_desc_buf *)
@@ -2465,12 +2452,10 @@ done_unmap:
 		PRINTM(MERROR, "SEND DATA: failed to moal_unmap_memory\n");
 		ret = MLAN_STATUS_FAILURE;
 	}
-	pcb->moal_spin_lock(pmadapter->pmoal_handle,
-			    pmadapter->pmlan_pcie_lock);
+	wlan_spin_lock(pmadapter, pmadapter->pmlan_pcie_lock);
 	pmadapter->pcard_pcie->txbd_pending--;
 	pmadapter->pcard_pcie->tx_buf_list[wrindx] = MNULL;
-	pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-			      pmadapter->pmlan_pcie_lock);
+	wlan_spin_unlock(pmadapter, pmadapter->pmlan_pcie_lock);
 
 	if (padma_bd_buf) {
 		padma_bd_buf->paddr = 0;
@@ -2571,8 +2556,7 @@ static mlan_status wlan_pcie_send_data(mlan_adapter *pmadapter, t_u8 type,
 		       "SEND DATA: Attach pmbuf %p at tx_ring[%d], txbd_wrptr=0x%x\n",
 		       pmbuf, wrindx, pmadapter->pcard_pcie->txbd_wrptr);
 
-		pcb->moal_spin_lock(pmadapter->pmoal_handle,
-				    pmadapter->pmlan_pcie_lock);
+		wlan_spin_lock(pmadapter, pmadapter->pmlan_pcie_lock);
 
 		pmadapter->pcard_pcie->tx_buf_list[wrindx] = pmbuf;
 #if defined(PCIE8997) || defined(PCIE8897)
@@ -2646,8 +2630,7 @@ static mlan_status wlan_pcie_send_data(mlan_adapter *pmadapter, t_u8 type,
 			(pmadapter->pcard_pcie->txbd_wrptr << wr_ptr_start) |
 				rxbd_val);
 
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->pmlan_pcie_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->pmlan_pcie_lock);
 
 		if (status) {
 			PRINTM(MERROR,
@@ -2710,12 +2693,10 @@ done_unmap:
 		PRINTM(MERROR, "SEND DATA: failed to moal_unmap_memory\n");
 		ret = MLAN_STATUS_FAILURE;
 	}
-	pcb->moal_spin_lock(pmadapter->pmoal_handle,
-			    pmadapter->pmlan_pcie_lock);
+	wlan_spin_lock(pmadapter, pmadapter->pmlan_pcie_lock);
 	pmadapter->pcard_pcie->txbd_pending--;
 	pmadapter->pcard_pcie->tx_buf_list[wrindx] = MNULL;
-	pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-			      pmadapter->pmlan_pcie_lock);
+	wlan_spin_unlock(pmadapter, pmadapter->pmlan_pcie_lock);
 
 #if defined(PCIE8997) || defined(PCIE8897)
 	if (!pmadapter->pcard_pcie->reg->use_adma && ptx_bd_buf) {
@@ -2865,6 +2846,7 @@ static mlan_status wlan_pcie_process_recv_data(mlan_adapter *pmadapter)
 
 	ENTER();
 
+	wlan_rx_lat_take_irq(pmadapter);
 	/* Read the RX ring Read pointer set by firmware */
 	if (pcb->moal_read_reg(pmadapter->pmoal_handle, reg_rxbd_rdptr,
 			       &rdptr)) {
@@ -2885,9 +2867,9 @@ static mlan_status wlan_pcie_process_recv_data(mlan_adapter *pmadapter)
 			pmadapter->pmoal_handle, 6, 0);
 	}
 	while (wlan_check_rx_pending_buffer(pmadapter, rdptr)) {
-		if (pmadapter->rx_pkts_queued > HIGH_RX_PENDING) {
+		if (wlan_rx_pending_pause(pmadapter,
+					  &pmadapter->delay_rx_data_flag)) {
 			PRINTM(MEVENT, "RX Pause\n");
-			pmadapter->delay_rx_data_flag = MTRUE;
 			goto done;
 		}
 
@@ -2940,6 +2922,7 @@ static mlan_status wlan_pcie_process_recv_data(mlan_adapter *pmadapter)
 			/* send buffer to host (which will free it) */
 			pmbuf->data_len = rx_len - PCIE_INTF_HEADER_LEN;
 			pmbuf->data_offset += PCIE_INTF_HEADER_LEN;
+			wlan_rx_lat_start(pmadapter, pmbuf);
 			// rx_trace 5
 			if (pmadapter->tp_state_on) {
 				pmadapter->callbacks.moal_tp_accounting(
@@ -2958,9 +2941,10 @@ static mlan_status wlan_pcie_process_recv_data(mlan_adapter *pmadapter)
 			} else {
 				PRINTM(MINFO,
 				       "RECV DATA: Received packet from FW successfully\n");
-				pmadapter->callbacks.moal_spin_lock(
-					pmadapter->pmoal_handle,
-					pmadapter->rx_data_queue.plock);
+				wlan_rx_lat_stamp(pmadapter, pmbuf,
+						  MLAN_RX_LAT_ENQ);
+				wlan_spin_lock(pmadapter,
+					       pmadapter->rx_data_queue.plock);
 				util_enqueue_list_tail(
 					pmadapter->pmoal_handle,
 					&pmadapter->rx_data_queue,
@@ -2973,8 +2957,8 @@ static mlan_status wlan_pcie_process_recv_data(mlan_adapter *pmadapter)
 							1,
 							pmadapter
 								->rx_pkts_queued);
-				pmadapter->callbacks.moal_spin_unlock(
-					pmadapter->pmoal_handle,
+				wlan_spin_unlock(
+					pmadapter,
 					pmadapter->rx_data_queue.plock);
 
 				pmadapter->data_received = MTRUE;
@@ -3036,8 +3020,7 @@ static mlan_status wlan_pcie_process_recv_data(mlan_adapter *pmadapter)
 					 txrx_rw_ptr_rollover_ind);
 			}
 
-			pcb->moal_spin_lock(pmadapter->pmoal_handle,
-					    pmadapter->pmlan_pcie_lock);
+			wlan_spin_lock(pmadapter, pmadapter->pmlan_pcie_lock);
 
 			/* update rxbd's wrptrs */
 			if ((++pmadapter->pcard_pcie->rxbd_wrptr &
@@ -3085,8 +3068,7 @@ static mlan_status wlan_pcie_process_recv_data(mlan_adapter *pmadapter)
 
 #if defined(PCIE8997) || defined(PCIE8897)
 		if (!pmadapter->pcard_pcie->reg->use_adma) {
-			pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-					      pmadapter->pmlan_pcie_lock);
+			wlan_spin_unlock(pmadapter, pmadapter->pmlan_pcie_lock);
 		}
 #endif
 		if (ret) {
@@ -4245,9 +4227,9 @@ static mlan_status wlan_pcie_interrupt(t_u16 msg_id, pmlan_adapter pmadapter)
 	ENTER();
 
 	if (pmadapter->pcard_pcie->pcie_int_mode == PCIE_INT_MODE_MSI) {
-		pcb->moal_spin_lock(pmoal_handle, pint_lock);
+		wlan_spin_lock(pmadapter, pint_lock);
 		pmadapter->ireg = 1;
-		pcb->moal_spin_unlock(pmoal_handle, pint_lock);
+		wlan_spin_unlock(pmadapter, pint_lock);
 	} else {
 		wlan_pcie_disable_host_int_mask(pmadapter);
 		if (pcb->moal_read_reg(
@@ -4271,9 +4253,9 @@ static mlan_status wlan_pcie_interrupt(t_u16 msg_id, pmlan_adapter pmadapter)
 				pmadapter->ps_state = PS_STATE_AWAKE;
 				pmadapter->pm_wakeup_card_req = MFALSE;
 			}
-			pcb->moal_spin_lock(pmoal_handle, pint_lock);
+			wlan_spin_lock(pmadapter, pint_lock);
 			pmadapter->ireg |= pcie_ireg;
-			pcb->moal_spin_unlock(pmoal_handle, pint_lock);
+			wlan_spin_unlock(pmadapter, pint_lock);
 
 			/* Clear the pending interrupts */
 			if (pcb->moal_write_reg(pmoal_handle,
@@ -4311,11 +4293,11 @@ static mlan_status wlan_process_pcie_int_status(mlan_adapter *pmadapter)
 
 	ENTER();
 
-	pcb->moal_spin_lock(pmadapter->pmoal_handle, pmadapter->pint_lock);
+	wlan_spin_lock(pmadapter, pmadapter->pint_lock);
 	if (pmadapter->pcard_pcie->pcie_int_mode != PCIE_INT_MODE_MSI)
 		pcie_ireg = pmadapter->ireg;
 	pmadapter->ireg = 0;
-	pcb->moal_spin_unlock(pmadapter->pmoal_handle, pmadapter->pint_lock);
+	wlan_spin_unlock(pmadapter, pmadapter->pint_lock);
 	if (pmadapter->pcard_pcie->pcie_int_mode == PCIE_INT_MODE_MSI) {
 		if (pcb->moal_read_reg(
 			    pmadapter->pmoal_handle,
@@ -4369,11 +4351,9 @@ static mlan_status wlan_process_pcie_int_status(mlan_adapter *pmadapter)
 			pcie_ireg &=
 				~pmadapter->pcard_pcie->reg->host_intr_upld_rdy;
 			PRINTM(MINFO, "Rx DATA\n");
-			pcb->moal_spin_lock(pmadapter->pmoal_handle,
-					    pmadapter->pmlan_rx_lock);
+			wlan_spin_lock(pmadapter, pmadapter->pmlan_rx_lock);
 			pmadapter->pcard_pcie->rx_pending = MTRUE;
-			pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-					      pmadapter->pmlan_rx_lock);
+			wlan_spin_unlock(pmadapter, pmadapter->pmlan_rx_lock);
 			pmadapter->callbacks.moal_tp_accounting_rx_param(
 				pmadapter->pmoal_handle, 0, 0);
 			wlan_recv_event(wlan_get_priv(pmadapter,
@@ -4424,11 +4404,9 @@ static mlan_status wlan_process_pcie_int_status(mlan_adapter *pmadapter)
 		}
 #endif
 		if (pmadapter->pcard_pcie->pcie_int_mode == PCIE_INT_MODE_MSI) {
-			pcb->moal_spin_lock(pmadapter->pmoal_handle,
-					    pmadapter->pint_lock);
+			wlan_spin_lock(pmadapter, pmadapter->pint_lock);
 			pmadapter->ireg = 0;
-			pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-					      pmadapter->pint_lock);
+			wlan_spin_unlock(pmadapter, pmadapter->pint_lock);
 		}
 		if (pcb->moal_read_reg(
 			    pmadapter->pmoal_handle,
@@ -4458,12 +4436,11 @@ static mlan_status wlan_process_pcie_int_status(mlan_adapter *pmadapter)
 			}
 			if (pmadapter->pcard_pcie->pcie_int_mode !=
 			    PCIE_INT_MODE_MSI) {
-				pcb->moal_spin_lock(pmadapter->pmoal_handle,
-						    pmadapter->pint_lock);
+				wlan_spin_lock(pmadapter, pmadapter->pint_lock);
 				pcie_ireg |= pmadapter->ireg;
 				pmadapter->ireg = 0;
-				pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-						      pmadapter->pint_lock);
+				wlan_spin_unlock(pmadapter,
+						 pmadapter->pint_lock);
 			}
 			/* Don't update the pmadapter->pcie_ireg,
 			 * serving the status right now */
@@ -5217,26 +5194,22 @@ static mlan_status wlan_pcie_interrupt_ext(t_u16 msg_id,
  */
 static void wlan_pcie_process_rx(mlan_adapter *pmadapter)
 {
-	pmlan_callbacks pcb = &pmadapter->callbacks;
 	ENTER();
-	pcb->moal_spin_lock(pmadapter->pmoal_handle, pmadapter->pmlan_rx_lock);
+	wlan_spin_lock(pmadapter, pmadapter->pmlan_rx_lock);
 	if (pmadapter->pcie_rx_processing) {
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->pmlan_rx_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->pmlan_rx_lock);
 		goto exit_rx_proc;
 	} else {
 		pmadapter->pcie_rx_processing = MTRUE;
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->pmlan_rx_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->pmlan_rx_lock);
 	}
 
 	wlan_pcie_process_recv_data(pmadapter);
 
-	pcb->moal_spin_lock(pmadapter->pmoal_handle, pmadapter->pmlan_rx_lock);
+	wlan_spin_lock(pmadapter, pmadapter->pmlan_rx_lock);
 	pmadapter->pcie_rx_processing = MFALSE;
 	pmadapter->pcard_pcie->rx_pending = MFALSE;
-	pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-			      pmadapter->pmlan_rx_lock);
+	wlan_spin_unlock(pmadapter, pmadapter->pmlan_rx_lock);
 exit_rx_proc:
 	LEAVE();
 	return;
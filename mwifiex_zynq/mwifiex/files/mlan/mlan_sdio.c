@@ -682,6 +682,28 @@ static mlan_status wlan_get_wr_port_data(mlan_adapter *pmadapter, t_u8 *pport)
 	return MLAN_STATUS_SUCCESS;
 }
 
+/**
+ *  @brief This function waits before the next register poll. The first
+ *         retry is immediate, later ones wait 1, 2, 4 ... usec up to
+ *         SDIO_POLL_MAX_DELAY_US.
+ *
+ *  @param pmadapter  A pointer to mlan_adapter structure
+ *  @param delay      A pointer to the current delay, 0 before the first poll
+ *  @param waited     A pointer to the total wait in usec
+ *  @return           N/A
+ */
+static void wlan_sdio_poll_backoff(mlan_adapter *pmadapter, t_u32 *delay,
+				   t_u32 *waited)
+{
+	if (*delay) {
+		wlan_udelay(pmadapter, *delay);
+		*waited += *delay;
+		*delay = MIN(*delay * 2, SDIO_POLL_MAX_DELAY_US);
+	} else {
+		*delay = 1;
+	}
+}
+
 /**
  *  @brief This function polls the card status register.
  *
@@ -695,10 +717,11 @@ static mlan_status wlan_sdio_poll_card_status(mlan_adapter *pmadapter,
 	pmlan_callbacks pcb = &pmadapter->callbacks;
 	t_u32 tries;
 	t_u32 cs = 0;
+	t_u32 delay = 0, waited = 0;
 
 	ENTER();
 
-	for (tries = 0; tries < 10000; tries++) {
+	for (tries = 0; waited < SDIO_POLL_CARD_STATUS_US; tries++) {
 		if (pcb->moal_read_reg(pmadapter->pmoal_handle,
 				       pmadapter->pcard_sd->reg->poll_reg,
 				       &cs) != MLAN_STATUS_SUCCESS)
@@ -707,7 +730,7 @@ static mlan_status wlan_sdio_poll_card_status(mlan_adapter *pmadapter,
 			LEAVE();
 			return MLAN_STATUS_SUCCESS;
 		}
-		wlan_udelay(pmadapter, 10);
+		wlan_sdio_poll_backoff(pmadapter, &delay, &waited);
 	}
 
 	PRINTM(MERROR,
@@ -996,6 +1019,114 @@ exit:
 	return ret;
 }
 
+/**
+ *  @brief This function reads the card status and the length the helper
+ *         asks for with one CMD53 over the register range
+ *
+ *  @param pmadapter  A pointer to mlan_adapter structure
+ *  @param regbuf     A pointer to a DMA buffer of MLAN_SDIO_BLOCK_SIZE
+ *  @param cs         A pointer to keep the card status
+ *  @param len        A pointer to keep the length
+ *  @return           MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status wlan_sdio_read_fw_dnld_req(pmlan_adapter pmadapter,
+					      t_u8 *regbuf, t_u32 *cs,
+					      t_u16 *len)
+{
+	const mlan_sdio_card_reg *reg = pmadapter->pcard_sd->reg;
+	mlan_buffer mbuf;
+
+	memset(pmadapter, &mbuf, 0, sizeof(mlan_buffer));
+	mbuf.pbuf = regbuf;
+	mbuf.data_len = reg->base_1_reg - reg->poll_reg + 1;
+	if (pmadapter->callbacks.moal_read_data_sync(
+		    pmadapter->pmoal_handle, &mbuf,
+		    (REG_PORT + reg->poll_reg) | MLAN_SDIO_BYTE_MODE_MASK,
+		    0) != MLAN_STATUS_SUCCESS)
+		return MLAN_STATUS_FAILURE;
+	*cs = regbuf[0];
+	*len = (t_u16)((regbuf[reg->base_1_reg - reg->poll_reg] << 8) |
+		       regbuf[reg->base_0_reg - reg->poll_reg]);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function waits until the helper is ready for the next
+ *         block and reads the length it asks for
+ *
+ *  @param pmadapter  A pointer to mlan_adapter structure
+ *  @param regbuf     A pointer to a DMA buffer to read the status and
+ *                    length with one CMD53, MNULL to use CMD52
+ *  @param need_len   MFALSE to return as soon as the card is ready
+ *  @param len        A pointer to keep the length, 0 if none was posted
+ *  @return           MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status wlan_sdio_wait_fw_dnld_req(pmlan_adapter pmadapter,
+					      t_u8 *regbuf, t_u8 need_len,
+					      t_u16 *len)
+{
+	pmlan_callbacks pcb = &pmadapter->callbacks;
+	const mlan_sdio_card_reg *reg = pmadapter->pcard_sd->reg;
+	const t_u8 bits = CARD_IO_READY | DN_LD_CARD_RDY;
+	t_u32 base0 = 0, base1 = 0;
+	t_u32 delay = 0, waited = 0, len_waited = 0;
+	t_u32 cs = 0;
+
+	*len = 0;
+	if (!regbuf) {
+		if (wlan_sdio_poll_card_status(pmadapter, bits) !=
+		    MLAN_STATUS_SUCCESS)
+			return MLAN_STATUS_FAILURE;
+		if (!need_len)
+			return MLAN_STATUS_SUCCESS;
+		while (waited < SDIO_POLL_FW_LEN_US) {
+			if (pcb->moal_read_reg(pmadapter->pmoal_handle,
+					       reg->base_0_reg,
+					       &base0) != MLAN_STATUS_SUCCESS) {
+				PRINTM(MERROR,
+				       "Dev BASE0 register read failed:"
+				       " base0=0x%04X(%d). Terminating download\n",
+				       base0, base0);
+				return MLAN_STATUS_FAILURE;
+			}
+			if (pcb->moal_read_reg(pmadapter->pmoal_handle,
+					       reg->base_1_reg,
+					       &base1) != MLAN_STATUS_SUCCESS) {
+				PRINTM(MERROR,
+				       "Dev BASE1 register read failed:"
+				       " base1=0x%04X(%d). Terminating download\n",
+				       base1, base1);
+				return MLAN_STATUS_FAILURE;
+			}
+			*len = (t_u16)(((base1 & 0xff) << 8) | (base0 & 0xff));
+			if (*len)
+				break;
+			wlan_sdio_poll_backoff(pmadapter, &delay, &waited);
+		}
+		return MLAN_STATUS_SUCCESS;
+	}
+
+	/* The length is read along with the status, the card status
+	 * budget covers the wait for both */
+	while (waited < SDIO_POLL_CARD_STATUS_US) {
+		if (wlan_sdio_read_fw_dnld_req(pmadapter, regbuf, &cs, len) !=
+		    MLAN_STATUS_SUCCESS) {
+			PRINTM(MERROR, "FW download request read failed\n");
+			return MLAN_STATUS_FAILURE;
+		}
+		if ((cs & bits) == bits) {
+			if (!need_len || *len || len_waited >= SDIO_POLL_FW_LEN_US)
+				return MLAN_STATUS_SUCCESS;
+			wlan_sdio_poll_backoff(pmadapter, &delay, &len_waited);
+			continue;
+		}
+		wlan_sdio_poll_backoff(pmadapter, &delay, &waited);
+	}
+
+	PRINTM(MERROR, "FW download request poll failed, cs = 0x%x\n", cs);
+	return MLAN_STATUS_FAILURE;
+}
+
 /**
  *  @brief  This function downloads FW blocks to device
  *
@@ -1013,17 +1144,26 @@ static mlan_status wlan_sdio_prog_fw_w_helper(pmlan_adapter pmadapter, t_u8 *fw,
 	t_u8 *firmware = fw;
 	t_u32 firmwarelen = fw_len;
 	t_u32 offset = 0;
-	t_u32 base0 = 0, base1 = 0;
 	t_void *tmpfwbuf = MNULL;
 	t_u32 tmpfwbufsz;
 	t_u8 *fwbuf;
 	mlan_buffer mbuf;
 	t_u16 len = 0;
-	t_u32 txlen = 0, tx_blocks = 0, tries = 0;
+	t_u32 txlen = 0, tx_blocks = 0;
 	t_u32 i = 0;
 	const mlan_sdio_card_reg *reg = pmadapter->pcard_sd->reg;
-	t_u32 read_base_0_reg = reg->base_0_reg;
-	t_u32 read_base_1_reg = reg->base_1_reg;
+	/* Status and length registers are read with one CMD53 into regbuf
+	 * once that is seen to match CMD52 on the first block */
+	t_u8 probe_cmd53 = reg->poll_reg < reg->base_0_reg &&
+			   reg->poll_reg < reg->base_1_reg &&
+			   reg->base_1_reg - reg->poll_reg < MLAN_SDIO_BLOCK_SIZE;
+	t_u8 *probe_buf;
+	t_u8 *regbuf = MNULL;
+	t_u32 cs = 0;
+	t_u16 probe_len = 0;
+	t_u64 start_ns = 0, ts = 0, now = 0;
+	t_u64 poll_ns = 0, write_ns = 0;
+	t_u32 blocks = 0, total_us;
 #if defined(SD9098)
 	t_u32 rev_id_reg = 0;
 	t_u32 revision_id = 0;
@@ -1043,7 +1183,8 @@ static mlan_status wlan_sdio_prog_fw_w_helper(pmlan_adapter pmadapter, t_u8 *fw,
 
 	PRINTM(MINFO, "WLAN: Downloading FW image (%d bytes)\n", firmwarelen);
 
-	tmpfwbufsz = ALIGN_SZ(WLAN_UPLD_SIZE, DMA_ALIGNMENT);
+	tmpfwbufsz = ALIGN_SZ(WLAN_UPLD_SIZE, DMA_ALIGNMENT) +
+		     MLAN_SDIO_BLOCK_SIZE;
 	ret = pcb->moal_malloc(pmadapter->pmoal_handle, tmpfwbufsz,
 			       MLAN_MEM_DEF | MLAN_MEM_DMA, (t_u8 **)&tmpfwbuf);
 	if ((ret != MLAN_STATUS_SUCCESS) || !tmpfwbuf) {
@@ -1054,6 +1195,8 @@ static mlan_status wlan_sdio_prog_fw_w_helper(pmlan_adapter pmadapter, t_u8 *fw,
 	}
 	/* Ensure 8-byte aligned firmware buffer */
 	fwbuf = (t_u8 *)ALIGN_ADDR(tmpfwbuf, DMA_ALIGNMENT);
+	probe_buf = fwbuf + ALIGN_SZ(WLAN_UPLD_SIZE, DMA_ALIGNMENT);
+	pcb->moal_get_boot_ktime(pmadapter->pmoal_handle, &start_ns);
 #if defined(SD9098)
 	if (IS_SD9098(pmadapter->card_type)) {
 		rev_id_reg = pmadapter->pcard_sd->reg->card_revision_reg;
@@ -1083,9 +1226,11 @@ static mlan_status wlan_sdio_prog_fw_w_helper(pmlan_adapter pmadapter, t_u8 *fw,
 	/* Perform firmware data transfer */
 	do {
 		/* The host polls for the DN_LD_CARD_RDY and CARD_IO_READY bits
-		 */
-		ret = wlan_sdio_poll_card_status(
-			pmadapter, CARD_IO_READY | DN_LD_CARD_RDY);
+		 * and the length the helper asks for */
+		pcb->moal_get_boot_ktime(pmadapter->pmoal_handle, &ts);
+		ret = wlan_sdio_wait_fw_dnld_req(
+			pmadapter, regbuf,
+			!(firmwarelen && offset >= firmwarelen), &len);
 		if (ret != MLAN_STATUS_SUCCESS) {
 			PRINTM(MFATAL,
 			       "WLAN: FW download with helper poll status timeout @ %d\n",
@@ -1097,31 +1242,22 @@ static mlan_status wlan_sdio_prog_fw_w_helper(pmlan_adapter pmadapter, t_u8 *fw,
 		if (firmwarelen && offset >= firmwarelen)
 			break;
 
-		for (tries = 0; tries < MAX_POLL_TRIES; tries++) {
-			ret = pcb->moal_read_reg(pmadapter->pmoal_handle,
-						 read_base_0_reg, &base0);
-			if (ret != MLAN_STATUS_SUCCESS) {
-				PRINTM(MERROR,
-				       "Dev BASE0 register read failed:"
-				       " base0=0x%04X(%d). Terminating download\n",
-				       base0, base0);
-				goto done;
-			}
-			ret = pcb->moal_read_reg(pmadapter->pmoal_handle,
-						 read_base_1_reg, &base1);
-			if (ret != MLAN_STATUS_SUCCESS) {
-				PRINTM(MERROR,
-				       "Dev BASE1 register read failed:"
-				       " base1=0x%04X(%d). Terminating download\n",
-				       base1, base1);
-				goto done;
+		if (probe_cmd53 && len) {
+			probe_cmd53 = MFALSE;
+			if (wlan_sdio_read_fw_dnld_req(pmadapter, probe_buf,
+						       &cs, &probe_len) !=
+			    MLAN_STATUS_SUCCESS) {
+				pcb->moal_write_reg(pmadapter->pmoal_handle,
+						    HOST_TO_CARD_EVENT_REG,
+						    HOST_TERM_CMD53);
+			} else if ((cs & (CARD_IO_READY | DN_LD_CARD_RDY)) ==
+					   (CARD_IO_READY | DN_LD_CARD_RDY) &&
+				   probe_len == len) {
+				regbuf = probe_buf;
 			}
-			len = (t_u16)(((base1 & 0xff) << 8) | (base0 & 0xff));
-
-			if (len)
-				break;
-			wlan_udelay(pmadapter, 10);
 		}
+		pcb->moal_get_boot_ktime(pmadapter->pmoal_handle, &now);
+		poll_ns += now - ts;
 
 		if (!len)
 			break;
@@ -1208,12 +1344,19 @@ static mlan_status wlan_sdio_prog_fw_w_helper(pmlan_adapter pmadapter, t_u8 *fw,
 				    MLAN_SDIO_BLOCK_SIZE_FW_DNLD;
 
 			/* Copy payload to buffer */
-			if (firmware)
+			if (firmware) {
 				memmove(pmadapter, fwbuf, &firmware[offset],
 					txlen);
-			else
-				pcb->moal_get_fw_data(pmadapter->pmoal_handle,
-						      offset, txlen, fwbuf);
+			} else if (pcb->moal_get_fw_data(
+					   pmadapter->pmoal_handle, offset,
+					   txlen, fwbuf) !=
+				   MLAN_STATUS_SUCCESS) {
+				PRINTM(MERROR,
+				       "WLAN: FW download, get fw data failed @ %d\n",
+				       offset);
+				ret = MLAN_STATUS_FAILURE;
+				goto done;
+			}
 		}
 
 		/* Send data */
@@ -1221,8 +1364,12 @@ static mlan_status wlan_sdio_prog_fw_w_helper(pmlan_adapter pmadapter, t_u8 *fw,
 		mbuf.pbuf = (t_u8 *)fwbuf;
 		mbuf.data_len = tx_blocks * MLAN_SDIO_BLOCK_SIZE_FW_DNLD;
 
+		pcb->moal_get_boot_ktime(pmadapter->pmoal_handle, &ts);
 		ret = pcb->moal_write_data_sync(pmadapter->pmoal_handle, &mbuf,
 						pmadapter->pcard_sd->ioport, 0);
+		pcb->moal_get_boot_ktime(pmadapter->pmoal_handle, &now);
+		write_ns += now - ts;
+		blocks++;
 		if (ret != MLAN_STATUS_SUCCESS) {
 			PRINTM(MERROR,
 			       "WLAN: FW download, write iomem (%d) failed @ %d\n",
@@ -1242,6 +1389,16 @@ static mlan_status wlan_sdio_prog_fw_w_helper(pmlan_adapter pmadapter, t_u8 *fw,
 
 	PRINTM(MMSG, "Wlan: FW download over, firmwarelen=%d downloaded %d\n",
 	       firmwarelen, offset);
+	pcb->moal_get_boot_ktime(pmadapter->pmoal_handle, &now);
+	total_us = (t_u32)pcb->moal_do_div(now - start_ns, 1000);
+	PRINTM(MMSG,
+	       "Wlan: FW download %u writes in %u us (poll %u us, write %u us), %u KB/s, status read by %s\n",
+	       blocks, total_us, (t_u32)pcb->moal_do_div(poll_ns, 1000),
+	       (t_u32)pcb->moal_do_div(write_ns, 1000),
+	       total_us ? (t_u32)pcb->moal_do_div(
+				  ((t_u64)offset * 1000000) >> 10, total_us) :
+			  0,
+	       regbuf ? "CMD53" : "CMD52");
 
 	ret = MLAN_STATUS_SUCCESS;
 done:
@@ -1297,17 +1454,16 @@ static mlan_status wlan_decode_rx_packet(mlan_adapter *pmadapter,
 		if (pmadapter->rx_work_flag) {
 			pmbuf->buf_type = MLAN_BUF_TYPE_SPA_DATA;
 			if (lock_flag)
-				pmadapter->callbacks.moal_spin_lock(
-					pmadapter->pmoal_handle,
-					pmadapter->rx_data_queue.plock);
+				wlan_spin_lock(pmadapter,
+					       pmadapter->rx_data_queue.plock);
 			util_enqueue_list_tail(pmadapter->pmoal_handle,
 					       &pmadapter->rx_data_queue,
 					       (pmlan_linked_list)pmbuf, MNULL,
 					       MNULL);
 			pmadapter->rx_pkts_queued++;
 			if (lock_flag)
-				pmadapter->callbacks.moal_spin_unlock(
-					pmadapter->pmoal_handle,
+				wlan_spin_unlock(
+					pmadapter,
 					pmadapter->rx_data_queue.plock);
 		} else {
 			wlan_decode_spa_buffer(pmadapter,
@@ -1328,6 +1484,7 @@ static mlan_status wlan_decode_rx_packet(mlan_adapter *pmadapter,
 		}
 		pmbuf->data_len = (pmadapter->upld_len - SDIO_INTF_HEADER_LEN);
 		pmbuf->data_offset += SDIO_INTF_HEADER_LEN;
+		wlan_rx_lat_start(pmadapter, pmbuf);
 		if (pmadapter->rx_work_flag) {
 			// rx_trace 5
 			if (pmadapter->tp_state_on) {
@@ -1345,9 +1502,11 @@ static mlan_status wlan_decode_rx_packet(mlan_adapter *pmadapter,
 				pmadapter->ops.data_complete(
 					pmadapter, pmbuf, MLAN_STATUS_SUCCESS);
 			} else {
+				wlan_rx_lat_stamp(pmadapter, pmbuf,
+						  MLAN_RX_LAT_ENQ);
 				if (lock_flag)
-					pmadapter->callbacks.moal_spin_lock(
-						pmadapter->pmoal_handle,
+					wlan_spin_lock(
+						pmadapter,
 						pmadapter->rx_data_queue.plock);
 				util_enqueue_list_tail(
 					pmadapter->pmoal_handle,
@@ -1362,8 +1521,8 @@ static mlan_status wlan_decode_rx_packet(mlan_adapter *pmadapter,
 							pmadapter
 								->rx_pkts_queued);
 				if (lock_flag)
-					pmadapter->callbacks.moal_spin_unlock(
-						pmadapter->pmoal_handle,
+					wlan_spin_unlock(
+						pmadapter,
 						pmadapter->rx_data_queue.plock);
 			}
 		} else {
@@ -1569,9 +1728,7 @@ static mlan_status wlan_receive_mp_aggr_buf(mlan_adapter *pmadapter)
 		}
 	} while (ret == MLAN_STATUS_FAILURE);
 	if (pmadapter->rx_work_flag)
-		pmadapter->callbacks.moal_spin_lock(
-			pmadapter->pmoal_handle,
-			pmadapter->rx_data_queue.plock);
+		wlan_spin_lock(pmadapter, pmadapter->rx_data_queue.plock);
 	if (!pmadapter->pcard_sd->mpa_rx.buf &&
 	    pmadapter->pcard_sd->mpa_rx.pkt_cnt > 1) {
 		for (pind = 0; pind < pmadapter->pcard_sd->mpa_rx.pkt_cnt;
@@ -1632,9 +1789,7 @@ static mlan_status wlan_receive_mp_aggr_buf(mlan_adapter *pmadapter)
 		}
 	}
 	if (pmadapter->rx_work_flag)
-		pmadapter->callbacks.moal_spin_unlock(
-			pmadapter->pmoal_handle,
-			pmadapter->rx_data_queue.plock);
+		wlan_spin_unlock(pmadapter, pmadapter->rx_data_queue.plock);
 	pmadapter->pcard_sd
 		->mpa_rx_count[pmadapter->pcard_sd->mpa_rx.pkt_cnt - 1]++;
 	MP_RX_AGGR_BUF_RESET(pmadapter);
@@ -2640,11 +2795,9 @@ static mlan_status wlan_sdio_interrupt(t_u16 msg_id, pmlan_adapter pmadapter)
 		PRINTM(MINTR, "wlan_interrupt: sdio_ireg = 0x%x\n", sdio_ireg);
 		pmadapter->pm_wakeup_timeout = 0;
 		pmadapter->pcard_sd->num_of_irq++;
-		pcb->moal_spin_lock(pmadapter->pmoal_handle,
-				    pmadapter->pint_lock);
+		wlan_spin_lock(pmadapter, pmadapter->pint_lock);
 		pmadapter->ireg |= sdio_ireg;
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->pint_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->pint_lock);
 		if (!pmadapter->pps_uapsd_mode &&
 		    pmadapter->ps_state == PS_STATE_SLEEP) {
 			pmadapter->pm_wakeup_fw_try = MFALSE;
@@ -2749,10 +2902,11 @@ static mlan_status wlan_process_sdio_int_status(mlan_adapter *pmadapter,
 
 	ENTER();
 
-	pcb->moal_spin_lock(pmadapter->pmoal_handle, pmadapter->pint_lock);
+	wlan_spin_lock(pmadapter, pmadapter->pint_lock);
 	sdio_ireg = (t_u8)pmadapter->ireg;
 	pmadapter->ireg = 0;
-	pcb->moal_spin_unlock(pmadapter->pmoal_handle, pmadapter->pint_lock);
+	wlan_spin_unlock(pmadapter, pmadapter->pint_lock);
+	wlan_rx_lat_take_irq(pmadapter);
 
 	if (!sdio_ireg)
 		goto done;
@@ -98,6 +98,13 @@ Change log:
 /** Card Control Registers : Download card ready */
 #define DN_LD_CARD_RDY (0x1U << 0)
 
+/** Longest single wait of the adaptive register poll, in usec */
+#define SDIO_POLL_MAX_DELAY_US 64
+/** Wait budget for the card status during FW download, in usec */
+#define SDIO_POLL_CARD_STATUS_US 100000
+/** Wait budget for the helper to post a block length, in usec */
+#define SDIO_POLL_FW_LEN_US 1000
+
 /** Card Control Registers : Host power interrupt mask */
 #define HOST_POWER_INT_MASK (0x1U << 3)
 /** Card Control Registers : Abort card interrupt mask */
@@ -184,6 +184,34 @@ static void wlan_process_pending_ioctl(mlan_adapter *pmadapter)
 	}
 	LEAVE();
 }
+
+/**
+ *  @brief This function hands the data path lock operations counted
+ *         since the last report to the tp accounting
+ *
+ *  @param pmadapter  A pointer to mlan_adapter structure
+ *
+ *  @return           N/A
+ */
+static t_void wlan_report_lock_ops(mlan_adapter *pmadapter)
+{
+	t_s32 lock_ops;
+
+	if (!pmadapter->tp_state_on)
+		return;
+	lock_ops = util_scalar_atomic_read(pmadapter->pmoal_handle,
+					   &pmadapter->tp_lock_ops,
+					   wlan_atomic_read_cb(pmadapter),
+					   MNULL, MNULL);
+	if (!lock_ops)
+		return;
+	/* Subtract what was read so concurrent increments are kept */
+	util_scalar_atomic_sub(pmadapter->pmoal_handle,
+			       &pmadapter->tp_lock_ops, lock_ops,
+			       wlan_atomic_sub_cb(pmadapter), MNULL, MNULL);
+	pmadapter->callbacks.moal_tp_accounting_rx_param(
+		pmadapter->pmoal_handle, 9 /* data path lock ops */, lock_ops);
+}
 /********************************************************
 			Global Functions
 ********************************************************/
@@ -280,6 +308,8 @@ mlan_status mlan_register(pmlan_device pmdevice, t_void **ppmlan_adapter)
 					 &pmdevice->callbacks,
 					 sizeof(mlan_callbacks));
 
+	wlan_init_data_rate_index();
+
 	/* Assertion for all callback functions */
 	MASSERT(pcb->moal_get_hw_spec_complete);
 	MASSERT(pcb->moal_init_fw_complete);
@@ -452,6 +482,11 @@ mlan_status mlan_register(pmlan_device pmdevice, t_void **ppmlan_adapter)
 	pmadapter->init_para.drcs_chantime_mode = pmdevice->drcs_chantime_mode;
 	pmadapter->second_mac = pmdevice->second_mac;
 	pmadapter->napi = pmdevice->napi;
+	pmadapter->rx_amsdu_zcopy = pmdevice->rx_amsdu_zcopy;
+	pmadapter->uap_fwd_zcopy = pmdevice->uap_fwd_zcopy;
+	pmadapter->tx_aqm = pmdevice->tx_aqm;
+	/* One station may not fill the per-AC queue on its own */
+	pmadapter->tx_aqm_limit = pmdevice->max_tx_pending / 2;
 	pmadapter->hs_wake_interval = pmdevice->hs_wake_interval;
 	if (pmdevice->indication_gpio != 0xff) {
 		pmadapter->ind_gpio = pmdevice->indication_gpio & 0x0f;
@@ -912,19 +947,15 @@ mlan_status mlan_shutdown_fw(t_void *padapter)
  */
 static t_void mlan_queue_main_work(mlan_adapter *pmadapter)
 {
-	pmlan_callbacks pcb = &pmadapter->callbacks;
 	ENTER();
-	pcb->moal_spin_lock(pmadapter->pmoal_handle,
-			    pmadapter->pmain_proc_lock);
+	wlan_spin_lock(pmadapter, pmadapter->pmain_proc_lock);
 
 	/* Check if already processing */
 	if (pmadapter->mlan_processing) {
 		pmadapter->more_task_flag = MTRUE;
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->pmain_proc_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->pmain_proc_lock);
 	} else {
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->pmain_proc_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->pmain_proc_lock);
 		wlan_recv_event(wlan_get_priv(pmadapter, MLAN_BSS_ROLE_ANY),
 				MLAN_EVENT_ID_DRV_DEFER_HANDLING, MNULL);
 	}
@@ -941,19 +972,16 @@ static t_void mlan_queue_main_work(mlan_adapter *pmadapter)
  */
 static t_void mlan_queue_rx_work(mlan_adapter *pmadapter)
 {
-	pmlan_callbacks pcb = &pmadapter->callbacks;
 	ENTER();
 
-	pcb->moal_spin_lock(pmadapter->pmoal_handle, pmadapter->prx_proc_lock);
+	wlan_spin_lock(pmadapter, pmadapter->prx_proc_lock);
 
 	/* Check if already processing */
 	if (pmadapter->mlan_rx_processing) {
 		pmadapter->more_rx_task_flag = MTRUE;
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->prx_proc_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->prx_proc_lock);
 	} else {
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->prx_proc_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->prx_proc_lock);
 		wlan_recv_event(wlan_get_priv(pmadapter, MLAN_BSS_ROLE_ANY),
 				MLAN_EVENT_ID_DRV_DEFER_RX_WORK, MNULL);
 	}
@@ -971,25 +999,20 @@ static t_void mlan_queue_rx_work(mlan_adapter *pmadapter)
  */
 void mlan_block_main_process(mlan_adapter *pmadapter, t_u8 block)
 {
-	pmlan_callbacks pcb = &pmadapter->callbacks;
-	pcb->moal_spin_lock(pmadapter->pmoal_handle,
-			    pmadapter->pmain_proc_lock);
+	wlan_spin_lock(pmadapter, pmadapter->pmain_proc_lock);
 	if (!block) {
 		pmadapter->main_lock_flag = MFALSE;
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->pmain_proc_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->pmain_proc_lock);
 	} else {
 		pmadapter->main_lock_flag = MTRUE;
 		if (pmadapter->mlan_processing) {
-			pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-					      pmadapter->pmain_proc_lock);
+			wlan_spin_unlock(pmadapter, pmadapter->pmain_proc_lock);
 			PRINTM(MEVENT, "wlan: wait main work done...\n");
 			wlan_recv_event(
 				wlan_get_priv(pmadapter, MLAN_BSS_ROLE_ANY),
 				MLAN_EVENT_ID_DRV_FLUSH_MAIN_WORK, MNULL);
 		} else {
-			pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-					      pmadapter->pmain_proc_lock);
+			wlan_spin_unlock(pmadapter, pmadapter->pmain_proc_lock);
 		}
 	}
 }
@@ -1004,28 +1027,91 @@ void mlan_block_main_process(mlan_adapter *pmadapter, t_u8 block)
  */
 void mlan_block_rx_process(mlan_adapter *pmadapter, t_u8 block)
 {
-	pmlan_callbacks pcb = &pmadapter->callbacks;
-	pcb->moal_spin_lock(pmadapter->pmoal_handle, pmadapter->prx_proc_lock);
+	wlan_spin_lock(pmadapter, pmadapter->prx_proc_lock);
 	if (!block) {
 		pmadapter->rx_lock_flag = MFALSE;
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->prx_proc_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->prx_proc_lock);
 	} else {
 		pmadapter->rx_lock_flag = MTRUE;
 		if (pmadapter->mlan_rx_processing) {
-			pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-					      pmadapter->prx_proc_lock);
+			wlan_spin_unlock(pmadapter, pmadapter->prx_proc_lock);
 			PRINTM(MEVENT, "wlan: wait rx work done...\n");
 			wlan_recv_event(wlan_get_priv(pmadapter,
 						      MLAN_BSS_ROLE_ANY),
 					MLAN_EVENT_ID_DRV_FLUSH_RX_WORK, MNULL);
 		} else {
-			pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-					      pmadapter->prx_proc_lock);
+			wlan_spin_unlock(pmadapter, pmadapter->prx_proc_lock);
+			/* Rx late stage workers may still hold packets */
+			if (pmadapter->callbacks.moal_rx_late_queue)
+				wlan_recv_event(
+					wlan_get_priv(pmadapter,
+						      MLAN_BSS_ROLE_ANY),
+					MLAN_EVENT_ID_DRV_FLUSH_RX_WORK, MNULL);
 		}
 	}
 }
 
+/**
+ *  @brief Pause reading rx data from the card while more than
+ *         HIGH_RX_PENDING packets are queued. The check and the flag
+ *         update are done under the rx_data_queue lock, the same lock
+ *         wlan_rx_pending_resume clears the flag under.
+ *
+ *  @param pmadapter	A pointer to mlan_adapter structure
+ *  @param pflag		A pointer to the delay flag to set
+ *
+ *  @return			MTRUE if rx is paused, otherwise MFALSE
+ */
+t_u8 wlan_rx_pending_pause(mlan_adapter *pmadapter, t_u32 *pflag)
+{
+	t_u8 pause = MFALSE;
+
+	wlan_spin_lock(pmadapter, pmadapter->rx_data_queue.plock);
+	if (pmadapter->rx_pkts_queued > HIGH_RX_PENDING) {
+		*pflag = MTRUE;
+		pause = MTRUE;
+	}
+	wlan_spin_unlock(pmadapter, pmadapter->rx_data_queue.plock);
+	return pause;
+}
+
+/**
+ *  @brief Resume reading rx data from the card once rx_pkts_queued
+ *         has dropped below LOW_RX_PENDING
+ *
+ *  @param pmadapter	A pointer to mlan_adapter structure
+ *
+ *  @return			N/A
+ */
+static t_void wlan_rx_pending_resume(mlan_adapter *pmadapter)
+{
+	t_u32 *pflag = &pmadapter->delay_task_flag;
+	t_u8 resume = MFALSE;
+
+#ifdef PCIE
+	if (IS_PCIE(pmadapter->card_type))
+		pflag = &pmadapter->delay_rx_data_flag;
+#endif
+	/* Rx late stage workers resume concurrently with the pause check */
+	wlan_spin_lock(pmadapter, pmadapter->rx_data_queue.plock);
+	if (*pflag && (pmadapter->rx_pkts_queued < LOW_RX_PENDING)) {
+		*pflag = MFALSE;
+		resume = MTRUE;
+	}
+	wlan_spin_unlock(pmadapter, pmadapter->rx_data_queue.plock);
+	if (!resume)
+		return;
+	PRINTM(MEVENT, "Run\n");
+#ifdef PCIE
+	if (IS_PCIE(pmadapter->card_type)) {
+		wlan_recv_event(wlan_get_priv(pmadapter, MLAN_BSS_ROLE_ANY),
+				MLAN_EVENT_ID_DRV_DEFER_RX_DATA, MNULL);
+		return;
+	}
+#endif
+	mlan_queue_main_work(pmadapter);
+}
+
 /**
  *  @brief The receive process
  *
@@ -1048,18 +1134,16 @@ mlan_status mlan_rx_process(t_void *padapter, t_u8 *rx_pkts)
 
 	MASSERT(padapter);
 	pcb = &pmadapter->callbacks;
-	pcb->moal_spin_lock(pmadapter->pmoal_handle, pmadapter->prx_proc_lock);
+	wlan_spin_lock(pmadapter, pmadapter->prx_proc_lock);
 	if (pmadapter->mlan_rx_processing || pmadapter->rx_lock_flag) {
 		pmadapter->more_rx_task_flag = MTRUE;
 		if (rx_pkts)
 			*rx_pkts = 0;
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->prx_proc_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->prx_proc_lock);
 		goto exit_rx_proc;
 	} else {
 		pmadapter->mlan_rx_processing = MTRUE;
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->prx_proc_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->prx_proc_lock);
 	}
 	if (rx_pkts)
 		limit = *rx_pkts;
@@ -1071,23 +1155,19 @@ rx_process_start:
 			pmadapter->flush_data = MFALSE;
 			wlan_flush_rxreorder_tbl(pmadapter);
 		}
-		pmadapter->callbacks.moal_spin_lock(
-			pmadapter->pmoal_handle,
-			pmadapter->rx_data_queue.plock);
+		wlan_spin_lock(pmadapter, pmadapter->rx_data_queue.plock);
 		pmbuf = (pmlan_buffer)util_dequeue_list(
 			pmadapter->pmoal_handle, &pmadapter->rx_data_queue,
 			MNULL, MNULL);
 		if (!pmbuf) {
-			pmadapter->callbacks.moal_spin_unlock(
-				pmadapter->pmoal_handle,
-				pmadapter->rx_data_queue.plock);
+			wlan_spin_unlock(pmadapter,
+					 pmadapter->rx_data_queue.plock);
 			break;
 		}
 		pmadapter->rx_pkts_queued--;
 		rx_num++;
-		pmadapter->callbacks.moal_spin_unlock(
-			pmadapter->pmoal_handle,
-			pmadapter->rx_data_queue.plock);
+		wlan_spin_unlock(pmadapter, pmadapter->rx_data_queue.plock);
+		wlan_rx_lat_stamp(pmadapter, pmbuf, MLAN_RX_LAT_DEQ);
 
 		// rx_trace 6
 		if (pmadapter->tp_state_on) {
@@ -1104,24 +1184,7 @@ rx_process_start:
 			goto rx_process_start;
 		}
 
-		if (!IS_PCIE(pmadapter->card_type) &&
-		    pmadapter->delay_task_flag &&
-		    (pmadapter->rx_pkts_queued < LOW_RX_PENDING)) {
-			PRINTM(MEVENT, "Run\n");
-			pmadapter->delay_task_flag = MFALSE;
-			mlan_queue_main_work(pmadapter);
-		}
-#ifdef PCIE
-		if (IS_PCIE(pmadapter->card_type) &&
-		    pmadapter->delay_rx_data_flag &&
-		    (pmadapter->rx_pkts_queued < LOW_RX_PENDING)) {
-			PRINTM(MEVENT, "Run\n");
-			pmadapter->delay_rx_data_flag = MFALSE;
-			wlan_recv_event(wlan_get_priv(pmadapter,
-						      MLAN_BSS_ROLE_ANY),
-					MLAN_EVENT_ID_DRV_DEFER_RX_DATA, MNULL);
-		}
-#endif
+		wlan_rx_pending_resume(pmadapter);
 		pmadapter->ops.handle_rx_packet(pmadapter, pmbuf);
 		if (limit && rx_num >= limit)
 			break;
@@ -1130,21 +1193,59 @@ rx_process_start:
 	}
 	if (rx_pkts)
 		*rx_pkts = rx_num;
-	pcb->moal_spin_lock(pmadapter->pmoal_handle, pmadapter->prx_proc_lock);
+	wlan_spin_lock(pmadapter, pmadapter->prx_proc_lock);
 	if (pmadapter->more_rx_task_flag) {
 		pmadapter->more_rx_task_flag = MFALSE;
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->prx_proc_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->prx_proc_lock);
 		goto rx_process_start;
 	}
 	pmadapter->mlan_rx_processing = MFALSE;
-	pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-			      pmadapter->prx_proc_lock);
+	wlan_spin_unlock(pmadapter, pmadapter->prx_proc_lock);
+	wlan_report_lock_ops(pmadapter);
 exit_rx_proc:
 	LEAVE();
 	return ret;
 }
 
+/**
+ *  @brief The late receive stage for a packet deferred by
+ *         moal_rx_late_queue
+ *
+ *  @param padapter	A pointer to mlan_adapter structure
+ *  @param pmbuf		A pointer to mlan_buffer structure
+ *
+ *  @return			MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+mlan_status mlan_rx_late_process(t_void *padapter, pmlan_buffer pmbuf)
+{
+	mlan_status ret = MLAN_STATUS_SUCCESS;
+	mlan_adapter *pmadapter = (mlan_adapter *)padapter;
+	mlan_private *priv = MNULL;
+
+	ENTER();
+	MASSERT(padapter && pmbuf);
+
+	if (pmbuf->bss_index < pmadapter->priv_num)
+		priv = pmadapter->priv[pmbuf->bss_index];
+	if (!priv) {
+		PRINTM(MERROR, "rx_late: invalid bss_index %d\n",
+		       pmbuf->bss_index);
+		pmadapter->ops.data_complete(pmadapter, pmbuf,
+					     MLAN_STATUS_FAILURE);
+		ret = MLAN_STATUS_FAILURE;
+	} else {
+		ret = wlan_11n_rx_late_process(priv, pmbuf);
+	}
+	/* The packet was counted when it was queued to the worker */
+	wlan_spin_lock(pmadapter, pmadapter->rx_data_queue.plock);
+	if (pmadapter->rx_pkts_queued)
+		pmadapter->rx_pkts_queued--;
+	wlan_spin_unlock(pmadapter, pmadapter->rx_data_queue.plock);
+	wlan_rx_pending_resume(pmadapter);
+	LEAVE();
+	return ret;
+}
+
 /**
  *  @brief The main process
  *
@@ -1164,20 +1265,17 @@ mlan_status mlan_main_process(t_void *padapter)
 
 	pcb = &pmadapter->callbacks;
 
-	pcb->moal_spin_lock(pmadapter->pmoal_handle,
-			    pmadapter->pmain_proc_lock);
+	wlan_spin_lock(pmadapter, pmadapter->pmain_proc_lock);
 
 	/* Check if already processing */
 	if (pmadapter->mlan_processing || pmadapter->main_lock_flag) {
 		pmadapter->more_task_flag = MTRUE;
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->pmain_proc_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->pmain_proc_lock);
 		goto exit_main_proc;
 	} else {
 		pmadapter->mlan_processing = MTRUE;
 		pmadapter->main_process_cnt++;
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->pmain_proc_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->pmain_proc_lock);
 	}
 process_start:
 	do {
@@ -1196,11 +1294,11 @@ process_start:
 		}
 #if defined(SDIO)
 		if (IS_SD(pmadapter->card_type)) {
-			if (pmadapter->rx_pkts_queued > HIGH_RX_PENDING) {
+			if (wlan_rx_pending_pause(
+				    pmadapter, &pmadapter->delay_task_flag)) {
 				pcb->moal_tp_accounting_rx_param(
 					pmadapter->pmoal_handle, 2, 0);
 				PRINTM(MEVENT, "Pause\n");
-				pmadapter->delay_task_flag = MTRUE;
 				mlan_queue_rx_work(pmadapter);
 				break;
 			}
@@ -1449,17 +1547,15 @@ process_start:
 #endif
 	} while (MTRUE);
 
-	pcb->moal_spin_lock(pmadapter->pmoal_handle,
-			    pmadapter->pmain_proc_lock);
+	wlan_spin_lock(pmadapter, pmadapter->pmain_proc_lock);
 	if (pmadapter->more_task_flag == MTRUE) {
 		pmadapter->more_task_flag = MFALSE;
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->pmain_proc_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->pmain_proc_lock);
 		goto process_start;
 	}
 	pmadapter->mlan_processing = MFALSE;
-	pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-			      pmadapter->pmain_proc_lock);
+	wlan_spin_unlock(pmadapter, pmadapter->pmain_proc_lock);
+	wlan_report_lock_ops(pmadapter);
 
 exit_main_proc:
 	if (pmadapter->hw_status == WlanHardwareStatusClosing)
@@ -1895,17 +1991,15 @@ mlan_status mlan_recv(t_void *padapter, pmlan_buffer pmbuf, t_u32 port)
 			pmadapter->callbacks.moal_get_system_time(
 				pmadapter->pmoal_handle, &pmbuf->in_ts_sec,
 				&pmbuf->in_ts_usec);
-			pmadapter->callbacks.moal_spin_lock(
-				pmadapter->pmoal_handle,
-				pmadapter->rx_data_queue.plock);
+			wlan_spin_lock(pmadapter,
+				       pmadapter->rx_data_queue.plock);
 			util_enqueue_list_tail(pmadapter->pmoal_handle,
 					       &pmadapter->rx_data_queue,
 					       (pmlan_linked_list)pmbuf, MNULL,
 					       MNULL);
 			pmadapter->rx_pkts_queued++;
-			pmadapter->callbacks.moal_spin_unlock(
-				pmadapter->pmoal_handle,
-				pmadapter->rx_data_queue.plock);
+			wlan_spin_unlock(pmadapter,
+					 pmadapter->rx_data_queue.plock);
 			pmadapter->data_received = MTRUE;
 			mlan_queue_rx_work(pmadapter);
 		}
@@ -1960,6 +2054,46 @@ t_u8 mlan_select_wmm_queue(t_void *padapter, t_u8 bss_num, t_u8 tid)
 	return ret;
 }
 
+/**
+ *  @brief This function checks if a station over tx_aqm_limit stopped
+ *         the wmm queue
+ *
+ *  @param padapter  A pointer to mlan_adapter structure
+ *  @param bss_num   BSS number
+ *  @param queue     wmm queue index (0-3)
+ *
+ *  @return          MTRUE or MFALSE
+ */
+t_u8 mlan_is_tx_queue_overlimit(t_void *padapter, t_u8 bss_num, t_u8 queue)
+{
+	mlan_adapter *pmadapter = (mlan_adapter *)padapter;
+	pmlan_private pmpriv = pmadapter->priv[bss_num];
+
+	return (pmpriv->wmm.aqm_stop & MBIT(queue)) ? MTRUE : MFALSE;
+}
+
+/**
+ *  @brief This function checks if the wmm queue can be woken, that is
+ *         no station holds it stopped over tx_aqm_limit any more
+ *
+ *  @param padapter  A pointer to mlan_adapter structure
+ *  @param bss_num   BSS number
+ *  @param queue     wmm queue index (0-3)
+ *
+ *  @return          MTRUE or MFALSE
+ */
+t_u8 mlan_tx_queue_can_wake(t_void *padapter, t_u8 bss_num, t_u8 queue)
+{
+	mlan_adapter *pmadapter = (mlan_adapter *)padapter;
+	pmlan_private pmpriv = pmadapter->priv[bss_num];
+	t_u8 ret;
+
+	ENTER();
+	ret = wlan_wmm_aqm_can_wake(pmpriv, queue);
+	LEAVE();
+	return ret;
+}
+
 /**
  *  @brief this function handle the amsdu packet after deaggreate.
  *
@@ -2022,8 +2156,17 @@ mlan_status mlan_interrupt(t_u16 msg_id, t_void *adapter)
 {
 	mlan_adapter *pmadapter = (mlan_adapter *)adapter;
 	mlan_status ret;
+	t_u64 ts = 0;
 
 	ENTER();
+	if (pmadapter->rx_lat_on) {
+		pmadapter->callbacks.moal_get_boot_ktime(
+			pmadapter->pmoal_handle, &ts);
+		wlan_spin_lock(pmadapter, pmadapter->pint_lock);
+		if (!pmadapter->rx_lat_irq_ts)
+			pmadapter->rx_lat_irq_ts = ts;
+		wlan_spin_unlock(pmadapter, pmadapter->pint_lock);
+	}
 	ret = pmadapter->ops.interrupt(msg_id, pmadapter);
 	LEAVE();
 	return ret;
@@ -2058,23 +2201,35 @@ t_void mlan_pm_wakeup_card(t_void *adapter, t_u8 keep_wakeup)
 t_u8 mlan_is_main_process_running(t_void *adapter)
 {
 	mlan_adapter *pmadapter = (mlan_adapter *)adapter;
-	pmlan_callbacks pcb = &pmadapter->callbacks;
 	t_u8 ret = MFALSE;
 	ENTER();
-	pcb->moal_spin_lock(pmadapter->pmoal_handle,
-			    pmadapter->pmain_proc_lock);
+	wlan_spin_lock(pmadapter, pmadapter->pmain_proc_lock);
 
 	/* Check if already processing */
 	if (pmadapter->mlan_processing) {
 		pmadapter->more_task_flag = MTRUE;
 		ret = MTRUE;
 	}
-	pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-			      pmadapter->pmain_proc_lock);
+	wlan_spin_unlock(pmadapter, pmadapter->pmain_proc_lock);
 	LEAVE();
 	return ret;
 }
 
+/**
+ *  @brief This function turns the RX latency trace on or off.
+ *
+ *  @param adapter  A pointer to mlan_adapter structure
+ *  @param on       MTRUE to trace, MFALSE to stop
+ *  @return         N/A
+ */
+t_void mlan_set_rx_lat(t_void *adapter, t_u8 on)
+{
+	mlan_adapter *pmadapter = (mlan_adapter *)adapter;
+	ENTER();
+	pmadapter->rx_lat_on = on;
+	LEAVE();
+}
+
 #ifdef PCIE
 /**
  *  @brief This function sets the PCIE interrupt mode.
@@ -2114,11 +2269,11 @@ void mlan_process_pcie_interrupt_cb(t_void *padapter, int type)
 			return;
 		}
 
-		if (pmadapter->rx_pkts_queued > HIGH_RX_PENDING) {
+		if (wlan_rx_pending_pause(pmadapter,
+					  &pmadapter->delay_rx_data_flag)) {
 			pcb->moal_tp_accounting_rx_param(
 				pmadapter->pmoal_handle, 2, 0);
 			PRINTM(MEVENT, "Pause\n");
-			pmadapter->delay_rx_data_flag = MTRUE;
 			if (pmadapter->napi)
 				mlan_queue_rx_work(pmadapter);
 			else
@@ -2131,11 +2286,9 @@ void mlan_process_pcie_interrupt_cb(t_void *padapter, int type)
 		return;
 	} else if (type == RX_DATA_DELAY) {
 		PRINTM(MEVENT, "Delay Rx DATA\n");
-		pcb->moal_spin_lock(pmadapter->pmoal_handle,
-				    pmadapter->pmlan_rx_lock);
+		wlan_spin_lock(pmadapter, pmadapter->pmlan_rx_lock);
 		pmadapter->pcard_pcie->rx_pending = MFALSE;
-		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
-				      pmadapter->pmlan_rx_lock);
+		wlan_spin_unlock(pmadapter, pmadapter->pmlan_rx_lock);
 		LEAVE();
 		return;
 	}
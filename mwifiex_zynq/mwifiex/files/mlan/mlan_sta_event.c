@@ -1429,7 +1429,7 @@ mlan_status wlan_ops_sta_process_event(t_void *priv)
 #endif
 	case EVENT_CSI:
 		PRINTM(MEVENT, "EVENT: EVENT_CSI on STA\n");
-		wlan_process_csi_event(pmpriv);
+		wlan_process_csi_event(pmpriv, pevent);
 		break;
 	case EVENT_MEF_HOST_WAKEUP:
 		PRINTM(MEVENT, "EVENT: EVENT_MEF_HOST_WAKEUP len=%d\n",
@@ -424,7 +424,8 @@ void wlan_rxpdinfo_to_radiotapinfo(pmlan_private priv, RxPD *prx_pd,
 			   sizeof(rt_info_tmp.extra_info),
 			   sizeof(rt_info_tmp.extra_info));
 
-	memset(priv->adapter, prt_info, 0x00, sizeof(radiotap_info));
+	/* prt_info overlaps the RxPD, it is only written once rt_info_tmp is
+	 * complete */
 	memcpy_ext(priv->adapter, prt_info, &rt_info_tmp, sizeof(rt_info_tmp),
 		   sizeof(radiotap_info));
 
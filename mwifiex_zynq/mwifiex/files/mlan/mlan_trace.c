@@ -0,0 +1,247 @@
+/** @file mlan_trace.c
+ *
+ *  @brief This file contains the per-CPU trace ring that takes the data
+ *  path debug levels (MLAN_TRACE_LEVELS) instead of printk.
+ *
+ *
+ *  Copyright 2026 NXP
+ *
+ *  This software file (the File) is distributed by NXP
+ *  under the terms of the GNU General Public License Version 2, June 1991
+ *  (the License).  You may use, redistribute and/or modify the File in
+ *  accordance with the terms and conditions of the License, a copy of which
+ *  is available by writing to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA or on the
+ *  worldwide web at http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *  THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE EXPRESSLY DISCLAIMED.  The License provides additional details about
+ *  this warranty disclaimer.
+ *
+ */
+
+/********************************************************
+Change log:
+    10/18/2026: initial version
+********************************************************/
+
+#if defined(LINUX) && defined(MLAN_TRACE)
+#include <linux/version.h>
+#include <linux/kernel.h>
+#include <linux/percpu.h>
+#include <linux/rcupdate.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 11, 0)
+#include <linux/sched/clock.h>
+#else
+#include <linux/sched.h>
+#endif
+#include "mlan_decl.h"
+#include "mlan_os.h"
+
+/********************************************************
+			Local Variables
+********************************************************/
+/** Per-CPU trace ring, only written by its own CPU with irqs disabled */
+typedef struct _mlan_trace_ring {
+	/** Number of records written */
+	t_u32 head;
+	/** First record reported by mlan_trace_snapshot */
+	t_u32 start;
+	/** Records */
+	mlan_trace_rec rec[MLAN_TRACE_RING_SIZE];
+} mlan_trace_ring;
+
+/** Trace rings, NULL until mlan_trace_init */
+static mlan_trace_ring __percpu *mlan_trace_rings;
+
+/********************************************************
+			Global Variables
+********************************************************/
+DEFINE_STATIC_KEY_FALSE(mlan_trace_key_MENTRY);
+DEFINE_STATIC_KEY_FALSE(mlan_trace_key_MINFO);
+DEFINE_STATIC_KEY_FALSE(mlan_trace_key_MINTR);
+DEFINE_STATIC_KEY_FALSE(mlan_trace_key_MDATA);
+DEFINE_STATIC_KEY_FALSE(mlan_trace_key_MDAT_D);
+
+/********************************************************
+			Local Functions
+********************************************************/
+/**
+ *  @brief Enable or disable one trace level
+ *
+ *  @param key      Pointer to the static key of the level
+ *  @param on       MTRUE to enable, MFALSE to disable
+ *
+ *  @return         N/A
+ */
+static void mlan_trace_key_set(struct static_key_false *key, t_u32 on)
+{
+	if (on)
+		static_branch_enable(key);
+	else
+		static_branch_disable(key);
+}
+
+/********************************************************
+			Global Functions
+********************************************************/
+/**
+ *  @brief Allocate the trace ring and enable the levels set in mask
+ *
+ *  @param mask     Driver debug mask
+ *
+ *  @return         MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+mlan_status mlan_trace_init(t_u32 mask)
+{
+	mlan_trace_rings = alloc_percpu(mlan_trace_ring);
+	if (!mlan_trace_rings)
+		return MLAN_STATUS_FAILURE;
+	mlan_trace_set_mask(mask);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief Disable all levels and free the trace ring
+ *
+ *  @return         N/A
+ */
+void mlan_trace_exit(void)
+{
+	mlan_trace_ring __percpu *rings = mlan_trace_rings;
+
+	if (!rings)
+		return;
+	mlan_trace_set_mask(0);
+	WRITE_ONCE(mlan_trace_rings, NULL);
+	/* Writers run with irqs disabled, wait for the last of them. Before
+	 * 4.20 only an RCU-sched grace period covers irq-disabled code */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 20, 0)
+	synchronize_rcu();
+#else
+	synchronize_sched();
+#endif
+	free_percpu(rings);
+}
+
+/**
+ *  @brief Enable the trace levels set in mask and disable the others.
+ *         Patches the code, so it must be called from process context.
+ *
+ *  @param mask     Driver debug mask
+ *
+ *  @return         N/A
+ */
+void mlan_trace_set_mask(t_u32 mask)
+{
+	mlan_trace_key_set(&mlan_trace_key_MENTRY, mask & MENTRY);
+	mlan_trace_key_set(&mlan_trace_key_MINFO, mask & MINFO);
+	mlan_trace_key_set(&mlan_trace_key_MINTR, mask & MINTR);
+	mlan_trace_key_set(&mlan_trace_key_MDATA, mask & MDATA);
+	mlan_trace_key_set(&mlan_trace_key_MDAT_D, mask & MDAT_D);
+}
+
+/**
+ *  @brief Write one record to the trace ring of the current CPU, or
+ *         print it when there is no ring (no proc fs, or the ring
+ *         failed to allocate)
+ *
+ *  @param level    Debug level
+ *  @param fmt      Format string
+ *
+ *  @return         N/A
+ */
+void mlan_trace_log(t_u32 level, char *fmt, ...)
+{
+	mlan_trace_ring __percpu *rings;
+	mlan_trace_ring *ring;
+	mlan_trace_rec *rec;
+	unsigned long flags;
+	va_list args;
+	t_u32 head;
+
+	local_irq_save(flags);
+	rings = READ_ONCE(mlan_trace_rings);
+	if (!rings) {
+		local_irq_restore(flags);
+		va_start(args, fmt);
+		vprintk(fmt, args);
+		va_end(args);
+		return;
+	}
+	ring = this_cpu_ptr(rings);
+	head = ring->head;
+	rec = &ring->rec[head & (MLAN_TRACE_RING_SIZE - 1)];
+	/* Invalidate the slot before it is overwritten */
+	WRITE_ONCE(rec->seq, 0);
+	smp_wmb();
+	rec->ts = local_clock();
+	rec->level = level;
+	va_start(args, fmt);
+	vsnprintf(rec->msg, sizeof(rec->msg), fmt, args);
+	va_end(args);
+	smp_wmb();
+	WRITE_ONCE(rec->seq, head + 1);
+	WRITE_ONCE(ring->head, head + 1);
+	local_irq_restore(flags);
+}
+
+/**
+ *  @brief Copy the valid records of one CPU, oldest first. Records that
+ *         are overwritten while they are copied are skipped.
+ *
+ *  @param cpu      CPU number
+ *  @param prec     Pointer to the destination records
+ *  @param num      Number of records prec can hold
+ *
+ *  @return         Number of records copied
+ */
+t_u32 mlan_trace_snapshot(t_u32 cpu, mlan_trace_rec *prec, t_u32 num)
+{
+	mlan_trace_ring __percpu *rings = READ_ONCE(mlan_trace_rings);
+	mlan_trace_ring *ring;
+	mlan_trace_rec *rec;
+	t_u32 head, pos, seq;
+	t_u32 count = 0;
+
+	if (!rings || cpu >= nr_cpu_ids || !cpu_possible(cpu))
+		return 0;
+	ring = per_cpu_ptr(rings, cpu);
+	head = READ_ONCE(ring->head);
+	pos = READ_ONCE(ring->start);
+	if (head - pos > MLAN_TRACE_RING_SIZE)
+		pos = head - MLAN_TRACE_RING_SIZE;
+	for (; pos != head && count < num; pos++) {
+		rec = &ring->rec[pos & (MLAN_TRACE_RING_SIZE - 1)];
+		seq = READ_ONCE(rec->seq);
+		smp_rmb();
+		memcpy(&prec[count], rec, sizeof(*rec));
+		smp_rmb();
+		if (seq != pos + 1 || READ_ONCE(rec->seq) != seq)
+			continue;
+		prec[count].msg[MLAN_TRACE_MSG_LEN - 1] = '\0';
+		count++;
+	}
+	return count;
+}
+
+/**
+ *  @brief Drop the records logged so far from later snapshots
+ *
+ *  @return         N/A
+ */
+void mlan_trace_reset(void)
+{
+	mlan_trace_ring __percpu *rings = READ_ONCE(mlan_trace_rings);
+	mlan_trace_ring *ring;
+	int cpu;
+
+	if (!rings)
+		return;
+	for_each_possible_cpu (cpu) {
+		ring = per_cpu_ptr(rings, cpu);
+		WRITE_ONCE(ring->start, READ_ONCE(ring->head));
+	}
+}
+#endif /* LINUX && MLAN_TRACE */
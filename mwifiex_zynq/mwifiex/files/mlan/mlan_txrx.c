@@ -210,12 +210,14 @@ mlan_status wlan_process_tx(pmlan_private priv, pmlan_buffer pmbuf,
 
 	if (dest_mac_first_octet & 0x01)
 		wlan_drv_mcast_cycle_delay_calulation(pmadapter, pmbuf);
+	wlan_tx_lat_stamp(pmadapter, pmbuf, MLAN_TX_LAT_AGGR);
 	if (pmadapter->tp_state_on)
 		pmadapter->callbacks.moal_tp_accounting(pmadapter->pmoal_handle,
 							pmbuf, 4);
 	if (pmadapter->tp_state_drop_point == 4)
 		goto done;
 	else {
+		wlan_tx_lat_stamp(pmadapter, pmbuf, MLAN_TX_LAT_BUS);
 		ret = pmadapter->ops.host_to_card(priv, MLAN_TYPE_DATA, pmbuf,
 						  tx_param);
 	}
@@ -270,6 +272,33 @@ done:
 	return ret;
 }
 
+#ifdef UAP_SUPPORT
+/**
+ *  @brief Account the forward latency of a sent intra-BSS packet,
+ *         measured from the time it was queued in WMM
+ *
+ *  @param pmadapter  A pointer to mlan_adapter structure
+ *  @param pmbuf      A pointer to the mlan_buffer
+ *
+ *  @return           N/A
+ */
+static t_void wlan_bridge_fwd_done(pmlan_adapter pmadapter, pmlan_buffer pmbuf)
+{
+	t_u32 sec = 0, usec = 0;
+	t_u32 delay;
+
+	if (!(pmbuf->flags & MLAN_BUF_FLAG_BRIDGE_BUF) || !pmbuf->in_ts_sec)
+		return;
+	pmadapter->callbacks.moal_get_system_time(pmadapter->pmoal_handle,
+						  &sec, &usec);
+	delay = (sec - pmbuf->in_ts_sec) * 1000000 + usec - pmbuf->in_ts_usec;
+	pmadapter->bridge_fwd_done++;
+	pmadapter->bridge_fwd_lat += delay;
+	if (delay > pmadapter->bridge_fwd_lat_max)
+		pmadapter->bridge_fwd_lat_max = delay;
+}
+#endif
+
 /**
  *  @brief Packet send completion handling
  *
@@ -305,6 +334,15 @@ mlan_status wlan_write_data_complete(pmlan_adapter pmadapter,
 			t_u32 i, use_count = pmbuf->use_count;
 			for (i = 0; i <= use_count; i++) {
 				pmbuf_next = pmbuf->pnext;
+#ifdef UAP_SUPPORT
+				if (status == MLAN_STATUS_SUCCESS)
+					wlan_bridge_fwd_done(pmadapter, pmbuf);
+#endif
+				if (status == MLAN_STATUS_SUCCESS &&
+				    pmbuf->tx_lat_ts[MLAN_TX_LAT_XMIT])
+					pcb->moal_tp_accounting(
+						pmadapter->pmoal_handle, pmbuf,
+						MLAN_TX_LAT_DROP_POINT);
 				if (pmbuf->flags & MLAN_BUF_FLAG_MOAL_TX_BUF)
 					pcb->moal_send_packet_complete(
 						pmadapter->pmoal_handle, pmbuf,
@@ -315,6 +353,16 @@ mlan_status wlan_write_data_complete(pmlan_adapter pmadapter,
 			}
 		} else {
 #endif
+#ifdef UAP_SUPPORT
+			if (status == MLAN_STATUS_SUCCESS)
+				wlan_bridge_fwd_done(pmadapter, pmbuf);
+#endif
+			/* Report the TX latency of a traced packet */
+			if (status == MLAN_STATUS_SUCCESS &&
+			    pmbuf->tx_lat_ts[MLAN_TX_LAT_XMIT])
+				pcb->moal_tp_accounting(pmadapter->pmoal_handle,
+							pmbuf,
+							MLAN_TX_LAT_DROP_POINT);
 			if (pmbuf->flags & MLAN_BUF_FLAG_MOAL_TX_BUF) {
 				/* pmbuf was allocated by MOAL */
 				pcb->moal_send_packet_complete(
@@ -357,7 +405,8 @@ mlan_status wlan_recv_packet_complete(pmlan_adapter pmadapter,
 	MASSERT(pmbuf->bss_index < pmadapter->priv_num);
 
 	if (pmbuf->pparent) {
-		/** we will free the pparaent at the end of deaggr */
+		/** we will free the pparaent at the end of deaggr, a
+		 *  MLAN_BUF_FLAG_RX_VIEW child only drops its descriptor */
 		wlan_free_mlan_buffer(pmadapter, pmbuf);
 	} else {
 		pmadapter->ops.data_complete(pmadapter, pmbuf, status);
@@ -382,14 +431,15 @@ t_void wlan_add_buf_bypass_txqueue(mlan_adapter *pmadapter, pmlan_buffer pmbuf)
 
 	if (pmbuf->buf_type != MLAN_BUF_TYPE_RAW_DATA)
 		pmbuf->buf_type = MLAN_BUF_TYPE_DATA;
-	util_scalar_increment(pmadapter->pmoal_handle,
-			      &pmadapter->bypass_pkt_count,
-			      pmadapter->callbacks.moal_spin_lock,
-			      pmadapter->callbacks.moal_spin_unlock);
+	util_scalar_atomic_add(pmadapter->pmoal_handle,
+			       &pmadapter->bypass_pkt_count, 1,
+			       wlan_atomic_add_cb(pmadapter),
+			       wlan_lock_cb(pmadapter),
+			       wlan_unlock_cb(pmadapter));
 	util_enqueue_list_tail(pmadapter->pmoal_handle, &priv->bypass_txq,
 			       (pmlan_linked_list)pmbuf,
-			       pmadapter->callbacks.moal_spin_lock,
-			       pmadapter->callbacks.moal_spin_unlock);
+			       wlan_lock_cb(pmadapter),
+			       wlan_unlock_cb(pmadapter));
 	LEAVE();
 }
 
@@ -405,7 +455,6 @@ INLINE t_u8 wlan_bypass_tx_list_empty(mlan_adapter *pmadapter)
 	t_u32 bypass_pkt_count;
 #if defined(USB)
 	if (IS_USB(pmadapter->card_type)) {
-		pmlan_callbacks pcb = &pmadapter->callbacks;
 		pmlan_private priv;
 		int j = 0;
 		for (j = 0; j < pmadapter->priv_num; ++j) {
@@ -416,8 +465,8 @@ INLINE t_u8 wlan_bypass_tx_list_empty(mlan_adapter *pmadapter)
 					continue;
 				if (util_peek_list(pmadapter->pmoal_handle,
 						   &priv->bypass_txq,
-						   pcb->moal_spin_lock,
-						   pcb->moal_spin_unlock))
+						   wlan_lock_cb(pmadapter),
+						   wlan_unlock_cb(pmadapter)))
 					return MFALSE;
 			}
 		}
@@ -425,10 +474,11 @@ INLINE t_u8 wlan_bypass_tx_list_empty(mlan_adapter *pmadapter)
 	}
 #endif
 	bypass_pkt_count =
-		util_scalar_read(pmadapter->pmoal_handle,
-				 &pmadapter->bypass_pkt_count,
-				 pmadapter->callbacks.moal_spin_lock,
-				 pmadapter->callbacks.moal_spin_unlock);
+		util_scalar_atomic_read(pmadapter->pmoal_handle,
+					&pmadapter->bypass_pkt_count,
+					wlan_atomic_read_cb(pmadapter),
+					wlan_lock_cb(pmadapter),
+					wlan_unlock_cb(pmadapter));
 	return (bypass_pkt_count) ? MFALSE : MTRUE;
 }
 
@@ -444,21 +494,20 @@ t_void wlan_cleanup_bypass_txq(mlan_private *priv)
 	pmlan_buffer pmbuf;
 	mlan_adapter *pmadapter = priv->adapter;
 	ENTER();
-	pmadapter->callbacks.moal_spin_lock(pmadapter->pmoal_handle,
-					    priv->bypass_txq.plock);
+	wlan_spin_lock(pmadapter, priv->bypass_txq.plock);
 	while ((pmbuf = (pmlan_buffer)util_peek_list(pmadapter->pmoal_handle,
 						     &priv->bypass_txq, MNULL,
 						     MNULL))) {
 		util_unlink_list(pmadapter->pmoal_handle, &priv->bypass_txq,
 				 (pmlan_linked_list)pmbuf, MNULL, MNULL);
 		wlan_write_data_complete(pmadapter, pmbuf, MLAN_STATUS_FAILURE);
-		util_scalar_decrement(pmadapter->pmoal_handle,
-				      &pmadapter->bypass_pkt_count,
-				      pmadapter->callbacks.moal_spin_lock,
-				      pmadapter->callbacks.moal_spin_unlock);
+		util_scalar_atomic_sub(pmadapter->pmoal_handle,
+				       &pmadapter->bypass_pkt_count, 1,
+				       wlan_atomic_sub_cb(pmadapter),
+				       wlan_lock_cb(pmadapter),
+				       wlan_unlock_cb(pmadapter));
 	}
-	pmadapter->callbacks.moal_spin_unlock(pmadapter->pmoal_handle,
-					      priv->bypass_txq.plock);
+	wlan_spin_unlock(pmadapter, priv->bypass_txq.plock);
 	LEAVE();
 }
 
@@ -489,16 +538,15 @@ t_void wlan_process_bypass_tx(pmlan_adapter pmadapter)
 				pmbuf = (pmlan_buffer)util_dequeue_list(
 					pmadapter->pmoal_handle,
 					&priv->bypass_txq,
-					pmadapter->callbacks.moal_spin_lock,
-					pmadapter->callbacks.moal_spin_unlock);
+					wlan_lock_cb(pmadapter),
+					wlan_unlock_cb(pmadapter));
 				if (pmbuf) {
-					util_scalar_decrement(
+					util_scalar_atomic_sub(
 						pmadapter->pmoal_handle,
-						&pmadapter->bypass_pkt_count,
-						pmadapter->callbacks
-							.moal_spin_lock,
-						pmadapter->callbacks
-							.moal_spin_unlock);
+						&pmadapter->bypass_pkt_count, 1,
+						wlan_atomic_sub_cb(pmadapter),
+						wlan_lock_cb(pmadapter),
+						wlan_unlock_cb(pmadapter));
 					PRINTM(MINFO,
 					       "Dequeuing bypassed packet %p\n",
 					       pmbuf);
@@ -516,22 +564,20 @@ t_void wlan_process_bypass_tx(pmlan_adapter pmadapter)
 						/* Queue the packet again so
 						 * that it will be TX'ed later
 						 */
-						util_scalar_increment(
+						util_scalar_atomic_add(
 							pmadapter->pmoal_handle,
 							&pmadapter->bypass_pkt_count,
-							pmadapter->callbacks
-								.moal_spin_lock,
-							pmadapter->callbacks
-								.moal_spin_unlock);
+							1,
+							wlan_atomic_add_cb(pmadapter),
+							wlan_lock_cb(pmadapter),
+							wlan_unlock_cb(pmadapter));
 
 						util_enqueue_list_head(
 							pmadapter->pmoal_handle,
 							&priv->bypass_txq,
 							(pmlan_linked_list)pmbuf,
-							pmadapter->callbacks
-								.moal_spin_lock,
-							pmadapter->callbacks
-								.moal_spin_unlock);
+							wlan_lock_cb(pmadapter),
+							wlan_unlock_cb(pmadapter));
 					}
 					break;
 				} else {
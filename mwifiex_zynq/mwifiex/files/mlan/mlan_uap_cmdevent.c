@@ -618,8 +618,10 @@ static void wlan_process_tx_pause_event(pmlan_private priv, pmlan_buffer pevent)
 	ENTER();
 
 	total_pkts_queued =
-		util_scalar_read(priv->adapter->pmoal_handle,
-				 &priv->wmm.tx_pkts_queued, MNULL, MNULL);
+		util_scalar_atomic_read(
+			priv->adapter->pmoal_handle, &priv->wmm.tx_pkts_queued,
+			wlan_atomic_read_cb(priv->adapter), MNULL,
+			MNULL);
 	while (tlv_buf_left >= (int)sizeof(MrvlIEtypesHeader_t)) {
 		tlv_type = wlan_le16_to_cpu(tlv->type);
 		tlv_len = wlan_le16_to_cpu(tlv->len);
@@ -6245,7 +6247,7 @@ mlan_status wlan_ops_uap_process_event(t_void *priv)
 		break;
 	case EVENT_CSI:
 		PRINTM(MEVENT, "EVENT: EVENT_CSI on UAP\n");
-		wlan_process_csi_event(pmpriv);
+		wlan_process_csi_event(pmpriv, pevent);
 		break;
 
 	case EVENT_WLS_FTM_COMPLETE:
@@ -106,6 +106,170 @@ static mlan_status wlan_upload_uap_rx_packet(pmlan_adapter pmadapter,
 	return ret;
 }
 
+/**
+ *  @brief This function queues an 802.3 frame for intra-BSS forwarding
+ *         and applies the bridge backpressure
+ *
+ *  @param priv      A pointer to mlan_private
+ *  @param pmbuf     A pointer to mlan_buffer with TxPD headroom
+ *
+ *  @return          N/A
+ */
+static t_void wlan_uap_queue_bridge_pkt(mlan_private *priv, pmlan_buffer pmbuf)
+{
+	pmlan_adapter pmadapter = priv->adapter;
+
+	pmbuf->flags |= MLAN_BUF_FLAG_BRIDGE_BUF;
+	pmbuf->pparent = MNULL;
+	util_scalar_atomic_add(pmadapter->pmoal_handle,
+			       &pmadapter->pending_bridge_pkts, 1,
+			       wlan_atomic_add_cb(pmadapter),
+			       wlan_lock_cb(pmadapter),
+			       wlan_unlock_cb(pmadapter));
+	wlan_wmm_add_buf_txqueue(pmadapter, pmbuf);
+	if (util_scalar_atomic_read(pmadapter->pmoal_handle,
+				    &pmadapter->pending_bridge_pkts,
+				    wlan_atomic_read_cb(pmadapter),
+				    wlan_lock_cb(pmadapter),
+				    wlan_unlock_cb(pmadapter)) >
+	    RX_HIGH_THRESHOLD)
+		wlan_drop_tx_pkts(priv);
+	wlan_recv_event(priv, MLAN_EVENT_ID_DRV_DEFER_HANDLING, MNULL);
+}
+
+/**
+ *  @brief This function forwards a copy of a received 802.3 frame
+ *
+ *  @param priv      A pointer to mlan_private
+ *  @param pmbuf     A pointer to the received mlan_buffer
+ *  @param offset    Offset of the 802.3 frame from data_offset
+ *
+ *  @return          MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status wlan_uap_bridge_copy(mlan_private *priv, pmlan_buffer pmbuf,
+					t_u32 offset)
+{
+	pmlan_adapter pmadapter = priv->adapter;
+	pmlan_buffer newbuf = MNULL;
+
+	newbuf = wlan_alloc_mlan_buffer(pmadapter, MLAN_TX_DATA_BUF_SIZE_2K, 0,
+					MOAL_MALLOC_BUFFER);
+	if (!newbuf)
+		return MLAN_STATUS_FAILURE;
+	newbuf->bss_index = pmbuf->bss_index;
+	newbuf->buf_type = pmbuf->buf_type;
+	newbuf->priority = pmbuf->priority;
+	newbuf->in_ts_sec = pmbuf->in_ts_sec;
+	newbuf->in_ts_usec = pmbuf->in_ts_usec;
+	newbuf->data_offset =
+		(Tx_PD_SIZEOF(pmadapter) + priv->intf_hr_len + DMA_ALIGNMENT);
+	/* copy the data, skip rxpd */
+	memcpy_ext(pmadapter, (t_u8 *)newbuf->pbuf + newbuf->data_offset,
+		   pmbuf->pbuf + pmbuf->data_offset + offset,
+		   pmbuf->data_len - offset, MLAN_TX_DATA_BUF_SIZE_2K);
+	newbuf->data_len = pmbuf->data_len - offset;
+	wlan_uap_queue_bridge_pkt(priv, newbuf);
+	pmadapter->bridge_copy_pkts++;
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function checks if a received buffer can be sent back
+ *         to firmware as is: it must own its data and leave room for
+ *         the TxPD once the first offset bytes are chopped
+ *
+ *  @param priv      A pointer to mlan_private
+ *  @param pmbuf     A pointer to the received mlan_buffer
+ *  @param offset    Offset of the 802.3 frame from data_offset
+ *
+ *  @return          MTRUE or MFALSE
+ */
+static t_u8 wlan_uap_bridge_in_place(mlan_private *priv, pmlan_buffer pmbuf,
+				     t_u32 offset)
+{
+	pmlan_adapter pmadapter = priv->adapter;
+
+	if (pmbuf->flags & MLAN_BUF_FLAG_RX_VIEW)
+		return MFALSE;
+#ifdef USB
+	if (IS_USB(pmadapter->card_type) &&
+	    (pmbuf->flags & MLAN_BUF_FLAG_RX_DEAGGR))
+		return MFALSE;
+#endif
+	if (pmbuf->data_offset + offset <
+	    (Tx_PD_SIZEOF(pmadapter) + priv->intf_hr_len + DMA_ALIGNMENT))
+		return MFALSE;
+	return MTRUE;
+}
+
+/**
+ *  @brief This function checks if a received multicast buffer can be
+ *         forwarded in place while a copy of it goes up the stack
+ *
+ *  @param priv      A pointer to mlan_private
+ *  @param pmbuf     A pointer to the received mlan_buffer
+ *  @param offset    Offset of the 802.3 frame from data_offset
+ *
+ *  @return          MTRUE or MFALSE
+ */
+static t_u8 wlan_uap_bridge_shared(mlan_private *priv, pmlan_buffer pmbuf,
+				   t_u32 offset)
+{
+	if (!priv->adapter->uap_fwd_zcopy)
+		return MFALSE;
+#ifdef USB
+	if (IS_USB(priv->adapter->card_type))
+		return MFALSE;
+#endif
+	return wlan_uap_bridge_in_place(priv, pmbuf, offset);
+}
+
+/**
+ *  @brief This function uploads a copy of a received buffer which
+ *         itself is forwarded in place. The view has no parent, so
+ *         MOAL copies it into a new skb instead of cloning: the stack
+ *         must not share data with a buffer the tx path writes to.
+ *
+ *  @param priv      A pointer to mlan_private
+ *  @param pmbuf     A pointer to the received mlan_buffer
+ *  @param offset    Offset of the 802.3 frame from data_offset
+ *
+ *  @return          MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status wlan_uap_upload_view(mlan_private *priv, pmlan_buffer pmbuf,
+					t_u32 offset)
+{
+	pmlan_adapter pmadapter = priv->adapter;
+	pmlan_buffer view = MNULL;
+	mlan_status ret = MLAN_STATUS_SUCCESS;
+
+	view = wlan_alloc_mlan_buffer(pmadapter, 0, 0, MOAL_MALLOC_BUFFER);
+	if (!view) {
+		PRINTM(MERROR, "uAP Rx: failed to allocate view\n");
+		return MLAN_STATUS_FAILURE;
+	}
+	view->pbuf = pmbuf->pbuf;
+	view->data_offset = pmbuf->data_offset + offset;
+	view->data_len = pmbuf->data_len - offset;
+	view->flags |= MLAN_BUF_FLAG_RX_VIEW |
+		       (pmbuf->flags & MLAN_BUF_FLAG_EASYMESH);
+	view->bss_index = pmbuf->bss_index;
+	view->buf_type = pmbuf->buf_type;
+	view->priority = pmbuf->priority;
+	view->in_ts_sec = pmbuf->in_ts_sec;
+	view->in_ts_usec = pmbuf->in_ts_usec;
+	if (pmbuf->flags & MLAN_BUF_FLAG_EASYMESH)
+		memcpy_ext(pmadapter, view->mac, pmbuf->mac,
+			   MLAN_MAC_ADDR_LENGTH, MLAN_MAC_ADDR_LENGTH);
+	ret = pmadapter->callbacks.moal_recv_packet(pmadapter->pmoal_handle,
+						    view);
+	if (ret == MLAN_STATUS_FAILURE)
+		PRINTM(MERROR, "uAP Rx Error: moal_recv_packet returned error\n");
+	/* MOAL never takes ownership of a view */
+	wlan_free_mlan_buffer(pmadapter, view);
+	return ret;
+}
+
 /********************************************************
 			Global Functions
 ********************************************************/
@@ -602,7 +766,6 @@ mlan_status wlan_uap_recv_packet(mlan_private *priv, pmlan_buffer pmbuf)
 	pmlan_adapter pmadapter = priv->adapter;
 	mlan_status ret = MLAN_STATUS_SUCCESS;
 	RxPacketHdr_t *prx_pkt;
-	pmlan_buffer newbuf = MNULL;
 
 	ENTER();
 
@@ -621,95 +784,28 @@ mlan_status wlan_uap_recv_packet(mlan_private *priv, pmlan_buffer pmbuf)
 	if (prx_pkt->eth803_hdr.dest_addr[0] & 0x01) {
 		if (!(priv->pkt_fwd & PKT_FWD_INTRA_BCAST)) {
 			/* Multicast pkt */
-			newbuf =
-				wlan_alloc_mlan_buffer(pmadapter,
-						       MLAN_TX_DATA_BUF_SIZE_2K,
-						       0, MOAL_MALLOC_BUFFER);
-			if (newbuf) {
-				newbuf->bss_index = pmbuf->bss_index;
-				newbuf->buf_type = pmbuf->buf_type;
-				newbuf->priority = pmbuf->priority;
-				newbuf->in_ts_sec = pmbuf->in_ts_sec;
-				newbuf->in_ts_usec = pmbuf->in_ts_usec;
-				newbuf->data_offset =
-					(Tx_PD_SIZEOF(pmadapter) +
-					 priv->intf_hr_len + DMA_ALIGNMENT);
-				util_scalar_increment(
-					pmadapter->pmoal_handle,
-					&pmadapter->pending_bridge_pkts,
-					pmadapter->callbacks.moal_spin_lock,
-					pmadapter->callbacks.moal_spin_unlock);
-
-				newbuf->flags |= MLAN_BUF_FLAG_BRIDGE_BUF;
-
-				/* copy the data */
-				memcpy_ext(pmadapter,
-					   (t_u8 *)newbuf->pbuf +
-						   newbuf->data_offset,
-					   pmbuf->pbuf + pmbuf->data_offset,
-					   pmbuf->data_len,
-					   MLAN_TX_DATA_BUF_SIZE_2K);
-				newbuf->data_len = pmbuf->data_len;
-				wlan_wmm_add_buf_txqueue(pmadapter, newbuf);
-				if (util_scalar_read(
-					    pmadapter->pmoal_handle,
-					    &pmadapter->pending_bridge_pkts,
-					    pmadapter->callbacks.moal_spin_lock,
-					    pmadapter->callbacks
-						    .moal_spin_unlock) >
-				    RX_HIGH_THRESHOLD)
-					wlan_drop_tx_pkts(priv);
-				wlan_recv_event(
-					priv, MLAN_EVENT_ID_DRV_DEFER_HANDLING,
-					MNULL);
+			if (wlan_uap_bridge_shared(priv, pmbuf, 0)) {
+				wlan_uap_upload_view(priv, pmbuf, 0);
+				wlan_uap_queue_bridge_pkt(priv, pmbuf);
+				pmadapter->bridge_zcopy_pkts++;
+				/* the subframe now belongs to the tx path */
+				ret = MLAN_STATUS_PENDING;
+				goto done;
 			}
+			wlan_uap_bridge_copy(priv, pmbuf, 0);
 		}
 	} else {
 		if ((!(priv->pkt_fwd & PKT_FWD_INTRA_UCAST)) &&
 		    (wlan_get_station_entry(priv,
 					    prx_pkt->eth803_hdr.dest_addr))) {
 			/* Intra BSS packet */
-			newbuf =
-				wlan_alloc_mlan_buffer(pmadapter,
-						       MLAN_TX_DATA_BUF_SIZE_2K,
-						       0, MOAL_MALLOC_BUFFER);
-			if (newbuf) {
-				newbuf->bss_index = pmbuf->bss_index;
-				newbuf->buf_type = pmbuf->buf_type;
-				newbuf->priority = pmbuf->priority;
-				newbuf->in_ts_sec = pmbuf->in_ts_sec;
-				newbuf->in_ts_usec = pmbuf->in_ts_usec;
-				newbuf->data_offset =
-					(Tx_PD_SIZEOF(pmadapter) +
-					 priv->intf_hr_len + DMA_ALIGNMENT);
-				util_scalar_increment(
-					pmadapter->pmoal_handle,
-					&pmadapter->pending_bridge_pkts,
-					pmadapter->callbacks.moal_spin_lock,
-					pmadapter->callbacks.moal_spin_unlock);
-				newbuf->flags |= MLAN_BUF_FLAG_BRIDGE_BUF;
-
-				/* copy the data */
-				memcpy_ext(pmadapter,
-					   (t_u8 *)newbuf->pbuf +
-						   newbuf->data_offset,
-					   pmbuf->pbuf + pmbuf->data_offset,
-					   pmbuf->data_len,
-					   MLAN_TX_DATA_BUF_SIZE_2K);
-				newbuf->data_len = pmbuf->data_len;
-				wlan_wmm_add_buf_txqueue(pmadapter, newbuf);
-				if (util_scalar_read(
-					    pmadapter->pmoal_handle,
-					    &pmadapter->pending_bridge_pkts,
-					    pmadapter->callbacks.moal_spin_lock,
-					    pmadapter->callbacks
-						    .moal_spin_unlock) >
-				    RX_HIGH_THRESHOLD)
-					wlan_drop_tx_pkts(priv);
-				wlan_recv_event(
-					priv, MLAN_EVENT_ID_DRV_DEFER_HANDLING,
-					MNULL);
+			if (wlan_uap_bridge_in_place(priv, pmbuf, 0)) {
+				wlan_uap_queue_bridge_pkt(priv, pmbuf);
+				pmadapter->bridge_zcopy_pkts++;
+				ret = MLAN_STATUS_PENDING;
+				goto done;
 			}
+			wlan_uap_bridge_copy(priv, pmbuf, 0);
 			goto done;
 		}
 	}
@@ -737,7 +833,6 @@ mlan_status wlan_process_uap_rx_packet(mlan_private *priv, pmlan_buffer pmbuf)
 	mlan_status ret = MLAN_STATUS_SUCCESS;
 	RxPD *prx_pd;
 	RxPacketHdr_t *prx_pkt;
-	pmlan_buffer newbuf = MNULL;
 
 	ENTER();
 
@@ -772,145 +867,44 @@ mlan_status wlan_process_uap_rx_packet(mlan_private *priv, pmlan_buffer pmbuf)
 	if (prx_pkt->eth803_hdr.dest_addr[0] & 0x01) {
 		if (!(priv->pkt_fwd & PKT_FWD_INTRA_BCAST)) {
 			/* Multicast pkt */
-			newbuf =
-				wlan_alloc_mlan_buffer(pmadapter,
-						       MLAN_TX_DATA_BUF_SIZE_2K,
-						       0, MOAL_MALLOC_BUFFER);
-			if (newbuf) {
-				newbuf->bss_index = pmbuf->bss_index;
-				newbuf->buf_type = pmbuf->buf_type;
-				newbuf->priority = pmbuf->priority;
-				newbuf->in_ts_sec = pmbuf->in_ts_sec;
-				newbuf->in_ts_usec = pmbuf->in_ts_usec;
-				newbuf->data_offset =
-					(Tx_PD_SIZEOF(pmadapter) +
-					 priv->intf_hr_len + DMA_ALIGNMENT);
-				util_scalar_increment(
-					pmadapter->pmoal_handle,
-					&pmadapter->pending_bridge_pkts,
-					pmadapter->callbacks.moal_spin_lock,
-					pmadapter->callbacks.moal_spin_unlock);
-				newbuf->flags |= MLAN_BUF_FLAG_BRIDGE_BUF;
-
-				/* copy the data, skip rxpd */
-				memcpy_ext(pmadapter,
-					   (t_u8 *)newbuf->pbuf +
-						   newbuf->data_offset,
-					   pmbuf->pbuf + pmbuf->data_offset +
-						   prx_pd->rx_pkt_offset,
-					   pmbuf->data_len -
-						   prx_pd->rx_pkt_offset,
-					   MLAN_TX_DATA_BUF_SIZE_2K);
-				newbuf->data_len =
-					pmbuf->data_len - prx_pd->rx_pkt_offset;
-				wlan_wmm_add_buf_txqueue(pmadapter, newbuf);
-				if (util_scalar_read(
-					    pmadapter->pmoal_handle,
-					    &pmadapter->pending_bridge_pkts,
-					    pmadapter->callbacks.moal_spin_lock,
-					    pmadapter->callbacks
-						    .moal_spin_unlock) >
-				    RX_HIGH_THRESHOLD)
-					wlan_drop_tx_pkts(priv);
-				wlan_recv_event(
-					priv, MLAN_EVENT_ID_DRV_DEFER_HANDLING,
-					MNULL);
+			if (wlan_uap_bridge_shared(priv, pmbuf,
+						   prx_pd->rx_pkt_offset)) {
+				ret = wlan_uap_upload_view(priv, pmbuf,
+							   prx_pd->rx_pkt_offset);
+				pmbuf->data_len -= prx_pd->rx_pkt_offset;
+				pmbuf->data_offset += prx_pd->rx_pkt_offset;
+				wlan_uap_queue_bridge_pkt(priv, pmbuf);
+				pmadapter->bridge_zcopy_pkts++;
+				goto done;
 			}
+			wlan_uap_bridge_copy(priv, pmbuf, prx_pd->rx_pkt_offset);
 		}
 	} else {
 		if ((!(priv->pkt_fwd & PKT_FWD_INTRA_UCAST)) &&
 		    (wlan_get_station_entry(priv,
 					    prx_pkt->eth803_hdr.dest_addr))) {
 			/* Forwarding Intra-BSS packet */
+			if (!wlan_uap_bridge_in_place(priv, pmbuf,
+						      prx_pd->rx_pkt_offset)) {
+				ret = wlan_uap_bridge_copy(priv, pmbuf,
+							   prx_pd->rx_pkt_offset);
 #ifdef USB
-			if (IS_USB(pmadapter->card_type)) {
-				if (pmbuf->flags & MLAN_BUF_FLAG_RX_DEAGGR) {
-					newbuf = wlan_alloc_mlan_buffer(
-						pmadapter,
-						MLAN_TX_DATA_BUF_SIZE_2K, 0,
-						MOAL_MALLOC_BUFFER);
-					if (newbuf) {
-						newbuf->bss_index =
-							pmbuf->bss_index;
-						newbuf->buf_type =
-							pmbuf->buf_type;
-						newbuf->priority =
-							pmbuf->priority;
-						newbuf->in_ts_sec =
-							pmbuf->in_ts_sec;
-						newbuf->in_ts_usec =
-							pmbuf->in_ts_usec;
-						newbuf->data_offset =
-							(Tx_PD_SIZEOF(
-								 pmadapter) +
-							 priv->intf_hr_len +
-							 DMA_ALIGNMENT);
-						util_scalar_increment(
-							pmadapter->pmoal_handle,
-							&pmadapter->pending_bridge_pkts,
-							pmadapter->callbacks
-								.moal_spin_lock,
-							pmadapter->callbacks
-								.moal_spin_unlock);
-						newbuf->flags |=
-							MLAN_BUF_FLAG_BRIDGE_BUF;
-
-						/* copy the data, skip rxpd */
-						memcpy_ext(
-							pmadapter,
-							(t_u8 *)newbuf->pbuf +
-								newbuf->data_offset,
-							pmbuf->pbuf +
-								pmbuf->data_offset +
-								prx_pd->rx_pkt_offset,
-							pmbuf->data_len -
-								prx_pd->rx_pkt_offset,
-							pmbuf->data_len -
-								prx_pd->rx_pkt_offset);
-						newbuf->data_len =
-							pmbuf->data_len -
-							prx_pd->rx_pkt_offset;
-						wlan_wmm_add_buf_txqueue(
-							pmadapter, newbuf);
-						if (util_scalar_read(
-							    pmadapter->pmoal_handle,
-							    &pmadapter->pending_bridge_pkts,
-							    pmadapter->callbacks
-								    .moal_spin_lock,
-							    pmadapter->callbacks
-								    .moal_spin_unlock) >
-						    RX_HIGH_THRESHOLD)
-							wlan_drop_tx_pkts(priv);
-						wlan_recv_event(
-							priv,
-							MLAN_EVENT_ID_DRV_DEFER_HANDLING,
-							MNULL);
-					}
+				if (IS_USB(pmadapter->card_type) &&
+				    (pmbuf->flags & MLAN_BUF_FLAG_RX_DEAGGR)) {
 					pmadapter->callbacks.moal_recv_complete(
 						pmadapter->pmoal_handle, pmbuf,
 						pmadapter->rx_data_ep, ret);
 					goto done;
 				}
-			}
 #endif
+				pmadapter->ops.data_complete(pmadapter, pmbuf,
+							     ret);
+				goto done;
+			}
 			pmbuf->data_len -= prx_pd->rx_pkt_offset;
 			pmbuf->data_offset += prx_pd->rx_pkt_offset;
-			pmbuf->flags |= MLAN_BUF_FLAG_BRIDGE_BUF;
-			util_scalar_increment(
-				pmadapter->pmoal_handle,
-				&pmadapter->pending_bridge_pkts,
-				pmadapter->callbacks.moal_spin_lock,
-				pmadapter->callbacks.moal_spin_unlock);
-			wlan_wmm_add_buf_txqueue(pmadapter, pmbuf);
-			if (util_scalar_read(
-				    pmadapter->pmoal_handle,
-				    &pmadapter->pending_bridge_pkts,
-				    pmadapter->callbacks.moal_spin_lock,
-				    pmadapter->callbacks.moal_spin_unlock) >
-			    RX_HIGH_THRESHOLD)
-				wlan_drop_tx_pkts(priv);
-			wlan_recv_event(priv, MLAN_EVENT_ID_DRV_DEFER_HANDLING,
-					MNULL);
+			wlan_uap_queue_bridge_pkt(priv, pmbuf);
+			pmadapter->bridge_zcopy_pkts++;
 			goto done;
 		}
 	}
@@ -301,16 +301,23 @@ static mlan_status wlan_usb_prog_fw_w_helper(pmlan_adapter pmadapter,
 		} else {
 			/* Copy the header of the firmware data to get the
 			 * length */
-			if (firmware)
+			if (firmware) {
 				memcpy_ext(pmadapter, &fwdata->fw_header,
 					   &firmware[TotalBytes],
 					   sizeof(FWHeader),
 					   sizeof(fwdata->fw_header));
-			else
-				pcb->moal_get_fw_data(
-					pmadapter->pmoal_handle, TotalBytes,
-					sizeof(FWHeader),
-					(t_u8 *)&fwdata->fw_header);
+			} else if (pcb->moal_get_fw_data(
+					   pmadapter->pmoal_handle, TotalBytes,
+					   sizeof(FWHeader),
+					   (t_u8 *)&fwdata->fw_header) !=
+				   MLAN_STATUS_SUCCESS) {
+				PRINTM(MERROR,
+				       "fw_dnld: get fw header failed @ %d\n",
+				       TotalBytes);
+				retries = 0;
+				ret = MLAN_STATUS_FAILURE;
+				goto cleanup;
+			}
 
 			DataLength =
 				wlan_le32_to_cpu(fwdata->fw_header.data_length);
@@ -331,14 +338,21 @@ static mlan_status wlan_usb_prog_fw_w_helper(pmlan_adapter pmadapter,
 			}
 
 			/* Copy the firmware data */
-			if (firmware)
+			if (firmware) {
 				memcpy_ext(pmadapter, fwdata->data,
 					   &firmware[TotalBytes], DataLength,
 					   DataLength);
-			else
-				pcb->moal_get_fw_data(pmadapter->pmoal_handle,
-						      TotalBytes, DataLength,
-						      (t_u8 *)fwdata->data);
+			} else if (pcb->moal_get_fw_data(
+					   pmadapter->pmoal_handle, TotalBytes,
+					   DataLength, (t_u8 *)fwdata->data) !=
+				   MLAN_STATUS_SUCCESS) {
+				PRINTM(MERROR,
+				       "fw_dnld: get fw data failed @ %d\n",
+				       TotalBytes);
+				retries = 0;
+				ret = MLAN_STATUS_FAILURE;
+				goto cleanup;
+			}
 
 			fwdata->seq_num = wlan_cpu_to_le32(FWSeqNum);
 			TotalBytes += DataLength;
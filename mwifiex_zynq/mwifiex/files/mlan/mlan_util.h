@@ -610,6 +610,133 @@ static INLINE t_u8 util_scalar_conditional_write(
 	return (update) ? MTRUE : MFALSE;
 }
 
+/*
+ * Atomic scalar accessors. When MOAL supplies the atomic callbacks the
+ * counter is updated without taking its lock; otherwise these fall back
+ * to the lock handlers, same as the util_scalar_* functions above.
+ * Writers of a scalar must not mix the two sets of accessors unless the
+ * lock handlers passed here are MNULL.
+ */
+
+/**
+ *  @brief This function atomically adds an offset to the value in scalar
+ *
+ *  @param pscalar			Pointer to scalar
+ *  @param offset			Offset value (can be negative)
+ *  @param moal_atomic_add	A pointer to atomic add handler
+ *  @param moal_spin_lock	A pointer to spin lock handler
+ *  @param moal_spin_unlock	A pointer to spin unlock handler
+ *
+ *  @return					Value after offset
+ */
+static INLINE t_s32 util_scalar_atomic_add(
+	t_void *pmoal_handle, pmlan_scalar pscalar, t_s32 offset,
+	t_s32 (*moal_atomic_add)(t_void *handle, t_s32 *pval, t_s32 i),
+	mlan_status (*moal_spin_lock)(t_void *handle, t_void *plock),
+	mlan_status (*moal_spin_unlock)(t_void *handle, t_void *plock))
+{
+	t_s32 newval;
+
+	if (moal_atomic_add)
+		return moal_atomic_add(pmoal_handle, &pscalar->value, offset);
+	if (moal_spin_lock)
+		moal_spin_lock(pmoal_handle, pscalar->plock);
+	newval = (pscalar->value += offset);
+	if (moal_spin_unlock)
+		moal_spin_unlock(pmoal_handle, pscalar->plock);
+
+	return newval;
+}
+
+/**
+ *  @brief This function atomically subtracts an offset from the value
+ *         in scalar
+ *
+ *  @param pscalar			Pointer to scalar
+ *  @param offset			Offset value
+ *  @param moal_atomic_sub	A pointer to atomic sub handler
+ *  @param moal_spin_lock	A pointer to spin lock handler
+ *  @param moal_spin_unlock	A pointer to spin unlock handler
+ *
+ *  @return					Value after offset
+ */
+static INLINE t_s32 util_scalar_atomic_sub(
+	t_void *pmoal_handle, pmlan_scalar pscalar, t_s32 offset,
+	t_s32 (*moal_atomic_sub)(t_void *handle, t_s32 *pval, t_s32 i),
+	mlan_status (*moal_spin_lock)(t_void *handle, t_void *plock),
+	mlan_status (*moal_spin_unlock)(t_void *handle, t_void *plock))
+{
+	t_s32 newval;
+
+	if (moal_atomic_sub)
+		return moal_atomic_sub(pmoal_handle, &pscalar->value, offset);
+	if (moal_spin_lock)
+		moal_spin_lock(pmoal_handle, pscalar->plock);
+	newval = (pscalar->value -= offset);
+	if (moal_spin_unlock)
+		moal_spin_unlock(pmoal_handle, pscalar->plock);
+
+	return newval;
+}
+
+/**
+ *  @brief This function atomically reads value from scalar
+ *
+ *  @param pscalar			Pointer to scalar
+ *  @param moal_atomic_read	A pointer to atomic read handler
+ *  @param moal_spin_lock	A pointer to spin lock handler
+ *  @param moal_spin_unlock	A pointer to spin unlock handler
+ *
+ *  @return					Stored value
+ */
+static INLINE t_s32 util_scalar_atomic_read(
+	t_void *pmoal_handle, pmlan_scalar pscalar,
+	t_s32 (*moal_atomic_read)(t_void *handle, t_s32 *pval),
+	mlan_status (*moal_spin_lock)(t_void *handle, t_void *plock),
+	mlan_status (*moal_spin_unlock)(t_void *handle, t_void *plock))
+{
+	if (moal_atomic_read)
+		return moal_atomic_read(pmoal_handle, &pscalar->value);
+	return util_scalar_read(pmoal_handle, pscalar, moal_spin_lock,
+				moal_spin_unlock);
+}
+
+/**
+ *  @brief This function atomically replaces the value in scalar
+ *         if it equals the expected value
+ *
+ *  @param pscalar			Pointer to scalar
+ *  @param old				Expected value
+ *  @param new_val			Value to set
+ *  @param moal_atomic_cmpxchg	A pointer to atomic cmpxchg handler
+ *  @param moal_spin_lock	A pointer to spin lock handler
+ *  @param moal_spin_unlock	A pointer to spin unlock handler
+ *
+ *  @return					Value before the operation
+ */
+static INLINE t_s32 util_scalar_atomic_cmpxchg(
+	t_void *pmoal_handle, pmlan_scalar pscalar, t_s32 old, t_s32 new_val,
+	t_s32 (*moal_atomic_cmpxchg)(t_void *handle, t_s32 *pval, t_s32 old,
+				     t_s32 new_val),
+	mlan_status (*moal_spin_lock)(t_void *handle, t_void *plock),
+	mlan_status (*moal_spin_unlock)(t_void *handle, t_void *plock))
+{
+	t_s32 val;
+
+	if (moal_atomic_cmpxchg)
+		return moal_atomic_cmpxchg(pmoal_handle, &pscalar->value, old,
+					   new_val);
+	if (moal_spin_lock)
+		moal_spin_lock(pmoal_handle, pscalar->plock);
+	val = pscalar->value;
+	if (val == old)
+		pscalar->value = new_val;
+	if (moal_spin_unlock)
+		moal_spin_unlock(pmoal_handle, pscalar->plock);
+
+	return val;
+}
+
 /**
  *  @brief This function counts the bits of unsigned int number
  *
@@ -178,6 +178,7 @@ static raListTbl *wlan_wmm_allocate_ralist_node(pmlan_adapter pmadapter,
 	ra_list->del_ba_count = 0;
 	ra_list->total_pkts = 0;
 	ra_list->tx_pause = 0;
+	memset(pmadapter, &ra_list->aqm, 0, sizeof(ra_list->aqm));
 	PRINTM(MINFO, "RAList: Allocating buffers for TID %p\n", ra_list);
 done:
 	LEAVE();
@@ -198,8 +199,8 @@ static t_void wlan_add_buf_tdls_txqueue(pmlan_private priv, pmlan_buffer pmbuf)
 	ENTER();
 	util_enqueue_list_tail(pmadapter->pmoal_handle, &priv->tdls_pending_txq,
 			       (pmlan_linked_list)pmbuf,
-			       pmadapter->callbacks.moal_spin_lock,
-			       pmadapter->callbacks.moal_spin_unlock);
+			       wlan_lock_cb(pmadapter),
+			       wlan_unlock_cb(pmadapter));
 	LEAVE();
 }
 
@@ -259,8 +260,8 @@ static void wlan_wmm_queue_priorities_tid(pmlan_private priv,
 	 */
 	util_scalar_write(priv->adapter->pmoal_handle,
 			  &priv->wmm.highest_queued_prio, HIGH_PRIO_TID,
-			  priv->adapter->callbacks.moal_spin_lock,
-			  priv->adapter->callbacks.moal_spin_unlock);
+			  wlan_lock_cb(priv->adapter),
+			  wlan_unlock_cb(priv->adapter));
 
 	LEAVE();
 }
@@ -713,9 +714,8 @@ static raListTbl *wlan_wmm_get_highest_priolist_ptr(pmlan_adapter pmadapter,
 			}
 #endif
 
-			pmadapter->callbacks.moal_spin_lock(
-				pmadapter->pmoal_handle,
-				priv_tmp->wmm.ra_list_spinlock);
+			wlan_spin_lock(pmadapter,
+				       priv_tmp->wmm.ra_list_spinlock);
 
 			for (i = util_scalar_read(
 				     pmadapter->pmoal_handle,
@@ -802,9 +802,11 @@ static raListTbl *wlan_wmm_get_highest_priolist_ptr(pmlan_adapter pmadapter,
 
 			/* If priv still has packets queued, reset to
 			 * HIGH_PRIO_TID */
-			if (util_scalar_read(pmadapter->pmoal_handle,
-					     &priv_tmp->wmm.tx_pkts_queued,
-					     MNULL, MNULL))
+			if (util_scalar_atomic_read(
+				    pmadapter->pmoal_handle,
+				    &priv_tmp->wmm.tx_pkts_queued,
+				    wlan_atomic_read_cb(pmadapter),
+				    MNULL, MNULL))
 				util_scalar_write(
 					pmadapter->pmoal_handle,
 					&priv_tmp->wmm.highest_queued_prio,
@@ -818,9 +820,8 @@ static raListTbl *wlan_wmm_get_highest_priolist_ptr(pmlan_adapter pmadapter,
 					&priv_tmp->wmm.highest_queued_prio,
 					NO_PKT_PRIO_TID, MNULL, MNULL);
 
-			pmadapter->callbacks.moal_spin_unlock(
-				pmadapter->pmoal_handle,
-				priv_tmp->wmm.ra_list_spinlock);
+			wlan_spin_unlock(pmadapter,
+					 priv_tmp->wmm.ra_list_spinlock);
 
 		next_intf:
 			bssprio_node = bssprio_node->pnext;
@@ -836,6 +837,113 @@ static raListTbl *wlan_wmm_get_highest_priolist_ptr(pmlan_adapter pmadapter,
 	return MNULL;
 }
 
+/** PPDU formats in tx_rate_info of HostCmd_TX_RATE_QUERY */
+#define WMM_PPDU_TYPE_LEGACY 0
+#define WMM_PPDU_TYPE_HT 1
+#define WMM_PPDU_TYPE_VHT 2
+#define WMM_PPDU_TYPE_HE 3
+
+/** MAC header of a QoS data frame and FCS */
+#define WMM_MPDU_FRAMING_LEN (26 + 4)
+/** A-MPDU delimiter and average padding on top of the MPDU framing */
+#define WMM_AMPDU_SUBFRAME_LEN (WMM_MPDU_FRAMING_LEN + 4 + 2)
+/** aPPDUMaxTime in usec, bounds the MPDUs of one A-MPDU */
+#define WMM_PPDU_MAX_US 5484
+
+/**
+ *  @brief Check whether the interface operates in the 2.4 GHz band
+ *
+ *  @param priv      Pointer to the mlan_private driver data struct
+ *
+ *  @return          MTRUE or MFALSE
+ */
+static t_bool wlan_wmm_is_band_2g(pmlan_private priv)
+{
+#ifdef UAP_SUPPORT
+	if (GET_BSS_ROLE(priv) == MLAN_BSS_ROLE_UAP)
+		return priv->uap_state_chan_cb.bandcfg.chanBand == BAND_2GHZ;
+#endif
+	return !(priv->curr_bss_params.band &
+		 (BAND_A | BAND_AN | BAND_AAC | BAND_AAX));
+}
+
+/**
+ *  @brief Estimates the airtime a PPDU costs on top of its MPDUs: the
+ *         PHY preamble, SIFS and the ACK or BlockAck. Contention is left
+ *         out, it is not spent by one station.
+ *
+ *  @param band_2g      MTRUE in the 2.4 GHz band
+ *  @param ppdu_format  WMM_PPDU_TYPE_*
+ *  @param nss          Number of spatial streams
+ *  @param dsss         MTRUE for the DSSS/CCK rates
+ *  @param ampdu        MTRUE for an A-MPDU answered by a BlockAck
+ *
+ *  @return             overhead in usec
+ */
+static t_u16 wlan_wmm_get_ppdu_overhead(t_bool band_2g, t_u8 ppdu_format,
+					t_u8 nss, t_bool dsss, t_bool ampdu)
+{
+	/* L-STF, L-LTF and L-SIG of every OFDM preamble */
+	const t_u32 legacy_preamble_us = 20;
+	/* ERP-OFDM signal extension after each PPDU in 2.4 GHz */
+	const t_u32 sig_ext_us = band_2g ? 6 : 0;
+	const t_u32 sifs_us = band_2g ? 10 : 16;
+	t_u32 preamble_us;
+	t_u32 resp_us;
+
+	if (dsss) {
+		/* Long preamble, ACK of 14 bytes at 1 Mbps */
+		return 192 + sifs_us + 192 + 14 * 8;
+	}
+
+	switch (ppdu_format) {
+	case WMM_PPDU_TYPE_HT:
+		/* HT-SIG, HT-STF and one HT-LTF per stream */
+		preamble_us = legacy_preamble_us + 8 + 4 + 4 * nss;
+		break;
+	case WMM_PPDU_TYPE_VHT:
+		/* VHT-SIG-A, VHT-STF, VHT-LTFs and VHT-SIG-B */
+		preamble_us = legacy_preamble_us + 8 + 4 + 4 * nss + 4;
+		break;
+	case WMM_PPDU_TYPE_HE:
+		/* RL-SIG, HE-SIG-A, HE-STF and 2x HE-LTFs */
+		preamble_us = legacy_preamble_us + 4 + 8 + 4 + 8 * nss;
+		break;
+	default:
+		preamble_us = legacy_preamble_us;
+		break;
+	}
+
+	/* ACK (14 bytes) or compressed BlockAck (32 bytes) at 24 Mbps:
+	 * preamble and 2 or 3 symbols of 4 usec */
+	resp_us = legacy_preamble_us + (ampdu ? 3 : 2) * 4;
+
+	return preamble_us + sig_ext_us + sifs_us + resp_us + sig_ext_us;
+}
+
+/**
+ *  @brief Sets the per PPDU airtime overhead of a station
+ *
+ *  @param priv         Pointer to the mlan_private driver data struct
+ *  @param sta          Pointer to the wmm_sta_table data struct
+ *  @param ppdu_format  WMM_PPDU_TYPE_*
+ *  @param nss          Number of spatial streams
+ *  @param dsss         MTRUE for the DSSS/CCK rates
+ *
+ *  @return             N/A
+ */
+static void wlan_wmm_set_ppdu_overhead(pmlan_private priv,
+				       struct wmm_sta_table *sta,
+				       t_u8 ppdu_format, t_u8 nss, t_bool dsss)
+{
+	const t_bool band_2g = wlan_wmm_is_band_2g(priv);
+
+	sta->budget.ppdu_overhead_us = wlan_wmm_get_ppdu_overhead(
+		band_2g, ppdu_format, nss, dsss, MFALSE);
+	sta->budget.ampdu_overhead_us = wlan_wmm_get_ppdu_overhead(
+		band_2g, ppdu_format, nss, dsss, MTRUE);
+}
+
 /**
  *  @brief Calculates byte budget based on time budget and currect PHY rate
  *
@@ -863,14 +971,15 @@ static t_u32 wlan_wmm_get_byte_budget(pmlan_adapter pmadapter,
 /**
  *  @brief Allocate sta_table address
  *
- *  @param pmadapter       Pointer to the mlan_adapter structure
+ *  @param priv            Pointer to the mlan_private driver data struct
  *  @param ra              Pointer to the route address
  *
  *  @return         sta_table
  */
-static struct wmm_sta_table *
-wlan_wmm_allocate_sta_table(pmlan_adapter pmadapter, t_u8 *ra)
+static struct wmm_sta_table *wlan_wmm_allocate_sta_table(pmlan_private priv,
+							 t_u8 *ra)
 {
+	pmlan_adapter pmadapter = priv->adapter;
 	struct wmm_sta_table *sta_table = MNULL;
 	int i;
 	const t_u32 default_rate = 200 * 1000;
@@ -899,6 +1008,9 @@ wlan_wmm_allocate_sta_table(pmlan_adapter pmadapter, t_u8 *ra)
 		pmadapter, sta_table->budget.time_budget_init_us, default_rate);
 	sta_table->budget.queue_packets = default_queue_packets;
 	sta_table->budget.phy_rate_kbps = default_rate;
+	/* Until the first rate query, as for default_rate */
+	wlan_wmm_set_ppdu_overhead(priv, sta_table, WMM_PPDU_TYPE_HT, 1,
+				   MFALSE);
 
 	sta_table->budget.mpdu_with_amsdu_pps_cap =
 		pmadapter->tx_mpdu_with_amsdu_pps;
@@ -916,10 +1028,15 @@ wlan_wmm_allocate_sta_table(pmlan_adapter pmadapter, t_u8 *ra)
 				sta_table->budget.time_budget_init_us,
 			1000000);
 
+	sta_table->budget.airtime = pmadapter->init_para.mclient_scheduling ==
+				    MLAN_MCLIENT_SCHED_AIRTIME;
+
 	for (i = 0; i < NELEMENTS(sta_table->budget.bytes); ++i) {
 		sta_table->budget.bytes[i] = sta_table->budget.byte_budget_init;
 		sta_table->budget.mpdus[i] =
 			sta_table->budget.mpdu_with_amsdu_budget_init;
+		sta_table->budget.airtime_us[i] =
+			sta_table->budget.time_budget_init_us;
 	}
 
 done:
@@ -1205,7 +1322,6 @@ static mlan_private *wlan_wmm_get_next_mlan(pmlan_adapter pmadapter,
 					    mlan_bssprio_tbl *bssprio_tbl)
 {
 	mlan_bssprio_node *bss = bssprio_tbl->bssprio_cur;
-	const mlan_callbacks *const cb = &pmadapter->callbacks;
 	t_void *pmoal = pmadapter->pmoal_handle;
 	mlan_bssprio_node *const stop_point = bss;
 
@@ -1223,7 +1339,7 @@ static mlan_private *wlan_wmm_get_next_mlan(pmlan_adapter pmadapter,
 			goto next_bss;
 		}
 
-		cb->moal_spin_lock(pmoal, mlan->wmm.ra_list_spinlock);
+		wlan_spin_lock(pmadapter, mlan->wmm.ra_list_spinlock);
 
 		for (queue = 0; queue < NELEMENTS(mlan->wmm.pending_txq);
 		     ++queue) {
@@ -1235,7 +1351,7 @@ static mlan_private *wlan_wmm_get_next_mlan(pmlan_adapter pmadapter,
 			}
 		}
 
-		cb->moal_spin_unlock(pmoal, mlan->wmm.ra_list_spinlock);
+		wlan_spin_unlock(pmadapter, mlan->wmm.ra_list_spinlock);
 
 	next_bss:
 		bss = bss->pnext;
@@ -1305,8 +1421,10 @@ static t_bool wlan_wmm_process_ra_list_quoats(pmlan_adapter pmadapter,
 	struct wmm_sta_table *sta = ra_list->sta;
 	const t_u8 tid = ra_list->tid;
 	t_bool ready = MTRUE;
+	const t_s32 credit = sta->budget.airtime ? sta->budget.airtime_us[tid] :
+						   sta->budget.bytes[tid];
 
-	if (sta->budget.bytes[tid] <= 0 || sta->budget.mpdus[tid] <= 0) {
+	if (credit <= 0 || sta->budget.mpdus[tid] <= 0) {
 		const t_u32 mpdu_budget_init =
 			ra_list->amsdu_in_ampdu ?
 				sta->budget.mpdu_with_amsdu_budget_init :
@@ -1323,6 +1441,9 @@ static t_bool wlan_wmm_process_ra_list_quoats(pmlan_adapter pmadapter,
 			sta->budget.bytes[tid], sta->budget.byte_budget_init);
 		sta->budget.mpdus[tid] = wlan_wmm_refill_budget(
 			sta->budget.mpdus[tid], mpdu_budget_init);
+		sta->budget.airtime_us[tid] = wlan_wmm_refill_budget(
+			sta->budget.airtime_us[tid],
+			sta->budget.time_budget_init_us);
 
 		mlan->wmm.selected_ra_list = MNULL;
 
@@ -1376,6 +1497,8 @@ static raListTbl *wlan_wmm_get_next_ra_list(pmlan_adapter pmadapter,
 					sta->budget.byte_budget_init;
 				sta->budget.mpdus[ra_list->tid] =
 					mpdu_budget_init;
+				sta->budget.airtime_us[ra_list->tid] =
+					sta->budget.time_budget_init_us;
 
 				util_unlink_list_nl(
 					pmoal, &ra_list->pending_txq_entry);
@@ -1393,7 +1516,40 @@ static raListTbl *wlan_wmm_get_next_ra_list(pmlan_adapter pmadapter,
 }
 
 /**
- *  @brief Track byte budget consumed by ra_list
+ *  @brief Estimates the airtime of one frame at the STA's current TX rate
+ *
+ *  @param sta       Pointer to wmm_sta_table structure
+ *  @param ra_list   Pointer to raListTbl structure
+ *  @param data_len  Frame length in bytes
+ *
+ *  @return          airtime in usec
+ */
+static t_u32 wlan_wmm_get_frame_airtime(struct wmm_sta_table *sta,
+					raListTbl *ra_list, t_u32 data_len)
+{
+	const t_bool ampdu = ra_list->ba_status == BA_STREAM_SETUP_COMPLETE;
+	t_u32 airtime;
+	t_u32 frames;
+
+	data_len += ampdu ? WMM_AMPDU_SUBFRAME_LEN : WMM_MPDU_FRAMING_LEN;
+
+	/* phy_rate_kbps is never 0, frames are below 12K */
+	airtime = data_len * 8 * 1000 / sta->budget.phy_rate_kbps;
+
+	if (!ampdu)
+		return airtime + sta->budget.ppdu_overhead_us;
+
+	/* A backlogged station fills its A-MPDUs up to the BA window or
+	 * aPPDUMaxTime, each MPDU pays its share of the PPDU overhead */
+	frames = WMM_PPDU_MAX_US / MAX(airtime, 1);
+	frames = MIN(MAX(frames, 1), MLAN_UAP_AMPDU_DEF_TXWINSIZE);
+	airtime += sta->budget.ampdu_overhead_us / frames;
+
+	return MAX(airtime, 1);
+}
+
+/**
+ *  @brief Track byte or airtime budget consumed by ra_list
  *
  *  @param ra_list   Pointer to raListTbl structure
  *  @param pmbuf     Pointer to mlan_buffer structure
@@ -1404,7 +1560,11 @@ void wlan_wmm_consume_byte_budget(raListTbl *ra_list, mlan_buffer *pmbuf)
 {
 	struct wmm_sta_table *sta = ra_list->sta;
 
-	if (sta != MNULL) {
+	if (sta != MNULL && sta->budget.airtime) {
+		sta->budget.airtime_us[ra_list->tid] -=
+			wlan_wmm_get_frame_airtime(sta, ra_list,
+						   pmbuf->data_len);
+	} else if (sta != MNULL) {
 		t_u32 data_len = pmbuf->data_len;
 
 		if (ra_list->ba_status != BA_STREAM_SETUP_COMPLETE) {
@@ -1461,12 +1621,13 @@ static void wlan_wmm_track_ra_list_switch(mlan_private *mlan,
 			struct wmm_sta_table *old_sta = old_list->sta;
 
 			PRINTM(MSCH_D,
-			       "mclient: switch[ %u/%u : q size: %u/%u bb: r %d m %d ri %u mi %u %u p %u] %pM tid %u -> %pM tid %u",
+			       "mclient: switch[ %u/%u : q size: %u/%u bb: r %d m %d t %d ri %u mi %u %u p %u] %pM tid %u -> %pM tid %u",
 			       adapter->ra_list_tracing.pushed_pkg, in_tx_ring,
 			       old_list->total_pkts,
 			       old_sta->budget.queue_packets,
 			       old_sta->budget.bytes[old_list->tid],
 			       old_sta->budget.mpdus[old_list->tid],
+			       old_sta->budget.airtime_us[old_list->tid],
 			       old_sta->budget.byte_budget_init,
 			       old_sta->budget.mpdu_no_amsdu_budget_init,
 			       old_sta->budget.mpdu_with_amsdu_budget_init,
@@ -1495,15 +1656,13 @@ static raListTbl *wlan_wmm_get_next_priolist_ptr(pmlan_adapter pmadapter,
 						 pmlan_private *priv, int *tid)
 {
 	mlan_private *mlan = pmadapter->selected_mlan_bss;
-	mlan_callbacks *cbs = &pmadapter->callbacks;
-	void *const pmoal_handle = pmadapter->pmoal_handle;
 	raListTbl *ra_list = MNULL;
 
 	if (!pmadapter->mclient_tx_supported)
 		return wlan_wmm_get_highest_priolist_ptr(pmadapter, priv, tid);
 
 	if (mlan) {
-		cbs->moal_spin_lock(pmoal_handle, mlan->wmm.ra_list_spinlock);
+		wlan_spin_lock(pmadapter, mlan->wmm.ra_list_spinlock);
 	} else {
 		mlan = wlan_wmm_get_next_bss(pmadapter);
 	}
@@ -1516,8 +1675,7 @@ static raListTbl *wlan_wmm_get_next_priolist_ptr(pmlan_adapter pmadapter,
 		} else if (!wlan_wmm_process_ra_list_quoats(pmadapter, mlan,
 							    ra_list)) {
 			pmadapter->selected_mlan_bss = MNULL;
-			cbs->moal_spin_unlock(pmoal_handle,
-					      mlan->wmm.ra_list_spinlock);
+			wlan_spin_unlock(pmadapter, mlan->wmm.ra_list_spinlock);
 			continue;
 		}
 
@@ -1532,7 +1690,7 @@ static raListTbl *wlan_wmm_get_next_priolist_ptr(pmlan_adapter pmadapter,
 			return ra_list;
 		}
 
-		cbs->moal_spin_unlock(pmoal_handle, mlan->wmm.ra_list_spinlock);
+		wlan_spin_unlock(pmadapter, mlan->wmm.ra_list_spinlock);
 	}
 
 	pmadapter->selected_mlan_bss = MNULL;
@@ -1594,16 +1752,18 @@ static INLINE void wlan_send_single_packet(pmlan_private priv, raListTbl *ptr,
 						&ptr->buf_head, MNULL, MNULL);
 	if (pmbuf) {
 		PRINTM(MINFO, "Dequeuing the packet %p %p\n", ptr, pmbuf);
+		wlan_tx_lat_stamp(pmadapter, pmbuf, MLAN_TX_LAT_DEQ);
 		wlan_wmm_consume_mpdu_budget(ptr);
 		wlan_wmm_consume_byte_budget(ptr, pmbuf);
 		priv->wmm.pkts_queued[ptrindex]--;
-		util_scalar_decrement(pmadapter->pmoal_handle,
-				      &priv->wmm.tx_pkts_queued, MNULL, MNULL);
+		util_scalar_atomic_sub(pmadapter->pmoal_handle,
+				       &priv->wmm.tx_pkts_queued, 1,
+				       wlan_atomic_sub_cb(pmadapter),
+				       MNULL, MNULL);
 		ptr->total_pkts--;
 		pmbuf_next = (pmlan_buffer)util_peek_list(
 			pmadapter->pmoal_handle, &ptr->buf_head, MNULL, MNULL);
-		pmadapter->callbacks.moal_spin_unlock(
-			pmadapter->pmoal_handle, priv->wmm.ra_list_spinlock);
+		wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 
 		tx_param.next_pkt_len =
 			((pmbuf_next) ? pmbuf_next->data_len +
@@ -1615,23 +1775,22 @@ static INLINE void wlan_send_single_packet(pmlan_private priv, raListTbl *ptr,
 			/** Queue the packet back at the head */
 			PRINTM(MDAT_D, "Queuing pkt back to raList %p %p\n",
 			       ptr, pmbuf);
-			pmadapter->callbacks.moal_spin_lock(
-				pmadapter->pmoal_handle,
-				priv->wmm.ra_list_spinlock);
+			wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 
 			if (!wlan_is_ralist_valid(priv, ptr, ptrindex)) {
-				pmadapter->callbacks.moal_spin_unlock(
-					pmadapter->pmoal_handle,
-					priv->wmm.ra_list_spinlock);
+				wlan_spin_unlock(pmadapter,
+						 priv->wmm.ra_list_spinlock);
 				wlan_write_data_complete(pmadapter, pmbuf,
 							 MLAN_STATUS_FAILURE);
 				LEAVE();
 				return;
 			}
 			priv->wmm.pkts_queued[ptrindex]++;
-			util_scalar_increment(pmadapter->pmoal_handle,
-					      &priv->wmm.tx_pkts_queued, MNULL,
-					      MNULL);
+			util_scalar_atomic_add(
+				pmadapter->pmoal_handle,
+				&priv->wmm.tx_pkts_queued, 1,
+				wlan_atomic_add_cb(pmadapter), MNULL,
+				MNULL);
 			util_enqueue_list_head(pmadapter->pmoal_handle,
 					       &ptr->buf_head,
 					       (pmlan_linked_list)pmbuf, MNULL,
@@ -1639,13 +1798,9 @@ static INLINE void wlan_send_single_packet(pmlan_private priv, raListTbl *ptr,
 
 			ptr->total_pkts++;
 			pmbuf->flags |= MLAN_BUF_FLAG_REQUEUED_PKT;
-			pmadapter->callbacks.moal_spin_unlock(
-				pmadapter->pmoal_handle,
-				priv->wmm.ra_list_spinlock);
+			wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 		} else {
-			pmadapter->callbacks.moal_spin_lock(
-				pmadapter->pmoal_handle,
-				priv->wmm.ra_list_spinlock);
+			wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 			if (wlan_is_ralist_valid(priv, ptr, ptrindex)) {
 				priv->wmm.packets_out[ptrindex]++;
 				priv->wmm.tid_tbl_ptr[ptrindex].ra_list_curr =
@@ -1654,13 +1809,10 @@ static INLINE void wlan_send_single_packet(pmlan_private priv, raListTbl *ptr,
 			wlan_advance_bss_on_pkt_push(
 				pmadapter,
 				&pmadapter->bssprio_tbl[priv->bss_priority]);
-			pmadapter->callbacks.moal_spin_unlock(
-				pmadapter->pmoal_handle,
-				priv->wmm.ra_list_spinlock);
+			wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 		}
 	} else {
-		pmadapter->callbacks.moal_spin_unlock(
-			pmadapter->pmoal_handle, priv->wmm.ra_list_spinlock);
+		wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 		PRINTM(MINFO, "Nothing to send\n");
 	}
 
@@ -1711,13 +1863,13 @@ static INLINE void wlan_send_processed_packet(pmlan_private priv,
 	if (pmbuf) {
 		pmbuf_next = (pmlan_buffer)util_peek_list(
 			pmadapter->pmoal_handle, &ptr->buf_head, MNULL, MNULL);
-		pmadapter->callbacks.moal_spin_unlock(
-			pmadapter->pmoal_handle, priv->wmm.ra_list_spinlock);
+		wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 		tx_param.next_pkt_len =
 			((pmbuf_next) ? pmbuf_next->data_len +
 						Tx_PD_SIZEOF(pmadapter) :
 					0);
 
+		wlan_tx_lat_stamp(pmadapter, pmbuf, MLAN_TX_LAT_BUS);
 		ret = pmadapter->ops.host_to_card(priv, MLAN_TYPE_DATA, pmbuf,
 						  &tx_param);
 		switch (ret) {
@@ -1728,14 +1880,11 @@ static INLINE void wlan_send_processed_packet(pmlan_private priv,
 #endif
 		case MLAN_STATUS_RESOURCE:
 			PRINTM(MINFO, "MLAN_STATUS_RESOURCE is returned\n");
-			pmadapter->callbacks.moal_spin_lock(
-				pmadapter->pmoal_handle,
-				priv->wmm.ra_list_spinlock);
+			wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 
 			if (!wlan_is_ralist_valid(priv, ptr, ptrindex)) {
-				pmadapter->callbacks.moal_spin_unlock(
-					pmadapter->pmoal_handle,
-					priv->wmm.ra_list_spinlock);
+				wlan_spin_unlock(pmadapter,
+						 priv->wmm.ra_list_spinlock);
 				wlan_write_data_complete(pmadapter, pmbuf,
 							 MLAN_STATUS_FAILURE);
 				LEAVE();
@@ -1747,9 +1896,7 @@ static INLINE void wlan_send_processed_packet(pmlan_private priv,
 					       MNULL);
 
 			pmbuf->flags |= MLAN_BUF_FLAG_REQUEUED_PKT;
-			pmadapter->callbacks.moal_spin_unlock(
-				pmadapter->pmoal_handle,
-				priv->wmm.ra_list_spinlock);
+			wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 			break;
 		case MLAN_STATUS_FAILURE:
 			PRINTM(MERROR, "Error: Failed to write data\n");
@@ -1770,9 +1917,7 @@ static INLINE void wlan_send_processed_packet(pmlan_private priv,
 			break;
 		}
 		if (ret != MLAN_STATUS_RESOURCE) {
-			pmadapter->callbacks.moal_spin_lock(
-				pmadapter->pmoal_handle,
-				priv->wmm.ra_list_spinlock);
+			wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 			if (wlan_is_ralist_valid(priv, ptr, ptrindex)) {
 				priv->wmm.packets_out[ptrindex]++;
 				priv->wmm.tid_tbl_ptr[ptrindex].ra_list_curr =
@@ -1784,19 +1929,406 @@ static INLINE void wlan_send_processed_packet(pmlan_private priv,
 				pmadapter,
 				&pmadapter->bssprio_tbl[priv->bss_priority]);
 			priv->wmm.pkts_queued[ptrindex]--;
-			util_scalar_decrement(pmadapter->pmoal_handle,
-					      &priv->wmm.tx_pkts_queued, MNULL,
-					      MNULL);
-			pmadapter->callbacks.moal_spin_unlock(
+			util_scalar_atomic_sub(
 				pmadapter->pmoal_handle,
-				priv->wmm.ra_list_spinlock);
+				&priv->wmm.tx_pkts_queued, 1,
+				wlan_atomic_sub_cb(pmadapter), MNULL,
+				MNULL);
+			wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 		}
 	} else {
-		pmadapter->callbacks.moal_spin_unlock(
-			pmadapter->pmoal_handle, priv->wmm.ra_list_spinlock);
+		wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 	}
 }
 
+/** CoDel target sojourn time in usec */
+#define WMM_AQM_TARGET_US (20 * 1000)
+/** CoDel interval in usec */
+#define WMM_AQM_INTERVAL_US (100 * 1000)
+
+/**
+ *  @brief Integer square root
+ *
+ *  @param x         Value
+ *
+ *  @return          floor(sqrt(x))
+ */
+static t_u32 wlan_wmm_aqm_isqrt(t_u32 x)
+{
+	t_u32 res = 0;
+	t_u32 bit = 1u << 30;
+
+	while (bit > x)
+		bit >>= 2;
+	while (bit) {
+		if (x >= res + bit) {
+			x -= res + bit;
+			res = (res >> 1) + bit;
+		} else {
+			res >>= 1;
+		}
+		bit >>= 2;
+	}
+	return res;
+}
+
+/**
+ *  @brief CoDel control law, time of the next drop
+ *
+ *  @param t         Time of the last drop in usec
+ *  @param count     Drops since entering the dropping state
+ *
+ *  @return          Time of the next drop in usec
+ */
+static t_u64 wlan_wmm_aqm_control_law(t_u64 t, t_u32 count)
+{
+	return t + WMM_AQM_INTERVAL_US / MAX(wlan_wmm_aqm_isqrt(count), 1);
+}
+
+/**
+ *  @brief Sets ECN CE on an ECN capable IPv4 or IPv6 packet. Only MOAL
+ *         tx buffers MOAL reports writable are rewritten: bridged and
+ *         rx view buffers may share their data with the rx path.
+ *
+ *  @param pmadapter A pointer to mlan_adapter
+ *  @param pmbuf     Pointer to mlan_buffer structure
+ *
+ *  @return          MTRUE if the packet carries CE, MFALSE if it is not
+ *                   ECN capable or can't be written
+ */
+static t_bool wlan_wmm_aqm_mark_ce(pmlan_adapter pmadapter,
+				   mlan_buffer *pmbuf)
+{
+	const t_u32 ip_offset = MLAN_ETHER_PKT_TYPE_OFFSET + 2;
+	t_u8 *pos = pmbuf->pbuf + pmbuf->data_offset;
+	t_u8 *ip = pos + ip_offset;
+	t_u16 type;
+	t_u32 sum;
+	t_u16 old;
+
+	if (!(pmbuf->flags & MLAN_BUF_FLAG_MOAL_TX_BUF) ||
+	    (pmbuf->flags &
+	     (MLAN_BUF_FLAG_BRIDGE_BUF | MLAN_BUF_FLAG_RX_VIEW)) ||
+	    !pmadapter->callbacks.moal_buf_writable)
+		return MFALSE;
+	if (pmbuf->data_len < ip_offset + 20)
+		return MFALSE;
+	type = (pos[MLAN_ETHER_PKT_TYPE_OFFSET] << 8) |
+	       pos[MLAN_ETHER_PKT_TYPE_OFFSET + 1];
+
+	if (type == MLAN_ETHER_PKT_TYPE_IP && (ip[0] >> 4) == 4) {
+		if (!(ip[1] & 0x03))
+			return MFALSE;
+		if ((ip[1] & 0x03) == 0x03)
+			return MTRUE;
+		/* TOS and header checksum */
+		if (!pmadapter->callbacks.moal_buf_writable(
+			    pmadapter->pmoal_handle, pmbuf, ip_offset + 12))
+			return MFALSE;
+		/* Incremental header checksum update, RFC 1624 */
+		old = (ip[0] << 8) | ip[1];
+		ip[1] |= 0x03;
+		sum = (t_u16) ~((ip[10] << 8) | ip[11]);
+		sum += (t_u16)~old;
+		sum += (ip[0] << 8) | ip[1];
+		sum = (sum & 0xffff) + (sum >> 16);
+		sum = (sum & 0xffff) + (sum >> 16);
+		ip[10] = (t_u8)(~sum >> 8);
+		ip[11] = (t_u8)~sum;
+		return MTRUE;
+	}
+
+	if (type == MLAN_ETHER_PKT_TYPE_IPV6 && (ip[0] >> 4) == 6) {
+		if (!(ip[1] & 0x30))
+			return MFALSE;
+		if ((ip[1] & 0x30) != 0x30 &&
+		    !pmadapter->callbacks.moal_buf_writable(
+			    pmadapter->pmoal_handle, pmbuf, ip_offset + 2))
+			return MFALSE;
+		ip[1] |= 0x30;
+		return MTRUE;
+	}
+
+	return MFALSE;
+}
+
+/**
+ *  @brief Checks if the sojourn time of the head packet calls for a drop
+ *
+ *  @param ra_list   Pointer to raListTbl structure
+ *  @param pmbuf     Head packet
+ *  @param now       Current time in usec
+ *
+ *  @return          MTRUE if the head packet may be dropped
+ */
+static t_bool wlan_wmm_aqm_ok_to_drop(raListTbl *ra_list, mlan_buffer *pmbuf,
+				      t_u64 now)
+{
+	const t_u64 in_ts = (t_u64)pmbuf->in_ts_sec * 1000000 +
+			    pmbuf->in_ts_usec;
+
+	/* Never empty the queue */
+	if (ra_list->total_pkts <= 1 || now < in_ts ||
+	    now - in_ts < WMM_AQM_TARGET_US) {
+		ra_list->aqm.first_above_us = 0;
+		return MFALSE;
+	}
+
+	if (!ra_list->aqm.first_above_us) {
+		ra_list->aqm.first_above_us = now + WMM_AQM_INTERVAL_US;
+		return MFALSE;
+	}
+
+	return now >= ra_list->aqm.first_above_us;
+}
+
+/**
+ *  @brief Drops or marks the head packet of the RA list
+ *
+ *  @param priv      A pointer to mlan_private
+ *  @param ra_list   Pointer to raListTbl structure
+ *  @param ptrindex  ra_list's TID index
+ *  @param sta_ptr   Station entry of the RA list, or MNULL
+ *
+ *  @return          MTRUE if the packet was marked or is exempt and
+ *                   stays queued
+ */
+static t_bool wlan_wmm_aqm_drop_head(pmlan_private priv, raListTbl *ra_list,
+				     int ptrindex, sta_node *sta_ptr)
+{
+	pmlan_adapter pmadapter = priv->adapter;
+	pmlan_buffer pmbuf;
+
+	pmbuf = (pmlan_buffer)util_peek_list(pmadapter->pmoal_handle,
+					     &ra_list->buf_head, MNULL, MNULL);
+	/* Raw and management frames take the bypass queue, frames the
+	 * host waits a tx status or control for are not dropped either */
+	if (pmbuf->buf_type != MLAN_BUF_TYPE_DATA ||
+	    (pmbuf->flags & (MLAN_BUF_FLAG_TX_STATUS | MLAN_BUF_FLAG_TX_CTRL)))
+		return MTRUE;
+	if (wlan_wmm_aqm_mark_ce(pmadapter, pmbuf)) {
+		if (sta_ptr)
+			sta_ptr->tx_aqm_marks++;
+		return MTRUE;
+	}
+
+	util_unlink_list(pmadapter->pmoal_handle, &ra_list->buf_head,
+			 (pmlan_linked_list)pmbuf, MNULL, MNULL);
+	priv->wmm.pkts_queued[ptrindex]--;
+	util_scalar_atomic_sub(pmadapter->pmoal_handle,
+			       &priv->wmm.tx_pkts_queued, 1,
+			       wlan_atomic_sub_cb(pmadapter), MNULL,
+			       MNULL);
+	ra_list->total_pkts--;
+	if (sta_ptr)
+		sta_ptr->tx_aqm_drops++;
+	PRINTM(MDAT_D, "AQM: drop %p from ra_list %p\n", pmbuf, ra_list);
+	wlan_write_data_complete(pmadapter, pmbuf, MLAN_STATUS_FAILURE);
+	return MFALSE;
+}
+
+/**
+ *  @brief Counts the packets queued on the RA lists of a kernel queue.
+ *         Called with ra_list_spinlock held.
+ *
+ *  @param priv      A pointer to mlan_private
+ *  @param queue     Kernel queue index (0-3)
+ *
+ *  @return          number of packets
+ */
+static t_u32 wlan_wmm_aqm_queue_backlog(pmlan_private priv, t_u8 queue)
+{
+	t_u32 pkts = 0;
+	int tid;
+
+	for (tid = 0; tid < MAX_NUM_TID; tid++) {
+		if (wlan_wmm_select_queue(priv, tid) == queue)
+			pkts += priv->wmm.pkts_queued[tid];
+	}
+	return pkts;
+}
+
+/**
+ *  @brief Releases a kernel queue stopped over tx_aqm_limit once every
+ *         RA list that stopped it has drained to half of the limit. RA
+ *         lists deleted since simply no longer count. Called with
+ *         ra_list_spinlock held.
+ *
+ *  @param priv      A pointer to mlan_private
+ *  @param queue     Kernel queue index (0-3)
+ *
+ *  @return          MTRUE if the queue is released
+ */
+static t_u8 wlan_wmm_aqm_clear_stop(pmlan_private priv, t_u8 queue)
+{
+	pmlan_adapter pmadapter = priv->adapter;
+	raListTbl *ra_list;
+	mlan_list_head *head;
+	t_u8 blocked = MFALSE;
+	int i;
+
+	for (i = 0; i < MAX_NUM_TID; i++) {
+		head = &priv->wmm.tid_tbl_ptr[i].ra_list;
+		ra_list = (raListTbl *)util_peek_list(pmadapter->pmoal_handle,
+						      head, MNULL, MNULL);
+		while (ra_list && ra_list != (raListTbl *)head) {
+			if (ra_list->aqm.stop_mask & MBIT(queue)) {
+				if (ra_list->total_pkts >
+				    pmadapter->tx_aqm_limit / 2)
+					blocked = MTRUE;
+				else
+					ra_list->aqm.stop_mask &= ~MBIT(queue);
+			}
+			ra_list = ra_list->pnext;
+		}
+	}
+	if (!blocked)
+		priv->wmm.aqm_stop &= ~MBIT(queue);
+	return !blocked;
+}
+
+/**
+ *  @brief Releases the kernel queues an RA list stopped once it has
+ *         drained, from the dequeue path. Bridged packets never
+ *         complete to MOAL, so a queue held only by them would not be
+ *         retried from the tx completion. The wake itself is sent by
+ *         wlan_wmm_aqm_send_wake() outside of ra_list_spinlock.
+ *
+ *  @param priv      A pointer to mlan_private
+ *  @param ra_list   Pointer to raListTbl structure
+ *
+ *  @return          N/A
+ */
+static void wlan_wmm_aqm_release(pmlan_private priv, raListTbl *ra_list)
+{
+	pmlan_adapter pmadapter = priv->adapter;
+	t_u8 queue;
+
+	if (ra_list->total_pkts > pmadapter->tx_aqm_limit / 2)
+		return;
+	for (queue = 0; queue < MAX_AC_QUEUES; queue++) {
+		if ((ra_list->aqm.stop_mask & MBIT(queue)) &&
+		    wlan_wmm_aqm_clear_stop(priv, queue)) {
+			priv->wmm.aqm_wake |= MBIT(queue);
+			pmadapter->tx_aqm_wake = MTRUE;
+		}
+	}
+}
+
+/**
+ *  @brief Tells MOAL about the kernel queues released on dequeue
+ *
+ *  @param pmadapter  A pointer to mlan_adapter
+ *
+ *  @return           N/A
+ */
+static void wlan_wmm_aqm_send_wake(pmlan_adapter pmadapter)
+{
+	t_u8 event_buf[sizeof(mlan_event) + sizeof(t_u8)];
+	mlan_event *pevent = (mlan_event *)event_buf;
+	pmlan_private priv;
+	t_u8 mask;
+	int i;
+
+	pmadapter->tx_aqm_wake = MFALSE;
+	for (i = 0; i < pmadapter->priv_num; i++) {
+		priv = pmadapter->priv[i];
+		if (!priv || !priv->wmm.aqm_wake)
+			continue;
+		wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
+		mask = priv->wmm.aqm_wake;
+		priv->wmm.aqm_wake = 0;
+		wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
+		if (!mask)
+			continue;
+		memset(pmadapter, event_buf, 0, sizeof(event_buf));
+		pevent->bss_index = priv->bss_index;
+		pevent->event_id = MLAN_EVENT_ID_DRV_TX_QUEUE_WAKE;
+		pevent->event_len = sizeof(t_u8);
+		pevent->event_buf[0] = mask;
+		wlan_recv_event(priv, MLAN_EVENT_ID_DRV_TX_QUEUE_WAKE, pevent);
+	}
+}
+
+/**
+ *  @brief CoDel on the head of the RA list. Drops the packets whose
+ *         sojourn time has stayed above target for an interval, or
+ *         marks them with ECN CE when they are ECN capable. Called with
+ *         ra_list_spinlock held.
+ *
+ *  @param priv      A pointer to mlan_private
+ *  @param ra_list   Pointer to raListTbl structure
+ *  @param ptrindex  ra_list's TID index
+ *
+ *  @return          N/A
+ */
+static void wlan_wmm_aqm_dequeue(pmlan_private priv, raListTbl *ra_list,
+				 int ptrindex)
+{
+	pmlan_adapter pmadapter = priv->adapter;
+	sta_node *sta_ptr = MNULL;
+	pmlan_buffer pmbuf;
+	t_u32 sec, usec;
+	t_u64 now;
+	t_bool ok_to_drop;
+	t_u32 delta;
+
+	pmbuf = (pmlan_buffer)util_peek_list(pmadapter->pmoal_handle,
+					     &ra_list->buf_head, MNULL, MNULL);
+	if (!pmbuf)
+		return;
+	pmadapter->callbacks.moal_get_system_time(pmadapter->pmoal_handle, &sec,
+						  &usec);
+	now = (t_u64)sec * 1000000 + usec;
+	ok_to_drop = wlan_wmm_aqm_ok_to_drop(ra_list, pmbuf, now);
+	if (!ok_to_drop && !ra_list->aqm.dropping)
+		return;
+	if (!(ra_list->ra[0] & 0x01))
+		sta_ptr = wlan_get_station_entry(priv, ra_list->ra);
+
+	if (ra_list->aqm.dropping) {
+		if (!ok_to_drop)
+			ra_list->aqm.dropping = MFALSE;
+		while (ra_list->aqm.dropping &&
+		       now >= ra_list->aqm.drop_next_us) {
+			ra_list->aqm.count++;
+			if (wlan_wmm_aqm_drop_head(priv, ra_list, ptrindex,
+						   sta_ptr)) {
+				ra_list->aqm.drop_next_us =
+					wlan_wmm_aqm_control_law(
+						ra_list->aqm.drop_next_us,
+						ra_list->aqm.count);
+				return;
+			}
+			pmbuf = (pmlan_buffer)util_peek_list(
+				pmadapter->pmoal_handle, &ra_list->buf_head,
+				MNULL, MNULL);
+			if (!wlan_wmm_aqm_ok_to_drop(ra_list, pmbuf, now))
+				ra_list->aqm.dropping = MFALSE;
+			else
+				ra_list->aqm.drop_next_us =
+					wlan_wmm_aqm_control_law(
+						ra_list->aqm.drop_next_us,
+						ra_list->aqm.count);
+		}
+		return;
+	}
+
+	/* Enter the dropping state, resuming the drop rate if it was left
+	 * recently */
+	delta = ra_list->aqm.count - ra_list->aqm.lastcount;
+	if (delta > 1 &&
+	    now < ra_list->aqm.drop_next_us + 16 * WMM_AQM_INTERVAL_US)
+		ra_list->aqm.count = delta;
+	else
+		ra_list->aqm.count = 1;
+	ra_list->aqm.lastcount = ra_list->aqm.count;
+	ra_list->aqm.dropping = MTRUE;
+	ra_list->aqm.drop_next_us =
+		wlan_wmm_aqm_control_law(now, ra_list->aqm.count);
+	wlan_wmm_aqm_drop_head(priv, ra_list, ptrindex, sta_ptr);
+}
+
 /**
  *  @brief This function dequeues a packet
  *
@@ -1850,6 +2382,11 @@ static int wlan_dequeue_tx_packet(pmlan_adapter pmadapter)
 	}
 	if (ptr->del_ba_count >= DEL_BA_THRESHOLD)
 		wlan_update_del_ba_count(priv, ptr);
+	if (pmadapter->tx_aqm) {
+		wlan_wmm_aqm_dequeue(priv, ptr, ptrindex);
+		if (ptr->aqm.stop_mask)
+			wlan_wmm_aqm_release(priv, ptr);
+	}
 	if (pmadapter->tp_state_on) {
 		pmbuf = (pmlan_buffer)util_peek_list(
 			pmadapter->pmoal_handle, &ptr->buf_head, MNULL, MNULL);
@@ -1863,13 +2400,14 @@ static int wlan_dequeue_tx_packet(pmlan_adapter pmadapter)
 				PRINTM(MERROR, "Dequeuing the packet %p %p\n",
 				       ptr, pmbuf);
 				priv->wmm.pkts_queued[ptrindex]--;
-				util_scalar_decrement(pmadapter->pmoal_handle,
-						      &priv->wmm.tx_pkts_queued,
-						      MNULL, MNULL);
-				ptr->total_pkts--;
-				pmadapter->callbacks.moal_spin_unlock(
+				util_scalar_atomic_sub(
 					pmadapter->pmoal_handle,
-					priv->wmm.ra_list_spinlock);
+					&priv->wmm.tx_pkts_queued, 1,
+					wlan_atomic_sub_cb(pmadapter),
+					MNULL, MNULL);
+				ptr->total_pkts--;
+				wlan_spin_unlock(pmadapter,
+						 priv->wmm.ra_list_spinlock);
 				wlan_write_data_complete(pmadapter, pmbuf,
 							 MLAN_STATUS_SUCCESS);
 				LEAVE();
@@ -2007,11 +2545,9 @@ t_u16 wlan_update_ralist_tx_pause(pmlan_private priv, t_u8 *mac, t_u8 tx_pause)
 	int i;
 	pmlan_adapter pmadapter = priv->adapter;
 	t_u32 pkt_cnt = 0;
-	t_u32 tx_pkts_queued = 0;
 	ENTER();
 
-	pmadapter->callbacks.moal_spin_lock(pmadapter->pmoal_handle,
-					    priv->wmm.ra_list_spinlock);
+	wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 	for (i = 0; i < MAX_NUM_TID; ++i) {
 		raListTbl *ra_list = wlan_wmm_get_ralist_node(priv, i, mac);
 		if (ra_list == MNULL || ra_list->tx_pause == tx_pause)
@@ -2031,22 +2567,23 @@ t_u16 wlan_update_ralist_tx_pause(pmlan_private priv, t_u8 *mac, t_u8 tx_pause)
 	}
 
 	if (pkt_cnt) {
-		tx_pkts_queued = util_scalar_read(pmadapter->pmoal_handle,
-						  &priv->wmm.tx_pkts_queued,
-						  MNULL, MNULL);
 		if (tx_pause)
-			tx_pkts_queued -= pkt_cnt;
+			util_scalar_atomic_sub(
+				pmadapter->pmoal_handle,
+				&priv->wmm.tx_pkts_queued, pkt_cnt,
+				wlan_atomic_sub_cb(pmadapter), MNULL,
+				MNULL);
 		else
-			tx_pkts_queued += pkt_cnt;
-		util_scalar_write(priv->adapter->pmoal_handle,
-				  &priv->wmm.tx_pkts_queued, tx_pkts_queued,
-				  MNULL, MNULL);
+			util_scalar_atomic_add(
+				pmadapter->pmoal_handle,
+				&priv->wmm.tx_pkts_queued, pkt_cnt,
+				wlan_atomic_add_cb(pmadapter), MNULL,
+				MNULL);
 		util_scalar_write(priv->adapter->pmoal_handle,
 				  &priv->wmm.highest_queued_prio, HIGH_PRIO_TID,
 				  MNULL, MNULL);
 	}
-	pmadapter->callbacks.moal_spin_unlock(pmadapter->pmoal_handle,
-					      priv->wmm.ra_list_spinlock);
+	wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 
 	LEAVE();
 	return pkt_cnt;
@@ -2068,11 +2605,9 @@ t_void wlan_update_non_tdls_ralist(mlan_private *priv, t_u8 *mac, t_u8 tx_pause)
 	int i;
 	pmlan_adapter pmadapter = priv->adapter;
 	t_u32 pkt_cnt = 0;
-	t_u32 tx_pkts_queued = 0;
 	ENTER();
 
-	pmadapter->callbacks.moal_spin_lock(pmadapter->pmoal_handle,
-					    priv->wmm.ra_list_spinlock);
+	wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 	for (i = 0; i < MAX_NUM_TID; ++i) {
 		ra_list = (raListTbl *)util_peek_list(
 			priv->adapter->pmoal_handle,
@@ -2096,22 +2631,23 @@ t_void wlan_update_non_tdls_ralist(mlan_private *priv, t_u8 *mac, t_u8 tx_pause)
 		}
 	}
 	if (pkt_cnt) {
-		tx_pkts_queued = util_scalar_read(pmadapter->pmoal_handle,
-						  &priv->wmm.tx_pkts_queued,
-						  MNULL, MNULL);
 		if (tx_pause)
-			tx_pkts_queued -= pkt_cnt;
+			util_scalar_atomic_sub(
+				pmadapter->pmoal_handle,
+				&priv->wmm.tx_pkts_queued, pkt_cnt,
+				wlan_atomic_sub_cb(pmadapter), MNULL,
+				MNULL);
 		else
-			tx_pkts_queued += pkt_cnt;
-		util_scalar_write(priv->adapter->pmoal_handle,
-				  &priv->wmm.tx_pkts_queued, tx_pkts_queued,
-				  MNULL, MNULL);
+			util_scalar_atomic_add(
+				pmadapter->pmoal_handle,
+				&priv->wmm.tx_pkts_queued, pkt_cnt,
+				wlan_atomic_add_cb(pmadapter), MNULL,
+				MNULL);
 		util_scalar_write(priv->adapter->pmoal_handle,
 				  &priv->wmm.highest_queued_prio, HIGH_PRIO_TID,
 				  MNULL, MNULL);
 	}
-	pmadapter->callbacks.moal_spin_unlock(pmadapter->pmoal_handle,
-					      priv->wmm.ra_list_spinlock);
+	wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 	LEAVE();
 	return;
 }
@@ -2315,8 +2851,7 @@ t_void wlan_clean_txrx(pmlan_private priv)
 	if (IS_PCIE(pmadapter->card_type))
 		wlan_clean_pcie_ring_buf(priv->adapter);
 #endif
-	pmadapter->callbacks.moal_spin_lock(pmadapter->pmoal_handle,
-					    priv->wmm.ra_list_spinlock);
+	wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 	wlan_wmm_cleanup_queues(priv);
 	wlan_wmm_delete_all_sta_entries(priv);
 	wlan_wmm_delete_all_ralist(priv);
@@ -2337,8 +2872,7 @@ t_void wlan_clean_txrx(pmlan_private priv)
 		       sizeof(pmadapter->pcard_sd->mpa_rx_count));
 	}
 #endif
-	pmadapter->callbacks.moal_spin_unlock(pmadapter->pmoal_handle,
-					      priv->wmm.ra_list_spinlock);
+	wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 
 	LEAVE();
 }
@@ -2535,7 +3069,7 @@ void wlan_ralist_add(mlan_private *priv, t_u8 *ra)
 
 	ENTER();
 
-	sta = wlan_wmm_allocate_sta_table(pmadapter, ra);
+	sta = wlan_wmm_allocate_sta_table(priv, ra);
 	if (sta) {
 		util_enqueue_list_tail_nl(pmadapter->pmoal_handle,
 					  &priv->wmm.all_stas,
@@ -2814,11 +3348,12 @@ int wlan_wmm_lists_empty(pmlan_adapter pmadapter)
 				continue;
 #endif
 
-			if (util_scalar_read(
+			if (util_scalar_atomic_read(
 				    pmadapter->pmoal_handle,
 				    &priv->wmm.tx_pkts_queued,
-				    pmadapter->callbacks.moal_spin_lock,
-				    pmadapter->callbacks.moal_spin_unlock)) {
+				    wlan_atomic_read_cb(pmadapter),
+				    wlan_lock_cb(pmadapter),
+				    wlan_unlock_cb(pmadapter))) {
 				LEAVE();
 				return MFALSE;
 			}
@@ -3173,6 +3708,68 @@ static t_void wlan_wmm_update_queue_packets_budget(pmlan_adapter pmadapter,
 	}
 }
 
+/** Max queued packets looked at for an older TCP ACK of the same flow */
+#define TCP_ACK_COALESCE_SCAN 64
+
+/**
+ *  @brief Replace an older TCP ACK of the same flow still waiting in the
+ *         RA list with a newer cumulative ACK. Both are pure ACKs that moal
+ *         marked MLAN_BUF_FLAG_TCP_ACK_COALESCE, so they carry no payload,
+ *         SACK blocks or ECN signal. Duplicate ACKs are never merged.
+ *         Only the newest queued packet of the flow is a candidate, so the
+ *         new ACK never moves ahead of a data or SACK segment of the flow.
+ *
+ *  @param pmadapter  Pointer to the mlan_adapter driver data struct
+ *  @param ra_list    Pointer to the RA list, with ra_list_spinlock held
+ *  @param pmbuf      Pointer to the new TCP ACK
+ *
+ *  @return           MTRUE if pmbuf was copied into an older ACK
+ */
+static t_u8 wlan_wmm_coalesce_tcp_ack(pmlan_adapter pmadapter,
+				      raListTbl *ra_list, pmlan_buffer pmbuf)
+{
+	pmlan_buffer pold;
+	t_u8 *iph, *tcph, *old_iph, *old_tcph;
+	t_u32 ack_seq, old_ack_seq;
+	int scan = 0;
+
+	iph = pmbuf->pbuf + pmbuf->data_offset + sizeof(EthII_Hdr_t);
+	tcph = iph + (iph[0] & 0x0f) * 4;
+	memcpy_ext(pmadapter, &ack_seq, tcph + 8, sizeof(ack_seq),
+		   sizeof(ack_seq));
+	ack_seq = mlan_ntohl(ack_seq);
+
+	for (pold = (pmlan_buffer)ra_list->buf_head.pprev;
+	     pold != (pmlan_buffer)&ra_list->buf_head &&
+	     scan < TCP_ACK_COALESCE_SCAN;
+	     pold = pold->pprev, scan++) {
+		/* moal flags every IPv4 TCP packet it looked at */
+		if (!(pold->flags & MLAN_BUF_FLAG_TCP_PKT))
+			continue;
+		old_iph = pold->pbuf + pold->data_offset + sizeof(EthII_Hdr_t);
+		old_tcph = old_iph + (old_iph[0] & 0x0f) * 4;
+		/* Addresses, then ports */
+		if (memcmp(pmadapter, old_iph + 12, iph + 12, 8) ||
+		    memcmp(pmadapter, old_tcph, tcph, 4))
+			continue;
+		/* Newest packet of the flow, merge only into a pure ACK */
+		if (!(pold->flags & MLAN_BUF_FLAG_TCP_ACK_COALESCE) ||
+		    pold->data_len != pmbuf->data_len)
+			return MFALSE;
+		memcpy_ext(pmadapter, &old_ack_seq, old_tcph + 8,
+			   sizeof(old_ack_seq), sizeof(old_ack_seq));
+		old_ack_seq = mlan_ntohl(old_ack_seq);
+		if ((t_s32)(ack_seq - old_ack_seq) <= 0)
+			return MFALSE;
+		memcpy_ext(pmadapter, pold->pbuf + pold->data_offset,
+			   pmbuf->pbuf + pmbuf->data_offset, pmbuf->data_len,
+			   pold->data_len);
+		pmbuf->flags |= MLAN_BUF_FLAG_TCP_ACK_COALESCED;
+		return MTRUE;
+	}
+	return MFALSE;
+}
+
 /**
  *  @brief Add packet to WMM queue
  *
@@ -3204,8 +3801,7 @@ t_void wlan_wmm_add_buf_txqueue(pmlan_adapter pmadapter, pmlan_buffer pmbuf)
 		return;
 	}
 	tid = pmbuf->priority;
-	pmadapter->callbacks.moal_spin_lock(pmadapter->pmoal_handle,
-					    priv->wmm.ra_list_spinlock);
+	wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 	tid_down = wlan_wmm_downgrade_tid(priv, tid);
 
 	/* In case of infra as we have already created the list during
@@ -3220,9 +3816,7 @@ t_void wlan_wmm_add_buf_txqueue(pmlan_adapter pmadapter, pmlan_buffer pmbuf)
 			pmbuf->flags |= MLAN_BUF_FLAG_TDLS;
 		} else if (status == TDLS_SETUP_INPROGRESS) {
 			wlan_add_buf_tdls_txqueue(priv, pmbuf);
-			pmadapter->callbacks.moal_spin_unlock(
-				pmadapter->pmoal_handle,
-				priv->wmm.ra_list_spinlock);
+			wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 			LEAVE();
 			return;
 		} else
@@ -3263,8 +3857,7 @@ t_void wlan_wmm_add_buf_txqueue(pmlan_adapter pmadapter, pmlan_buffer pmbuf)
 		PRINTM(MWARN,
 		       "Drop packet %p, ra_list=%p, media_connected=%d\n",
 		       pmbuf, ra_list, priv->media_connected);
-		pmadapter->callbacks.moal_spin_unlock(
-			pmadapter->pmoal_handle, priv->wmm.ra_list_spinlock);
+		wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 		wlan_write_data_complete(pmadapter, pmbuf, MLAN_STATUS_FAILURE);
 		LEAVE();
 		return;
@@ -3274,11 +3867,20 @@ t_void wlan_wmm_add_buf_txqueue(pmlan_adapter pmadapter, pmlan_buffer pmbuf)
 	wlan_wmm_record_sta_tx(pmadapter, priv, ra_list, sta_table);
 	wlan_wmm_update_queue_packets_budget(pmadapter, priv);
 
+	if ((pmbuf->flags & MLAN_BUF_FLAG_TCP_ACK_COALESCE) &&
+	    wlan_wmm_coalesce_tcp_ack(pmadapter, ra_list, pmbuf)) {
+		PRINTM(MDATA, "TCP ACK %p coalesced in ra_list %p\n", pmbuf,
+		       ra_list);
+		wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
+		wlan_write_data_complete(pmadapter, pmbuf, MLAN_STATUS_SUCCESS);
+		LEAVE();
+		return;
+	}
+
 	if (sta_table &&
 	    ra_list->total_pkts > sta_table->budget.queue_packets &&
 	    !(pmbuf->flags & MLAN_BUF_FLAG_TCP_PKT)) {
-		pmadapter->callbacks.moal_spin_unlock(
-			pmadapter->pmoal_handle, priv->wmm.ra_list_spinlock);
+		wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 		wlan_write_data_complete(pmadapter, pmbuf,
 					 MLAN_STATUS_RESOURCE);
 		LEAVE();
@@ -3296,12 +3898,41 @@ t_void wlan_wmm_add_buf_txqueue(pmlan_adapter pmadapter, pmlan_buffer pmbuf)
 	ra_list->total_pkts++;
 	ra_list->packet_count++;
 
+	/* Have MOAL stop the kernel queue of the packet while this station
+	 * holds tx_aqm_limit packets and nothing else is queued for it.
+	 * With other stations backlogged the queue stays open, CoDel keeps
+	 * the sojourn time of this station down and max_tx_pending bounds
+	 * the total. The queue is woken from the dequeue path, see
+	 * wlan_wmm_aqm_release() */
+	if (pmadapter->tx_aqm &&
+	    ra_list->total_pkts >= pmadapter->tx_aqm_limit) {
+		t_u8 queue = wlan_wmm_select_queue(priv, pmbuf->priority);
+
+		/* The packet is not in pkts_queued yet */
+		if (wlan_wmm_aqm_queue_backlog(priv, queue) <
+		    ra_list->total_pkts) {
+			if (!(priv->wmm.aqm_stop & MBIT(queue))) {
+#ifdef UAP_SUPPORT
+				if (sta_ptr)
+					sta_ptr->tx_aqm_overlimit++;
+#endif
+				PRINTM(MDATA,
+				       "AQM: ra_list %p stops queue %d\n",
+				       ra_list, queue);
+			}
+			ra_list->aqm.stop_mask |= MBIT(queue);
+			priv->wmm.aqm_stop |= MBIT(queue);
+		}
+	}
+
 	priv->wmm.pkts_queued[tid_down]++;
 	if (ra_list->tx_pause) {
 		priv->wmm.pkts_paused[tid_down]++;
 	} else {
-		util_scalar_increment(pmadapter->pmoal_handle,
-				      &priv->wmm.tx_pkts_queued, MNULL, MNULL);
+		util_scalar_atomic_add(pmadapter->pmoal_handle,
+				       &priv->wmm.tx_pkts_queued, 1,
+				       wlan_atomic_add_cb(pmadapter),
+				       MNULL, MNULL);
 		/* if highest_queued_prio < prio(tid_down), set it to
 		 * prio(tid_down) */
 		util_scalar_conditional_write(
@@ -3339,8 +3970,8 @@ t_void wlan_wmm_add_buf_txqueue(pmlan_adapter pmadapter, pmlan_buffer pmbuf)
 	 */
 	pmadapter->callbacks.moal_get_system_time(
 		pmadapter->pmoal_handle, &pmbuf->in_ts_sec, &pmbuf->in_ts_usec);
-	pmadapter->callbacks.moal_spin_unlock(pmadapter->pmoal_handle,
-					      priv->wmm.ra_list_spinlock);
+	wlan_tx_lat_stamp(pmadapter, pmbuf, MLAN_TX_LAT_ENQ);
+	wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 
 	LEAVE();
 }
@@ -3691,10 +4322,39 @@ void wlan_wmm_process_tx(pmlan_adapter pmadapter)
 	} while (!pmadapter->data_sent && !pmadapter->tx_lock_flag &&
 		 !wlan_wmm_lists_empty(pmadapter));
 
+	if (pmadapter->tx_aqm_wake)
+		wlan_wmm_aqm_send_wake(pmadapter);
+
 	LEAVE();
 	return;
 }
 
+/**
+ *  @brief Check if a kernel queue stopped over tx_aqm_limit can be woken,
+ *         from the MOAL tx completion. See wlan_wmm_aqm_clear_stop().
+ *
+ *  @param priv         A pointer to mlan_private structure
+ *  @param queue        Kernel queue index (0-3)
+ *
+ *  @return             MTRUE or MFALSE
+ */
+t_u8 wlan_wmm_aqm_can_wake(mlan_private *priv, t_u8 queue)
+{
+	pmlan_adapter pmadapter = priv->adapter;
+	t_u8 ret;
+
+	ENTER();
+	if (!(priv->wmm.aqm_stop & MBIT(queue))) {
+		LEAVE();
+		return MTRUE;
+	}
+	wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
+	ret = wlan_wmm_aqm_clear_stop(priv, queue);
+	wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
+	LEAVE();
+	return ret;
+}
+
 /**
  *  @brief select wmm queue
  *
@@ -3765,9 +4425,10 @@ static INLINE t_u8 wlan_del_tx_pkts_in_ralist(pmlan_private priv,
 				if (ra_list->tx_pause)
 					priv->wmm.pkts_paused[tid]--;
 				else
-					util_scalar_decrement(
+					util_scalar_atomic_sub(
 						pmadapter->pmoal_handle,
-						&priv->wmm.tx_pkts_queued,
+						&priv->wmm.tx_pkts_queued, 1,
+						wlan_atomic_sub_cb(pmadapter),
 						MNULL, MNULL);
 				ret = MTRUE;
 				break;
@@ -3792,8 +4453,7 @@ t_void wlan_drop_tx_pkts(pmlan_private priv)
 	int j;
 	static int i;
 	pmlan_adapter pmadapter = priv->adapter;
-	pmadapter->callbacks.moal_spin_lock(pmadapter->pmoal_handle,
-					    priv->wmm.ra_list_spinlock);
+	wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 	for (j = 0; j < MAX_NUM_TID; j++, i++) {
 		if (i == MAX_NUM_TID)
 			i = 0;
@@ -3803,8 +4463,7 @@ t_void wlan_drop_tx_pkts(pmlan_private priv)
 			break;
 		}
 	}
-	pmadapter->callbacks.moal_spin_unlock(pmadapter->pmoal_handle,
-					      priv->wmm.ra_list_spinlock);
+	wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 	return;
 }
 
@@ -3825,10 +4484,9 @@ t_void wlan_wmm_delete_peer_ralist(pmlan_private priv, t_u8 *mac)
 	mlan_callbacks *cbs = &pmadapter->callbacks;
 	void *const pmoal_handle = pmadapter->pmoal_handle;
 	t_u32 pkt_cnt = 0;
-	t_u32 tx_pkts_queued = 0;
 
 	ENTER();
-	cbs->moal_spin_lock(pmoal_handle, priv->wmm.ra_list_spinlock);
+	wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 
 	for (i = 0; i < MAX_NUM_TID; ++i) {
 		ra_list = wlan_wmm_get_ralist_node(priv, i, mac);
@@ -3864,12 +4522,9 @@ t_void wlan_wmm_delete_peer_ralist(pmlan_private priv, t_u8 *mac)
 		}
 	}
 	if (pkt_cnt) {
-		tx_pkts_queued = util_scalar_read(
-			pmoal_handle, &priv->wmm.tx_pkts_queued, MNULL, MNULL);
-		tx_pkts_queued -= pkt_cnt;
-		util_scalar_write(priv->adapter->pmoal_handle,
-				  &priv->wmm.tx_pkts_queued, tx_pkts_queued,
-				  MNULL, MNULL);
+		util_scalar_atomic_sub(pmoal_handle, &priv->wmm.tx_pkts_queued,
+				       pkt_cnt, wlan_atomic_sub_cb(pmadapter),
+				       MNULL, MNULL);
 		util_scalar_write(priv->adapter->pmoal_handle,
 				  &priv->wmm.highest_queued_prio, HIGH_PRIO_TID,
 				  MNULL, MNULL);
@@ -3885,7 +4540,7 @@ t_void wlan_wmm_delete_peer_ralist(pmlan_private priv, t_u8 *mac)
 		cbs->moal_mfree(pmoal_handle, (t_u8 *)sta);
 	}
 
-	cbs->moal_spin_unlock(pmoal_handle, priv->wmm.ra_list_spinlock);
+	wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 	LEAVE();
 }
 
@@ -3906,8 +4561,7 @@ t_void wlan_hold_tdls_packets(pmlan_private priv, t_u8 *mac)
 	t_u8 i;
 
 	ENTER();
-	pmadapter->callbacks.moal_spin_lock(pmadapter->pmoal_handle,
-					    priv->wmm.ra_list_spinlock);
+	wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 	PRINTM(MDATA, "wlan_hold_tdls_packets: " MACSTR "\n", MAC2STR(mac));
 	for (i = 0; i < MAX_NUM_TID; ++i) {
 		ra_list = (raListTbl *)util_peek_list(
@@ -3922,17 +4576,18 @@ t_void wlan_hold_tdls_packets(pmlan_private priv, t_u8 *mac)
 						 MNULL, MNULL);
 				ra_list->total_pkts--;
 				priv->wmm.pkts_queued[i]--;
-				util_scalar_decrement(pmadapter->pmoal_handle,
-						      &priv->wmm.tx_pkts_queued,
-						      MNULL, MNULL);
+				util_scalar_atomic_sub(
+					pmadapter->pmoal_handle,
+					&priv->wmm.tx_pkts_queued, 1,
+					wlan_atomic_sub_cb(pmadapter),
+					MNULL, MNULL);
 				ra_list->packet_count--;
 				wlan_add_buf_tdls_txqueue(priv, pmbuf);
 				PRINTM(MDATA, "hold tdls packet=%p\n", pmbuf);
 			}
 		}
 	}
-	pmadapter->callbacks.moal_spin_unlock(pmadapter->pmoal_handle,
-					      priv->wmm.ra_list_spinlock);
+	wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 	LEAVE();
 }
 
@@ -3958,8 +4613,7 @@ t_void wlan_restore_tdls_packets(pmlan_private priv, t_u8 *mac,
 	PRINTM(MDATA, "wlan_restore_tdls_packets: " MACSTR " status=%d\n",
 	       MAC2STR(mac), status);
 
-	pmadapter->callbacks.moal_spin_lock(pmadapter->pmoal_handle,
-					    priv->wmm.ra_list_spinlock);
+	wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 
 	while ((pmbuf = wlan_find_packets_tdls_txq(priv, mac))) {
 		util_unlink_list(pmadapter->pmoal_handle,
@@ -3996,8 +4650,10 @@ t_void wlan_restore_tdls_packets(pmlan_private priv, t_u8 *mac,
 		ra_list->total_pkts++;
 		ra_list->packet_count++;
 		priv->wmm.pkts_queued[tid_down]++;
-		util_scalar_increment(pmadapter->pmoal_handle,
-				      &priv->wmm.tx_pkts_queued, MNULL, MNULL);
+		util_scalar_atomic_add(pmadapter->pmoal_handle,
+				       &priv->wmm.tx_pkts_queued, 1,
+				       wlan_atomic_add_cb(pmadapter),
+				       MNULL, MNULL);
 		util_scalar_conditional_write(
 			pmadapter->pmoal_handle, &priv->wmm.highest_queued_prio,
 			MLAN_SCALAR_COND_LESS_THAN, tos_to_tid_inv[tid_down],
@@ -4005,8 +4661,7 @@ t_void wlan_restore_tdls_packets(pmlan_private priv, t_u8 *mac,
 	}
 	if (status != TDLS_SETUP_COMPLETE)
 		wlan_wmm_delete_tdls_ralist(priv, mac);
-	pmadapter->callbacks.moal_spin_unlock(pmadapter->pmoal_handle,
-					      priv->wmm.ra_list_spinlock);
+	wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 	LEAVE();
 }
 
@@ -4965,8 +5620,10 @@ void wlan_dump_ralist(mlan_private *priv)
 	t_u32 tx_pkts_queued;
 
 	tx_pkts_queued =
-		util_scalar_read(pmadapter->pmoal_handle,
-				 &priv->wmm.tx_pkts_queued, MNULL, MNULL);
+		util_scalar_atomic_read(pmadapter->pmoal_handle,
+					&priv->wmm.tx_pkts_queued,
+					wlan_atomic_read_cb(pmadapter),
+					MNULL, MNULL);
 	PRINTM(MERROR, "bss_index = %d, tx_pkts_queued = %d tx_pause\n",
 	       priv->bss_index, tx_pkts_queued, priv->tx_pause);
 	if (!tx_pkts_queued)
@@ -5204,10 +5861,8 @@ static void wlan_wmm_adjust_sta_tx_budget(pmlan_private priv,
 					  HostCmd_TX_RATE_QUERY *rate)
 {
 	mlan_adapter *pmadapter = priv->adapter;
-	const t_u8 ppdu_type_legacy = 0;
-	const t_u8 ppdu_type_ht = 1;
-	const t_u8 ppdu_type_vht = 2;
-	const t_u8 ppdu_type_he = 3;
+	/* Legacy rate indexes 0-4 are the DSSS/CCK rates */
+	const t_u8 legacy_dsss_max_idx = 4;
 	t_u32 phy_rate = 0;
 	t_u8 nss = (rate->tx_rate >> 4) + 1;
 	t_u8 mcs = (rate->tx_rate) & 0x0f;
@@ -5219,13 +5874,13 @@ static void wlan_wmm_adjust_sta_tx_budget(pmlan_private priv,
 
 	gi |= (rate->tx_rate_info >> 6) & 0x02;
 
-	if (ppdu_format == ppdu_type_he)
+	if (ppdu_format == WMM_PPDU_TYPE_HE)
 		phy_rate = wlam_wmm_get_he_rate(ppdu_bw, gi, nss, mcs);
-	else if (ppdu_format == ppdu_type_vht)
+	else if (ppdu_format == WMM_PPDU_TYPE_VHT)
 		phy_rate = wlam_wmm_get_vht_rate(ppdu_bw, gi, nss, mcs);
-	else if (ppdu_format == ppdu_type_ht)
+	else if (ppdu_format == WMM_PPDU_TYPE_HT)
 		phy_rate = wlam_wmm_get_ht_rate(ppdu_bw, gi, rate->tx_rate);
-	else if (ppdu_format == ppdu_type_legacy)
+	else if (ppdu_format == WMM_PPDU_TYPE_LEGACY)
 		phy_rate = wlam_wmm_get_legacy_rate(rate->tx_rate);
 
 	if (phy_rate > 0) {
@@ -5233,6 +5888,13 @@ static void wlan_wmm_adjust_sta_tx_budget(pmlan_private priv,
 		sta->budget.byte_budget_init = wlan_wmm_get_byte_budget(
 			pmadapter, sta->budget.time_budget_init_us, phy_rate);
 		sta->budget.phy_rate_kbps = phy_rate;
+		/* HT carries the stream count in the MCS index */
+		if (ppdu_format == WMM_PPDU_TYPE_HT)
+			nss = (rate->tx_rate >> 3) + 1;
+		wlan_wmm_set_ppdu_overhead(
+			priv, sta, ppdu_format, nss,
+			ppdu_format == WMM_PPDU_TYPE_LEGACY &&
+				rate->tx_rate <= legacy_dsss_max_idx);
 
 		if (old_phy_rate / phy_rate >= 2 ||
 		    phy_rate / old_phy_rate >= 2) {
@@ -5284,10 +5946,8 @@ void wlan_update_sta_ps_state(pmlan_private priv, t_u8 *mac, t_u8 sleep)
 	mlan_adapter *pmadapter = priv->adapter;
 	struct wmm_sta_table *sta;
 	t_bool resume_sta = MFALSE;
-	mlan_callbacks *cbs = &pmadapter->callbacks;
 
-	cbs->moal_spin_lock(pmadapter->pmoal_handle,
-			    priv->wmm.ra_list_spinlock);
+	wlan_spin_lock(pmadapter, priv->wmm.ra_list_spinlock);
 
 	sta = wlan_wmm_get_sta(priv, mac);
 	if (sta) {
@@ -5303,8 +5963,7 @@ void wlan_update_sta_ps_state(pmlan_private priv, t_u8 *mac, t_u8 sleep)
 		sta->ps_sleep = sleep;
 	}
 
-	cbs->moal_spin_unlock(pmadapter->pmoal_handle,
-			      priv->wmm.ra_list_spinlock);
+	wlan_spin_unlock(pmadapter, priv->wmm.ra_list_spinlock);
 	if (resume_sta)
 		wlan_update_ralist_tx_pause(priv, mac, 0);
 }
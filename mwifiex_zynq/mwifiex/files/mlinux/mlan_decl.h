@@ -658,6 +658,21 @@ typedef enum {
 
 #define MLAN_BUF_FLAG_LLDE_PKT_FILTER MBIT(19)
 
+/** Buffer flag for rx subframe sharing the data of its pparent */
+#define MLAN_BUF_FLAG_RX_VIEW MBIT(20)
+
+/** Buffer flag for pure TCP ACK that may replace an older queued ACK */
+#define MLAN_BUF_FLAG_TCP_ACK_COALESCE MBIT(21)
+/** Buffer flag for TCP ACK copied into an older queued ACK of its flow */
+#define MLAN_BUF_FLAG_TCP_ACK_COALESCED MBIT(22)
+
+/** AMSDU subframes are copied into new buffers */
+#define RX_AMSDU_ZCOPY_DISABLE 0
+/** AMSDU subframes share the parent, IP header realigned when needed */
+#define RX_AMSDU_ZCOPY_ALIGN 1
+/** AMSDU subframes share the parent, no realignment */
+#define RX_AMSDU_ZCOPY_UNALIGNED 2
+
 #ifdef DEBUG_LEVEL1
 /** Debug level bit definition */
 #define MMSG MBIT(0)
@@ -914,6 +929,7 @@ typedef enum _mlan_event_id {
 #endif
 	MLAN_EVENT_ID_DRV_RGPWR_KEY_MISMATCH = 0x80000037,
 	MLAN_EVENT_ID_DRV_ASSOC_FAILURE = 0x80000039,
+	MLAN_EVENT_ID_DRV_TX_QUEUE_WAKE = 0x8000003A,
 } mlan_event_id;
 
 /** Data Structures */
@@ -1367,6 +1383,42 @@ typedef MLAN_PACK_START struct MAPP_Stats_Mcast_drv {
 	t_u32 spent_time_over_2000usec;
 	t_u32 spent_time_over_3000usec;
 } MLAN_PACK_END Stats_mcast_drv_t, *pStats_mcast_drv_t;
+
+/** TX latency trace points stamped in mlan_buffer.tx_lat_ts */
+enum _mlan_tx_lat_stage {
+	/** Entered the driver (hard_start_xmit) */
+	MLAN_TX_LAT_XMIT = 0,
+	/** Queued on the WMM RA list */
+	MLAN_TX_LAT_ENQ,
+	/** Dequeued from the WMM RA list */
+	MLAN_TX_LAT_DEQ,
+	/** Frame formed: AMSDU aggregated or single TxPD added */
+	MLAN_TX_LAT_AGGR,
+	/** Handed to the bus */
+	MLAN_TX_LAT_BUS,
+	MLAN_TX_LAT_STAGES,
+};
+
+/** moal_tp_accounting drop point of a traced packet at TX done */
+#define MLAN_TX_LAT_DROP_POINT 12
+
+/** RX latency trace points, stamped in this order */
+enum _mlan_rx_lat_stage {
+	/** Interrupt that announced the packet */
+	MLAN_RX_LAT_INT = 0,
+	/** Read from the bus */
+	MLAN_RX_LAT_BUS,
+	/** Queued on rx_data_queue */
+	MLAN_RX_LAT_ENQ,
+	/** Dequeued from rx_data_queue */
+	MLAN_RX_LAT_DEQ,
+	/** Released by the RX reorder table */
+	MLAN_RX_LAT_REORDER,
+	/** Late stage entered: AMSDU deaggregation, 802.3 conversion */
+	MLAN_RX_LAT_DEAGGR,
+	MLAN_RX_LAT_STAGES,
+};
+
 /** mlan_buffer data structure */
 typedef struct _mlan_buffer {
 	/** Pointer to previous mlan_buffer */
@@ -1412,6 +1464,14 @@ typedef struct _mlan_buffer {
 	t_u32 extra_ts_sec;
 	/** Time stamp when packet is dequed from rx_q(micro seconds) */
 	t_u32 extra_ts_usec;
+	/** TX latency trace boot time stamps in ns, the packet is only
+	 *  traced when tx_lat_ts[MLAN_TX_LAT_XMIT] is set */
+	t_u64 tx_lat_ts[MLAN_TX_LAT_STAGES];
+	/** RX latency trace boot time stamps in ns, the packet is only
+	 *  traced when rx_lat_ts[MLAN_RX_LAT_BUS] is set */
+	t_u64 rx_lat_ts[MLAN_RX_LAT_STAGES];
+	/** TID of a traced RX packet */
+	t_u8 rx_lat_tid;
 	/** When TX ra mac address,  When Rx Ta mac address*/
 	t_u8 mac[MLAN_MAC_ADDR_LENGTH];
 	/** Fields below are valid for MLAN module only */
@@ -2607,6 +2667,15 @@ typedef struct _mlan_callbacks {
 	mlan_status (*moal_spin_lock)(t_void *pmoal, t_void *plock);
 	/** moal_spin_unlock */
 	mlan_status (*moal_spin_unlock)(t_void *pmoal, t_void *plock);
+	/** moal_atomic_add, optional: returns the new value */
+	t_s32 (*moal_atomic_add)(t_void *pmoal, t_s32 *pval, t_s32 i);
+	/** moal_atomic_sub, optional: returns the new value */
+	t_s32 (*moal_atomic_sub)(t_void *pmoal, t_s32 *pval, t_s32 i);
+	/** moal_atomic_read, optional */
+	t_s32 (*moal_atomic_read)(t_void *pmoal, t_s32 *pval);
+	/** moal_atomic_cmpxchg, optional: returns the old value */
+	t_s32 (*moal_atomic_cmpxchg)(t_void *pmoal, t_s32 *pval, t_s32 old,
+				     t_s32 new_val);
 	/** moal_print */
 	t_void (*moal_print)(t_void *pmoal, t_u32 level, char *pformat, IN...);
 	/** moal_print_netintf */
@@ -2629,6 +2698,16 @@ typedef struct _mlan_callbacks {
 					    unsigned int rsvd1);
 	void (*moal_amsdu_tp_accounting)(t_void *pmoal, t_s32 delay,
 					 t_s32 copy_delay);
+	/** moal_rx_late_queue, optional: defer the late rx stage of a
+	 *  reordered packet to the worker owning the flow. Returns
+	 *  MLAN_STATUS_RESOURCE if the worker is full and the packet must
+	 *  be dropped, MLAN_STATUS_FAILURE to process it inline */
+	mlan_status (*moal_rx_late_queue)(t_void *pmoal, t_u32 flow,
+					  pmlan_buffer pmbuf);
+	/** moal_buf_writable, optional: check that the first len bytes of
+	 *  a MOAL tx buffer can be rewritten in place */
+	t_u8 (*moal_buf_writable)(t_void *pmoal, pmlan_buffer pmbuf,
+				  t_u32 len);
 } mlan_callbacks, *pmlan_callbacks;
 
 /** Parameter unchanged, use MLAN default setting */
@@ -2653,6 +2732,11 @@ typedef struct _mlan_callbacks {
 /** Parameter disabled, override MLAN default setting */
 #define MLAN_INIT_PARA_DISABLED 2
 
+/** Multi-client scheduling: byte budget per RA list */
+#define MLAN_MCLIENT_SCHED_BYTE 1
+/** Multi-client scheduling: airtime deficit per RA list */
+#define MLAN_MCLIENT_SCHED_AIRTIME 2
+
 /** Control bit for stream 2X2 */
 #define FEATURE_CTRL_STREAM_2X2 MBIT(0)
 /** Control bit for DFS support */
@@ -2789,6 +2873,12 @@ typedef struct _mlan_device {
 	t_u8 second_mac;
 	/** napi */
 	t_u8 napi;
+	/** AMSDU zero-copy deaggregation mode, RX_AMSDU_ZCOPY_* */
+	t_u8 rx_amsdu_zcopy;
+	/** Forward intra-BSS uAP multicast and AMSDU subframes in place */
+	t_u8 uap_fwd_zcopy;
+	/** CoDel queue management on RA lists */
+	t_u8 tx_aqm;
 	/** antcfg */
 	t_u32 antcfg;
 	/** dmcs */
@@ -2831,6 +2921,10 @@ MLAN_API mlan_status mlan_main_process(t_void *padapter);
 /** Rx process */
 mlan_status mlan_rx_process(t_void *padapter, t_u8 *rx_pkts);
 
+/** Late rx stage for a packet queued by moal_rx_late_queue */
+MLAN_API mlan_status mlan_rx_late_process(t_void *padapter,
+					  pmlan_buffer pmbuf);
+
 /** Packet Transmission */
 MLAN_API mlan_status mlan_send_packet(t_void *padapter, pmlan_buffer pmbuf);
 
@@ -2867,6 +2961,8 @@ MLAN_API t_void mlan_hs_callback(t_void *pctx);
 MLAN_API t_void mlan_pm_wakeup_card(t_void *padapter, t_u8 keep_wakeup);
 
 MLAN_API t_u8 mlan_is_main_process_running(t_void *adapter);
+/** Turn the RX latency trace on/off */
+MLAN_API t_void mlan_set_rx_lat(t_void *adapter, t_u8 on);
 #ifdef PCIE
 MLAN_API t_void mlan_set_int_mode(t_void *adapter, t_u32 int_mode,
 				  t_u8 func_num);
@@ -2875,6 +2971,12 @@ MLAN_API t_void mlan_set_int_mode(t_void *adapter, t_u32 int_mode,
 MLAN_API mlan_status mlan_ioctl(t_void *padapter, pmlan_ioctl_req pioctl_req);
 /** mlan select wmm queue */
 MLAN_API t_u8 mlan_select_wmm_queue(t_void *padapter, t_u8 bss_num, t_u8 tid);
+/** Check if a station over tx_aqm_limit stopped the wmm queue */
+MLAN_API t_u8 mlan_is_tx_queue_overlimit(t_void *padapter, t_u8 bss_num,
+					 t_u8 queue);
+/** Check if the wmm queue can be woken for tx_aqm */
+MLAN_API t_u8 mlan_tx_queue_can_wake(t_void *padapter, t_u8 bss_num,
+				     t_u8 queue);
 
 /** mlan mask host interrupt */
 MLAN_API mlan_status mlan_disable_host_int(t_void *padapter);
@@ -0,0 +1,279 @@
+/**  @file moal_csi.c
+ *
+ * @brief This file contains the CSI ring read through
+ * /proc/mwlan/adapterX/<interface>/csi. The event handler copies each
+ * CSI record into a slot of a ring that the reader maps, so records
+ * reach userspace without an allocation or a netlink message each.
+ *
+ *
+ * Copyright 2026 NXP
+ *
+ * This software file (the File) is distributed by NXP
+ * under the terms of the GNU General Public License Version 2, June 1991
+ * (the License).  You may use, redistribute and/or modify the File in
+ * accordance with the terms and conditions of the License, a copy of which
+ * is available by writing to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA or on the
+ * worldwide web at http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ * THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE
+ * ARE EXPRESSLY DISCLAIMED.  The License provides additional details about
+ * this warranty disclaimer.
+ *
+ */
+
+/********************************************************
+Change log:
+    10/18/2026: initial version
+********************************************************/
+
+#include <linux/poll.h>
+#include "moal_main.h"
+#include "moal_csi.h"
+
+/********************************************************
+		Local Variables
+********************************************************/
+/** CSI ring of one interface, exists while the csi file is open */
+struct _moal_csi_ring {
+	/** Interface */
+	moal_private *priv;
+	/** Mapped header and slots */
+	moal_csi_ring_hdr *hdr;
+	/** Reader waiting for records */
+	wait_queue_head_t wq;
+};
+
+/** Serializes open and release of the csi files */
+static DEFINE_MUTEX(csi_ring_lock);
+
+/** Name of the proc entry */
+#define CSI_PROC "csi"
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 16, 0)
+typedef __poll_t woal_poll_t;
+#else
+typedef unsigned int woal_poll_t;
+#endif
+
+/********************************************************
+		Local Functions
+********************************************************/
+/**
+ *  @brief csi proc open function, allocates the ring. Only one reader
+ *         may have the file open.
+ *
+ *  @param inode    pointer to inode
+ *  @param file     file pointer
+ *
+ *  @return         0 or negative error code
+ */
+static int woal_csi_proc_open(struct inode *inode, struct file *file)
+{
+	moal_private *priv;
+	moal_csi_ring *ring;
+	int ret = 0;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 16, 0)
+	priv = (moal_private *)pde_data(inode);
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(3, 10, 0)
+	priv = (moal_private *)PDE_DATA(inode);
+#else
+	priv = (moal_private *)PDE(inode)->data;
+#endif
+	if (!priv)
+		return -ENODEV;
+	if (!MODULE_GET)
+		return -EFAULT;
+	mutex_lock(&csi_ring_lock);
+	if (rcu_access_pointer(priv->csi_ring)) {
+		ret = -EBUSY;
+		goto done;
+	}
+	ring = kzalloc(sizeof(*ring), GFP_KERNEL);
+	if (!ring) {
+		ret = -ENOMEM;
+		goto done;
+	}
+	ring->hdr = vmalloc_user(MOAL_CSI_RING_LEN);
+	if (!ring->hdr) {
+		kfree(ring);
+		ret = -ENOMEM;
+		goto done;
+	}
+	ring->priv = priv;
+	init_waitqueue_head(&ring->wq);
+	ring->hdr->magic = MOAL_CSI_RING_MAGIC;
+	ring->hdr->version = MOAL_CSI_RING_VERSION;
+	ring->hdr->hdr_len = MOAL_CSI_RING_HDR_LEN;
+	ring->hdr->slot_size = MOAL_CSI_SLOT_SIZE;
+	ring->hdr->num_slots = MOAL_CSI_RING_SLOTS;
+	file->private_data = ring;
+	rcu_assign_pointer(priv->csi_ring, ring);
+done:
+	mutex_unlock(&csi_ring_lock);
+	if (ret)
+		MODULE_PUT;
+	return ret;
+}
+
+/**
+ *  @brief csi proc release function, frees the ring
+ *
+ *  @param inode    pointer to inode
+ *  @param file     file pointer
+ *
+ *  @return         0
+ */
+static int woal_csi_proc_release(struct inode *inode, struct file *file)
+{
+	moal_csi_ring *ring = file->private_data;
+
+	mutex_lock(&csi_ring_lock);
+	RCU_INIT_POINTER(ring->priv->csi_ring, NULL);
+	mutex_unlock(&csi_ring_lock);
+	/* Wait for woal_csi_ring_push on other CPUs. When the interface is
+	 * removed while the ring is still mapped, the mapping holds its
+	 * own reference on the pages, so vfree does not pull them away. */
+	synchronize_rcu();
+	vfree(ring->hdr);
+	kfree(ring);
+	MODULE_PUT;
+	return 0;
+}
+
+/**
+ *  @brief csi proc mmap function
+ *
+ *  @param file     file pointer
+ *  @param vma      pointer to vm_area_struct
+ *
+ *  @return         0 or negative error code
+ */
+static int woal_csi_proc_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	moal_csi_ring *ring = file->private_data;
+
+	if (vma->vm_pgoff ||
+	    vma->vm_end - vma->vm_start > PAGE_ALIGN(MOAL_CSI_RING_LEN))
+		return -EINVAL;
+	return remap_vmalloc_range(vma, ring->hdr, 0);
+}
+
+/**
+ *  @brief csi proc poll function, readable while records are pending
+ *
+ *  @param file     file pointer
+ *  @param wait     poll table
+ *
+ *  @return         poll mask
+ */
+static woal_poll_t woal_csi_proc_poll(struct file *file,
+				      struct poll_table_struct *wait)
+{
+	moal_csi_ring *ring = file->private_data;
+
+	poll_wait(file, &ring->wq, wait);
+	if (READ_ONCE(ring->hdr->head) != READ_ONCE(ring->hdr->tail))
+		return POLLIN | POLLRDNORM;
+	return 0;
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0)
+static const struct proc_ops csi_proc_fops = {
+	.proc_open = woal_csi_proc_open,
+	.proc_release = woal_csi_proc_release,
+	.proc_mmap = woal_csi_proc_mmap,
+	.proc_poll = woal_csi_proc_poll,
+};
+#else
+static const struct file_operations csi_proc_fops = {
+	.owner = THIS_MODULE,
+	.open = woal_csi_proc_open,
+	.release = woal_csi_proc_release,
+	.mmap = woal_csi_proc_mmap,
+	.poll = woal_csi_proc_poll,
+};
+#endif
+
+/********************************************************
+		Global Functions
+********************************************************/
+/**
+ *  @brief Copy one CSI record to the ring of the interface. Records are
+ *         dropped and counted in overruns while the ring is full.
+ *
+ *  @param priv     A pointer to moal_private
+ *  @param data     CSI record
+ *  @param len      Length of the CSI record
+ *
+ *  @return         MTRUE if a reader has the ring open, MFALSE otherwise
+ */
+t_u8 woal_csi_ring_push(moal_private *priv, t_u8 *data, t_u32 len)
+{
+	moal_csi_ring *ring;
+	moal_csi_ring_hdr *hdr;
+	moal_csi_slot *slot;
+	t_u32 head, tail;
+	t_u64 ns = 0;
+	t_u8 ret = MFALSE;
+
+	rcu_read_lock();
+	ring = rcu_dereference(priv->csi_ring);
+	if (!ring)
+		goto done;
+	ret = MTRUE;
+	hdr = ring->hdr;
+	head = hdr->head;
+	tail = READ_ONCE(hdr->tail);
+	/* Do not write the slot before the reader is done with it */
+	smp_mb();
+	if (head - tail >= MOAL_CSI_RING_SLOTS) {
+		WRITE_ONCE(hdr->overruns, hdr->overruns + 1);
+		goto done;
+	}
+	slot = (moal_csi_slot *)((t_u8 *)hdr + MOAL_CSI_RING_HDR_LEN +
+				 (head & (MOAL_CSI_RING_SLOTS - 1)) *
+					 MOAL_CSI_SLOT_SIZE);
+	len = MIN(len, MOAL_CSI_SLOT_SIZE - sizeof(moal_csi_slot));
+	moal_get_boot_ktime(priv->phandle, &ns);
+	slot->csi_seq = priv->csi_seq;
+	slot->len = len;
+	slot->timestamp = ns;
+	moal_memcpy_ext(priv->phandle, slot->data, data, len, len);
+	/* Publish the slot before the head that covers it */
+	smp_wmb();
+	WRITE_ONCE(hdr->head, head + 1);
+	wake_up_interruptible(&ring->wq);
+done:
+	rcu_read_unlock();
+	return ret;
+}
+
+/**
+ *  @brief Create the csi proc entry of an interface
+ *
+ *  @param priv     A pointer to moal_private
+ *
+ *  @return         N/A
+ */
+void woal_csi_proc_create(moal_private *priv)
+{
+	if (!proc_create_data(CSI_PROC, 0600, priv->proc_entry, &csi_proc_fops,
+			      priv))
+		PRINTM(MMSG, "Fail to create proc csi\n");
+}
+
+/**
+ *  @brief Remove the csi proc entry of an interface. An open csi file
+ *         is released before this returns.
+ *
+ *  @param priv     A pointer to moal_private
+ *
+ *  @return         N/A
+ */
+void woal_csi_proc_remove(moal_private *priv)
+{
+	remove_proc_entry(CSI_PROC, priv->proc_entry);
+}
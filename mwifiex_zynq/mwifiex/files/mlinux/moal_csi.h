@@ -0,0 +1,102 @@
+/** @file moal_csi.h
+ *
+ * @brief This file contains the layout of the CSI ring mapped from
+ * /proc/mwlan/adapterX/<interface>/csi
+ *
+ *
+ * Copyright 2026 NXP
+ *
+ * This software file (the File) is distributed by NXP
+ * under the terms of the GNU General Public License Version 2, June 1991
+ * (the License).  You may use, redistribute and/or modify the File in
+ * accordance with the terms and conditions of the License, a copy of which
+ * is available by writing to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA or on the
+ * worldwide web at http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ * THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE
+ * ARE EXPRESSLY DISCLAIMED.  The License provides additional details about
+ * this warranty disclaimer.
+ *
+ */
+
+/********************************************************
+Change log:
+    10/18/2026: initial version
+********************************************************/
+
+#ifndef _MOAL_CSI_H
+#define _MOAL_CSI_H
+
+/*
+ * One reader opens the csi file and maps MOAL_CSI_RING_LEN bytes of it.
+ * The mapping is a moal_csi_ring_hdr, padded to hdr_len, followed by
+ * num_slots slots of slot_size bytes. Each slot is a moal_csi_slot
+ * followed by the CSI record. All fields are host endian.
+ *
+ * The driver writes the slots and head, the reader writes tail. Record
+ * n is in slot n % num_slots. The reader waits for head != tail with
+ * poll(), reads head, handles the slots from tail to head and then
+ * stores the new tail with release semantics. When head - tail reaches
+ * num_slots the driver drops new records and counts them in overruns.
+ *
+ * While the file is open records go to the ring instead of the
+ * netlink CSI event. The ring is cleared on every open.
+ */
+
+/** Ring magic, "WCSI" */
+#define MOAL_CSI_RING_MAGIC 0x49534357
+/** Ring layout version */
+#define MOAL_CSI_RING_VERSION 1
+/** Offset of the first slot */
+#define MOAL_CSI_RING_HDR_LEN 4096
+/** Size of one slot */
+#define MOAL_CSI_SLOT_SIZE 4096
+/** Number of slots, power of 2 */
+#define MOAL_CSI_RING_SLOTS 128
+/** Length of the mapping */
+#define MOAL_CSI_RING_LEN                                                      \
+	(MOAL_CSI_RING_HDR_LEN + MOAL_CSI_RING_SLOTS * MOAL_CSI_SLOT_SIZE)
+
+/** Ring header, head and tail are in cache lines of their own */
+typedef MLAN_PACK_START struct _moal_csi_ring_hdr {
+	/** MOAL_CSI_RING_MAGIC */
+	t_u32 magic;
+	/** MOAL_CSI_RING_VERSION */
+	t_u16 version;
+	/** Reserved */
+	t_u16 rsvd;
+	/** Offset of the first slot */
+	t_u32 hdr_len;
+	/** Size of one slot */
+	t_u32 slot_size;
+	/** Number of slots */
+	t_u32 num_slots;
+	/** Records dropped because the ring was full */
+	t_u32 overruns;
+	/** Reserved */
+	t_u32 rsvd1[10];
+	/** Records written, written by the driver */
+	t_u32 head;
+	/** Reserved */
+	t_u32 rsvd2[15];
+	/** Records consumed, written by the reader */
+	t_u32 tail;
+} MLAN_PACK_END moal_csi_ring_hdr;
+
+/** Slot header */
+typedef MLAN_PACK_START struct _moal_csi_slot {
+	/** csi_seq of the record, as in the netlink CSI event */
+	t_u16 csi_seq;
+	/** Length of the record */
+	t_u16 len;
+	/** Reserved */
+	t_u32 rsvd;
+	/** Boot time the record was received in ns */
+	t_u64 timestamp;
+	/** CSI record */
+	t_u8 data[];
+} MLAN_PACK_END moal_csi_slot;
+
+#endif /* _MOAL_CSI_H */
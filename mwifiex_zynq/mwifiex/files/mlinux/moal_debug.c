@@ -61,6 +61,10 @@ Change log:
 #define item_card_addr(n) ((t_ptr) & (((struct usb_card_rec *)0)->n))
 #endif
 
+/** Command class names, in mlan cmd_class_e order */
+static const char *cmd_class_name[MLAN_CMD_CLASS_NUM] = {"ps", "data", "mgmt",
+							  "get"};
+
 #ifdef STA_SUPPORT
 static struct debug_data items[] = {
 #ifdef DEBUG_LEVEL1
@@ -335,6 +339,14 @@ static struct debug_data uap_items[] = {
 	 item_addr(num_bridge_pkts), INFO_ADDR},
 	{"num_drop_pkts", item_size(num_drop_pkts), item_addr(num_drop_pkts),
 	 INFO_ADDR},
+	{"num_bridge_zcopy", item_size(num_bridge_zcopy),
+	 item_addr(num_bridge_zcopy), INFO_ADDR},
+	{"num_bridge_copy", item_size(num_bridge_copy),
+	 item_addr(num_bridge_copy), INFO_ADDR},
+	{"bridge_fwd_lat_avg", item_size(bridge_fwd_lat_avg),
+	 item_addr(bridge_fwd_lat_avg), INFO_ADDR},
+	{"bridge_fwd_lat_max", item_size(bridge_fwd_lat_max),
+	 item_addr(bridge_fwd_lat_max), INFO_ADDR},
 	{"num_cmd_timeout", item_size(num_cmd_timeout),
 	 item_addr(num_cmd_timeout), INFO_ADDR},
 	{"timeout_cmd_id", item_size(timeout_cmd_id), item_addr(timeout_cmd_id),
@@ -467,29 +479,25 @@ static struct debug_data uap_items[] = {
 #endif /* UAP_SUPPORT */
 
 /**
- *  @brief This function reset histogram data
+ *  @brief This function clears the counters of one histogram copy
  *
  *  @param priv 		A pointer to moal_private
+ *  @param data 		A pointer to hgm_data
  *
  *  @return   N/A
  */
 void woal_hist_do_reset(moal_private *priv, void *data)
 {
 	hgm_data *phist_data = (hgm_data *)data;
-	int ix;
 	t_u16 rx_rate_max_size = priv->phandle->card_info->rx_rate_max;
 
 	if (!phist_data)
 		return;
-	atomic_set(&(phist_data->num_samples), 0);
-	for (ix = 0; ix < rx_rate_max_size; ix++)
-		atomic_set(&(phist_data->rx_rate[ix]), 0);
-	for (ix = 0; ix < SNR_MAX; ix++)
-		atomic_set(&(phist_data->snr[ix]), 0);
-	for (ix = 0; ix < NOISE_FLR_MAX; ix++)
-		atomic_set(&(phist_data->noise_flr[ix]), 0);
-	for (ix = 0; ix < SIG_STRENGTH_MAX; ix++)
-		atomic_set(&(phist_data->sig_str[ix]), 0);
+	phist_data->num_samples = 0;
+	memset(phist_data->rx_rate, 0, rx_rate_max_size * sizeof(t_u32));
+	memset(phist_data->snr, 0, sizeof(phist_data->snr));
+	memset(phist_data->noise_flr, 0, sizeof(phist_data->noise_flr));
+	memset(phist_data->sig_str, 0, sizeof(phist_data->sig_str));
 }
 
 /**
@@ -503,10 +511,12 @@ void woal_hist_data_reset(moal_private *priv)
 {
 	int i = 0;
 	for (i = 0; i < priv->phandle->card_info->histogram_table_num; i++)
-		woal_hist_do_reset(priv, priv->hist_data[i]);
+		woal_hist_reset_table(priv, i);
 }
 /**
- *  @brief This function reset histogram data according to antenna
+ *  @brief This function reset histogram data according to antenna.
+ *         Each CPU clears its copy on its next sample, reads skip
+ *         copies of an older generation.
  *
  *  @param priv                A pointer to moal_private
  *
@@ -514,9 +524,7 @@ void woal_hist_data_reset(moal_private *priv)
  */
 void woal_hist_reset_table(moal_private *priv, t_u8 antenna)
 {
-	hgm_data *phist_data = priv->hist_data[antenna];
-
-	woal_hist_do_reset(priv, phist_data);
+	atomic_inc(&priv->hist_gen[antenna]);
 }
 
 /** NF calculation */
@@ -528,25 +536,25 @@ void woal_hist_reset_table(moal_private *priv, t_u8 antenna)
  *  @brief This function set histogram data
  *
  *  @param priv 		A pointer to moal_private
+ *  @param phist_data   histogram copy of this CPU
  *  @param rx_rate      rx rate
  *  @param snr			snr
  *  @param nflr			NF
  *
  *  @return   N/A
  */
-static void woal_hist_data_set(moal_private *priv, t_u16 rx_rate, t_s8 snr,
-			       t_s8 nflr, t_u8 antenna)
+static void woal_hist_data_set(moal_private *priv, hgm_data *phist_data,
+			       t_u16 rx_rate, t_s8 snr, t_s8 nflr)
 {
-	hgm_data *phist_data = priv->hist_data[antenna];
 	t_s8 nf = CAL_NF(nflr);
 	t_s8 rssi = CAL_RSSI(snr, nflr);
 
-	atomic_inc(&(phist_data->num_samples));
+	phist_data->num_samples++;
 	if (rx_rate < priv->phandle->card_info->rx_rate_max)
-		atomic_inc(&(phist_data->rx_rate[rx_rate]));
-	atomic_inc(&(phist_data->snr[snr + 128]));
-	atomic_inc(&(phist_data->noise_flr[nf + 128]));
-	atomic_inc(&(phist_data->sig_str[rssi + 128]));
+		phist_data->rx_rate[rx_rate]++;
+	phist_data->snr[snr + 128]++;
+	phist_data->noise_flr[nf + 128]++;
+	phist_data->sig_str[rssi + 128]++;
 }
 
 /**
@@ -563,15 +571,63 @@ void woal_hist_data_add(moal_private *priv, t_u16 rx_rate, t_s8 snr, t_s8 nflr,
 			t_u8 antenna)
 {
 	hgm_data *phist_data = NULL;
-	unsigned long curr_size;
+	t_u32 gen;
 
 	if ((antenna + 1) > priv->phandle->card_info->histogram_table_num)
 		antenna = 0;
-	phist_data = priv->hist_data[antenna];
-	curr_size = atomic_read(&(phist_data->num_samples));
-	if (curr_size > HIST_MAX_SAMPLES)
+	/* Only this CPU writes its copy, no atomics needed */
+	phist_data = get_cpu_ptr(priv->hist_data[antenna]);
+	if (hist_sample > 1 && ++phist_data->skip < (t_u32)hist_sample)
+		goto done;
+	phist_data->skip = 0;
+	if (phist_data->num_samples > HIST_MAX_SAMPLES)
 		woal_hist_reset_table(priv, antenna);
-	woal_hist_data_set(priv, rx_rate, snr, nflr, antenna);
+	gen = atomic_read(&priv->hist_gen[antenna]);
+	if (phist_data->gen != gen) {
+		woal_hist_do_reset(priv, phist_data);
+		phist_data->gen = gen;
+	}
+	woal_hist_data_set(priv, phist_data, rx_rate, snr, nflr);
+done:
+	put_cpu_ptr(priv->hist_data[antenna]);
+}
+
+/**
+ *  @brief This function sums the histogram copies of all CPUs
+ *
+ *  @param priv 		A pointer to moal_private
+ *  @param antenna      antenna
+ *
+ *  @return   hgm_data to kfree, or NULL
+ */
+static hgm_data *woal_hist_data_sum(moal_private *priv, t_u8 antenna)
+{
+	t_u16 rx_rate_max_size = priv->phandle->card_info->rx_rate_max;
+	hgm_data *psum, *phist_data;
+	t_u32 gen;
+	int cpu, i;
+
+	psum = kzalloc(sizeof(hgm_data) + rx_rate_max_size * sizeof(t_u32),
+		       GFP_KERNEL);
+	if (!psum)
+		return NULL;
+	gen = atomic_read(&priv->hist_gen[antenna]);
+	for_each_possible_cpu (cpu) {
+		phist_data = per_cpu_ptr(priv->hist_data[antenna], cpu);
+		/* Not cleared since the last reset */
+		if (READ_ONCE(phist_data->gen) != gen)
+			continue;
+		psum->num_samples += phist_data->num_samples;
+		for (i = 0; i < rx_rate_max_size; i++)
+			psum->rx_rate[i] += phist_data->rx_rate[i];
+		for (i = 0; i < SNR_MAX; i++)
+			psum->snr[i] += phist_data->snr[i];
+		for (i = 0; i < NOISE_FLR_MAX; i++)
+			psum->noise_flr[i] += phist_data->noise_flr[i];
+		for (i = 0; i < SIG_STRENGTH_MAX; i++)
+			psum->sig_str[i] += phist_data->sig_str[i];
+	}
+	return psum;
 }
 #define MAX_MCS_NUM_SUPP 16
 #define MAX_MCS_NUM_AC 10
@@ -604,8 +660,9 @@ static int woal_histogram_info(struct seq_file *sfp, void *data)
 		return -EFAULT;
 	}
 
-	seq_printf(sfp, "total samples = %d \n",
-		   atomic_read(&(phist_data->num_samples)));
+	seq_printf(sfp, "total samples = %u \n", phist_data->num_samples);
+	if (hist_sample > 1)
+		seq_printf(sfp, "sampling 1 in %d rx packets\n", hist_sample);
 	seq_printf(sfp, "rx rates (in Mbps):\n");
 	seq_printf(sfp, "\t0-3:     B-MCS  0-3\n");
 	seq_printf(sfp, "\t4-11:    G-MCS  0-7\n");
@@ -662,7 +719,7 @@ static int woal_histogram_info(struct seq_file *sfp, void *data)
 		"\t388-399: AX-MCS 0-11(BW80:NSS1:GI2)    400-411: AX-MCS 0-11(BW80:NSS2:GI2)\n");
 
 	for (i = 0; i < rx_rate_max_size; i++) {
-		value = atomic_read(&(phist_data->rx_rate[i]));
+		value = phist_data->rx_rate[i];
 		if (value) {
 			if (i <= 11)
 				seq_printf(sfp, "rx_rate[%03d] = %d\n", i,
@@ -715,19 +772,19 @@ static int woal_histogram_info(struct seq_file *sfp, void *data)
 		}
 	}
 	for (i = 0; i < SNR_MAX; i++) {
-		value = atomic_read(&(phist_data->snr[i]));
+		value = phist_data->snr[i];
 		if (value)
 			seq_printf(sfp, "snr[%02ddB] = %d\n", (int)(i - 128),
 				   value);
 	}
 	for (i = 0; i < NOISE_FLR_MAX; i++) {
-		value = atomic_read(&(phist_data->noise_flr[i]));
+		value = phist_data->noise_flr[i];
 		if (value)
 			seq_printf(sfp, "noise_flr[%02ddBm] = %d\n",
 				   (int)(i - 128), value);
 	}
 	for (i = 0; i < SIG_STRENGTH_MAX; i++) {
-		value = atomic_read(&(phist_data->sig_str[i]));
+		value = phist_data->sig_str[i];
 		if (value)
 			seq_printf(sfp, "sig_strength[%02ddBm] = %d\n",
 				   (int)(i - 128), value);
@@ -750,6 +807,7 @@ static int woal_histogram_read(struct seq_file *sfp, void *data)
 {
 	wlan_hist_proc_data *hist_data = (wlan_hist_proc_data *)sfp->private;
 	moal_private *priv = (moal_private *)hist_data->priv;
+	hgm_data *psum;
 
 	ENTER();
 	if (!priv) {
@@ -757,8 +815,17 @@ static int woal_histogram_read(struct seq_file *sfp, void *data)
 		return -EFAULT;
 	}
 
-	if (hist_data->ant_idx < priv->phandle->card_info->histogram_table_num)
-		woal_histogram_info(sfp, priv->hist_data[hist_data->ant_idx]);
+	if (hist_data->ant_idx <
+		    priv->phandle->card_info->histogram_table_num &&
+	    priv->hist_data[hist_data->ant_idx]) {
+		psum = woal_hist_data_sum(priv, hist_data->ant_idx);
+		if (!psum) {
+			LEAVE();
+			return -ENOMEM;
+		}
+		woal_histogram_info(sfp, psum);
+		kfree(psum);
+	}
 
 	LEAVE();
 	return 0;
@@ -979,6 +1046,23 @@ static int woal_log_proc_open(struct inode *inode, struct file *file)
 /********************************************************
 		Local Functions
 ********************************************************/
+/**
+ *  @brief Print the statistics of a lookup table
+ *
+ *  @param sfp     pointer to seq_file structure
+ *  @param name    name of the table
+ *  @param table   pointer to woal_lru_table structure
+ *
+ *  @return        N/A
+ */
+static void woal_debug_lru_table(struct seq_file *sfp, const char *name,
+				 struct woal_lru_table *table)
+{
+	seq_printf(sfp, "%s: num=%u max=%u hit=%d miss=%d evicted=%u\n", name,
+		   table->num, table->max, atomic_read(&table->hit),
+		   atomic_read(&table->miss), table->evicted);
+}
+
 /**
  *  @brief Proc read function
  *
@@ -999,6 +1083,7 @@ static int woal_debug_read(struct seq_file *sfp, void *data)
 	mlan_debug_info *info = NULL;
 	t_u32 intf_mask = INTF_MASK << 8;
 	unsigned int j;
+	unsigned long flags;
 #ifdef SDIO
 	t_u8 mp_aggr_pkt_limit = 0;
 #endif
@@ -1104,10 +1189,56 @@ static int woal_debug_read(struct seq_file *sfp, void *data)
 		seq_printf(sfp, "txrx bd size:%d\n", info->txrx_bd_size);
 	}
 #endif
+	seq_printf(sfp, "cmd_pool_size=%u\n", info->cmd_pool_size);
+	for (i = 0; i < MLAN_CMD_CLASS_NUM; i++)
+		seq_printf(
+			sfp,
+			"cmd_class[%s]: queued=%u max_queued=%u dispatched=%u avg_wait_us=%u max_wait_us=%u\n",
+			cmd_class_name[i], info->cmd_class_queued[i],
+			info->cmd_class_max_queued[i],
+			info->cmd_class_dispatched[i],
+			info->cmd_class_avg_wait[i],
+			info->cmd_class_max_wait[i]);
+	for (i = 0; i < MOAL_EVENT_SLOT_NUM; i++) {
+		struct woal_event_stats *stats = &priv->phandle->evt_stats[i];
+
+		if (!stats->count)
+			continue;
+		seq_printf(sfp, "event[0x%x]: count=%u max_lat_us=%u lat_hist=",
+			   (i & 0x80) ? (0x80000000 | (i & 0x7f)) : i,
+			   stats->count, stats->max_lat);
+		for (j = 0; j < EVENT_LAT_HIST_NUM; j++)
+			seq_printf(sfp, "%u ", stats->lat_hist[j]);
+		seq_printf(sfp, "\n");
+	}
+	for (i = 0; i < priv->phandle->rx_shard_num; i++)
+		seq_printf(sfp, "rx_shard[%d]: cpu=%d rx_pkts=%u dropped=%u\n",
+			   i, priv->phandle->rx_shard[i].cpu,
+			   priv->phandle->rx_shard[i].rx_pkts,
+			   priv->phandle->rx_shard[i].rx_overflow);
 	seq_printf(sfp, "tcp_ack_drop_cnt=%d\n", priv->tcp_ack_drop_cnt);
 	seq_printf(sfp, "tcp_ack_cnt=%d\n", priv->tcp_ack_cnt);
 	seq_printf(sfp, "tcp_ack_payload=%d\n", priv->tcp_ack_payload);
 	seq_printf(sfp, "tcp_sess_cnt=%d\n", priv->tcp_sess_cnt);
+	spin_lock_irqsave(&priv->tcp_sess_lock, flags);
+	for (i = 0; priv->tcp_sess_pool && i < TCP_ACK_MAX_SESS; i++) {
+		struct tcp_sess *tcp_sess = &priv->tcp_sess_pool[i];
+
+		if (!hash_hashed(&tcp_sess->hnode) || !tcp_sess->coalesced)
+			continue;
+		seq_printf(sfp, "tcp_sess: %pI4:%u -> %pI4:%u coalesced=%u\n",
+			   &tcp_sess->src_ip_addr,
+			   ntohs((__force __be16)tcp_sess->src_tcp_port),
+			   &tcp_sess->dst_ip_addr,
+			   ntohs((__force __be16)tcp_sess->dst_tcp_port),
+			   tcp_sess->coalesced);
+	}
+	spin_unlock_irqrestore(&priv->tcp_sess_lock, flags);
+	woal_debug_lru_table(sfp, "mcast_table", &priv->mcast_table);
+#ifdef STA_CFG80211
+	woal_debug_lru_table(sfp, "dhcp_table", &priv->dhcp_table);
+	woal_debug_lru_table(sfp, "arp_table", &priv->arp_table);
+#endif
 #if LINUX_VERSION_CODE > KERNEL_VERSION(2, 6, 29)
 	for (i = 0; i < 4; i++)
 		seq_printf(sfp, "wmm_tx_pending[%d]:%d\n", i,
@@ -4229,18 +4229,15 @@ static int woal_priv_setgettcpackenh(moal_private *priv, t_u8 *respbuf,
 			ret = -EINVAL;
 			goto done;
 		}
-		if (data[0] > 1 || data[1] > TCP_ACK_MAX_HOLD) {
+		if (data[0] > TCP_ACK_ENH_WMM || data[1] > TCP_ACK_MAX_HOLD) {
 			PRINTM(MERROR, "Invalid argument\n");
 			ret = -EINVAL;
 			goto done;
 		}
-		if (data[0] == MTRUE) {
-			PRINTM(MINFO, "Enabling TCP Ack enhancement\n");
-			priv->enable_tcp_ack_enh = MTRUE;
-		} else if (data[0] == MFALSE) {
-			PRINTM(MINFO, "Disabling TCP Ack enhancement\n");
-			priv->enable_tcp_ack_enh = MFALSE;
-			/* release the tcp sessions if any */
+		if (data[0] != priv->enable_tcp_ack_enh) {
+			PRINTM(MINFO, "TCP Ack enhancement mode %d\n", data[0]);
+			priv->enable_tcp_ack_enh = data[0];
+			/* release the tcp sessions and held ACKs if any */
 			woal_flush_tcp_sess_queue(priv);
 		}
 		if (user_data_len >= 2) {
@@ -13539,13 +13536,13 @@ static int woal_priv_mcast_aggr_group_cfg(moal_private *priv, t_u8 *respbuf,
 	}
 	memset(mcast_cfg, 0, sizeof(mcast_aggr_group));
 
-	spin_lock_irqsave(&priv->mcast_lock, flags);
-	list_for_each_entry (node, &priv->mcast_list, link) {
+	spin_lock_irqsave(&priv->mcast_table.lock, flags);
+	list_for_each_entry (node, &priv->mcast_table.lru, lru.link) {
 		moal_memcpy_ext(priv->phandle, &mcast_cfg->mac_list[index],
 				node->mcast_addr, ETH_ALEN, ETH_ALEN);
 		index++;
 	}
-	spin_unlock_irqrestore(&priv->mcast_lock, flags);
+	spin_unlock_irqrestore(&priv->mcast_table.lock, flags);
 	mcast_cfg->num_mcast_addr = index;
 	priv->num_mcast_addr = index;
 	ret = header_len + sizeof(mcast_aggr_group);
@@ -20599,6 +20596,13 @@ void woal_tp_acnt_timer_func(void *context)
 	phandle->tp_acnt.tx_amsdu_pkt_cnt_last =
 		phandle->tp_acnt.tx_amsdu_pkt_cnt;
 
+	/* MLAN data path lock accounting */
+	if (!phandle->tp_acnt.lock_cycles_cb)
+		moal_tp_lock_calibrate(phandle);
+	phandle->tp_acnt.lock_ops_rate =
+		phandle->tp_acnt.lock_ops - phandle->tp_acnt.lock_ops_last;
+	phandle->tp_acnt.lock_ops_last = phandle->tp_acnt.lock_ops;
+
 	/* re-arm timer */
 	woal_mod_timer(&phandle->tp_acnt.timer, 1000);
 }
@@ -0,0 +1,446 @@
+/**  @file moal_fw_xz.c
+ *
+ * @brief This file contains the decompression of xz compressed firmware
+ * images. SDIO and USB read the image through moal_get_fw_data() while a
+ * thread decompresses the next blocks, so that decompression overlaps
+ * with the bus writes.
+ *
+ *
+ * Copyright 2026 NXP
+ *
+ * This software file (the File) is distributed by NXP
+ * under the terms of the GNU General Public License Version 2, June 1991
+ * (the License).  You may use, redistribute and/or modify the File in
+ * accordance with the terms and conditions of the License, a copy of which
+ * is available by writing to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA or on the
+ * worldwide web at http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ * THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE
+ * ARE EXPRESSLY DISCLAIMED.  The License provides additional details about
+ * this warranty disclaimer.
+ *
+ */
+
+/********************************************************
+Change log:
+    10/18/2026: initial version
+********************************************************/
+
+#include <linux/xz.h>
+#include "moal_main.h"
+
+/********************************************************
+		Local Variables
+********************************************************/
+/** Size of the decompressed data ring, power of 2 */
+#define MOAL_FW_XZ_RING (64 * 1024)
+/** Most data decompressed in one step */
+#define MOAL_FW_XZ_CHUNK 4096
+/** Largest LZMA2 dictionary accepted */
+#define MOAL_FW_XZ_DICT_MAX (8 * 1024 * 1024)
+/** Size of the xz stream header and footer */
+#define MOAL_FW_XZ_HDR_LEN 12
+
+/** xz stream header magic */
+static const t_u8 fw_xz_magic[6] = {0xfd, '7', 'z', 'X', 'Z', 0x00};
+
+/** Decompression of one firmware image */
+struct _moal_fw_xz {
+	/** Compressed image */
+	const struct firmware *src;
+	/** Decompressor */
+	struct xz_dec *dec;
+	/** Decompressor input and output */
+	struct xz_buf buf;
+	/** Decompressed data ring, written by thread */
+	t_u8 *ring;
+	/** Bytes written to ring */
+	t_u32 head;
+	/** Bytes read from ring */
+	t_u32 tail;
+	/** Decompression finished, status is valid */
+	t_u8 done;
+	/** Last decompressor status */
+	enum xz_ret status;
+	/** Decompression thread, NULL when not streaming */
+	struct task_struct *thread;
+	/** Wakes the thread on free space and the reader on new data */
+	wait_queue_head_t wq;
+	/** Fully decompressed image for PCIe */
+	t_u8 *image;
+};
+
+/********************************************************
+		Local Functions
+********************************************************/
+/**
+ * @brief Read one xz multibyte integer
+ *
+ * @param buf       A pointer to the data
+ * @param end       End of the data
+ * @param val       A pointer to the value
+ *
+ * @return          Bytes read or 0 if invalid
+ */
+static t_u32 woal_fw_xz_get_num(const t_u8 *buf, const t_u8 *end, t_u64 *val)
+{
+	t_u32 i;
+
+	*val = 0;
+	for (i = 0; i < 9 && buf + i < end; i++) {
+		*val |= (t_u64)(buf[i] & 0x7f) << (i * 7);
+		if (!(buf[i] & 0x80))
+			return i + 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Decompression thread, keeps the ring full until the image
+ *        ends or the thread is stopped
+ *
+ * @param data      A pointer to moal_fw_xz
+ *
+ * @return          0
+ */
+static int woal_fw_xz_thread(void *data)
+{
+	moal_fw_xz *xz = data;
+	t_u32 pos, space;
+	enum xz_ret ret;
+
+	while (!kthread_should_stop()) {
+		wait_event_interruptible(
+			xz->wq,
+			kthread_should_stop() ||
+				(!xz->done && xz->head - READ_ONCE(xz->tail) <
+						      MOAL_FW_XZ_RING));
+		if (kthread_should_stop())
+			break;
+		if (xz->done)
+			continue;
+		pos = xz->head & (MOAL_FW_XZ_RING - 1);
+		space = MOAL_FW_XZ_RING - (xz->head - READ_ONCE(xz->tail));
+		space = MIN(space, MOAL_FW_XZ_RING - pos);
+		xz->buf.out = xz->ring + pos;
+		xz->buf.out_pos = 0;
+		xz->buf.out_size = MIN(space, MOAL_FW_XZ_CHUNK);
+		ret = xz_dec_run(xz->dec, &xz->buf);
+		/* Publish the data before head, and head before done */
+		smp_wmb();
+		WRITE_ONCE(xz->head, xz->head + xz->buf.out_pos);
+		if (ret != XZ_OK) {
+			xz->status = ret;
+			smp_wmb();
+			WRITE_ONCE(xz->done, MTRUE);
+		}
+		wake_up(&xz->wq);
+	}
+	return 0;
+}
+
+/**
+ * @brief Start decompressing from the beginning of the image
+ *
+ * @param xz        A pointer to moal_fw_xz
+ *
+ * @return          MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status woal_fw_xz_run(moal_fw_xz *xz)
+{
+	xz_dec_reset(xz->dec);
+	xz->buf.in = xz->src->data;
+	xz->buf.in_pos = 0;
+	xz->buf.in_size = xz->src->size;
+	xz->head = 0;
+	xz->tail = 0;
+	xz->done = MFALSE;
+	xz->status = XZ_OK;
+	xz->thread = kthread_run(woal_fw_xz_thread, xz, "woal_fw_xz");
+	if (IS_ERR(xz->thread)) {
+		xz->thread = NULL;
+		return MLAN_STATUS_FAILURE;
+	}
+	return MLAN_STATUS_SUCCESS;
+}
+
+/********************************************************
+		Global Functions
+********************************************************/
+/**
+ * @brief Check for an xz compressed firmware image
+ *
+ * @param fw        A pointer to the image
+ *
+ * @return          MTRUE or MFALSE
+ */
+t_u8 woal_fw_is_xz(const struct firmware *fw)
+{
+	return fw && fw->size > 2 * MOAL_FW_XZ_HDR_LEN &&
+	       !memcmp(fw->data, fw_xz_magic, sizeof(fw_xz_magic));
+}
+
+/**
+ * @brief Get the decompressed length of an xz image from its index.
+ *        Only single stream images are supported.
+ *
+ * @param fw        A pointer to the image
+ *
+ * @return          Decompressed length or 0 if the image is invalid
+ */
+t_u32 woal_fw_xz_len(const struct firmware *fw)
+{
+	const t_u8 *start = fw->data;
+	const t_u8 *end = fw->data + fw->size;
+	const t_u8 *p;
+	t_u64 records, unpadded, size, backward, total = 0;
+	t_u32 n;
+
+	/* Skip stream padding */
+	while (end - start > 2 * MOAL_FW_XZ_HDR_LEN + 4 && !end[-1] &&
+	       !end[-2] && !end[-3] && !end[-4])
+		end -= 4;
+	if (end[-2] != 'Y' || end[-1] != 'Z')
+		return 0;
+	/* Backward size in the footer is the index size / 4 - 1 */
+	backward = ((t_u64)(end[-8] | end[-7] << 8 | end[-6] << 16 |
+			    (t_u32)end[-5] << 24) +
+		    1) *
+		   4;
+	if (backward > end - start - 2 * MOAL_FW_XZ_HDR_LEN)
+		return 0;
+	p = end - MOAL_FW_XZ_HDR_LEN - backward;
+	end = p + backward;
+	/* Index indicator, number of records, then pairs of unpadded and
+	 * uncompressed size */
+	if (*p++)
+		return 0;
+	n = woal_fw_xz_get_num(p, end, &records);
+	if (!n)
+		return 0;
+	p += n;
+	while (records--) {
+		n = woal_fw_xz_get_num(p, end, &unpadded);
+		if (!n)
+			return 0;
+		p += n;
+		n = woal_fw_xz_get_num(p, end, &size);
+		if (!n)
+			return 0;
+		p += n;
+		total += size;
+		if (total > 0xffffffff)
+			return 0;
+	}
+	return (t_u32)total;
+}
+
+/**
+ * @brief Decompress part of an xz image in one go
+ *
+ * @param fw        A pointer to the compressed image
+ * @param offset    Offset in the decompressed image
+ * @param len       Bytes to copy
+ * @param pbuf      Destination
+ *
+ * @return          MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+mlan_status woal_fw_xz_copy(const struct firmware *fw, t_u32 offset,
+			    t_u32 len, t_u8 *pbuf)
+{
+	struct xz_dec *dec;
+	struct xz_buf buf;
+	t_u8 *chunk;
+	t_u32 pos = 0, n;
+	enum xz_ret ret = XZ_OK;
+
+	chunk = kmalloc(MOAL_FW_XZ_CHUNK, GFP_KERNEL);
+	if (!chunk)
+		return MLAN_STATUS_FAILURE;
+	dec = xz_dec_init(XZ_DYNALLOC, MOAL_FW_XZ_DICT_MAX);
+	if (!dec) {
+		kfree(chunk);
+		return MLAN_STATUS_FAILURE;
+	}
+	buf.in = fw->data;
+	buf.in_pos = 0;
+	buf.in_size = fw->size;
+	while (len && ret == XZ_OK) {
+		/* Decompress straight into pbuf once offset is reached */
+		if (pos >= offset) {
+			buf.out = pbuf;
+			buf.out_size = len;
+		} else {
+			buf.out = chunk;
+			buf.out_size = MIN(offset - pos, MOAL_FW_XZ_CHUNK);
+		}
+		buf.out_pos = 0;
+		ret = xz_dec_run(dec, &buf);
+		n = buf.out_pos;
+		if (pos >= offset) {
+			pbuf += n;
+			len -= n;
+		}
+		pos += n;
+	}
+	xz_dec_end(dec);
+	kfree(chunk);
+	if (len) {
+		PRINTM(MERROR, "fw xz: decompress failed at %u, ret=%d\n", pos,
+		       ret);
+		return MLAN_STATUS_FAILURE;
+	}
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ * @brief Prepare the download of an xz image. SDIO and USB stream the
+ *        image through moal_get_fw_data(), PCIe gets it decompressed
+ *        in one buffer.
+ *
+ * @param handle    A pointer to moal_handle structure
+ * @param pfw       A pointer to the image passed to mlan_dnld_fw()
+ *
+ * @return          MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+mlan_status woal_fw_xz_start(moal_handle *handle, mlan_fw_image *pfw)
+{
+	moal_fw_xz *xz;
+	t_u32 len = woal_fw_xz_len(handle->firmware);
+
+	ENTER();
+	if (!len) {
+		PRINTM(MERROR, "fw xz: invalid image %s\n",
+		       handle->drv_mode.fw_name);
+		LEAVE();
+		return MLAN_STATUS_FAILURE;
+	}
+	xz = kzalloc(sizeof(*xz), GFP_KERNEL);
+	if (!xz) {
+		LEAVE();
+		return MLAN_STATUS_FAILURE;
+	}
+	xz->src = handle->firmware;
+	init_waitqueue_head(&xz->wq);
+	handle->fw_xz = xz;
+	pfw->fw_len = len;
+
+#ifdef PCIE
+	if (IS_PCIE(handle->card_type)) {
+		/* The PCIe download maps the whole image */
+		xz->image = vmalloc(len);
+		if (!xz->image ||
+		    woal_fw_xz_copy(handle->firmware, 0, len, xz->image))
+			goto fail;
+		pfw->pfw_buf = xz->image;
+		LEAVE();
+		return MLAN_STATUS_SUCCESS;
+	}
+#endif
+	xz->ring = vmalloc(MOAL_FW_XZ_RING);
+	if (!xz->ring)
+		goto fail;
+	xz->dec = xz_dec_init(XZ_DYNALLOC, MOAL_FW_XZ_DICT_MAX);
+	if (!xz->dec || woal_fw_xz_run(xz))
+		goto fail;
+	pfw->pfw_buf = NULL;
+	PRINTM(MMSG, "fw xz: streaming %s, %u -> %u bytes\n",
+	       handle->drv_mode.fw_name, (t_u32)handle->firmware->size, len);
+	LEAVE();
+	return MLAN_STATUS_SUCCESS;
+fail:
+	woal_fw_xz_stop(handle);
+	LEAVE();
+	return MLAN_STATUS_FAILURE;
+}
+
+/**
+ * @brief Stop decompressing and free what woal_fw_xz_start() allocated
+ *
+ * @param handle    A pointer to moal_handle structure
+ *
+ * @return          N/A
+ */
+void woal_fw_xz_stop(moal_handle *handle)
+{
+	moal_fw_xz *xz = handle->fw_xz;
+
+	if (!xz)
+		return;
+	handle->fw_xz = NULL;
+	if (xz->thread)
+		kthread_stop(xz->thread);
+	if (xz->dec)
+		xz_dec_end(xz->dec);
+	if (xz->ring)
+		vfree(xz->ring);
+	if (xz->image)
+		vfree(xz->image);
+	kfree(xz);
+}
+
+/**
+ * @brief Read decompressed data for the download. Reads are expected in
+ *        order; a read before the current position restarts the
+ *        decompression, as after a MIC error.
+ *
+ * @param handle    A pointer to moal_handle structure
+ * @param offset    Offset in the decompressed image
+ * @param len       Bytes to read
+ * @param pbuf      Destination
+ *
+ * @return          MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+mlan_status woal_fw_xz_read(moal_handle *handle, t_u32 offset, t_u32 len,
+			    t_u8 *pbuf)
+{
+	moal_fw_xz *xz = handle->fw_xz;
+	t_u32 avail, pos, n;
+	t_u8 done;
+
+	if (!xz->thread)
+		return MLAN_STATUS_FAILURE;
+	if (offset < xz->tail) {
+		PRINTM(MINFO, "fw xz: restart for offset %u\n", offset);
+		kthread_stop(xz->thread);
+		xz->thread = NULL;
+		if (woal_fw_xz_run(xz))
+			return MLAN_STATUS_FAILURE;
+	}
+	while (len) {
+		wait_event(xz->wq, READ_ONCE(xz->head) != xz->tail ||
+					   READ_ONCE(xz->done));
+		done = READ_ONCE(xz->done);
+		smp_rmb();
+		avail = READ_ONCE(xz->head) - xz->tail;
+		if (!avail) {
+			if (done) {
+				PRINTM(MERROR,
+				       "fw xz: no data at %u, ret=%d\n",
+				       offset, xz->status);
+				return MLAN_STATUS_FAILURE;
+			}
+			continue;
+		}
+		smp_rmb();
+		pos = xz->tail & (MOAL_FW_XZ_RING - 1);
+		n = MIN(avail, MOAL_FW_XZ_RING - pos);
+		if (offset > xz->tail) {
+			/* Skip data that is not asked for */
+			n = MIN(n, offset - xz->tail);
+		} else {
+			n = MIN(n, len);
+			memcpy(pbuf, xz->ring + pos, n);
+			pbuf += n;
+			len -= n;
+			offset += n;
+		}
+		/* Hand the space back only after the copy */
+		smp_mb();
+		WRITE_ONCE(xz->tail, xz->tail + n);
+		wake_up(&xz->wq);
+	}
+	return MLAN_STATUS_SUCCESS;
+}
@@ -29,6 +29,8 @@ extern pmoal_handle m_handle[];
 static char *fw_name;
 static int req_fw_nowait;
 int fw_reload;
+/** Firmware image cache limit in KB */
+int fw_cache_max;
 #ifdef PCIE
 int auto_fw_reload = AUTO_FW_RELOAD_ENABLE | AUTO_FW_RELOAD_PCIE_INBAND_RESET;
 #else
@@ -90,6 +92,12 @@ static int auto_ds;
 static int net_rx = 1;
 /** amsdu deaggr mode */
 static int amsdu_deaggr = 1;
+/** zero-copy amsdu deaggregation in mlan */
+static int rx_amsdu_zcopy;
+/** forward intra-BSS uAP packets from the rx buffer */
+static int uap_fwd_zcopy;
+/** CoDel queue management on tx RA lists */
+static int tx_aqm;
 
 static int tx_budget = 2600;
 static int mclient_scheduling = 1;
@@ -108,6 +116,8 @@ static int scan_chan_gap;
 static int sched_scan = 1;
 /** Max Tx buffer size */
 int max_tx_buf;
+/** Rx histograms sample 1 in hist_sample packets */
+int hist_sample = 1;
 
 #ifdef STA_SUPPORT
 /** Max STA interfaces */
@@ -243,6 +253,8 @@ static int wq_sched_prio;
 static int wq_sched_policy = SCHED_NORMAL;
 /** rx_work flag */
 static int rx_work;
+/** number of rx late stage shards */
+static int rx_shard;
 
 #if defined(USB)
 int skip_fwdnld;
@@ -885,6 +897,28 @@ static mlan_status parse_cfg_read_block(t_u8 *data, t_u32 size,
 			params->amsdu_deaggr = out_data;
 			PRINTM(MMSG, "amsdu_deaggr = %d\n",
 			       params->amsdu_deaggr);
+		} else if (strncmp(line, "rx_amsdu_zcopy",
+				   strlen("rx_amsdu_zcopy")) == 0) {
+			if (parse_line_read_int(line, &out_data) !=
+			    MLAN_STATUS_SUCCESS)
+				goto err;
+			params->rx_amsdu_zcopy = out_data;
+			PRINTM(MMSG, "rx_amsdu_zcopy = %d\n",
+			       params->rx_amsdu_zcopy);
+		} else if (strncmp(line, "uap_fwd_zcopy",
+				   strlen("uap_fwd_zcopy")) == 0) {
+			if (parse_line_read_int(line, &out_data) !=
+			    MLAN_STATUS_SUCCESS)
+				goto err;
+			params->uap_fwd_zcopy = out_data;
+			PRINTM(MMSG, "uap_fwd_zcopy = %d\n",
+			       params->uap_fwd_zcopy);
+		} else if (strncmp(line, "tx_aqm", strlen("tx_aqm")) == 0) {
+			if (parse_line_read_int(line, &out_data) !=
+			    MLAN_STATUS_SUCCESS)
+				goto err;
+			params->tx_aqm = out_data;
+			PRINTM(MMSG, "tx_aqm = %d\n", params->tx_aqm);
 		} else if (strncmp(line, "tx_budget", strlen("tx_budget")) ==
 			   0) {
 			if (parse_line_read_int(line, &out_data) !=
@@ -1113,6 +1147,12 @@ static mlan_status parse_cfg_read_block(t_u8 *data, t_u32 size,
 				goto err;
 			params->rx_work = out_data;
 			PRINTM(MMSG, "rx_work=0x%x\n", params->rx_work);
+		} else if (strncmp(line, "rx_shard", strlen("rx_shard")) == 0) {
+			if (parse_line_read_int(line, &out_data) !=
+			    MLAN_STATUS_SUCCESS)
+				goto err;
+			params->rx_shard = out_data;
+			PRINTM(MMSG, "rx_shard=%d\n", params->rx_shard);
 		} else if (strncmp(line, "aggrctrl", strlen("aggrctrl")) == 0) {
 			if (parse_line_read_int(line, &out_data) !=
 			    MLAN_STATUS_SUCCESS)
@@ -1797,6 +1837,13 @@ static void woal_setup_module_param(moal_handle *handle, moal_mod_para *params)
 	if (params)
 		handle->params.amsdu_deaggr = params->amsdu_deaggr;
 
+	handle->params.rx_amsdu_zcopy = rx_amsdu_zcopy;
+	if (params)
+		handle->params.rx_amsdu_zcopy = params->rx_amsdu_zcopy;
+	handle->params.uap_fwd_zcopy =
+		params ? params->uap_fwd_zcopy : uap_fwd_zcopy;
+	handle->params.tx_aqm = params ? params->tx_aqm : tx_aqm;
+
 	handle->params.tx_budget = params ? params->tx_budget : tx_budget;
 	handle->params.mclient_scheduling =
 		params ? params->mclient_scheduling : mclient_scheduling;
@@ -1889,10 +1936,12 @@ static void woal_setup_module_param(moal_handle *handle, moal_mod_para *params)
 	handle->params.wq_sched_prio = wq_sched_prio;
 	handle->params.wq_sched_policy = wq_sched_policy;
 	handle->params.rx_work = rx_work;
+	handle->params.rx_shard = rx_shard;
 	if (params) {
 		handle->params.wq_sched_prio = params->wq_sched_prio;
 		handle->params.wq_sched_policy = params->wq_sched_policy;
 		handle->params.rx_work = params->rx_work;
+		handle->params.rx_shard = params->rx_shard;
 	}
 	if (aggrctrl)
 		moal_extflg_set(handle, EXT_AGGR_CTRL);
@@ -2878,6 +2927,10 @@ MODULE_PARM_DESC(
 module_param(fw_reload, int, 0);
 MODULE_PARM_DESC(fw_reload,
 		 "0: disable fw_reload; 1: enable fw reload feature");
+module_param(fw_cache_max, int, 0);
+MODULE_PARM_DESC(
+	fw_cache_max,
+	"0: disable firmware image cache (default); >0: KB of firmware images kept in memory for fw reload and VDLL");
 module_param(auto_fw_reload, int, 0);
 #ifdef PCIE
 MODULE_PARM_DESC(
@@ -2966,6 +3019,10 @@ MODULE_PARM_DESC(sched_scan,
 		 "0: disable sched_scan; 1: enable sched_scan default");
 module_param(max_tx_buf, int, 0);
 MODULE_PARM_DESC(max_tx_buf, "Maximum Tx buffer size (2048/4096/8192)");
+module_param(hist_sample, int, 0660);
+MODULE_PARM_DESC(
+	hist_sample,
+	"N: add 1 in N Rx packets to the Rx histograms, per CPU (default 1)");
 
 #if defined(SDIO)
 module_param(intmode, int, 0);
@@ -3058,6 +3115,10 @@ module_param(rx_work, int, 0);
 MODULE_PARM_DESC(
 	rx_work,
 	"0: default; 1: Enable rx_work_queue; 2: Disable rx_work_queue");
+module_param(rx_shard, int, 0);
+MODULE_PARM_DESC(
+	rx_shard,
+	"0: Disable; N: Run rx AMSDU deaggregation/delivery on N per-CPU workers (max 8)");
 module_param(aggrctrl, int, 0);
 MODULE_PARM_DESC(aggrctrl,
 		 "1: Enable Tx aggregation; 0: Disable Tx aggregation");
@@ -3091,6 +3152,19 @@ module_param(amsdu_deaggr, int, 0);
 MODULE_PARM_DESC(
 	amsdu_deaggr,
 	"0: buf copy in amsud deaggregation; 1: avoid buf copy in amsud deaggregation (default)");
+module_param(rx_amsdu_zcopy, int, 0);
+MODULE_PARM_DESC(
+	rx_amsdu_zcopy,
+	"0: copy subframes when mlan deaggregates amsdu (default); 1: subframes share the amsdu buffer");
+module_param(uap_fwd_zcopy, int, 0);
+MODULE_PARM_DESC(
+	uap_fwd_zcopy,
+	"0: copy intra-BSS multicast and amsdu subframes forwarded by uAP (default); 1: forward them from the rx buffer");
+
+module_param(tx_aqm, int, 0);
+MODULE_PARM_DESC(
+	tx_aqm,
+	"0: no queue management on tx RA lists (default); 1: CoDel drop/ECN mark and per-station queue limit");
 
 module_param(tx_budget, int, 0);
 MODULE_PARM_DESC(
@@ -3098,8 +3172,9 @@ MODULE_PARM_DESC(
 	"airtime tx budget for multi-client scheduling in usec, 0 - disable, default - 2600");
 
 module_param(mclient_scheduling, int, 0);
-MODULE_PARM_DESC(mclient_scheduling,
-		 "0: disable multi-client scheduling; 1 - enable(default)");
+MODULE_PARM_DESC(
+	mclient_scheduling,
+	"0: disable multi-client scheduling; 1 - enable with byte budget(default); 2 - enable with airtime deficit");
 
 #ifdef SDIO
 module_param(sdio_rx_aggr, int, 0);
@@ -2318,6 +2318,13 @@ mlan_status woal_get_debug_info(moal_private *priv, t_u8 wait_option,
 	info->sub_command = MLAN_OID_GET_DEBUG_INFO;
 	req->req_id = MLAN_IOCTL_GET_INFO;
 	req->action = MLAN_ACT_GET;
+	/* Station counters only go to a buffer the caller passes in */
+	if (debug_info && debug_info->psta_stats_list) {
+		info->param.debug_info.psta_stats_list =
+			debug_info->psta_stats_list;
+		info->param.debug_info.sta_stats_max =
+			debug_info->sta_stats_max;
+	}
 
 	/* Send IOCTL request to MLAN */
 	status = woal_request_ioctl(priv, req, wait_option);
@@ -4497,6 +4504,10 @@ int woal_set_drvdbg(moal_private *priv, t_u32 drv_dbg)
 	misc->param.drvdbg = drv_dbg;
 
 	ret = woal_request_ioctl(priv, req, MOAL_IOCTL_WAIT);
+#ifdef MLAN_TRACE
+	if (ret == MLAN_STATUS_SUCCESS)
+		mlan_trace_set_mask(drv_dbg);
+#endif
 
 	if (ret != MLAN_STATUS_PENDING)
 		kfree(req);
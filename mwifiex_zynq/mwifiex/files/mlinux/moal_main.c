@@ -101,6 +101,12 @@ static int reg_work;
 /********************************************************
 		Local Variables
 ********************************************************/
+/** Cached firmware images, most recently used first */
+static LIST_HEAD(fw_cache_list);
+/** Bytes held by fw_cache_list */
+static t_u32 fw_cache_size;
+/** Protects fw_cache_list and fw_cache_size */
+static DEFINE_MUTEX(fw_cache_lock);
 
 #ifdef SD8801
 static struct _card_info card_info_SD8801 = {
@@ -1064,6 +1070,10 @@ static mlan_callbacks woal_callbacks = {
 	.moal_free_lock = moal_free_lock,
 	.moal_spin_lock = moal_spin_lock,
 	.moal_spin_unlock = moal_spin_unlock,
+	.moal_atomic_add = moal_atomic_add,
+	.moal_atomic_sub = moal_atomic_sub,
+	.moal_atomic_read = moal_atomic_read,
+	.moal_atomic_cmpxchg = moal_atomic_cmpxchg,
 	.moal_print = moal_print,
 	.moal_print_netintf = moal_print_netintf,
 	.moal_assert = moal_assert,
@@ -1074,6 +1084,8 @@ static mlan_callbacks woal_callbacks = {
 	.moal_tp_accounting = moal_tp_accounting,
 	.moal_tp_accounting_rx_param = moal_tp_accounting_rx_param,
 	.moal_amsdu_tp_accounting = moal_amsdu_tp_accounting,
+	.moal_rx_late_queue = moal_rx_late_queue,
+	.moal_buf_writable = moal_buf_writable,
 };
 
 int woal_open(struct net_device *dev);
@@ -2654,6 +2666,7 @@ mlan_status woal_init_sw(moal_handle *handle)
 #endif
 #if defined(STA_CFG80211) && defined(UAP_CFG80211)
 	handle->mon_if = NULL;
+	skb_queue_head_init(&handle->mon_rx_q);
 #endif
 
 #ifdef REASSOCIATION
@@ -2726,6 +2739,9 @@ mlan_status woal_init_sw(moal_handle *handle)
 #endif
 #ifdef DEBUG_LEVEL1
 	device.drvdbg = drvdbg;
+#ifdef MLAN_TRACE
+	mlan_trace_set_mask(drvdbg);
+#endif
 #endif
 	device.fixed_beacon_buffer =
 		(t_u32)moal_extflg_isset(handle, EXT_FIX_BCN_BUF);
@@ -2839,11 +2855,22 @@ mlan_status woal_init_sw(moal_handle *handle)
 					MAX_TX_PENDING;
 	device.tx_budget = handle->params.tx_budget;
 	device.mclient_scheduling = handle->params.mclient_scheduling;
+	device.tx_aqm = handle->params.tx_aqm;
+	device.uap_fwd_zcopy = handle->params.uap_fwd_zcopy ? MTRUE : MFALSE;
 
 	moal_memcpy_ext(handle, &device.callbacks, &woal_callbacks,
 			sizeof(mlan_callbacks), sizeof(mlan_callbacks));
 	if (!handle->params.amsdu_deaggr)
 		device.callbacks.moal_recv_amsdu_packet = NULL;
+	if (handle->params.rx_shard <= 0)
+		device.callbacks.moal_rx_late_queue = NULL;
+	if (handle->params.rx_amsdu_zcopy) {
+#ifdef CONFIG_HAVE_EFFICIENT_UNALIGNED_ACCESS
+		device.rx_amsdu_zcopy = RX_AMSDU_ZCOPY_UNALIGNED;
+#else
+		device.rx_amsdu_zcopy = RX_AMSDU_ZCOPY_ALIGN;
+#endif
+	}
 	device.drv_mode = handle->params.drv_mode;
 	if (MLAN_STATUS_SUCCESS == mlan_register(&device, &pmlan))
 		handle->pmlan_adapter = pmlan;
@@ -2895,6 +2922,18 @@ void woal_free_moal_handle(moal_handle *handle)
 		handle->pmlan_adapter = NULL;
 	}
 
+	if (handle->tx_lat) {
+		moal_vfree(handle, (t_u8 *)handle->tx_lat);
+		handle->tx_lat = NULL;
+	}
+	if (handle->rx_lat) {
+		moal_vfree(handle, (t_u8 *)handle->rx_lat);
+		handle->rx_lat = NULL;
+	}
+#if defined(STA_CFG80211) && defined(UAP_CFG80211)
+	skb_queue_purge(&handle->mon_rx_q);
+#endif
+
 	/* Free BSS attribute table */
 	kfree(handle->drv_mode.bss_attr);
 	handle->drv_mode.bss_attr = NULL;
@@ -3617,6 +3656,159 @@ static void woal_request_vdll_fw_callback(const struct firmware *firmware,
 	return;
 }
 
+/**
+ * @brief Free a cached firmware image, called with fw_cache_lock held
+ *
+ * @param entry     A pointer to moal_fw_cache_entry
+ *
+ * @return          N/A
+ */
+static void woal_fw_cache_free(moal_fw_cache_entry *entry)
+{
+	list_del(&entry->link);
+	fw_cache_size -= entry->fw.size;
+	vfree(entry->data);
+	kfree(entry);
+}
+
+/**
+ * @brief Get a cached firmware image. The image must be given back
+ *        with woal_release_fw().
+ *
+ * @param name      Firmware file name
+ *
+ * @return          A pointer to the image or NULL if it is not cached
+ */
+const struct firmware *woal_fw_cache_get(const char *name)
+{
+	moal_fw_cache_entry *entry;
+	const struct firmware *fw = NULL;
+
+	if (!name)
+		return NULL;
+	mutex_lock(&fw_cache_lock);
+	list_for_each_entry (entry, &fw_cache_list, link) {
+		if (!entry->stale && !strcmp(entry->name, name)) {
+			entry->users++;
+			list_move(&entry->link, &fw_cache_list);
+			fw = &entry->fw;
+			break;
+		}
+	}
+	mutex_unlock(&fw_cache_lock);
+	return fw;
+}
+
+/**
+ * @brief Keep a copy of a firmware image that was downloaded
+ *        successfully. Idle images are evicted, least recently used
+ *        first, to stay within fw_cache_max.
+ *
+ * @param name      Firmware file name
+ * @param fw        A pointer to the image returned by request_firmware()
+ *
+ * @return          N/A
+ */
+void woal_fw_cache_add(const char *name, const struct firmware *fw)
+{
+	moal_fw_cache_entry *entry, *old, *tmp;
+	t_u64 max = (t_u64)fw_cache_max * 1024;
+
+	if (fw_cache_max <= 0 || !name || !fw || !fw->size || fw->size > max)
+		return;
+	entry = kzalloc(sizeof(*entry) + strlen(name) + 1, GFP_KERNEL);
+	if (!entry)
+		return;
+	entry->data = vmalloc(fw->size);
+	if (!entry->data) {
+		kfree(entry);
+		return;
+	}
+	memcpy(entry->data, fw->data, fw->size);
+	entry->fw.data = entry->data;
+	entry->fw.size = fw->size;
+	strcpy(entry->name, name);
+
+	mutex_lock(&fw_cache_lock);
+	list_for_each_entry (old, &fw_cache_list, link) {
+		/* Another adapter got there first */
+		if (!old->stale && !strcmp(old->name, name))
+			goto drop;
+	}
+	list_for_each_entry_safe_reverse (old, tmp, &fw_cache_list, link) {
+		if (fw_cache_size + fw->size <= max)
+			break;
+		if (!old->users)
+			woal_fw_cache_free(old);
+	}
+	if (fw_cache_size + fw->size > max) {
+		PRINTM(MINFO, "fw cache full, %s not cached\n", name);
+		goto drop;
+	}
+	list_add(&entry->link, &fw_cache_list);
+	fw_cache_size += fw->size;
+	mutex_unlock(&fw_cache_lock);
+	PRINTM(MMSG, "Cached firmware %s: %u bytes, %u in cache\n", name,
+	       (t_u32)fw->size, fw_cache_size);
+	return;
+drop:
+	mutex_unlock(&fw_cache_lock);
+	vfree(entry->data);
+	kfree(entry);
+}
+
+/**
+ * @brief Give back an image from woal_fw_cache_get() or
+ *        request_firmware()
+ *
+ * @param fw        A pointer to the image
+ *
+ * @return          N/A
+ */
+void woal_release_fw(const struct firmware *fw)
+{
+	moal_fw_cache_entry *entry;
+
+	if (!fw)
+		return;
+	mutex_lock(&fw_cache_lock);
+	list_for_each_entry (entry, &fw_cache_list, link) {
+		if (&entry->fw == fw) {
+			entry->users--;
+			if (entry->stale && !entry->users)
+				woal_fw_cache_free(entry);
+			mutex_unlock(&fw_cache_lock);
+			return;
+		}
+	}
+	mutex_unlock(&fw_cache_lock);
+	release_firmware(fw);
+}
+
+/**
+ * @brief Drop all cached firmware images, so that the next download
+ *        reads the files again. Images in use are freed when released.
+ *
+ * @return          Number of images dropped
+ */
+t_u32 woal_fw_cache_flush(void)
+{
+	moal_fw_cache_entry *entry, *tmp;
+	t_u32 count = 0;
+
+	mutex_lock(&fw_cache_lock);
+	list_for_each_entry_safe (entry, tmp, &fw_cache_list, link) {
+		if (entry->stale)
+			continue;
+		entry->stale = MTRUE;
+		count++;
+		if (!entry->users)
+			woal_fw_cache_free(entry);
+	}
+	mutex_unlock(&fw_cache_lock);
+	return count;
+}
+
 /**
  * @brief Request firmware image for VDLL
  *
@@ -4721,6 +4913,15 @@ static mlan_status woal_init_fw_dpc(moal_handle *handle)
 		memset(&fw, 0, sizeof(mlan_fw_image));
 		fw.pfw_buf = (t_u8 *)handle->firmware->data;
 		fw.fw_len = handle->firmware->size;
+#ifdef FW_XZ
+		if (woal_fw_is_xz(handle->firmware)) {
+			ret = woal_fw_xz_start(handle, &fw);
+			if (ret) {
+				wifi_status = WIFI_STATUS_DNLD_FW_FAIL;
+				goto done;
+			}
+		}
+#endif
 		if (handle->params.fw_reload == FW_RELOAD_SDIO_INBAND_RESET)
 			fw.fw_reload = handle->params.fw_reload;
 		else
@@ -4730,6 +4931,9 @@ static mlan_status woal_init_fw_dpc(moal_handle *handle)
 		wifi_status = WIFI_STATUS_FW_DNLD;
 		ret = mlan_dnld_fw(handle->pmlan_adapter, &fw);
 		mlan_pm_wakeup_card(handle->pmlan_adapter, MFALSE);
+#ifdef FW_XZ
+		woal_fw_xz_stop(handle);
+#endif
 		if (ret == MLAN_STATUS_FAILURE) {
 			wifi_status = WIFI_STATUS_DNLD_FW_FAIL;
 			PRINTM(MERROR,
@@ -4924,6 +5128,8 @@ static void woal_request_fw_callback(const struct firmware *firmware,
 	if (MLAN_STATUS_SUCCESS !=
 	    woal_request_fw_dpc((moal_handle *)context, firmware))
 		PRINTM(MERROR, "woal_request_fw_dpc failed\n");
+	else
+		woal_fw_cache_add(handle->drv_mode.fw_name, firmware);
 	if (firmware) {
 		release_firmware(firmware);
 		handle->firmware = NULL;
@@ -4944,12 +5150,16 @@ mlan_status woal_request_fw(moal_handle *handle)
 	int err;
 	mlan_status ret = MLAN_STATUS_SUCCESS;
 	t_u8 req_fw_nowait = moal_extflg_isset(handle, EXT_REQ_FW_NOWAIT);
+	const struct firmware *cached;
+	t_u64 start_ns = 0, ready_ns = 0, done_ns = 0;
 
 	ENTER();
 
 	PRINTM(MMSG, "Request firmware: %s\n", handle->drv_mode.fw_name);
 
-	if (req_fw_nowait && !handle->fw_reload) {
+	moal_get_boot_ktime(handle, &start_ns);
+	cached = woal_fw_cache_get(handle->drv_mode.fw_name);
+	if (req_fw_nowait && !handle->fw_reload && !cached) {
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0)
 		err = request_firmware_nowait(THIS_MODULE, FW_ACTION_UEVENT,
 					      handle->drv_mode.fw_name,
@@ -4984,21 +5194,38 @@ mlan_status woal_request_fw(moal_handle *handle)
 			ret = MLAN_STATUS_FAILURE;
 		}
 	} else {
-		err = request_firmware(&handle->firmware,
-				       handle->drv_mode.fw_name,
-				       handle->hotplug_device);
+		if (cached) {
+			handle->firmware = cached;
+			err = 0;
+		} else {
+			err = request_firmware(&handle->firmware,
+					       handle->drv_mode.fw_name,
+					       handle->hotplug_device);
+		}
 		if (err < 0) {
 			PRINTM(MFATAL,
 			       "WLAN: request_firmware() failed, error code = %d\n",
 			       err);
 			ret = MLAN_STATUS_FAILURE;
 		} else {
+			moal_get_boot_ktime(handle, &ready_ns);
 			if (handle->fw_reload)
 				ret = woal_init_fw_dpc(handle);
 			else
 				ret = woal_request_fw_dpc(handle,
 							  handle->firmware);
-			release_firmware(handle->firmware);
+			moal_get_boot_ktime(handle, &done_ns);
+			PRINTM(MMSG,
+			       "wlan: %s image from %s in %u us, fw init %s in %u ms\n",
+			       handle->drv_mode.fw_name,
+			       cached ? "cache" : "file",
+			       (t_u32)moal_do_div(ready_ns - start_ns, 1000),
+			       ret ? "failed" : "done",
+			       (t_u32)moal_do_div(done_ns - start_ns, 1000000));
+			if (!ret && !cached)
+				woal_fw_cache_add(handle->drv_mode.fw_name,
+						  handle->firmware);
+			woal_release_fw(handle->firmware);
 			handle->firmware = NULL;
 		}
 	}
@@ -5202,7 +5429,12 @@ static int woal_mon_open(struct net_device *ndev)
  */
 static int woal_mon_close(struct net_device *ndev)
 {
+	monitor_iface *mon_if = netdev_priv(ndev);
+
 	ENTER();
+	/* Drop the frames not yet delivered to this device */
+	if (mon_if->priv)
+		skb_queue_purge(&mon_if->priv->phandle->mon_rx_q);
 	LEAVE();
 	return 0;
 }
@@ -5419,6 +5651,107 @@ static void woal_mon_if_setup(struct net_device *dev)
 	LEAVE();
 }
 
+/**
+ * @brief Fill the radiotap templates of a monitor interface. The fields
+ *        that only depend on the rate format are set here once, the Rx
+ *        path copies the template and adds the per frame fields.
+ *
+ * @param mon_if            A pointer to monitor_iface
+ *
+ * @return                  N/A
+ */
+static void woal_mon_init_rt_tmpl(monitor_iface *mon_if)
+{
+	struct radiotap_header *rth;
+	t_u32 present;
+	t_u8 format;
+
+	for (format = 0; format < MON_RT_TMPL_NUM; format++) {
+		rth = &mon_if->rt_tmpl[format];
+		memset(rth, 0, sizeof(*rth));
+		rth->hdr.it_version = PKTHDR_RADIOTAP_VERSION;
+		rth->hdr.it_len = cpu_to_le16(sizeof(*rth));
+		present = (1 << IEEE80211_RADIOTAP_TSFT) |
+			  (1 << IEEE80211_RADIOTAP_FLAGS) |
+			  (1 << IEEE80211_RADIOTAP_CHANNEL) |
+			  (1 << IEEE80211_RADIOTAP_DBM_ANTSIGNAL) |
+			  (1 << IEEE80211_RADIOTAP_DBM_ANTNOISE) |
+			  (1 << IEEE80211_RADIOTAP_ANTENNA);
+		switch (format) {
+		case MLAN_RATE_FORMAT_LG:
+			present |= 1 << IEEE80211_RADIOTAP_RATE;
+			break;
+		case MLAN_RATE_FORMAT_HT:
+			present |= 1 << IEEE80211_RADIOTAP_MCS;
+			break;
+		case MLAN_RATE_FORMAT_VHT:
+			present |= 1 << IEEE80211_RADIOTAP_VHT;
+			rth->body.u.vht.known = woal_cpu_to_le16(
+				VHT_KNOWN_STBC | VHT_KNOWN_GI |
+				VHT_KNOWN_SGI_NSYM_DIS | VHT_KNOWN_BEAMFORMED |
+				VHT_KNOWN_BANDWIDTH | VHT_KNOWN_GROUP_ID);
+			break;
+		case MLAN_RATE_FORMAT_HE:
+			present |= 1 << IEEE80211_RADIOTAP_HE;
+			/* Host order, the Rx path converts data1 */
+			rth->body.u.he.data1 = HE_CODING_KNOWN | HE_BW_KNOWN |
+					       HE_MCS_KNOWN | HE_DCM_KNOWN;
+			rth->body.u.he.data2 = HE_DATA_GI_KNOWN;
+			break;
+		default:
+			break;
+		}
+		rth->hdr.it_present = cpu_to_le32(present);
+	}
+	/* No channel is 0xff, the first frame fills the channel field */
+	mon_if->rt_chan_num = 0xff;
+}
+
+/**
+ * @brief Deliver the monitor frames queued during the Rx pass
+ *
+ * @param handle            A pointer to moal_handle
+ *
+ * @return                  N/A
+ */
+void woal_mon_rx_flush(moal_handle *handle)
+{
+	struct sk_buff_head q;
+	struct sk_buff *skb;
+	unsigned long flags;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 19, 0)
+	LIST_HEAD(list);
+#endif
+
+	if (skb_queue_empty(&handle->mon_rx_q))
+		return;
+	__skb_queue_head_init(&q);
+	spin_lock_irqsave(&handle->mon_rx_q.lock, flags);
+	skb_queue_splice_init(&handle->mon_rx_q, &q);
+	spin_unlock_irqrestore(&handle->mon_rx_q.lock, flags);
+	/* Frames that raced with woal_mon_close */
+	if (!handle->mon_if || !netif_running(handle->mon_if->mon_ndev)) {
+		__skb_queue_purge(&q);
+		return;
+	}
+
+	if (in_interrupt() || irqs_disabled()) {
+		while ((skb = __skb_dequeue(&q)))
+			netif_rx(skb);
+		return;
+	}
+	local_bh_disable();
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 19, 0)
+	while ((skb = __skb_dequeue(&q)))
+		list_add_tail(&skb->list, &list);
+	netif_receive_skb_list(&list);
+#else
+	while ((skb = __skb_dequeue(&q)))
+		netif_receive_skb(skb);
+#endif
+	local_bh_enable();
+}
+
 /**
  * @brief Request the driver to add a monitor interface
  *
@@ -5479,6 +5812,7 @@ monitor_iface *woal_prepare_mon_if(moal_private *priv, const char *name,
 	mon_if->base_ndev = priv->netdev;
 	mon_if->radiotap_enabled = 1;
 	mon_if->flag = 1;
+	woal_mon_init_rt_tmpl(mon_if);
 
 fail:
 	if (ret) {
@@ -5843,9 +6177,7 @@ moal_private *woal_add_interface(moal_handle *handle, t_u8 bss_index,
 	else if (bss_type == MLAN_BSS_TYPE_DFS)
 		priv->bss_role = MLAN_BSS_ROLE_UAP;
 
-	INIT_LIST_HEAD(&priv->tcp_sess_queue);
-	spin_lock_init(&priv->tcp_sess_lock);
-	priv->tcp_sess_cnt = 0;
+	woal_init_tcp_sess_queue(priv);
 #ifdef STA_SUPPORT
 	INIT_LIST_HEAD(&priv->tdls_list);
 	spin_lock_init(&priv->tdls_lock);
@@ -5853,13 +6185,11 @@ moal_private *woal_add_interface(moal_handle *handle, t_u8 bss_index,
 
 	INIT_LIST_HEAD(&priv->tx_stat_queue);
 	spin_lock_init(&priv->tx_stat_lock);
-	INIT_LIST_HEAD(&priv->mcast_list);
-	spin_lock_init(&priv->mcast_lock);
+	woal_lru_init(&priv->mcast_table, MLAN_MAX_MULTICAST_LIST_SIZE);
 
 #ifdef STA_CFG80211
-	INIT_LIST_HEAD(&priv->dhcp_discover_queue);
-	spin_lock_init(&priv->dhcp_discover_lock);
-	hash_init(priv->hlist);
+	woal_lru_init(&priv->dhcp_table, DHCP_DISCOVER_TABLE_MAX);
+	woal_lru_init(&priv->arp_table, ARP_REQ_TABLE_MAX);
 #endif
 #ifdef STA_CFG80211
 #ifdef STA_SUPPORT
@@ -6068,14 +6398,14 @@ moal_private *woal_add_interface(moal_handle *handle, t_u8 bss_index,
 #endif
 
 		for (i = 0; i < handle->card_info->histogram_table_num; i++) {
-			priv->hist_data[i] =
-				kmalloc(sizeof(hgm_data) +
-						handle->card_info->rx_rate_max *
-							sizeof(atomic_t),
-					GFP_KERNEL);
+			priv->hist_data[i] = (hgm_data __percpu *)__alloc_percpu(
+				sizeof(hgm_data) +
+					handle->card_info->rx_rate_max *
+						sizeof(t_u32),
+				__alignof__(hgm_data));
 			if (!(priv->hist_data[i])) {
 				PRINTM(MERROR,
-				       "kmalloc priv->hist_data[%d] failed\n",
+				       "alloc priv->hist_data[%d] failed\n",
 				       i);
 				goto error;
 			}
@@ -6124,6 +6454,8 @@ error:
 #endif
 			unregister_netdev(dev);
 	}
+	if (priv)
+		woal_free_tcp_sess_queue(priv);
 	if (dev)
 		free_netdev(dev);
 	LEAVE();
@@ -6201,7 +6533,7 @@ void woal_remove_interface(moal_handle *handle, t_u8 bss_index)
 	if (priv->bss_type == MLAN_BSS_TYPE_STA ||
 	    priv->bss_type == MLAN_BSS_TYPE_UAP) {
 		for (i = 0; i < handle->card_info->histogram_table_num; i++) {
-			kfree(priv->hist_data[i]);
+			free_percpu(priv->hist_data[i]);
 			priv->hist_data[i] = NULL;
 		}
 	}
@@ -6231,6 +6563,7 @@ void woal_remove_interface(moal_handle *handle, t_u8 bss_index)
 #endif
 			unregister_netdev(dev);
 	}
+	woal_free_tcp_sess_queue(priv);
 
 	if (priv->mclist_workqueue) {
 		flush_workqueue(priv->mclist_workqueue);
@@ -6578,6 +6911,8 @@ void woal_flush_workqueue(moal_handle *handle)
 			flush_workqueue(handle->rx_workqueue);
 	}
 #endif
+	if (handle->rx_shard_workqueue)
+		flush_workqueue(handle->rx_shard_workqueue);
 #ifdef PCIE
 	if (IS_PCIE(handle->card_type)) {
 		if (handle->pcie_cmd_resp_workqueue)
@@ -6635,6 +6970,12 @@ void woal_terminate_workqueue(moal_handle *handle)
 		}
 	}
 #endif
+	if (handle->rx_shard_workqueue) {
+		flush_workqueue(handle->rx_shard_workqueue);
+		destroy_workqueue(handle->rx_shard_workqueue);
+		handle->rx_shard_workqueue = NULL;
+		handle->rx_shard_num = 0;
+	}
 #ifdef PCIE
 	if (IS_PCIE(handle->card_type)) {
 		if (handle->pcie_cmd_resp_workqueue) {
@@ -7598,6 +7939,133 @@ void woal_remove_tx_info(moal_private *priv, t_u8 tx_seq_num)
 	LEAVE();
 }
 
+/**
+ *  @brief This function initializes a lookup table
+ *
+ *  @param table       A pointer to woal_lru_table structure
+ *  @param max         Max number of entries
+ *
+ *  @return            N/A
+ */
+void woal_lru_init(struct woal_lru_table *table, t_u32 max)
+{
+	spin_lock_init(&table->lock);
+	hash_init(table->hash);
+	INIT_LIST_HEAD(&table->lru);
+	table->num = 0;
+	table->max = max;
+	atomic_set(&table->hit, 0);
+	atomic_set(&table->miss, 0);
+	table->evicted = 0;
+}
+
+/**
+ *  @brief This function removes an entry from a lookup table, with the
+ *         table lock held. The entry is freed once RCU readers are done.
+ *
+ *  @param table       A pointer to woal_lru_table structure
+ *  @param node        A pointer to the lookup table node of the entry
+ *
+ *  @return            N/A
+ */
+static void woal_lru_del(struct woal_lru_table *table,
+			 struct woal_lru_node *node)
+{
+	hash_del_rcu(&node->hnode);
+	list_del(&node->link);
+	table->num--;
+	/* node is the first member of the entry */
+	kfree_rcu(node, rcu);
+}
+
+/**
+ *  @brief This function adds an entry to a lookup table, with the table
+ *         lock held. A full table evicts its least recently used entry;
+ *         entries looked up since the last pass get a second chance.
+ *
+ *  @param table       A pointer to woal_lru_table structure
+ *  @param node        A pointer to the lookup table node of the entry
+ *  @param key         Hash key of the entry
+ *
+ *  @return            N/A
+ */
+static void woal_lru_add(struct woal_lru_table *table,
+			 struct woal_lru_node *node, t_u32 key)
+{
+	struct woal_lru_node *old = NULL;
+
+	while (table->num && table->num >= table->max) {
+		old = list_first_entry(&table->lru, struct woal_lru_node,
+				       link);
+		if (READ_ONCE(old->referenced)) {
+			WRITE_ONCE(old->referenced, MFALSE);
+			list_move_tail(&old->link, &table->lru);
+			continue;
+		}
+		woal_lru_del(table, old);
+		table->evicted++;
+	}
+	node->stamp = jiffies;
+	node->referenced = MFALSE;
+	hash_add_rcu(table->hash, &node->hnode, key);
+	list_add_tail(&node->link, &table->lru);
+	table->num++;
+}
+
+/**
+ *  @brief This function marks an entry of a lookup table as just used,
+ *         with the table lock held
+ *
+ *  @param table       A pointer to woal_lru_table structure
+ *  @param node        A pointer to the lookup table node of the entry
+ *
+ *  @return            N/A
+ */
+static inline void woal_lru_touch(struct woal_lru_table *table,
+				  struct woal_lru_node *node)
+{
+	WRITE_ONCE(node->stamp, jiffies);
+	list_move_tail(&node->link, &table->lru);
+}
+
+/**
+ *  @brief This function accounts a lookup in a lookup table
+ *
+ *  @param table       A pointer to woal_lru_table structure
+ *  @param node        A pointer to the node found, or NULL
+ *
+ *  @return            N/A
+ */
+static inline void woal_lru_lookup_done(struct woal_lru_table *table,
+					struct woal_lru_node *node)
+{
+	if (node) {
+		if (!READ_ONCE(node->referenced))
+			WRITE_ONCE(node->referenced, MTRUE);
+		atomic_inc(&table->hit);
+	} else {
+		atomic_inc(&table->miss);
+	}
+}
+
+/**
+ *  @brief This function removes all entries of a lookup table
+ *
+ *  @param table       A pointer to woal_lru_table structure
+ *
+ *  @return            N/A
+ */
+void woal_lru_flush(struct woal_lru_table *table)
+{
+	struct woal_lru_node *node = NULL, *tmp;
+	unsigned long flags;
+
+	spin_lock_irqsave(&table->lock, flags);
+	list_for_each_entry_safe (node, tmp, &table->lru, link)
+		woal_lru_del(table, node);
+	spin_unlock_irqrestore(&table->lock, flags);
+}
+
 #if defined(STA_CFG80211)
 /**
  *  @brief This function flushes arp request entry from list
@@ -7608,17 +8076,7 @@ void woal_remove_tx_info(moal_private *priv, t_u8 tx_seq_num)
  */
 t_void woal_flush_arp_request_entry(moal_private *priv)
 {
-	struct arp_entry *arp = NULL;
-	struct hlist_node *tmp = NULL;
-	unsigned long flags;
-	int i;
-
-	spin_lock_irqsave(&priv->arp_request_lock, flags);
-	hash_for_each_safe (priv->hlist, i, tmp, arp, arp_hlist) {
-		hlist_del(&arp->arp_hlist);
-		kfree(arp);
-	}
-	spin_unlock_irqrestore(&priv->arp_request_lock, flags);
+	woal_lru_flush(&priv->arp_table);
 }
 
 /**
@@ -7720,38 +8178,67 @@ t_u32 woal_generate_arp_request_hash(struct sk_buff *skb)
  */
 t_void woal_add_arp_request_node(moal_private *priv, t_u32 hash_key)
 {
+	struct woal_lru_table *table = &priv->arp_table;
 	struct arp_entry *node = NULL;
-	struct hlist_node *temp = NULL;
 	unsigned long flags;
-	bool found = false;
-	int i;
 
-	spin_lock_irqsave(&priv->arp_request_lock, flags);
-	hash_for_each_safe (priv->hlist, i, temp, node, arp_hlist) {
-		if (node && node->hash_key == hash_key) {
-			found = true;
+	spin_lock_irqsave(&table->lock, flags);
+	/* The list is in request order, apart from the entries that got a
+	 * second chance, so the aged entries are at its head */
+	while (!list_empty(&table->lru)) {
+		node = list_first_entry(&table->lru, struct arp_entry,
+					lru.link);
+		if ((jiffies - node->lru.stamp) < ARP_REQ_AGEOUT_TIME)
 			break;
-		}
+		woal_lru_del(table, &node->lru);
+	}
 
-		if (node &&
-		    (jiffies - node->ageout_jiffies) >= ARP_REQ_AGEOUT_TIME) {
-			hlist_del(&node->arp_hlist);
-			kfree(node);
+	hash_for_each_possible (table->hash, node, lru.hnode, hash_key) {
+		if (node->hash_key == hash_key) {
+			/* A resent request restarts its ageout */
+			woal_lru_touch(table, &node->lru);
+			goto done;
 		}
 	}
 
-	if (!found) {
-		node = kzalloc(sizeof(struct arp_entry), GFP_ATOMIC);
-		if (!node) {
-			PRINTM(MERROR, "Failed to alloc memory for arp node\n");
-			return;
-		}
+	node = kzalloc(sizeof(struct arp_entry), GFP_ATOMIC);
+	if (!node) {
+		PRINTM(MERROR, "Failed to alloc memory for arp node\n");
+		goto done;
+	}
+	node->hash_key = hash_key;
+	woal_lru_add(table, &node->lru, hash_key);
+done:
+	spin_unlock_irqrestore(&table->lock, flags);
+}
 
-		node->hash_key = hash_key;
-		node->ageout_jiffies = jiffies;
-		hash_add(priv->hlist, &node->arp_hlist, hash_key);
+/**
+ *  @brief This function checks if an ARP request was sent within
+ *         ARP_REQ_AGEOUT_TIME
+ *
+ *  @param priv        A pointer to moal_private structure
+ *  @param hash_key    hash key of arp request
+ *
+ *  @return            MTRUE if found, MFALSE otherwise
+ */
+t_u8 woal_find_arp_request_node(moal_private *priv, t_u32 hash_key)
+{
+	struct arp_entry *node = NULL;
+	t_u8 ret = MFALSE;
+
+	rcu_read_lock();
+	hash_for_each_possible_rcu (priv->arp_table.hash, node, lru.hnode,
+				    hash_key) {
+		if (node->hash_key == hash_key &&
+		    (jiffies - READ_ONCE(node->lru.stamp)) <
+			    ARP_REQ_AGEOUT_TIME) {
+			ret = MTRUE;
+			break;
+		}
 	}
-	spin_unlock_irqrestore(&priv->arp_request_lock, flags);
+	woal_lru_lookup_done(&priv->arp_table, ret ? &node->lru : NULL);
+	rcu_read_unlock();
+	return ret;
 }
 
 /**
@@ -7763,41 +8250,37 @@ t_void woal_add_arp_request_node(moal_private *priv, t_u32 hash_key)
  */
 void woal_flush_dhcp_discover_queue(moal_private *priv)
 {
-	struct dhcp_discover_info *discover_info = NULL, *tmp_node;
-	unsigned long flags;
-	spin_lock_irqsave(&priv->dhcp_discover_lock, flags);
-	list_for_each_entry_safe (discover_info, tmp_node,
-				  &priv->dhcp_discover_queue, link) {
-		list_del(&discover_info->link);
-		kfree(discover_info);
-	}
-	INIT_LIST_HEAD(&priv->dhcp_discover_queue);
-	spin_unlock_irqrestore(&priv->dhcp_discover_lock, flags);
+	woal_lru_flush(&priv->dhcp_table);
 }
 
 /**
- *  @brief This function gets dhcp_discover_info
+ *  @brief This function checks if a dhcp discover was sent
  *
  *  @param priv      		A pointer to moal_private structure
  *  @param transation_id         token_id of the packet
  *
- *  @return	         N/A
+ *  @return	         MTRUE if found, MFALSE otherwise
  */
-struct dhcp_discover_info *woal_get_dhcp_discover_info(moal_private *priv,
-						       t_u32 transaction_id)
+t_u8 woal_find_dhcp_discover_node(moal_private *priv, t_u32 transaction_id)
 {
 	struct dhcp_discover_info *discover_info = NULL;
+	t_u8 ret = MFALSE;
 
 	ENTER();
-	list_for_each_entry (discover_info, &priv->dhcp_discover_queue, link) {
+	rcu_read_lock();
+	hash_for_each_possible_rcu (priv->dhcp_table.hash, discover_info,
+				    lru.hnode, transaction_id) {
 		// TODO: add 5 second ageout check
 		if (discover_info->transaction_id == transaction_id) {
-			LEAVE();
-			return discover_info;
+			ret = MTRUE;
+			break;
 		}
 	}
+	woal_lru_lookup_done(&priv->dhcp_table,
+			     ret ? &discover_info->lru : NULL);
+	rcu_read_unlock();
 	LEAVE();
-	return NULL;
+	return ret;
 }
 
 /**
@@ -7816,8 +8299,9 @@ t_void woal_add_dhcp_discover_node(moal_private *priv, t_u32 transaction_id,
 	unsigned long flags;
 	t_u8 find_node = MFALSE;
 	if (priv) {
-		spin_lock_irqsave(&priv->dhcp_discover_lock, flags);
-		list_for_each_entry (node, &priv->dhcp_discover_queue, link) {
+		spin_lock_irqsave(&priv->dhcp_table.lock, flags);
+		hash_for_each_possible (priv->dhcp_table.hash, node, lru.hnode,
+					transaction_id) {
 			if (node->transaction_id == transaction_id) {
 				find_node = MTRUE;
 				node->in_ts_sec = pmbuf->in_ts_sec;
@@ -7833,15 +8317,14 @@ t_void woal_add_dhcp_discover_node(moal_private *priv, t_u32 transaction_id,
 				node->transaction_id = transaction_id;
 				node->in_ts_sec = pmbuf->in_ts_sec;
 				node->in_ts_usec = pmbuf->in_ts_usec;
-				INIT_LIST_HEAD(&node->link);
-				list_add_tail(&node->link,
-					      &priv->dhcp_discover_queue);
+				woal_lru_add(&priv->dhcp_table, &node->lru,
+					     transaction_id);
 				PRINTM(MCMND,
 				       "Add to dhcp_disover_queue: transaction_id=0x%x\n",
 				       transaction_id);
 			}
 		}
-		spin_unlock_irqrestore(&priv->dhcp_discover_lock, flags);
+		spin_unlock_irqrestore(&priv->dhcp_table.lock, flags);
 	}
 }
 
@@ -7897,16 +8380,22 @@ done:
  */
 void woal_flush_mcast_list(moal_private *priv)
 {
-	struct mcast_node *node = NULL, *tmp_node;
-	unsigned long flags;
-	spin_lock_irqsave(&priv->mcast_lock, flags);
-	list_for_each_entry_safe (node, tmp_node, &priv->mcast_list, link) {
-		list_del(&node->link);
-		kfree(node);
-	}
-	INIT_LIST_HEAD(&priv->mcast_list);
+	woal_lru_flush(&priv->mcast_table);
 	priv->num_mcast_addr = 0;
-	spin_unlock_irqrestore(&priv->mcast_lock, flags);
+}
+
+/**
+ *  @brief  This function returns the mcast table key of an address
+ *
+ *  @param mcast_addr       mcast address
+ *
+ *  @return          Hash key
+ */
+static inline t_u32 woal_mcast_key(const t_u8 *mcast_addr)
+{
+	/* The leading bytes are the same for a whole group family */
+	return (t_u32)mcast_addr[2] << 24 | (t_u32)mcast_addr[3] << 16 |
+	       (t_u32)mcast_addr[4] << 8 | mcast_addr[5];
 }
 
 /**
@@ -7920,22 +8409,19 @@ void woal_flush_mcast_list(moal_private *priv)
 t_u8 woal_find_mcast_node_tx(moal_private *priv, struct sk_buff *skb)
 {
 	struct mcast_node *node = NULL;
-	unsigned long flags;
 	t_u8 ret = MFALSE;
-	t_u8 ra[MLAN_MAC_ADDR_LENGTH] = {0};
+	t_u8 *ra = skb->data;
 	ENTER();
-	moal_memcpy_ext(priv->phandle, ra, skb->data, MLAN_MAC_ADDR_LENGTH,
-			sizeof(ra));
-	//    if (ra[0] & 0x01){
-	spin_lock_irqsave(&priv->mcast_lock, flags);
-	list_for_each_entry (node, &priv->mcast_list, link) {
+	rcu_read_lock();
+	hash_for_each_possible_rcu (priv->mcast_table.hash, node, lru.hnode,
+				    woal_mcast_key(ra)) {
 		if (!memcmp(node->mcast_addr, ra, ETH_ALEN)) {
 			ret = MTRUE;
 			break;
 		}
 	}
-	spin_unlock_irqrestore(&priv->mcast_lock, flags);
-	//    }
+	woal_lru_lookup_done(&priv->mcast_table, ret ? &node->lru : NULL);
+	rcu_read_unlock();
 	LEAVE();
 	return ret;
 }
@@ -7953,9 +8439,12 @@ t_void woal_add_mcast_node(moal_private *priv, t_u8 *mcast_addr)
 	struct mcast_node *node = NULL;
 	unsigned long flags;
 	t_u8 find_node = MFALSE;
+	t_u32 key;
 	if (priv) {
-		spin_lock_irqsave(&priv->mcast_lock, flags);
-		list_for_each_entry (node, &priv->mcast_list, link) {
+		key = woal_mcast_key(mcast_addr);
+		spin_lock_irqsave(&priv->mcast_table.lock, flags);
+		hash_for_each_possible (priv->mcast_table.hash, node, lru.hnode,
+					key) {
 			if (!memcmp(node->mcast_addr, mcast_addr, ETH_ALEN)) {
 				find_node = MTRUE;
 				break;
@@ -7967,14 +8456,14 @@ t_void woal_add_mcast_node(moal_private *priv, t_u8 *mcast_addr)
 			if (node) {
 				moal_memcpy_ext(priv->phandle, node->mcast_addr,
 						mcast_addr, ETH_ALEN, ETH_ALEN);
-				INIT_LIST_HEAD(&node->link);
-				list_add_tail(&node->link, &priv->mcast_list);
+				woal_lru_add(&priv->mcast_table, &node->lru,
+					     key);
 				PRINTM(MCMND,
 				       "Add to mcast list: node=" MACSTR "\n",
 				       MAC2STR(mcast_addr));
 			}
 		}
-		spin_unlock_irqrestore(&priv->mcast_lock, flags);
+		spin_unlock_irqrestore(&priv->mcast_table.lock, flags);
 	}
 }
 
@@ -7988,19 +8477,19 @@ t_void woal_add_mcast_node(moal_private *priv, t_u8 *mcast_addr)
  */
 void woal_remove_mcast_node(moal_private *priv, t_u8 *mcast_addr)
 {
-	struct mcast_node *node, *tmp = NULL;
+	struct mcast_node *node = NULL;
 	unsigned long flags;
 	ENTER();
 
-	spin_lock_irqsave(&priv->mcast_lock, flags);
-	list_for_each_entry_safe (node, tmp, &priv->mcast_list, link) {
+	spin_lock_irqsave(&priv->mcast_table.lock, flags);
+	hash_for_each_possible (priv->mcast_table.hash, node, lru.hnode,
+				woal_mcast_key(mcast_addr)) {
 		if (!memcmp(node->mcast_addr, mcast_addr, ETH_ALEN)) {
-			list_del(&node->link);
-			kfree(node);
+			woal_lru_del(&priv->mcast_table, &node->lru);
 			break;
 		}
 	}
-	spin_unlock_irqrestore(&priv->mcast_lock, flags);
+	spin_unlock_irqrestore(&priv->mcast_table.lock, flags);
 
 	LEAVE();
 }
@@ -8075,6 +8564,41 @@ static void woal_tdls_check_tx(moal_private *priv, struct sk_buff *skb)
 #endif
 #endif
 
+/**
+ *  @brief This function returns the current tcp session ageing wheel tick
+ *
+ *  @return          Tick
+ */
+static inline t_u32 woal_tcp_sess_tick(void)
+{
+	wifi_timeval t;
+
+	woal_get_monotonic_time(&t);
+	return t.time_sec / TCP_SESS_TICK_SEC;
+}
+
+/**
+ *  @brief This function returns a tcp session to the free list, with
+ *         tcp_sess_lock held
+ *
+ *  @param priv      A pointer to moal_private structure
+ *  @param tcp_sess  A pointer to the tcp session
+ *
+ *  @return          N/A
+ */
+static void woal_put_tcp_sess(moal_private *priv, struct tcp_sess *tcp_sess)
+{
+	struct sk_buff *skb = (struct sk_buff *)tcp_sess->ack_skb;
+
+	hash_del(&tcp_sess->hnode);
+	list_move_tail(&tcp_sess->link, &priv->tcp_sess_free);
+	priv->tcp_sess_cnt--;
+	tcp_sess->ack_skb = NULL;
+	tcp_sess->pmbuf = NULL;
+	if (skb)
+		dev_kfree_skb_any(skb);
+}
+
 /**
  *  @brief This function flush tcp session queue
  *
@@ -8084,36 +8608,52 @@ static void woal_tdls_check_tx(moal_private *priv, struct sk_buff *skb)
  */
 void woal_flush_tcp_sess_queue(moal_private *priv)
 {
-	struct tcp_sess *tcp_sess = NULL, *tmp_node;
+	struct tcp_sess *tcp_sess = NULL;
 	unsigned long flags;
-	struct sk_buff *skb;
+	int i;
+	if (!priv->tcp_sess_pool)
+		return;
 	spin_lock_irqsave(&priv->tcp_sess_lock, flags);
-	list_for_each_entry_safe (tcp_sess, tmp_node, &priv->tcp_sess_queue,
-				  link) {
-		list_del(&tcp_sess->link);
+	for (i = 0; i < TCP_ACK_MAX_SESS; i++) {
+		tcp_sess = &priv->tcp_sess_pool[i];
+		if (!hash_hashed(&tcp_sess->hnode))
+			continue;
 		if (atomic_read(&tcp_sess->is_timer_set)) {
 			// coverity[double_unlock:SUPPRESS]
 			spin_unlock_irqrestore(&priv->tcp_sess_lock, flags);
 			woal_cancel_timer(&tcp_sess->ack_timer);
 			spin_lock_irqsave(&priv->tcp_sess_lock, flags);
+			if (!hash_hashed(&tcp_sess->hnode))
+				continue;
 		}
-		skb = (struct sk_buff *)tcp_sess->ack_skb;
-		if (skb)
-			dev_kfree_skb_any(skb);
-		kfree(tcp_sess);
+		woal_put_tcp_sess(priv, tcp_sess);
 	}
-	INIT_LIST_HEAD(&priv->tcp_sess_queue);
 	priv->tcp_ack_drop_cnt = 0;
 	priv->tcp_ack_cnt = 0;
-	priv->tcp_sess_cnt = 0;
 	// coverity[double_unlock:SUPPRESS]
 	spin_unlock_irqrestore(&priv->tcp_sess_lock, flags);
 }
 
 /**
- *  @brief This function gets tcp session from the tcp session queue
+ *  @brief This function returns the tcp session hash key of a packet
+ *
+ *  @param iph       A pointer to the IP header
+ *  @param tcph      A pointer to the TCP header
+ *
+ *  @return          Hash key
+ */
+static inline t_u32 woal_tcp_sess_key(struct iphdr *iph, struct tcphdr *tcph)
+{
+	return (__force t_u32)iph->saddr ^ (__force t_u32)iph->daddr ^
+	       ((t_u32)(__force t_u16)tcph->source << 16 |
+		(__force t_u16)tcph->dest);
+}
+
+/**
+ *  @brief This function gets tcp session from the tcp session hash
  *
  *  @param priv      A pointer to moal_private structure
+ *  @param key       Hash key of the session
  *  @param src_ip    IP address of the device
  *  @param src_port  TCP port of the device
  *  @param dst_ip    IP address of the client
@@ -8123,53 +8663,75 @@ void woal_flush_tcp_sess_queue(moal_private *priv)
  *                   Otherwise, null
  */
 static inline struct tcp_sess *woal_get_tcp_sess(moal_private *priv,
-						 t_u32 src_ip, t_u16 src_port,
-						 t_u32 dst_ip, t_u16 dst_port)
+						 t_u32 key, t_u32 src_ip,
+						 t_u16 src_port, t_u32 dst_ip,
+						 t_u16 dst_port)
 {
 	struct tcp_sess *tcp_sess = NULL;
-	ENTER();
 
-	list_for_each_entry (tcp_sess, &priv->tcp_sess_queue, link) {
+	hash_for_each_possible (priv->tcp_sess_hash, tcp_sess, hnode, key) {
 		if ((tcp_sess->src_ip_addr == src_ip) &&
 		    (tcp_sess->src_tcp_port == src_port) &&
 		    (tcp_sess->dst_ip_addr == dst_ip) &&
-		    (tcp_sess->dst_tcp_port == dst_port)) {
-			LEAVE();
+		    (tcp_sess->dst_tcp_port == dst_port))
 			return tcp_sess;
-		}
 	}
-	LEAVE();
 	return NULL;
 }
 
-#define TCP_SESS_AGEOUT 300
 /**
- *  @brief This function flush tcp session queue
+ *  @brief This function moves a tcp session to the ageing wheel slot of
+ *         the current tick, with tcp_sess_lock held
  *
  *  @param priv      A pointer to moal_private structure
+ *  @param tcp_sess  A pointer to the tcp session
+ *  @param tick      Current tick
  *
  *  @return          N/A
  */
-static void woal_ageout_tcp_sess_queue(moal_private *priv)
+static inline void woal_touch_tcp_sess(moal_private *priv,
+				       struct tcp_sess *tcp_sess, t_u32 tick)
+{
+	if (tcp_sess->tick == tick)
+		return;
+	tcp_sess->tick = tick;
+	list_move_tail(&tcp_sess->link,
+		       &priv->tcp_sess_wheel[tick % TCP_SESS_WHEEL_SIZE]);
+}
+
+/**
+ *  @brief This function ages out the tcp sessions of the ageing wheel
+ *         slots that have expired since the last call, with
+ *         tcp_sess_lock held
+ *
+ *  @param priv      A pointer to moal_private structure
+ *  @param tick      Current tick
+ *
+ *  @return          N/A
+ */
+static void woal_ageout_tcp_sess_queue(moal_private *priv, t_u32 tick)
 {
 	struct tcp_sess *tcp_sess = NULL, *tmp_node;
-	wifi_timeval t;
-	struct sk_buff *skb;
-	woal_get_monotonic_time(&t);
-	list_for_each_entry_safe (tcp_sess, tmp_node, &priv->tcp_sess_queue,
-				  link) {
-		if (t.time_sec >
-		    (tcp_sess->update_time.time_sec + TCP_SESS_AGEOUT)) {
+	struct list_head *slot;
+
+	/* A long idle gap would otherwise walk the same slots again */
+	if (tick - priv->tcp_sess_tick >
+	    TCP_SESS_AGEOUT_TICKS + TCP_SESS_WHEEL_SIZE)
+		priv->tcp_sess_tick =
+			tick - TCP_SESS_AGEOUT_TICKS - TCP_SESS_WHEEL_SIZE;
+	while (tick - priv->tcp_sess_tick > TCP_SESS_AGEOUT_TICKS) {
+		priv->tcp_sess_tick++;
+		slot = &priv->tcp_sess_wheel[priv->tcp_sess_tick %
+					     TCP_SESS_WHEEL_SIZE];
+		list_for_each_entry_safe (tcp_sess, tmp_node, slot, link) {
+			/* Touched in a later round of the wheel */
+			if (tick - tcp_sess->tick < TCP_SESS_AGEOUT_TICKS)
+				continue;
 			PRINTM(MDATA, "wlan: ageout TCP seesion %p\n",
 			       tcp_sess);
-			list_del(&tcp_sess->link);
-			priv->tcp_sess_cnt--;
 			if (atomic_read(&tcp_sess->is_timer_set))
 				woal_cancel_timer(&tcp_sess->ack_timer);
-			skb = (struct sk_buff *)tcp_sess->ack_skb;
-			if (skb)
-				dev_kfree_skb_any(skb);
-			kfree(tcp_sess);
+			woal_put_tcp_sess(priv, tcp_sess);
 		}
 	}
 }
@@ -8211,7 +8773,8 @@ static void woal_tcp_ack_timer_func(void *context)
 #if LINUX_VERSION_CODE > KERNEL_VERSION(2, 6, 29)
 			atomic_inc(&priv->wmm_tx_pending[index]);
 			if (atomic_read(&priv->wmm_tx_pending[index]) >=
-			    priv->max_tx_pending) {
+				    priv->max_tx_pending ||
+			    woal_tx_aqm_overlimit(priv, index)) {
 				struct netdev_queue *txq = netdev_get_tx_queue(
 					priv->netdev, index);
 				netif_tx_stop_queue(txq);
@@ -8244,6 +8807,73 @@ static void woal_tcp_ack_timer_func(void *context)
 	return;
 }
 
+/**
+ *  @brief This function initializes the tcp session pool, hash and
+ *         ageing wheel
+ *
+ *  @param priv      A pointer to moal_private structure
+ *
+ *  @return          N/A
+ */
+void woal_init_tcp_sess_queue(moal_private *priv)
+{
+	struct tcp_sess *tcp_sess = NULL;
+	int i;
+
+	spin_lock_init(&priv->tcp_sess_lock);
+	hash_init(priv->tcp_sess_hash);
+	INIT_LIST_HEAD(&priv->tcp_sess_free);
+	for (i = 0; i < TCP_SESS_WHEEL_SIZE; i++)
+		INIT_LIST_HEAD(&priv->tcp_sess_wheel[i]);
+	priv->tcp_sess_cnt = 0;
+	priv->tcp_sess_tick = woal_tcp_sess_tick() - TCP_SESS_AGEOUT_TICKS;
+	/* Without a pool the free list stays empty and no ACK is held */
+	priv->tcp_sess_pool =
+		kzalloc(sizeof(struct tcp_sess) * TCP_ACK_MAX_SESS, GFP_KERNEL);
+	if (!priv->tcp_sess_pool) {
+		PRINTM(MERROR, "%s: alloc tcp session pool fail\n", __func__);
+		return;
+	}
+	for (i = 0; i < TCP_ACK_MAX_SESS; i++) {
+		tcp_sess = &priv->tcp_sess_pool[i];
+		tcp_sess->priv = (void *)priv;
+		INIT_HLIST_NODE(&tcp_sess->hnode);
+		woal_initialize_timer(&tcp_sess->ack_timer,
+				      woal_tcp_ack_timer_func, tcp_sess);
+		list_add_tail(&tcp_sess->link, &priv->tcp_sess_free);
+	}
+}
+
+/**
+ *  @brief This function flushes and frees the tcp session pool
+ *
+ *  @param priv      A pointer to moal_private structure
+ *
+ *  @return          N/A
+ */
+void woal_free_tcp_sess_queue(moal_private *priv)
+{
+	struct tcp_sess *pool = NULL;
+	unsigned long flags;
+	int i;
+
+	woal_flush_tcp_sess_queue(priv);
+	spin_lock_irqsave(&priv->tcp_sess_lock, flags);
+	pool = priv->tcp_sess_pool;
+	priv->tcp_sess_pool = NULL;
+	INIT_LIST_HEAD(&priv->tcp_sess_free);
+	hash_init(priv->tcp_sess_hash);
+	for (i = 0; i < TCP_SESS_WHEEL_SIZE; i++)
+		INIT_LIST_HEAD(&priv->tcp_sess_wheel[i]);
+	priv->tcp_sess_cnt = 0;
+	spin_unlock_irqrestore(&priv->tcp_sess_lock, flags);
+	if (!pool)
+		return;
+	for (i = 0; i < TCP_ACK_MAX_SESS; i++)
+		woal_cancel_timer(&pool[i].ack_timer);
+	kfree(pool);
+}
+
 /**
  *  @brief This function send the tcp ack
  *
@@ -8271,7 +8901,8 @@ static void woal_send_tcp_ack(moal_private *priv, struct sk_buff *skb,
 #if LINUX_VERSION_CODE > KERNEL_VERSION(2, 6, 29)
 		atomic_inc(&priv->wmm_tx_pending[index]);
 		if (atomic_read(&priv->wmm_tx_pending[index]) >=
-		    priv->max_tx_pending) {
+			    priv->max_tx_pending ||
+		    woal_tx_aqm_overlimit(priv, index)) {
 			struct netdev_queue *txq =
 				netdev_get_tx_queue(priv->netdev, index);
 			netif_tx_stop_queue(txq);
@@ -8299,6 +8930,65 @@ static void woal_send_tcp_ack(moal_private *priv, struct sk_buff *skb,
 	LEAVE();
 }
 
+/**
+ *  @brief This function checks if a pure TCP ACK may be replaced by a newer
+ *         ACK of its flow while queued. ACKs carrying SACK blocks or an ECN
+ *         congestion mark must reach the sender.
+ *
+ *  @param iph       A pointer to the IP header
+ *  @param tcph      A pointer to the TCP header
+ *
+ *  @return          MTRUE or MFALSE
+ */
+static t_u8 woal_tcp_ack_coalescible(struct iphdr *iph, struct tcphdr *tcph)
+{
+	t_u8 *opt = (t_u8 *)(tcph + 1);
+	t_u8 *end = (t_u8 *)tcph + tcph->doff * 4;
+
+	if (INET_ECN_is_ce(iph->tos))
+		return MFALSE;
+	while (opt < end) {
+		if (*opt == TCPOPT_EOL)
+			break;
+		if (*opt == TCPOPT_NOP) {
+			opt++;
+			continue;
+		}
+		if (opt + 1 >= end || opt[1] < 2 || *opt == TCPOPT_SACK)
+			return MFALSE;
+		opt += opt[1];
+	}
+	return MTRUE;
+}
+
+/**
+ *  @brief This function counts a TCP ACK that mlan copied into an older
+ *         queued ACK of its flow
+ *
+ *  @param priv      A pointer to moal_private structure
+ *  @param skb       A pointer to the coalesced ACK
+ *
+ *  @return          N/A
+ */
+void woal_tcp_ack_coalesced(moal_private *priv, struct sk_buff *skb)
+{
+	struct iphdr *iph = (struct iphdr *)(skb->data + sizeof(struct ethhdr));
+	struct tcphdr *tcph = (struct tcphdr *)((t_u8 *)iph + iph->ihl * 4);
+	struct tcp_sess *tcp_session;
+	unsigned long flags;
+
+	spin_lock_irqsave(&priv->tcp_sess_lock, flags);
+	priv->tcp_ack_drop_cnt++;
+	tcp_session = woal_get_tcp_sess(priv, woal_tcp_sess_key(iph, tcph),
+					(__force t_u32)iph->saddr,
+					(__force t_u16)tcph->source,
+					(__force t_u32)iph->daddr,
+					(__force t_u16)tcph->dest);
+	if (tcp_session)
+		tcp_session->coalesced++;
+	spin_unlock_irqrestore(&priv->tcp_sess_lock, flags);
+}
+
 /**
  *  @brief This function get the tcp ack session node
  *
@@ -8318,6 +9008,7 @@ static int woal_process_tcp_ack(moal_private *priv, mlan_buffer *pmbuf)
 	struct iphdr *iph = NULL;
 	struct tcphdr *tcph = NULL;
 	t_u32 ack_seq;
+	t_u32 key, tick;
 	struct sk_buff *skb;
 
 	ENTER();
@@ -8347,63 +9038,56 @@ static int woal_process_tcp_ack(moal_private *priv, mlan_buffer *pmbuf)
 			return ret;
 		}
 		priv->tcp_ack_cnt++;
+		if (priv->enable_tcp_ack_enh == TCP_ACK_ENH_WMM &&
+		    woal_tcp_ack_coalescible(iph, tcph))
+			pmbuf->flags |= MLAN_BUF_FLAG_TCP_ACK_COALESCE;
+		key = woal_tcp_sess_key(iph, tcph);
+		tick = woal_tcp_sess_tick();
 		spin_lock_irqsave(&priv->tcp_sess_lock, flags);
-		tcp_session = woal_get_tcp_sess(priv, (__force t_u32)iph->saddr,
+		tcp_session = woal_get_tcp_sess(priv, key,
+						(__force t_u32)iph->saddr,
 						(__force t_u16)tcph->source,
 						(__force t_u32)iph->daddr,
 						(__force t_u16)tcph->dest);
 		if (!tcp_session) {
 			/* check any aging out sessions can be removed */
-			woal_ageout_tcp_sess_queue(priv);
-			if (priv->tcp_sess_cnt >= TCP_ACK_MAX_SESS) {
+			woal_ageout_tcp_sess_queue(priv, tick);
+			if (list_empty(&priv->tcp_sess_free)) {
 				PRINTM(MINFO, "tcp_sess_cnt reach limit\n");
 				spin_unlock_irqrestore(&priv->tcp_sess_lock,
 						       flags);
 				goto done;
 			}
-			tcp_session =
-				kmalloc(sizeof(struct tcp_sess), GFP_ATOMIC);
-			if (!tcp_session) {
-				PRINTM(MERROR, "Fail to allocate tcp_sess.\n");
-				spin_unlock_irqrestore(&priv->tcp_sess_lock,
-						       flags);
-				goto done;
-			}
-			woal_get_monotonic_time(&tcp_session->update_time);
+			tcp_session = list_first_entry(&priv->tcp_sess_free,
+						       struct tcp_sess, link);
+			tcp_session->tick = tick;
+			list_move_tail(
+				&tcp_session->link,
+				&priv->tcp_sess_wheel[tick %
+						      TCP_SESS_WHEEL_SIZE]);
+			hash_add(priv->tcp_sess_hash, &tcp_session->hnode, key);
 			PRINTM(MDATA, "wlan: create TCP seesion %p\n",
 			       tcp_session);
 
-			tcp_session->ack_skb = pmbuf->pdesc;
-			tcp_session->pmbuf = pmbuf;
-			pmbuf->flags |= MLAN_BUF_FLAG_TCP_ACK;
 			tcp_session->src_ip_addr = (__force t_u32)iph->saddr;
 			tcp_session->dst_ip_addr = (__force t_u32)iph->daddr;
 			tcp_session->src_tcp_port = (__force t_u32)tcph->source;
 			tcp_session->dst_tcp_port = (__force t_u32)tcph->dest;
-			tcp_session->ack_seq = ntohl(tcph->ack_seq);
-			tcp_session->priv = (void *)priv;
-			skb = (struct sk_buff *)pmbuf->pdesc;
-			skb->cb[0] = 0;
-			/* Initialize the timer for tcp ack */
-			woal_initialize_timer(&tcp_session->ack_timer,
-					      woal_tcp_ack_timer_func,
-					      tcp_session);
-			atomic_set(&tcp_session->is_timer_set, MTRUE);
-			woal_mod_timer(&tcp_session->ack_timer, MOAL_TIMER_1MS);
-			list_add_tail(&tcp_session->link,
-				      &priv->tcp_sess_queue);
+			tcp_session->coalesced = 0;
 			priv->tcp_sess_cnt++;
+		} else {
+			woal_touch_tcp_sess(priv, tcp_session, tick);
+		}
+		if (priv->enable_tcp_ack_enh == TCP_ACK_ENH_WMM) {
+			/* mlan coalesces the ACK while it is queued */
 			spin_unlock_irqrestore(&priv->tcp_sess_lock, flags);
-			ret = HOLD_TCP_ACK;
-			LEAVE();
-			return ret;
-		} else if (!tcp_session->ack_skb) {
-			woal_get_monotonic_time(&tcp_session->update_time);
+			goto done;
+		}
+		if (!tcp_session->ack_skb) {
 			tcp_session->ack_skb = pmbuf->pdesc;
 			tcp_session->pmbuf = pmbuf;
 			pmbuf->flags |= MLAN_BUF_FLAG_TCP_ACK;
 			tcp_session->ack_seq = ntohl(tcph->ack_seq);
-			tcp_session->priv = (void *)priv;
 			skb = (struct sk_buff *)pmbuf->pdesc;
 			skb->cb[0] = 0;
 			atomic_set(&tcp_session->is_timer_set, MTRUE);
@@ -8413,7 +9097,6 @@ static int woal_process_tcp_ack(moal_private *priv, mlan_buffer *pmbuf)
 			LEAVE();
 			return ret;
 		}
-		woal_get_monotonic_time(&tcp_session->update_time);
 		ack_seq = ntohl(tcph->ack_seq);
 		skb = (struct sk_buff *)tcp_session->ack_skb;
 		if (likely(ack_seq > tcp_session->ack_seq) &&
@@ -8712,6 +9395,7 @@ static void woal_start_xmit(moal_private *priv, struct sk_buff *skb)
 	memset((t_u8 *)pmbuf, 0, sizeof(mlan_buffer));
 	pmbuf->bss_index = priv->bss_index;
 	woal_fill_mlan_buffer(priv, pmbuf, skb);
+	pmbuf->tx_lat_ts[MLAN_TX_LAT_XMIT] = *MOAL_SKB_TX_LAT_TS(skb);
 
 #ifdef UAP_SUPPORT
 #if defined(UAP_CFG80211) || defined(STA_CFG80211)
@@ -8786,7 +9470,8 @@ static void woal_start_xmit(moal_private *priv, struct sk_buff *skb)
 #if LINUX_VERSION_CODE > KERNEL_VERSION(2, 6, 29)
 		atomic_inc(&priv->wmm_tx_pending[index]);
 		if (atomic_read(&priv->wmm_tx_pending[index]) >=
-		    priv->max_tx_pending) {
+			    priv->max_tx_pending ||
+		    woal_tx_aqm_overlimit(priv, index)) {
 			struct netdev_queue *txq =
 				netdev_get_tx_queue(priv->netdev, index);
 			netif_tx_stop_queue(txq);
@@ -8837,6 +9522,10 @@ netdev_tx_t woal_hard_start_xmit(struct sk_buff *skb, struct net_device *dev)
 	/* Collect TP statistics */
 	if (priv->phandle->tp_acnt.on)
 		moal_tp_accounting(priv->phandle, skb, 1);
+	/* TX latency trace entry point */
+	*MOAL_SKB_TX_LAT_TS(skb) = 0;
+	if (priv->phandle->tx_lat && priv->phandle->tx_lat->on)
+		moal_get_boot_ktime(priv->phandle, MOAL_SKB_TX_LAT_TS(skb));
 	/* Drop Tx packets at drop point 1 */
 	if (priv->phandle->tp_acnt.drop_point == 1) {
 		dev_kfree_skb_any(skb);
@@ -9194,7 +9883,7 @@ void woal_init_priv(moal_private *priv, t_u8 wait_option)
 #endif
 #endif
 
-	priv->enable_tcp_ack_enh = MTRUE;
+	priv->enable_tcp_ack_enh = TCP_ACK_ENH_HOLD;
 	priv->tcp_ack_drop_cnt = 0;
 	priv->tcp_ack_cnt = 0;
 	priv->tcp_ack_payload = 0;
@@ -11946,6 +12635,92 @@ done:
 }
 #endif
 
+/**
+ *  @brief Start the counters of a firmware dump data phase
+ *
+ *  @param phandle  A pointer to moal_handle
+ *  @param stat     A pointer to moal_dump_stat
+ *
+ *  @return         N/A
+ */
+void woal_dump_stat_start(moal_handle *phandle, moal_dump_stat *stat)
+{
+	memset(stat, 0, sizeof(*stat));
+	moal_get_boot_ktime(phandle, &stat->start_ns);
+}
+
+/**
+ *  @brief Get the throughput of a firmware dump so far
+ *
+ *  @param phandle  A pointer to moal_handle
+ *  @param stat     A pointer to moal_dump_stat
+ *  @param ms       A pointer to the elapsed time in ms
+ *
+ *  @return         KB/s
+ */
+static t_u32 woal_dump_stat_rate(moal_handle *phandle, moal_dump_stat *stat,
+				 t_u32 *ms)
+{
+	t_u64 now = 0;
+	t_u32 us;
+
+	moal_get_boot_ktime(phandle, &now);
+	us = (t_u32)moal_do_div(now - stat->start_ns, 1000);
+	*ms = us / 1000;
+	if (!us)
+		return 0;
+	return (t_u32)moal_do_div(((t_u64)stat->bytes * 1000000) >> 10, us);
+}
+
+/**
+ *  @brief Account one firmware dump window and report progress every
+ *         FW_DUMP_PROGRESS_STEP bytes
+ *
+ *  @param phandle  A pointer to moal_handle
+ *  @param stat     A pointer to moal_dump_stat
+ *  @param len      Bytes read
+ *  @param bulk     MTRUE if the window was read with one bus access
+ *  @param name     Name of the memory being dumped
+ *
+ *  @return         N/A
+ */
+void woal_dump_stat_add(moal_handle *phandle, moal_dump_stat *stat,
+			t_u32 len, t_u8 bulk, t_u8 *name)
+{
+	t_u32 ms, rate;
+
+	stat->bytes += len;
+	stat->windows++;
+	if (bulk)
+		stat->bulk++;
+	if (stat->bytes - stat->reported < FW_DUMP_PROGRESS_STEP)
+		return;
+	stat->reported = stat->bytes;
+	rate = woal_dump_stat_rate(phandle, stat, &ms);
+	PRINTM(MMSG, "FW dump %s: %u KB in %u ms, %u KB/s\n", name,
+	       stat->bytes >> 10, ms, rate);
+}
+
+/**
+ *  @brief Report the totals of a firmware dump data phase
+ *
+ *  @param phandle  A pointer to moal_handle
+ *  @param stat     A pointer to moal_dump_stat
+ *  @param name     Name of the memory dumped
+ *
+ *  @return         N/A
+ */
+void woal_dump_stat_done(moal_handle *phandle, moal_dump_stat *stat,
+			 t_u8 *name)
+{
+	t_u32 ms, rate;
+
+	rate = woal_dump_stat_rate(phandle, stat, &ms);
+	PRINTM(MMSG,
+	       "FW dump %s: %u bytes in %u ms, %u KB/s, %u of %u windows in one access\n",
+	       name, stat->bytes, ms, rate, stat->bulk, stat->windows);
+}
+
 #ifdef DUMP_TO_PROC
 /**
  *  @brief This function adds header and copy the src data to buf
@@ -12378,6 +13153,9 @@ static int woal_netdev_poll_rx(struct napi_struct *napi, int budget)
 	if (MLAN_STATUS_SUCCESS !=
 	    mlan_rx_process(handle->pmlan_adapter, &recv))
 		PRINTM(MERROR, "%s: mlan_rx_process failed \n", __func__);
+#if defined(STA_CFG80211) && defined(UAP_CFG80211)
+	woal_mon_rx_flush(handle);
+#endif
 	if (recv < budget) {
 #if CFG80211_VERSION_CODE >= KERNEL_VERSION(4, 10, 0)
 		if (false == napi_complete(napi))
@@ -12594,6 +13372,9 @@ t_void woal_evt_work_queue(struct work_struct *work)
 					       "Fail to request country power table\n");
 			}
 			break;
+		case WOAL_EVENT_DISPATCH:
+			woal_dispatch_queued_event(handle, evt);
+			break;
 		default:
 			break;
 		}
@@ -12633,6 +13414,9 @@ t_void woal_rx_work_queue(struct work_struct *work)
 	woal_get_monotonic_time(&start_timeval);
 	if (MLAN_STATUS_SUCCESS != mlan_rx_process(handle->pmlan_adapter, NULL))
 		PRINTM(MERROR, "%s: mlan_rx_process failed \n", __func__);
+#if defined(STA_CFG80211) && defined(UAP_CFG80211)
+	woal_mon_rx_flush(handle);
+#endif
 
 	woal_get_monotonic_time(&end_timeval);
 	handle->rx_time += (t_u64)(timeval_to_usec(end_timeval) -
@@ -12648,6 +13432,42 @@ t_void woal_rx_work_queue(struct work_struct *work)
 }
 #endif
 
+/**
+ *  @brief This workqueue function runs the late rx stage for the
+ *         packets queued on one rx shard
+ *
+ *  @param work    A pointer to work_struct
+ *
+ *  @return        N/A
+ */
+t_void woal_rx_shard_work_queue(struct work_struct *work)
+{
+	struct moal_rx_shard *shard =
+		container_of(work, struct moal_rx_shard, work);
+	moal_handle *handle = shard->handle;
+	pmlan_buffer pmbuf, pnext;
+	unsigned long flags;
+
+	ENTER();
+	spin_lock_irqsave(&shard->lock, flags);
+	pmbuf = shard->phead;
+	shard->phead = shard->ptail = NULL;
+	shard->pending = 0;
+	spin_unlock_irqrestore(&shard->lock, flags);
+
+	while (pmbuf) {
+		pnext = pmbuf->pnext;
+		pmbuf->pnext = NULL;
+		mlan_rx_late_process(handle->pmlan_adapter, pmbuf);
+		shard->rx_pkts++;
+		pmbuf = pnext;
+	}
+#if defined(STA_CFG80211) && defined(UAP_CFG80211)
+	woal_mon_rx_flush(handle);
+#endif
+	LEAVE();
+}
+
 #ifdef PCIE
 #ifdef TASKLET_SUPPORT
 /**
@@ -12683,6 +13503,9 @@ static void woal_pcie_rx_data_task(unsigned long data)
 	woal_get_monotonic_time(&start_timeval);
 
 	mlan_process_pcie_interrupt_cb(handle->pmlan_adapter, RX_DATA);
+#if defined(STA_CFG80211) && defined(UAP_CFG80211)
+	woal_mon_rx_flush(handle);
+#endif
 
 	woal_get_monotonic_time(&end_timeval);
 	handle->rx_time += (t_u64)(timeval_to_usec(end_timeval) -
@@ -12751,6 +13574,9 @@ t_void woal_pcie_rx_work_queue(struct work_struct *work)
 	woal_get_monotonic_time(&start_timeval);
 
 	mlan_process_pcie_interrupt_cb(handle->pmlan_adapter, RX_DATA);
+#if defined(STA_CFG80211) && defined(UAP_CFG80211)
+	woal_mon_rx_flush(handle);
+#endif
 
 	woal_get_monotonic_time(&end_timeval);
 	handle->rx_time += (t_u64)(timeval_to_usec(end_timeval) -
@@ -12990,6 +13816,9 @@ t_void woal_main_work_queue(struct work_struct *work)
 	handle->main_state = MOAL_START_MAIN_PROCESS;
 	/* Call MLAN main process */
 	(void)mlan_main_process(handle->pmlan_adapter);
+#if defined(STA_CFG80211) && defined(UAP_CFG80211)
+	woal_mon_rx_flush(handle);
+#endif
 	handle->main_state = MOAL_END_MAIN_PROCESS;
 
 	LEAVE();
@@ -13344,6 +14173,7 @@ moal_handle *woal_add_card(void *card, struct device *dev, moal_if_ops *if_ops,
 	MLAN_INIT_WORK(&handle->evt_work, woal_evt_work_queue);
 	INIT_LIST_HEAD(&handle->evt_queue);
 	spin_lock_init(&handle->evt_lock);
+	woal_init_event_dispatch(handle);
 
 #if defined(STA_CFG80211) || defined(UAP_CFG80211)
 #if CFG80211_VERSION_CODE >= KERNEL_VERSION(4, 0, 0)
@@ -13501,6 +14331,39 @@ moal_handle *woal_add_card(void *card, struct device *dev, moal_if_ops *if_ops,
 		MLAN_INIT_WORK(&handle->tx_work, woal_tx_work_handler);
 	}
 
+	if (handle->params.rx_shard > 0) {
+		int cpu;
+		int num = MIN(handle->params.rx_shard, MAX_RX_SHARD);
+		struct moal_rx_shard *shard;
+
+		/* Create per-CPU workqueue for the rx late stage */
+#if LINUX_VERSION_CODE < KERNEL_VERSION(2, 6, 36)
+		handle->rx_shard_workqueue =
+			create_workqueue("MOAL_RX_SHARD_WORKQ");
+#else
+		handle->rx_shard_workqueue = alloc_workqueue(
+			"MOAL_RX_SHARD_WORKQ", WQ_HIGHPRI | WQ_MEM_RECLAIM, 0);
+#endif
+		if (!handle->rx_shard_workqueue) {
+			woal_terminate_workqueue(handle);
+			goto err_kmalloc;
+		}
+		handle->rx_shard_num = 0;
+		for_each_online_cpu (cpu) {
+			if (handle->rx_shard_num >= num)
+				break;
+			shard = &handle->rx_shard[handle->rx_shard_num++];
+			shard->handle = handle;
+			shard->cpu = cpu;
+			shard->phead = shard->ptail = NULL;
+			shard->pending = 0;
+			spin_lock_init(&shard->lock);
+			MLAN_INIT_WORK(&shard->work, woal_rx_shard_work_queue);
+		}
+		PRINTM(MMSG, "rx_shard: %d late stage workers\n",
+		       handle->rx_shard_num);
+	}
+
 #ifdef REASSOCIATION
 	PRINTM(MINFO, "Starting re-association thread...\n");
 	handle->reassoc_thread.handle = handle;
@@ -14241,6 +15104,7 @@ int woal_request_fw_reload(moal_handle *phandle, t_u8 mode)
 #endif
 	moal_handle *handle = phandle;
 	moal_handle *ref_handle = NULL;
+	t_u64 start_ns = 0, done_ns = 0;
 
 	ENTER();
 
@@ -14294,6 +15158,7 @@ int woal_request_fw_reload(moal_handle *phandle, t_u8 mode)
 		LEAVE();
 		return ret;
 	}
+	moal_get_boot_ktime(handle, &start_ns);
 	woal_pre_reset(handle);
 	if (ref_handle)
 		woal_pre_reset(ref_handle);
@@ -14338,6 +15203,9 @@ int woal_request_fw_reload(moal_handle *phandle, t_u8 mode)
 	if (ref_handle)
 		woal_post_reset(ref_handle);
 	wifi_status = WIFI_STATUS_OK;
+	moal_get_boot_ktime(handle, &done_ns);
+	PRINTM(MMSG, "FW reload mode %d: recovered in %u ms\n", mode,
+	       (t_u32)moal_do_div(done_ns - start_ns, 1000000));
 done:
 	LEAVE();
 	return ret;
@@ -14710,6 +15578,7 @@ exit_sem_err:
 	}
 
 	woal_root_proc_remove();
+	woal_fw_cache_flush();
 
 	LEAVE();
 }
@@ -131,6 +131,9 @@ Change log:
 
 #include "mlan.h"
 #include "moal_shim.h"
+#ifdef MLAN_TRACE
+#include "mlan_os.h"
+#endif
 /* Wireless header */
 #if defined(STA_CFG80211) || defined(UAP_CFG80211)
 #include <net/lib80211.h>
@@ -344,6 +347,8 @@ extern char driver_version[];
 extern struct semaphore AddRemoveCardSem;
 extern int wifi_status;
 extern int max_tx_buf;
+/** Rx histograms sample 1 in hist_sample packets */
+extern int hist_sample;
 extern int pcie_int_mode;
 
 #define STA_CFG80211
@@ -363,6 +368,8 @@ extern const struct net_device_ops woal_uap_netdev_ops;
 
 /** Global veriable for usb independent reset */
 extern int fw_reload;
+/** Firmware image cache limit in KB, 0 to disable */
+extern int fw_cache_max;
 
 #ifdef MFG_CMD_SUPPORT
 /** Mfg mode */
@@ -393,6 +400,14 @@ typedef enum {
 typedef struct _moal_private moal_private, *pmoal_private;
 /** Handle data structure for MOAL  */
 typedef struct _moal_handle moal_handle, *pmoal_handle;
+#ifdef FW_XZ
+/** xz firmware decompression, see moal_fw_xz.c */
+typedef struct _moal_fw_xz moal_fw_xz;
+#endif
+#ifdef CONFIG_PROC_FS
+/** CSI ring, see moal_csi.c */
+typedef struct _moal_csi_ring moal_csi_ring;
+#endif
 
 /** Hardware status codes */
 typedef enum _MOAL_HARDWARE_STATUS {
@@ -1203,11 +1218,30 @@ struct debug_data_priv {
 #define TCP_ACK_MAX_HOLD 9
 /* max num of tcp session */
 #define TCP_ACK_MAX_SESS 100
+/** tcp session hash size in bits */
+#define TCP_SESS_HASH_BITS 6
+/** Seconds a tcp session may stay idle */
+#define TCP_SESS_AGEOUT 300
+/** Seconds per tcp session ageing wheel slot */
+#define TCP_SESS_TICK_SEC 60
+/** Ticks after which an idle tcp session has aged out */
+#define TCP_SESS_AGEOUT_TICKS (TCP_SESS_AGEOUT / TCP_SESS_TICK_SEC + 1)
+/** tcp session ageing wheel slots, more than TCP_SESS_AGEOUT_TICKS */
+#define TCP_SESS_WHEEL_SIZE 8
 
 #define DROP_TCP_ACK 1
 #define HOLD_TCP_ACK 2
+/** enable_tcp_ack_enh: hold ACKs in moal with a timer */
+#define TCP_ACK_ENH_HOLD 1
+/** enable_tcp_ack_enh: replace queued ACKs in the WMM RA list */
+#define TCP_ACK_ENH_WMM 2
 struct tcp_sess {
+	/** ageing wheel slot or free list */
 	struct list_head link;
+	/** tcp session hash */
+	struct hlist_node hnode;
+	/** ageing wheel tick of the last update */
+	t_u32 tick;
 	/** tcp session info */
 	t_u32 src_ip_addr;
 	t_u32 dst_ip_addr;
@@ -1225,8 +1259,8 @@ struct tcp_sess {
 	moal_drv_timer ack_timer __ATTRIB_ALIGN__;
 	/** timer is set */
 	atomic_t is_timer_set;
-	/** last update time*/
-	wifi_timeval update_time;
+	/** ACKs replaced by a newer ACK in the WMM queue */
+	t_u32 coalesced;
 };
 
 struct tx_status_info {
@@ -1264,6 +1298,7 @@ enum woal_event_type {
 #endif
 	WOAL_EVENT_RGPWR_KEY_MISMATCH,
 	WOAL_EVENT_RESET_WIFI,
+	WOAL_EVENT_DISPATCH,
 };
 
 /** chan_rpt_info */
@@ -1290,6 +1325,8 @@ struct woal_event {
 	/** priv pointer */
 	void *priv;
 	struct cfg80211_bss *assoc_bss;
+	/** time the event was queued */
+	wifi_timeval tstamp;
 	union {
 		chan_band_info chan_info;
 		woal_evt_buf evt;
@@ -1297,9 +1334,82 @@ struct woal_event {
 		mlan_deauth_param deauth_info;
 		chan_radar_info radar_info;
 		t_u8 deauth_evt_cnt;
+		/** event copy of WOAL_EVENT_DISPATCH */
+		mlan_event *dispatch_evt;
 	};
 };
 
+/** Number of slots in the event dispatch table */
+#define MOAL_EVENT_SLOT_NUM 256
+/** Event slot: FW event ids use 0-127, DRV event ids use 128-255 */
+#define MOAL_EVENT_SLOT(id)                                                    \
+	((((t_u32)(id) >> 24) & 0x80) | ((t_u32)(id)&0x7f))
+
+/** Context an event handler runs in */
+enum woal_event_ctx {
+	/** called directly from moal_recv_event, must not sleep */
+	WOAL_EVT_CTX_ATOMIC = 0,
+	/** called with bottom halves disabled, must not sleep */
+	WOAL_EVT_CTX_SOFTIRQ,
+	/** called from evt_workqueue, may sleep */
+	WOAL_EVT_CTX_WORKQ,
+};
+
+/** Spare bytes after a queued event copy, for handlers that prepend a
+ *  custom header in place (e.g. CSI) */
+#define EVENT_DISPATCH_HEADROOM 32
+
+/** Event handler */
+typedef void (*woal_event_handler)(moal_handle *handle, pmlan_event pmevent);
+
+/** Event dispatch table entry */
+struct woal_event_dispatch {
+	/** event id, for slot collision check */
+	mlan_event_id event_id;
+	/** enum woal_event_ctx */
+	t_u8 ctx;
+	/** handler, NULL to use woal_process_event */
+	woal_event_handler handler;
+};
+
+/** Number of event latency histogram buckets */
+#define EVENT_LAT_HIST_NUM 8
+/** Per event statistics */
+struct woal_event_stats {
+	/** number of events received */
+	t_u32 count;
+	/** longest handling latency in usec */
+	t_u32 max_lat;
+	/** latency histogram: <4us, <16us, ... in powers of 4, last is rest */
+	t_u32 lat_hist[EVENT_LAT_HIST_NUM];
+};
+
+/** Maximum number of rx late stage shards */
+#define MAX_RX_SHARD 8
+/** Packets a shard holds before new ones are processed inline */
+#define RX_SHARD_MAX_PENDING 512
+/** Rx late stage shard, one per worker CPU */
+struct moal_rx_shard {
+	/** back pointer to handle */
+	moal_handle *handle;
+	/** shard work */
+	struct work_struct work;
+	/** CPU the work is queued on */
+	int cpu;
+	/** lock for packet list */
+	spinlock_t lock;
+	/** head of pending packet list, linked by pnext */
+	pmlan_buffer phead;
+	/** tail of pending packet list */
+	pmlan_buffer ptail;
+	/** number of packets on the pending list */
+	t_u32 pending;
+	/** number of packets handled by this shard */
+	t_u32 rx_pkts;
+	/** number of packets dropped because the shard was full */
+	t_u32 rx_overflow;
+};
+
 #define MAX_NUM_ETHER_TYPE 8
 typedef struct {
 	/** number of protocols in protocol array*/
@@ -1383,9 +1493,47 @@ struct tdls_peer {
 	t_u8 num_failure;
 };
 
+/** Bits of the hash of a lookup table */
+#define WOAL_LRU_HASH_BITS 6
+
+/** Lookup table node, the first member of each table entry */
+struct woal_lru_node {
+	/** hash link */
+	struct hlist_node hnode;
+	/** LRU list link */
+	struct list_head link;
+	/** deferred free */
+	struct rcu_head rcu;
+	/** jiffies when the entry was added */
+	unsigned long stamp;
+	/** looked up since the last eviction pass */
+	t_u8 referenced;
+};
+
+/** Lookup table, read under RCU and bounded by LRU eviction */
+struct woal_lru_table {
+	/** serializes updates */
+	spinlock_t lock;
+	/** entries by key */
+	DECLARE_HASHTABLE(hash, WOAL_LRU_HASH_BITS);
+	/** entries, least recently used first */
+	struct list_head lru;
+	/** number of entries */
+	t_u32 num;
+	/** max number of entries */
+	t_u32 max;
+	/** lookups that found an entry */
+	atomic_t hit;
+	/** lookups that found no entry */
+	atomic_t miss;
+	/** entries evicted to make room */
+	t_u32 evicted;
+};
+
 /** mcast node */
 struct mcast_node {
-	struct list_head link;
+	/** lookup table node */
+	struct woal_lru_node lru;
 	/** mcast address information */
 	t_u8 mcast_addr[ETH_ALEN];
 };
@@ -1468,18 +1616,22 @@ struct rf_test_mode_data {
 #define NOISE_FLR_MAX 256
 /** SIG STRENTGH MAX */
 #define SIG_STRENGTH_MAX 256
-/** historgram data */
+/** historgram data, one copy per CPU only written by its own CPU */
 typedef struct _hgm_data {
+	/** hist_gen the counters belong to */
+	t_u32 gen;
+	/** Packets skipped since the last sample */
+	t_u32 skip;
 	/** snr */
-	atomic_t snr[SNR_MAX];
+	t_u32 snr[SNR_MAX];
 	/** noise flr */
-	atomic_t noise_flr[NOISE_FLR_MAX];
+	t_u32 noise_flr[NOISE_FLR_MAX];
 	/** sig_str */
-	atomic_t sig_str[SIG_STRENGTH_MAX];
+	t_u32 sig_str[SIG_STRENGTH_MAX];
 	/** num sample */
-	atomic_t num_samples;
+	t_u32 num_samples;
 	/** rx rate */
-	atomic_t rx_rate[];
+	t_u32 rx_rate[];
 } hgm_data, *phgm_data;
 
 /** max antenna number */
@@ -1536,10 +1688,13 @@ typedef struct _station_node {
 	t_u8 is_valid;
 } station_node;
 
+/** Max dhcp discover entries */
+#define DHCP_DISCOVER_TABLE_MAX 32
+
 /** dhcp discover info */
 struct dhcp_discover_info {
-	/** link */
-	struct list_head link;
+	/** lookup table node */
+	struct woal_lru_node lru;
 	/** transaction id */
 	t_u32 transaction_id;
 	/** Time stamp when packet is received (seconds) */
@@ -1626,11 +1781,15 @@ struct arp_hdr {
 /** ARP request entry ageout of 10 secs */
 #define ARP_REQ_AGEOUT_TIME (10 * HZ)
 
+/** Max ARP request entries */
+#define ARP_REQ_TABLE_MAX 128
+
 /** ARP request node */
 struct arp_entry {
+	/** lookup table node, stamp is the time of the request */
+	struct woal_lru_node lru;
+	/** hash of the request */
 	t_u32 hash_key;
-	struct hlist_node arp_hlist;
-	t_u64 ageout_jiffies;
 };
 
 #define EASY_MESH_MULTI_AP_FH_BSS (t_u8)(0x20)
@@ -1926,6 +2085,8 @@ struct _moal_private {
 	struct proc_dir_entry *hist_entry;
 	/** ant_hist_proc_data */
 	wlan_hist_proc_data hist_proc[MAX_ANTENNA_NUM];
+	/** CSI ring, set while the csi proc file is open */
+	moal_csi_ring __rcu *csi_ring;
 #endif /* CONFIG_PROC_FS */
 #ifdef STA_SUPPORT
 	/** Nickname */
@@ -1978,8 +2139,16 @@ struct _moal_private {
 	/** MLAN debug info */
 	struct debug_data_priv items_priv;
 
-	/** tcp session queue */
-	struct list_head tcp_sess_queue;
+	/** tcp sessions, TCP_ACK_MAX_SESS allocated with the interface */
+	struct tcp_sess *tcp_sess_pool;
+	/** free tcp sessions */
+	struct list_head tcp_sess_free;
+	/** tcp sessions by 4-tuple */
+	DECLARE_HASHTABLE(tcp_sess_hash, TCP_SESS_HASH_BITS);
+	/** tcp sessions by ageing wheel tick of the last update */
+	struct list_head tcp_sess_wheel[TCP_SESS_WHEEL_SIZE];
+	/** last ageing wheel tick aged out */
+	t_u32 tcp_sess_tick;
 	/** tcp session count */
 	t_u8 tcp_sess_cnt;
 	/** TCP Ack enhance flag */
@@ -1988,10 +2157,8 @@ struct _moal_private {
 	t_u8 tcp_ack_max_hold;
 	/** TCP session spin lock */
 	spinlock_t tcp_sess_lock;
-	/** mcast spin lock */
-	spinlock_t mcast_lock;
-	/** mcast list */
-	struct list_head mcast_list;
+	/** mcast table */
+	struct woal_lru_table mcast_table;
 	/** num_mcast_addr */
 	t_u32 num_mcast_addr;
 	/** enable mc_aggr */
@@ -2022,7 +2189,9 @@ struct _moal_private {
 	/** tx status queue */
 	struct list_head tx_stat_queue;
 	/** rx hgm data */
-	phgm_data hist_data[MAX_ANTENNA_NUM];
+	hgm_data __percpu *hist_data[MAX_ANTENNA_NUM];
+	/** Bumped to reset hist_data, each CPU clears its copy lazily */
+	atomic_t hist_gen[MAX_ANTENNA_NUM];
 	t_u8 random_mac[MLAN_MAC_ADDR_LENGTH];
 	BOOLEAN assoc_with_mac;
 	t_u8 gtk_data_ready;
@@ -2051,14 +2220,10 @@ struct _moal_private {
 	moal_private *parent_priv;
 #endif
 #endif
-	/** dhcp discover lock*/
-	spinlock_t dhcp_discover_lock;
-	/** DHCP DISCOVER Info queue */
-	struct list_head dhcp_discover_queue;
-	/** hash table for arp request */
-	DECLARE_HASHTABLE(hlist, 8);
-	/** arp request lock */
-	spinlock_t arp_request_lock;
+	/** DHCP DISCOVER Info table */
+	struct woal_lru_table dhcp_table;
+	/** ARP request table */
+	struct woal_lru_table arp_table;
 	/** txwatchdog disable */
 	t_u8 txwatchdog_disable;
 
@@ -2517,6 +2682,11 @@ typedef struct _netmon_band_chan_cfg {
 } netmon_band_chan_cfg;
 
 #if defined(STA_CFG80211) && defined(UAP_CFG80211)
+/** Number of radiotap templates, one per MLAN_RATE_FORMAT */
+#define MON_RT_TMPL_NUM (MLAN_RATE_FORMAT_HE + 1)
+/** Monitor frames delivered to the stack at once */
+#define MON_RX_BATCH 32
+
 typedef struct _monitor_iface {
 	/* The priv data of interface on which the monitor iface is based */
 	moal_private *priv;
@@ -2534,6 +2704,18 @@ typedef struct _monitor_iface {
 	netmon_band_chan_cfg band_chan_cfg;
 	/** Monitor device statistics structure */
 	struct net_device_stats stats;
+	/** Radiotap header prefilled with the fields fixed per rate format */
+	struct radiotap_header rt_tmpl[MON_RT_TMPL_NUM];
+	/** Channel the cached radiotap channel field was built for */
+	t_u8 rt_chan_num;
+	/** chandef.chan the cached radiotap channel field was built for */
+	struct ieee80211_channel *rt_chan;
+	/** rt_chan->flags the cached radiotap channel field was built for */
+	t_u32 rt_chan_flags;
+	/** Band the cached radiotap channel field was built for */
+	t_u8 rt_band;
+	/** Cached radiotap channel field */
+	struct channel_field rt_channel;
 } monitor_iface;
 #endif
 
@@ -2659,6 +2841,9 @@ typedef struct _moal_mod_para {
 	int auto_ds;
 	int net_rx;
 	int amsdu_deaggr;
+	int rx_amsdu_zcopy;
+	int uap_fwd_zcopy;
+	int tx_aqm;
 	int tx_budget;
 	int mclient_scheduling;
 	int ext_scan;
@@ -2689,6 +2874,7 @@ typedef struct _moal_mod_para {
 	int wq_sched_prio;
 	int wq_sched_policy;
 	int rx_work;
+	int rx_shard;
 #ifdef USB
 	int usb_aggr;
 #endif
@@ -2751,6 +2937,9 @@ void woal_set_tp_state(moal_private *priv);
 #define TXRX_MAX_SAMPLE 50
 #define RX_TIME_PKT (MAX_TP_ACCOUNT_DROP_POINT_NUM + 5)
 #define TX_TIME_PKT (MAX_TP_ACCOUNT_DROP_POINT_NUM + 6)
+/** TX done of a packet traced by the TX latency tracer,
+ *  MAX_TP_ACCOUNT_DROP_POINT_NUM + 7 */
+#define TX_LAT_PKT MLAN_TX_LAT_DROP_POINT
 
 typedef struct _moal_tp_acnt_t {
 	/* TX accounting */
@@ -2800,6 +2989,13 @@ typedef struct _moal_tp_acnt_t {
 	unsigned long rx_delay_kernel[TXRX_MAX_SAMPLE];
 	unsigned long rx_amsdu_delay[TXRX_MAX_SAMPLE];
 	unsigned long rx_amsdu_copy_delay[TXRX_MAX_SAMPLE];
+	/** MLAN data path lock accounting */
+	unsigned long lock_ops;
+	unsigned long lock_ops_last;
+	unsigned long lock_ops_rate;
+	/* get_cycles() per 1000 lock/unlock pairs, callback and inline */
+	unsigned long lock_cycles_cb;
+	unsigned long lock_cycles_inline;
 	t_u8 rx_amsdu_index;
 	t_u8 rx_index;
 	t_u8 tx_index;
@@ -2811,6 +3007,85 @@ typedef struct _moal_tp_acnt_t {
 	moal_drv_timer timer;
 } moal_tp_acnt_t;
 
+/** Latency histogram: 8 linear sub-buckets per power of 2 ns */
+#define LAT_HIST_SUB_BITS 3
+#define LAT_HIST_SUB (1 << LAT_HIST_SUB_BITS)
+/** Largest power of 2 ns tracked, ~34s, longer samples use the last bucket */
+#define LAT_HIST_MAX_EXP 35
+#define LAT_HIST_BUCKETS                                                       \
+	((LAT_HIST_MAX_EXP - LAT_HIST_SUB_BITS + 2) * LAT_HIST_SUB)
+
+/** Log-linear latency histogram, in ns */
+typedef struct _moal_lat_hist {
+	/** Samples per bucket */
+	t_u32 bucket[LAT_HIST_BUCKETS];
+	/** Number of samples */
+	t_u64 count;
+	/** Sum of the samples */
+	t_u64 sum;
+	/** Largest sample */
+	t_u64 max;
+} moal_lat_hist;
+
+/** TX latency intervals, interval n ends at trace point n + 1 */
+#define TX_LAT_TOTAL MLAN_TX_LAT_STAGES
+#define TX_LAT_NUM (MLAN_TX_LAT_STAGES + 1)
+
+/** TX latency histograms of one CPU, per AC (BK, BE, VI, VO) and
+ *  interval */
+typedef struct _moal_tx_lat_cpu {
+	moal_lat_hist hist[MAX_AC_QUEUES][TX_LAT_NUM];
+} moal_tx_lat_cpu;
+
+/** TX latency tracer, one histogram set per CPU merged on read */
+typedef struct _moal_tx_lat {
+	/** Tracing on/off */
+	t_u8 on;
+	/** Histograms, nr_cpu_ids entries, written with irqs disabled */
+	moal_tx_lat_cpu cpu[];
+} moal_tx_lat;
+
+/** RX latency intervals, interval n ends at trace point n + 1 */
+#define RX_LAT_TOTAL MLAN_RX_LAT_STAGES
+#define RX_LAT_NUM (MLAN_RX_LAT_STAGES + 1)
+
+/** RX latency histograms of one CPU, per TID and interval */
+typedef struct _moal_rx_lat_cpu {
+	moal_lat_hist hist[MAX_NUM_TID][RX_LAT_NUM];
+} moal_rx_lat_cpu;
+
+/** RX latency tracer, one histogram set per CPU merged on read */
+typedef struct _moal_rx_lat {
+	/** Tracing on/off */
+	t_u8 on;
+	/** Histograms, nr_cpu_ids entries, written with irqs disabled */
+	moal_rx_lat_cpu cpu[];
+} moal_rx_lat;
+
+/** Stamp of the TX latency tracer carried in skb->cb, after the
+ *  TCP ACK hold count in cb[0] */
+#define MOAL_SKB_TX_LAT_TS(skb) ((t_u64 *)&(skb)->cb[8])
+
+void moal_lat_hist_add(moal_lat_hist *hist, t_u64 ns);
+void moal_lat_hist_merge(moal_lat_hist *dst, moal_lat_hist *src);
+t_u64 moal_lat_hist_percentile(moal_lat_hist *hist, t_u32 permille);
+
+/** Firmware image kept in memory across reloads, see fw_cache_max */
+typedef struct _moal_fw_cache_entry {
+	/** Entry in the cache list, most recently used first */
+	struct list_head link;
+	/** Image handed out in place of request_firmware() */
+	struct firmware fw;
+	/** Copy of the image */
+	t_u8 *data;
+	/** Handles using fw */
+	t_u32 users;
+	/** Flushed while in use, freed by the last woal_release_fw() */
+	t_u8 stale;
+	/** Firmware file name */
+	char name[];
+} moal_fw_cache_entry;
+
 /** Handle data structure for MOAL */
 struct _moal_handle {
 	/** MLAN adapter structure */
@@ -2825,6 +3100,8 @@ struct _moal_handle {
 #if defined(STA_CFG80211) && defined(UAP_CFG80211)
 	/** Monitor interface */
 	monitor_iface *mon_if;
+	/** Monitor frames waiting for the end of the Rx pass */
+	struct sk_buff_head mon_rx_q;
 #endif
 
 	/** set mac address flag */
@@ -2843,6 +3120,10 @@ struct _moal_handle {
 #endif /* USB */
 	/** Firmware */
 	const struct firmware *firmware;
+#ifdef FW_XZ
+	/** Decompression of an xz firmware during download */
+	moal_fw_xz *fw_xz;
+#endif
 	/** Firmware request start time */
 	wifi_timeval req_fw_time;
 	/** Init config file */
@@ -2940,6 +3221,8 @@ struct _moal_handle {
 	atomic_t vmalloc_count;
 	/** mlan buffer alloc count */
 	atomic_t mbufalloc_count;
+	/** Stats snapshot sequence number */
+	atomic_t stats_gen;
 #ifdef PCIE
 	/** Malloc consistent count */
 	atomic_t malloc_cons_count;
@@ -3013,10 +3296,20 @@ struct _moal_handle {
 	spinlock_t evt_lock;
 	/** event queue */
 	struct list_head evt_queue;
+	/** event dispatch table, indexed by MOAL_EVENT_SLOT() */
+	struct woal_event_dispatch evt_dispatch[MOAL_EVENT_SLOT_NUM];
+	/** event statistics, indexed by MOAL_EVENT_SLOT() */
+	struct woal_event_stats evt_stats[MOAL_EVENT_SLOT_NUM];
 	/** tx workqueue */
 	struct workqueue_struct *tx_workqueue;
 	/** tx work */
 	struct work_struct tx_work;
+	/** rx late stage workqueue */
+	struct workqueue_struct *rx_shard_workqueue;
+	/** rx late stage shards */
+	struct moal_rx_shard rx_shard[MAX_RX_SHARD];
+	/** number of active rx shards */
+	t_u8 rx_shard_num;
 
 	/** remain on channel flag */
 	t_u8 remain_on_channel;
@@ -3272,6 +3565,10 @@ struct _moal_handle {
 	/** TP accounting parameters */
 	moal_tp_acnt_t tp_acnt;
 	BOOLEAN is_tp_acnt_timer_set;
+	/** TX latency tracer, allocated when first turned on */
+	moal_tx_lat *tx_lat;
+	/** RX latency tracer, allocated when first turned on */
+	moal_rx_lat *rx_lat;
 
 	t_u8 request_pm;
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 35)
@@ -3412,6 +3709,39 @@ static inline void woal_wake_queue(struct net_device *dev)
 #endif
 }
 
+/**
+ *  @brief Check if a station over its tx_aqm limit holds the wmm queue
+ *
+ *  @param priv		A pointer to moal_private structure
+ *  @param index	wmm queue index
+ *
+ *  @return			MTRUE or MFALSE
+ */
+static inline t_u8 woal_tx_aqm_overlimit(moal_private *priv, t_u8 index)
+{
+	if (!priv->phandle->params.tx_aqm)
+		return MFALSE;
+	return mlan_is_tx_queue_overlimit(priv->phandle->pmlan_adapter,
+					  priv->bss_index, index);
+}
+
+/**
+ *  @brief Check if no station over its tx_aqm limit holds the wmm queue
+ *         any more
+ *
+ *  @param priv		A pointer to moal_private structure
+ *  @param index	wmm queue index
+ *
+ *  @return			MTRUE or MFALSE
+ */
+static inline t_u8 woal_tx_aqm_can_wake(moal_private *priv, t_u8 index)
+{
+	if (!priv->phandle->params.tx_aqm)
+		return MTRUE;
+	return mlan_tx_queue_can_wake(priv->phandle->pmlan_adapter,
+				      priv->bss_index, index);
+}
+
 /** Debug Macro definition*/
 #ifdef DEBUG_LEVEL1
 extern t_u32 drvdbg;
@@ -3539,6 +3869,23 @@ static inline void woal_print(t_u32 level, char *fmt, ...)
 {
 }
 
+#ifdef MLAN_TRACE
+/* The data path levels go to the MLAN trace ring, one NOP while disabled.
+ * MENTRY and MINFO stay compiled out below DEBUG_LEVEL2 */
+#undef PRINTM_MINTR
+#undef PRINTM_MDATA
+#undef PRINTM_MDAT_D
+#ifdef DEBUG_LEVEL2
+#undef PRINTM_MENTRY
+#undef PRINTM_MINFO
+#define PRINTM_MENTRY(msg...) MLAN_TRACE_LOG(MENTRY, msg)
+#define PRINTM_MINFO(msg...) MLAN_TRACE_LOG(MINFO, msg)
+#endif
+#define PRINTM_MINTR(msg...) MLAN_TRACE_LOG(MINTR, msg)
+#define PRINTM_MDATA(msg...) MLAN_TRACE_LOG(MDATA, msg)
+#define PRINTM_MDAT_D(msg...) MLAN_TRACE_LOG(MDAT_D, msg)
+#endif /* MLAN_TRACE */
+
 #define PRINTM(level, msg...) PRINTM_##level(msg)
 
 #else
@@ -3905,6 +4252,12 @@ void woal_terminate_workqueue(moal_handle *handle);
 void woal_flush_workqueue(moal_handle *handle);
 void woal_queue_rx_task(moal_handle *handle);
 void woal_flush_evt_queue(moal_handle *handle);
+int woal_register_event_handler(moal_handle *handle, mlan_event_id event_id,
+				t_u8 ctx, woal_event_handler handler);
+void woal_unregister_event_handler(moal_handle *handle,
+				   mlan_event_id event_id);
+void woal_init_event_dispatch(moal_handle *handle);
+void woal_dispatch_queued_event(moal_handle *handle, struct woal_event *evt);
 /** initializes firmware */
 mlan_status woal_init_fw(moal_handle *handle);
 /** frees the structure of moal_handle */
@@ -4060,6 +4413,27 @@ mlan_status woal_save_dump_info_to_file(char *dir_name, char *file_name,
 void woal_dump_drv_info(moal_handle *phandle, t_u8 *dir_name);
 #endif
 
+/** Bytes between two firmware dump progress messages */
+#define FW_DUMP_PROGRESS_STEP (256 * 1024)
+/** Firmware dump data phase counters */
+typedef struct _moal_dump_stat {
+	/** Start of the data phase in ns */
+	t_u64 start_ns;
+	/** Bytes read */
+	t_u32 bytes;
+	/** Bytes at the last progress message */
+	t_u32 reported;
+	/** Windows read */
+	t_u32 windows;
+	/** Windows read with one bus access */
+	t_u32 bulk;
+} moal_dump_stat;
+void woal_dump_stat_start(moal_handle *phandle, moal_dump_stat *stat);
+void woal_dump_stat_add(moal_handle *phandle, moal_dump_stat *stat,
+			t_u32 len, t_u8 bulk, t_u8 *name);
+void woal_dump_stat_done(moal_handle *phandle, moal_dump_stat *stat,
+			 t_u8 *name);
+
 #define FW_DUMP_TYPE_ENDED 0x002
 #define FW_DUMP_TYPE_MEM_ITCM 0x004
 #define FW_DUMP_TYPE_MEM_DTCM 0x005
@@ -4283,6 +4657,12 @@ void woal_create_proc_entry(moal_private *priv);
 void woal_proc_remove(moal_private *priv);
 /** string to number */
 int woal_string_to_number(char *s);
+/** Copy a CSI record to the CSI ring */
+t_u8 woal_csi_ring_push(moal_private *priv, t_u8 *data, t_u32 len);
+/** Create CSI proc entry */
+void woal_csi_proc_create(moal_private *priv);
+/** Remove CSI proc entry */
+void woal_csi_proc_remove(moal_private *priv);
 #endif
 
 /** Create debug proc fs */
@@ -4315,6 +4695,7 @@ void woal_fw_dump_timer_func(void *context);
 t_void woal_rx_work_queue(struct work_struct *work);
 #endif
 t_void woal_main_work_queue(struct work_struct *work);
+t_void woal_rx_shard_work_queue(struct work_struct *work);
 t_void woal_evt_work_queue(struct work_struct *work);
 t_void woal_mclist_work_queue(struct work_struct *work);
 
@@ -4407,7 +4788,10 @@ void woal_save_conn_params(moal_private *priv,
 void woal_clear_conn_params(moal_private *priv);
 #endif
 
+void woal_init_tcp_sess_queue(moal_private *priv);
+void woal_free_tcp_sess_queue(moal_private *priv);
 void woal_flush_tcp_sess_queue(moal_private *priv);
+void woal_tcp_ack_coalesced(moal_private *priv, struct sk_buff *skb);
 #ifdef STA_CFG80211
 void woal_flush_tdls_list(moal_private *priv);
 #endif
@@ -4423,6 +4807,8 @@ void woal_flush_tx_stat_queue(moal_private *priv);
 struct tx_status_info *woal_get_tx_info(moal_private *priv, t_u8 tx_seq_num);
 void woal_remove_tx_info(moal_private *priv, t_u8 tx_seq_num);
 
+void woal_lru_init(struct woal_lru_table *table, t_u32 max);
+void woal_lru_flush(struct woal_lru_table *table);
 void woal_flush_mcast_list(moal_private *priv);
 t_void woal_add_mcast_node(moal_private *priv, t_u8 *mcast_addr);
 void woal_remove_mcast_node(moal_private *priv, t_u8 *mcast_addr);
@@ -4451,13 +4837,13 @@ mlan_status woal_set_hotspotcfg(moal_private *priv, t_u8 wait_option,
 
 #if defined(STA_CFG80211)
 mlan_status woal_multi_ap_cfg(moal_private *priv, t_u8 wait_option, t_u8 flag);
-struct dhcp_discover_info *woal_get_dhcp_discover_info(moal_private *priv,
-						       t_u32 transaction_id);
+t_u8 woal_find_dhcp_discover_node(moal_private *priv, t_u32 transaction_id);
 void woal_flush_dhcp_discover_queue(moal_private *priv);
 t_u32 woal_get_dhcp_discover_transation_id(struct sk_buff *skb);
 t_void woal_add_dhcp_discover_node(moal_private *priv, t_u32 transaction_id,
 				   mlan_buffer *pmbuf);
 t_void woal_add_arp_request_node(moal_private *priv, t_u32 hash_key);
+t_u8 woal_find_arp_request_node(moal_private *priv, t_u32 hash_key);
 t_u32 woal_generate_arp_request_hash(struct sk_buff *skb);
 t_void woal_flush_arp_request_entry(moal_private *priv);
 #endif
@@ -4517,6 +4903,7 @@ mlan_status woal_init_aggr_ctrl(moal_handle *handle, t_u8 wait_option);
 #if defined(STA_CFG80211) && defined(UAP_CFG80211)
 monitor_iface *woal_prepare_mon_if(moal_private *priv, const char *name,
 				   unsigned char name_assign_type);
+void woal_mon_rx_flush(moal_handle *handle);
 #endif
 
 #if defined(STA_CFG80211) || defined(UAP_CFG80211)
@@ -4534,6 +4921,20 @@ mlan_status woal_set_rekey_data(moal_private *priv,
 #endif
 
 mlan_status woal_vdll_req_fw(moal_handle *handle);
+const struct firmware *woal_fw_cache_get(const char *name);
+void woal_fw_cache_add(const char *name, const struct firmware *fw);
+void woal_release_fw(const struct firmware *fw);
+t_u32 woal_fw_cache_flush(void);
+#ifdef FW_XZ
+t_u8 woal_fw_is_xz(const struct firmware *fw);
+t_u32 woal_fw_xz_len(const struct firmware *fw);
+mlan_status woal_fw_xz_copy(const struct firmware *fw, t_u32 offset,
+			    t_u32 len, t_u8 *pbuf);
+mlan_status woal_fw_xz_start(moal_handle *handle, mlan_fw_image *pfw);
+void woal_fw_xz_stop(moal_handle *handle);
+mlan_status woal_fw_xz_read(moal_handle *handle, t_u32 offset, t_u32 len,
+			    t_u8 *pbuf);
+#endif
 
 void woal_ioctl_get_misc_conf(moal_private *priv, mlan_ds_misc_cfg *info);
 t_u8 woal_get_second_channel_offset(moal_private *priv, int chan);
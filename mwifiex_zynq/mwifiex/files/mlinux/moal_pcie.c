@@ -1948,6 +1948,12 @@ static void woal_pcie_reg_dbg(moal_handle *phandle)
 
 #define DEBUG_FW_DONE 0xFF
 #define MAX_POLL_TRIES 100
+/** Budget of the dump control register poll in us */
+#define DUMP_POLL_MAX_US (MAX_POLL_TRIES * 100)
+/** Longest delay between two dump control register polls in us */
+#define DUMP_POLL_MAX_DELAY_US 100
+/** Delays below this are busy waits, longer ones sleep */
+#define DUMP_POLL_SPIN_US 10
 
 typedef enum {
 	DUMP_TYPE_ITCM = 0,
@@ -2014,6 +2020,36 @@ static mlan_status woal_read_reg_eight_bit(moal_handle *handle, t_u32 reg,
 	return MLAN_STATUS_SUCCESS;
 }
 
+/**
+ *  @brief This function reads one firmware dump window, a dword at a
+ *         time when the window is dword aligned
+ *
+ *  @param handle   A Pointer to the moal_handle structure
+ *  @param reg      First register of the window
+ *  @param len      Length of the window
+ *  @param buf      Buffer to fill
+ *
+ *  @return    		MTRUE if read by dwords, MFALSE if read by bytes
+ */
+static t_u8 woal_pcie_read_dump_window(moal_handle *handle, t_u32 reg,
+				       t_u32 len, t_u8 *buf)
+{
+	pcie_service_card *card = (pcie_service_card *)handle->card;
+	t_u32 i, val;
+
+	if (!(reg & 3) && !(len & 3)) {
+		for (i = 0; i < len; i += 4) {
+			val = cpu_to_le32(ioread32(card->pci_mmap1 + reg + i));
+			moal_memcpy_ext(handle, buf + i, &val, sizeof(val),
+					len - i);
+		}
+		return MTRUE;
+	}
+	for (i = 0; i < len; i++)
+		buf[i] = ioread8(card->pci_mmap1 + reg + i);
+	return MFALSE;
+}
+
 /**
  *  @brief This function read/write firmware
  *
@@ -2027,7 +2063,7 @@ static rdwr_status woal_pcie_rdwr_firmware(moal_handle *phandle, t_u8 doneflag,
 					   t_u8 resetflag)
 {
 	int ret = 0;
-	int tries = 0;
+	t_u32 delay = 0, waited = 0;
 	t_u8 ctrl_data = 0;
 	t_u32 reg_data = 0;
 	t_u32 debug_host_ready = 0;
@@ -2084,7 +2120,9 @@ static rdwr_status woal_pcie_rdwr_firmware(moal_handle *phandle, t_u8 doneflag,
 		       dump_ctrl_reg);
 		return RDWR_STATUS_FAILURE;
 	}
-	for (tries = 0; tries < MAX_POLL_TRIES; tries++) {
+	/* The firmware usually answers within a few us, so back off from
+	 * an immediate re-read to DUMP_POLL_MAX_DELAY_US */
+	while (waited < DUMP_POLL_MAX_US) {
 		ret = woal_read_reg_eight_bit(phandle, dump_ctrl_reg,
 					      &ctrl_data);
 		if (ret) {
@@ -2108,10 +2146,16 @@ static rdwr_status woal_pcie_rdwr_firmware(moal_handle *phandle, t_u8 doneflag,
 			}
 		}
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 36)
-		usleep_range(99, 100);
+		if (delay >= DUMP_POLL_SPIN_US)
+			usleep_range(delay - 1, delay);
+		else if (delay)
+			udelay(delay);
 #else
-		udelay(100);
+		if (delay)
+			udelay(delay);
 #endif
+		waited += delay;
+		delay = delay ? MIN(delay * 2, DUMP_POLL_MAX_DELAY_US) : 1;
 	}
 	if (ctrl_data == debug_host_ready) {
 		PRINTM(MERROR, "Fail to pull ctrl_data=0x%x host_ready=0x%x\n",
@@ -2333,7 +2377,7 @@ done:
 static void woal_pcie_dump_fw_info_v2(moal_handle *phandle)
 {
 	int ret = 0;
-	unsigned int reg, reg_start, reg_end;
+	unsigned int reg;
 	t_u8 *dbg_ptr = NULL;
 	t_u8 *tmp_ptr = NULL;
 	t_u32 sec, usec;
@@ -2349,6 +2393,8 @@ static void woal_pcie_dump_fw_info_v2(moal_handle *phandle)
 	memory_type_mapping *mem_type_mapping_tbl = &mem_type_mapping_tbl_8997;
 	t_u32 dump_start_reg = 0;
 	t_u32 dump_end_reg = 0;
+	t_u32 win_len, offset;
+	moal_dump_stat dump_stat;
 
 	if (!phandle) {
 		PRINTM(MERROR, "Could not dump firmwware info\n");
@@ -2428,50 +2474,47 @@ static void woal_pcie_dump_fw_info_v2(moal_handle *phandle)
 	end_ptr = dbg_ptr + memory_size;
 
 	doneflag = mem_type_mapping_tbl->done_flag;
+	win_len = dump_end_reg - dump_start_reg + 1;
 	moal_get_system_time(phandle, &sec, &usec);
 	PRINTM(MMSG, "Start %s output %u.%06u, please wait...\n",
 	       mem_type_mapping_tbl->mem_name, sec, usec);
+	woal_dump_stat_start(phandle, &dump_stat);
 	do {
 		stat = woal_pcie_rdwr_firmware(phandle, doneflag, 0);
 		if (RDWR_STATUS_FAILURE == stat)
 			goto done;
 
-		reg_start = dump_start_reg;
-		reg_end = dump_end_reg;
-		for (reg = reg_start; reg <= reg_end; reg++) {
-			ret = woal_read_reg_eight_bit(phandle, reg, dbg_ptr);
-			if (ret) {
-				PRINTM(MMSG, "PCIE READ ERR\n");
+		if (dbg_ptr + win_len > end_ptr) {
+			PRINTM(MINFO, "pre-allocced buf is not enough\n");
+			/* Double the buffer rather than growing it by a fixed
+			 * step, which copies the whole dump again and again */
+			offset = dbg_ptr - mem_type_mapping_tbl->mem_Ptr;
+			ret = moal_vmalloc(phandle, memory_size * 2 + 1,
+					   (t_u8 **)&tmp_ptr);
+			if ((ret != MLAN_STATUS_SUCCESS) || !tmp_ptr) {
+				PRINTM(MERROR,
+				       "Error: vmalloc  buffer failed!!!\n");
 				goto done;
 			}
-			dbg_ptr++;
-			if (dbg_ptr >= end_ptr) {
-				PRINTM(MINFO,
-				       "pre-allocced buf is not enough\n");
-				ret = moal_vmalloc(phandle,
-						   memory_size + 0x4000 + 1,
-						   (t_u8 **)&tmp_ptr);
-				if ((ret != MLAN_STATUS_SUCCESS) || !tmp_ptr) {
-					PRINTM(MERROR,
-					       "Error: vmalloc  buffer failed!!!\n");
-					goto done;
-				}
-				moal_memcpy_ext(phandle, tmp_ptr,
-						mem_type_mapping_tbl->mem_Ptr,
-						memory_size,
-						memory_size + 0x4000);
-				moal_vfree(phandle,
-					   mem_type_mapping_tbl->mem_Ptr);
-				mem_type_mapping_tbl->mem_Ptr = tmp_ptr;
-				tmp_ptr = NULL;
-				dbg_ptr = mem_type_mapping_tbl->mem_Ptr +
-					  memory_size;
-				memory_size += 0x4000;
-				end_ptr = mem_type_mapping_tbl->mem_Ptr +
-					  memory_size;
-			}
+			moal_memcpy_ext(phandle, tmp_ptr,
+					mem_type_mapping_tbl->mem_Ptr, offset,
+					memory_size * 2);
+			moal_vfree(phandle, mem_type_mapping_tbl->mem_Ptr);
+			mem_type_mapping_tbl->mem_Ptr = tmp_ptr;
+			tmp_ptr = NULL;
+			memory_size *= 2;
+			dbg_ptr = mem_type_mapping_tbl->mem_Ptr + offset;
+			end_ptr = mem_type_mapping_tbl->mem_Ptr + memory_size;
 		}
+		woal_dump_stat_add(phandle, &dump_stat, win_len,
+				   woal_pcie_read_dump_window(phandle,
+							      dump_start_reg,
+							      win_len, dbg_ptr),
+				   mem_type_mapping_tbl->mem_name);
+		dbg_ptr += win_len;
 		if (RDWR_STATUS_DONE == stat) {
+			woal_dump_stat_done(phandle, &dump_stat,
+					    mem_type_mapping_tbl->mem_name);
 #ifdef MLAN_64BIT
 			PRINTM(MMSG,
 			       "%s done:"
@@ -27,6 +27,7 @@ Change log:
 
 #include "moal_main.h"
 #include "moal_eth_ioctl.h"
+#include "moal_stats.h"
 #ifdef UAP_SUPPORT
 #include "moal_uap.h"
 #endif
@@ -43,6 +44,9 @@ Change log:
 ********************************************************/
 #ifdef CONFIG_PROC_FS
 #define STATUS_PROC "wifi_status"
+#ifdef MLAN_TRACE
+#define TRACE_PROC "trace"
+#endif
 #define MWLAN_PROC "mwlan"
 #define WLAN_PROC "adapter%d"
 /** Proc mwlan directory entry */
@@ -106,6 +110,7 @@ static int woal_info_proc_read(struct seq_file *sfp, void *data)
 #ifdef UAP_SUPPORT
 	mlan_ds_uap_stats ustats;
 #endif
+	unsigned long pkts, lock_ops;
 	union {
 		t_u32 l;
 		t_u8 c[4];
@@ -363,6 +368,32 @@ static int woal_info_proc_read(struct seq_file *sfp, void *data)
 		   handle->tp_acnt.rx_paused_cnt);
 	seq_printf(sfp, "Rx rdptr full cnt   : %lu\n",
 		   handle->tp_acnt.rx_rdptr_full_cnt);
+	seq_printf(sfp, "====Lock accounting====\n");
+#ifdef MLAN_INLINE_OS
+	seq_printf(sfp, "Lock mode           : inline\n");
+#else
+	seq_printf(sfp, "Lock mode           : callback\n");
+#endif
+	seq_printf(sfp, "Lock ops            : %lu\n", handle->tp_acnt.lock_ops);
+	seq_printf(sfp, "Lock ops rate       : %lu\n",
+		   handle->tp_acnt.lock_ops_rate);
+	seq_printf(sfp, "Lock cycles/1k ops  : callback %lu inline %lu\n",
+		   handle->tp_acnt.lock_cycles_cb,
+		   handle->tp_acnt.lock_cycles_inline);
+	pkts = handle->tp_acnt.tx_packets_rate[0] +
+	       handle->tp_acnt.rx_packets_rate[0];
+	if (pkts) {
+		lock_ops = handle->tp_acnt.lock_ops_rate;
+		seq_printf(sfp, "Lock ops/pkt        : %lu\n", lock_ops / pkts);
+		if (handle->tp_acnt.lock_cycles_cb >
+		    handle->tp_acnt.lock_cycles_inline)
+			seq_printf(
+				sfp, "Lock cycles saved/pkt: %lu\n",
+				lock_ops *
+					(handle->tp_acnt.lock_cycles_cb -
+					 handle->tp_acnt.lock_cycles_inline) /
+					1000 / pkts);
+	}
 exit:
 	LEAVE();
 	MODULE_PUT;
@@ -729,6 +760,9 @@ static ssize_t woal_config_write(struct file *f, const char __user *buf,
 		PRINTM(MMSG, "Request fw_reload=%d\n", config_data);
 		ret = woal_request_fw_reload(handle, config_data);
 	}
+	if (!strncmp(databuf, "fw_cache_flush", strlen("fw_cache_flush")))
+		PRINTM(MMSG, "fw cache: dropped %u images\n",
+		       woal_fw_cache_flush());
 	if (!strncmp(databuf, "drop_point=", strlen("drop_point="))) {
 		line += strlen("drop_point") + 1;
 		// coverity[string_null:SUPPRESS]
@@ -1119,6 +1153,703 @@ static const struct file_operations config_proc_fops = {
 };
 #endif
 
+/** TX latency interval names, see MLAN_TX_LAT_* */
+static const char *tx_lat_name[TX_LAT_NUM] = {"xmit->enq", "enq->deq",
+					      "deq->aggr", "aggr->bus",
+					      "bus->done", "total"};
+/** AC names in the moal_tx_lat order */
+static const char *tx_lat_ac[MAX_AC_QUEUES] = {"BK", "BE", "VI", "VO"};
+
+/**
+ *  @brief Print a latency in us with ns precision
+ *
+ *  @param sfp      pointer to seq_file structure
+ *  @param ns       latency in ns
+ *
+ *  @return         N/A
+ */
+static void woal_lat_print(struct seq_file *sfp, t_u64 ns)
+{
+	t_u64 us = moal_do_div(ns, 1000);
+
+	seq_printf(sfp, " %8llu.%03u", us, (t_u32)(ns - us * 1000));
+}
+
+/**
+ *  @brief Print one latency histogram row, skipped if it has no samples
+ *
+ *  The per CPU histograms are summed without stopping the writers, so a
+ *  row may miss the samples recorded while it is merged.
+ *
+ *  @param sfp      pointer to seq_file structure
+ *  @param group    AC or TID name
+ *  @param name     interval name
+ *  @param hist     pointer to the merged histogram
+ *
+ *  @return         N/A
+ */
+static void woal_lat_hist_print(struct seq_file *sfp, const char *group,
+				const char *name, moal_lat_hist *hist)
+{
+	if (!hist->count)
+		return;
+	seq_printf(sfp, "%-3s %-14s %10llu", group, name, hist->count);
+	woal_lat_print(sfp, div64_u64(hist->sum, hist->count));
+	woal_lat_print(sfp, moal_lat_hist_percentile(hist, 500));
+	woal_lat_print(sfp, moal_lat_hist_percentile(hist, 990));
+	woal_lat_print(sfp, moal_lat_hist_percentile(hist, 999));
+	woal_lat_print(sfp, hist->max);
+	seq_putc(sfp, '\n');
+}
+
+/**
+ *  @brief Print the latency histogram table header
+ *
+ *  @param sfp      pointer to seq_file structure
+ *  @param group    AC or TID column title
+ *
+ *  @return         N/A
+ */
+static void woal_lat_hist_header(struct seq_file *sfp, const char *group)
+{
+	seq_printf(sfp, "%-3s %-14s %10s %12s %12s %12s %12s %12s\n", group,
+		   "interval", "count", "avg(us)", "p50(us)", "p99(us)",
+		   "p999(us)", "max(us)");
+}
+
+/**
+ *  @brief tx_latency proc read function
+ *
+ *  @param sfp      pointer to seq_file structure
+ *  @param data
+ *
+ *  @return         number of output data
+ */
+static int woal_tx_lat_read(struct seq_file *sfp, void *data)
+{
+	moal_handle *handle = (moal_handle *)sfp->private;
+	moal_tx_lat *tx_lat;
+	moal_lat_hist *hist = NULL;
+	int ac, i, cpu;
+
+	ENTER();
+
+	if (!MODULE_GET) {
+		LEAVE();
+		return 0;
+	}
+
+	tx_lat = handle->tx_lat;
+	seq_printf(sfp, "tx latency trace: %s\n",
+		   (tx_lat && tx_lat->on) ? "on" : "off");
+	if (!tx_lat)
+		goto done;
+	hist = kmalloc(sizeof(*hist), GFP_KERNEL);
+	if (!hist)
+		goto done;
+	woal_lat_hist_header(sfp, "AC");
+	for (ac = 0; ac < MAX_AC_QUEUES; ac++) {
+		for (i = 0; i < TX_LAT_NUM; i++) {
+			memset(hist, 0, sizeof(*hist));
+			for_each_possible_cpu (cpu)
+				moal_lat_hist_merge(
+					hist, &tx_lat->cpu[cpu].hist[ac][i]);
+			woal_lat_hist_print(sfp, tx_lat_ac[ac], tx_lat_name[i],
+					    hist);
+		}
+	}
+	kfree(hist);
+done:
+	MODULE_PUT;
+	LEAVE();
+	return 0;
+}
+
+/**
+ *  @brief tx_latency proc write function: "on", "off" or "reset"
+ *
+ *  @param f        file pointer
+ *  @param buf      pointer to data buffer
+ *  @param count    data number to write
+ *  @param off      Offset
+ *
+ *  @return         number of data
+ */
+static ssize_t woal_tx_lat_write(struct file *f, const char __user *buf,
+				 size_t count, loff_t *off)
+{
+	struct seq_file *sfp = f->private_data;
+	moal_handle *handle = (moal_handle *)sfp->private;
+	moal_tx_lat *tx_lat = NULL;
+	t_u32 size = sizeof(moal_tx_lat) + nr_cpu_ids * sizeof(moal_tx_lat_cpu);
+	char cmd[8];
+
+	ENTER();
+
+	memset(cmd, 0, sizeof(cmd));
+	if (copy_from_user(cmd, buf, MIN(count, sizeof(cmd) - 1))) {
+		LEAVE();
+		return -EFAULT;
+	}
+	if (!handle->tx_lat && !strncmp(cmd, "on", strlen("on"))) {
+		if (moal_vmalloc(handle, size, (t_u8 **)&tx_lat) !=
+		    MLAN_STATUS_SUCCESS) {
+			LEAVE();
+			return -ENOMEM;
+		}
+		memset(tx_lat, 0, size);
+		/* Another writer may have turned it on in the meantime */
+		if (cmpxchg(&handle->tx_lat, NULL, tx_lat))
+			moal_vfree(handle, (t_u8 *)tx_lat);
+	}
+	tx_lat = handle->tx_lat;
+	if (!tx_lat)
+		goto done;
+	if (!strncmp(cmd, "on", strlen("on"))) {
+		tx_lat->on = MTRUE;
+	} else if (!strncmp(cmd, "off", strlen("off"))) {
+		tx_lat->on = MFALSE;
+	} else if (!strncmp(cmd, "reset", strlen("reset"))) {
+		/* Samples recorded during the reset may survive it */
+		memset(tx_lat->cpu, 0, nr_cpu_ids * sizeof(moal_tx_lat_cpu));
+	}
+done:
+	LEAVE();
+	return count;
+}
+
+static int woal_tx_lat_proc_open(struct inode *inode, struct file *file)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 16, 0)
+	return single_open(file, woal_tx_lat_read, pde_data(inode));
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(3, 10, 0)
+	return single_open(file, woal_tx_lat_read, PDE_DATA(inode));
+#else
+	return single_open(file, woal_tx_lat_read, PDE(inode)->data);
+#endif
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0)
+static const struct proc_ops tx_lat_proc_fops = {
+	.proc_open = woal_tx_lat_proc_open,
+	.proc_read = seq_read,
+	.proc_lseek = seq_lseek,
+	.proc_release = single_release,
+	.proc_write = woal_tx_lat_write,
+};
+#else
+static const struct file_operations tx_lat_proc_fops = {
+	.owner = THIS_MODULE,
+	.open = woal_tx_lat_proc_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+	.write = woal_tx_lat_write,
+};
+#endif
+
+/** RX latency interval names, see MLAN_RX_LAT_* */
+static const char *rx_lat_name[RX_LAT_NUM] = {
+	"int->bus",	   "bus->enq",	    "enq->deq", "deq->reorder",
+	"reorder->deaggr", "deaggr->stack", "total"};
+
+/**
+ *  @brief rx_latency proc read function
+ *
+ *  @param sfp      pointer to seq_file structure
+ *  @param data
+ *
+ *  @return         number of output data
+ */
+static int woal_rx_lat_read(struct seq_file *sfp, void *data)
+{
+	moal_handle *handle = (moal_handle *)sfp->private;
+	moal_rx_lat *rx_lat;
+	moal_lat_hist *hist = NULL;
+	char tid_name[4];
+	int tid, i, cpu;
+
+	ENTER();
+
+	if (!MODULE_GET) {
+		LEAVE();
+		return 0;
+	}
+
+	rx_lat = handle->rx_lat;
+	seq_printf(sfp, "rx latency trace: %s\n",
+		   (rx_lat && rx_lat->on) ? "on" : "off");
+	if (!rx_lat)
+		goto done;
+	hist = kmalloc(sizeof(*hist), GFP_KERNEL);
+	if (!hist)
+		goto done;
+	woal_lat_hist_header(sfp, "TID");
+	for (tid = 0; tid < MAX_NUM_TID; tid++) {
+		snprintf(tid_name, sizeof(tid_name), "%d", tid);
+		for (i = 0; i < RX_LAT_NUM; i++) {
+			memset(hist, 0, sizeof(*hist));
+			for_each_possible_cpu (cpu)
+				moal_lat_hist_merge(
+					hist, &rx_lat->cpu[cpu].hist[tid][i]);
+			woal_lat_hist_print(sfp, tid_name, rx_lat_name[i],
+					    hist);
+		}
+	}
+	kfree(hist);
+done:
+	MODULE_PUT;
+	LEAVE();
+	return 0;
+}
+
+/**
+ *  @brief rx_latency proc write function: "on", "off" or "reset"
+ *
+ *  @param f        file pointer
+ *  @param buf      pointer to data buffer
+ *  @param count    data number to write
+ *  @param off      Offset
+ *
+ *  @return         number of data
+ */
+static ssize_t woal_rx_lat_write(struct file *f, const char __user *buf,
+				 size_t count, loff_t *off)
+{
+	struct seq_file *sfp = f->private_data;
+	moal_handle *handle = (moal_handle *)sfp->private;
+	moal_rx_lat *rx_lat = NULL;
+	t_u32 size = sizeof(moal_rx_lat) + nr_cpu_ids * sizeof(moal_rx_lat_cpu);
+	char cmd[8];
+
+	ENTER();
+
+	memset(cmd, 0, sizeof(cmd));
+	if (copy_from_user(cmd, buf, MIN(count, sizeof(cmd) - 1))) {
+		LEAVE();
+		return -EFAULT;
+	}
+	if (!handle->rx_lat && !strncmp(cmd, "on", strlen("on"))) {
+		if (moal_vmalloc(handle, size, (t_u8 **)&rx_lat) !=
+		    MLAN_STATUS_SUCCESS) {
+			LEAVE();
+			return -ENOMEM;
+		}
+		memset(rx_lat, 0, size);
+		/* Another writer may have turned it on in the meantime */
+		if (cmpxchg(&handle->rx_lat, NULL, rx_lat))
+			moal_vfree(handle, (t_u8 *)rx_lat);
+	}
+	rx_lat = handle->rx_lat;
+	if (!rx_lat || !handle->pmlan_adapter)
+		goto done;
+	if (!strncmp(cmd, "on", strlen("on"))) {
+		rx_lat->on = MTRUE;
+		mlan_set_rx_lat(handle->pmlan_adapter, MTRUE);
+	} else if (!strncmp(cmd, "off", strlen("off"))) {
+		mlan_set_rx_lat(handle->pmlan_adapter, MFALSE);
+		rx_lat->on = MFALSE;
+	} else if (!strncmp(cmd, "reset", strlen("reset"))) {
+		/* Samples recorded during the reset may survive it */
+		memset(rx_lat->cpu, 0, nr_cpu_ids * sizeof(moal_rx_lat_cpu));
+	}
+done:
+	LEAVE();
+	return count;
+}
+
+static int woal_rx_lat_proc_open(struct inode *inode, struct file *file)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 16, 0)
+	return single_open(file, woal_rx_lat_read, pde_data(inode));
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(3, 10, 0)
+	return single_open(file, woal_rx_lat_read, PDE_DATA(inode));
+#else
+	return single_open(file, woal_rx_lat_read, PDE(inode)->data);
+#endif
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0)
+static const struct proc_ops rx_lat_proc_fops = {
+	.proc_open = woal_rx_lat_proc_open,
+	.proc_read = seq_read,
+	.proc_lseek = seq_lseek,
+	.proc_release = single_release,
+	.proc_write = woal_rx_lat_write,
+};
+#else
+static const struct file_operations rx_lat_proc_fops = {
+	.owner = THIS_MODULE,
+	.open = woal_rx_lat_proc_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+	.write = woal_rx_lat_write,
+};
+#endif
+
+/** Stats snapshot held by an open stats proc file */
+typedef struct _woal_stats_snap {
+	/** Snapshot length */
+	t_u32 len;
+	/** Handle the snapshot was taken from */
+	moal_handle *handle;
+	/** Snapshot, starts with moal_stats_hdr */
+	t_u8 data[];
+} woal_stats_snap;
+
+/**
+ *  @brief Start a section of the stats snapshot
+ *
+ *  @param hdr      pointer to the snapshot header
+ *  @param pos      pointer to the section
+ *  @param type     section type, MOAL_STATS_SEC_*
+ *  @param count    number of records
+ *  @param rec_len  length of one record
+ *
+ *  @return         pointer to the first record
+ */
+static t_u8 *woal_stats_section(moal_stats_hdr *hdr, t_u8 *pos, t_u16 type,
+				t_u16 count, t_u32 rec_len)
+{
+	moal_stats_section *sec = (moal_stats_section *)pos;
+
+	sec->type = type;
+	sec->count = count;
+	sec->len = count * rec_len;
+	hdr->num_sections++;
+	return pos + sizeof(moal_stats_section);
+}
+
+/**
+ *  @brief Fill the MOAL_STATS_SEC_DRV record
+ *
+ *  @param handle   pointer to moal_handle
+ *  @param drv      pointer to the record
+ *
+ *  @return         N/A
+ */
+static void woal_stats_fill_drv(moal_handle *handle, moal_stats_drv *drv)
+{
+	drv->tx_pending = atomic_read(&handle->tx_pending);
+	drv->rx_pending = atomic_read(&handle->rx_pending);
+	drv->ioctl_pending = atomic_read(&handle->ioctl_pending);
+	drv->lock_count = atomic_read(&handle->lock_count);
+	drv->malloc_count = atomic_read(&handle->malloc_count);
+	drv->vmalloc_count = atomic_read(&handle->vmalloc_count);
+	drv->mbufalloc_count = atomic_read(&handle->mbufalloc_count);
+#ifdef PCIE
+	drv->malloc_cons_count = atomic_read(&handle->malloc_cons_count);
+#endif
+	drv->hs_skip_count = handle->hs_skip_count;
+	drv->hs_force_count = handle->hs_force_count;
+}
+
+/**
+ *  @brief Fill the MOAL_STATS_SEC_MLAN record
+ *
+ *  @param info     pointer to the MLAN debug info
+ *  @param st       pointer to the record
+ *
+ *  @return         N/A
+ */
+static void woal_stats_fill_mlan(mlan_debug_info *info, moal_stats_mlan *st)
+{
+#ifdef SDIO
+	int i;
+#endif
+
+	st->rx_pkts_queued = info->rx_pkts_queued;
+	st->bypass_pkt_count = info->bypass_pkt_count;
+	st->num_cmd_host_to_card_failure = info->num_cmd_host_to_card_failure;
+	st->num_tx_host_to_card_failure = info->num_tx_host_to_card_failure;
+#ifdef SDIO
+	st->num_cmdevt_card_to_host_failure =
+		info->num_cmdevt_card_to_host_failure;
+	st->num_rx_card_to_host_failure = info->num_rx_card_to_host_failure;
+	st->num_int_read_failure = info->num_int_read_failure;
+	st->num_of_irq = info->num_of_irq;
+	for (i = 0;
+	     i < MIN(MOAL_STATS_MPA_NUM, SDIO_MP_AGGR_DEF_PKT_LIMIT_MAX); i++) {
+		st->mpa_tx_count[i] = info->mpa_tx_count[i];
+		st->mpa_rx_count[i] = info->mpa_rx_count[i];
+	}
+#endif
+	st->num_alloc_buffer_failure = info->num_alloc_buffer_failure;
+	st->num_pkt_dropped = info->num_pkt_dropped;
+	st->num_event_deauth = info->num_event_deauth;
+	st->num_event_disassoc = info->num_event_disassoc;
+	st->num_event_link_lost = info->num_event_link_lost;
+	st->num_cmd_timeout = info->num_cmd_timeout;
+}
+
+/**
+ *  @brief Fill the MOAL_STATS_SEC_TP record
+ *
+ *  @param acnt     pointer to the tp accounting
+ *  @param tp       pointer to the record
+ *
+ *  @return         N/A
+ */
+static void woal_stats_fill_tp(moal_tp_acnt_t *acnt, moal_stats_tp *tp)
+{
+	int i;
+
+	for (i = 0;
+	     i < MIN(MOAL_STATS_TP_POINTS, MAX_TP_ACCOUNT_DROP_POINT_NUM);
+	     i++) {
+		tp->tx_packets[i] = acnt->tx_packets[i];
+		tp->tx_bytes[i] = acnt->tx_bytes[i];
+		tp->rx_packets[i] = acnt->rx_packets[i];
+		tp->rx_bytes[i] = acnt->rx_bytes[i];
+	}
+	tp->tx_amsdu_cnt = acnt->tx_amsdu_cnt;
+	tp->tx_amsdu_pkt_cnt = acnt->tx_amsdu_pkt_cnt;
+	tp->tx_intr_cnt = acnt->tx_intr_cnt;
+	tp->tx_xmit_skb_realloc_cnt = acnt->tx_xmit_skb_realloc_cnt;
+	tp->tx_stop_queue_cnt = acnt->tx_stop_queue_cnt;
+	tp->rx_amsdu_cnt = acnt->rx_amsdu_cnt;
+	tp->rx_amsdu_pkt_cnt = acnt->rx_amsdu_pkt_cnt;
+	tp->rx_intr_cnt = acnt->rx_intr_cnt;
+	tp->rx_paused_cnt = acnt->rx_paused_cnt;
+	tp->rx_rdptr_full_cnt = acnt->rx_rdptr_full_cnt;
+	tp->lock_ops = acnt->lock_ops;
+}
+
+/**
+ *  @brief Fill the MOAL_STATS_SEC_NETDEV record of an interface
+ *
+ *  @param priv     pointer to moal_private
+ *  @param info     pointer to the MLAN debug info of the interface
+ *  @param nd       pointer to the record
+ *
+ *  @return         N/A
+ */
+static void woal_stats_fill_netdev(moal_private *priv, mlan_debug_info *info,
+				   moal_stats_netdev *nd)
+{
+	if (priv->netdev)
+		strncpy(nd->name, priv->netdev->name, sizeof(nd->name) - 1);
+	nd->bss_index = priv->bss_index;
+	nd->bss_role = priv->bss_role;
+	nd->media_connected = priv->media_connected;
+	nd->num_tx_timeout = priv->num_tx_timeout;
+	nd->wmm_ac[0] = info->wmm_ac_bk;
+	nd->wmm_ac[1] = info->wmm_ac_be;
+	nd->wmm_ac[2] = info->wmm_ac_vi;
+	nd->wmm_ac[3] = info->wmm_ac_vo;
+	nd->rx_packets = priv->stats.rx_packets;
+	nd->tx_packets = priv->stats.tx_packets;
+	nd->rx_bytes = priv->stats.rx_bytes;
+	nd->tx_bytes = priv->stats.tx_bytes;
+	nd->rx_dropped = priv->stats.rx_dropped;
+	nd->tx_dropped = priv->stats.tx_dropped;
+	nd->tx_errors = priv->stats.tx_errors;
+	nd->sta_list_gen = info->sta_list_gen;
+}
+
+/**
+ *  @brief Take a stats snapshot of all counters of the adapter. Host
+ *         counters only, no firmware command is sent.
+ *
+ *  @param handle   pointer to moal_handle
+ *
+ *  @return         pointer to the snapshot or NULL
+ */
+static woal_stats_snap *woal_stats_snapshot(moal_handle *handle)
+{
+	woal_stats_snap *snap = NULL;
+	mlan_debug_info *info = NULL;
+	sta_stats_info *list, *st;
+	moal_stats_hdr *hdr;
+	moal_stats_sta *sta;
+	moal_private *priv;
+	t_u8 *pos;
+	t_u64 start = 0, end = 0;
+	t_u32 size;
+	t_u8 mlan_done = MFALSE;
+	int i, j;
+
+	moal_get_boot_ktime(handle, &start);
+	size = sizeof(woal_stats_snap) + sizeof(moal_stats_hdr) +
+	       3 * sizeof(moal_stats_section) + sizeof(moal_stats_drv) +
+	       sizeof(moal_stats_mlan) + sizeof(moal_stats_tp) +
+	       handle->priv_num *
+		       (2 * sizeof(moal_stats_section) +
+			sizeof(moal_stats_netdev) +
+			MLAN_MAX_STA_STATS * sizeof(moal_stats_sta));
+	if (moal_vmalloc(handle, size, (t_u8 **)&snap) != MLAN_STATUS_SUCCESS)
+		return NULL;
+	/* Debug info and the station buffer it fills, only this caller
+	 * asks MLAN for the station counters */
+	if (moal_vmalloc(handle,
+			 sizeof(mlan_debug_info) +
+				 MLAN_MAX_STA_STATS * sizeof(sta_stats_info),
+			 (t_u8 **)&info) != MLAN_STATUS_SUCCESS) {
+		moal_vfree(handle, (t_u8 *)snap);
+		return NULL;
+	}
+	list = (sta_stats_info *)(info + 1);
+	memset(snap, 0, size);
+	snap->handle = handle;
+	hdr = (moal_stats_hdr *)snap->data;
+	hdr->magic = MOAL_STATS_MAGIC;
+	hdr->version = MOAL_STATS_VERSION;
+	hdr->hdr_len = sizeof(moal_stats_hdr);
+	hdr->generation = atomic_inc_return(&handle->stats_gen);
+	pos = snap->data + sizeof(moal_stats_hdr);
+
+	pos = woal_stats_section(hdr, pos, MOAL_STATS_SEC_DRV, 1,
+				 sizeof(moal_stats_drv));
+	woal_stats_fill_drv(handle, (moal_stats_drv *)pos);
+	pos += sizeof(moal_stats_drv);
+	pos = woal_stats_section(hdr, pos, MOAL_STATS_SEC_TP, 1,
+				 sizeof(moal_stats_tp));
+	woal_stats_fill_tp(&handle->tp_acnt, (moal_stats_tp *)pos);
+	pos += sizeof(moal_stats_tp);
+
+	for (i = 0; i < MIN(handle->priv_num, MLAN_MAX_BSS_NUM); i++) {
+		priv = handle->priv[i];
+		if (!priv)
+			continue;
+		memset(info, 0, sizeof(mlan_debug_info));
+		info->psta_stats_list = list;
+		info->sta_stats_max = MLAN_MAX_STA_STATS;
+		if (woal_get_debug_info(priv, MOAL_IOCTL_WAIT, info))
+			continue;
+		if (!mlan_done) {
+			/* Adapter counters, the same from every interface */
+			pos = woal_stats_section(hdr, pos, MOAL_STATS_SEC_MLAN,
+						 1, sizeof(moal_stats_mlan));
+			woal_stats_fill_mlan(info, (moal_stats_mlan *)pos);
+			pos += sizeof(moal_stats_mlan);
+			mlan_done = MTRUE;
+		}
+		pos = woal_stats_section(hdr, pos, MOAL_STATS_SEC_NETDEV, 1,
+					 sizeof(moal_stats_netdev));
+		woal_stats_fill_netdev(priv, info, (moal_stats_netdev *)pos);
+		pos += sizeof(moal_stats_netdev);
+		if (!info->sta_stats_num)
+			continue;
+		info->sta_stats_num =
+			MIN(info->sta_stats_num, MLAN_MAX_STA_STATS);
+		pos = woal_stats_section(hdr, pos, MOAL_STATS_SEC_STA,
+					 info->sta_stats_num,
+					 sizeof(moal_stats_sta));
+		for (j = 0; j < (int)info->sta_stats_num; j++) {
+			sta = (moal_stats_sta *)pos;
+			st = &list[j];
+			moal_memcpy_ext(handle, sta->mac_addr, st->mac_addr,
+					ETH_ALEN, sizeof(sta->mac_addr));
+			sta->bss_index = priv->bss_index;
+			sta->snr = st->snr;
+			sta->nf = st->nf;
+			sta->rx_packets = st->stats.rx_packets;
+			sta->tx_packets = st->stats.tx_packets;
+			sta->rx_bytes = st->stats.rx_bytes;
+			sta->tx_bytes = st->stats.tx_bytes;
+			sta->last_rx_in_msec = st->stats.last_rx_in_msec;
+			sta->tx_aqm_drops = st->tx_aqm_drops;
+			sta->tx_aqm_marks = st->tx_aqm_marks;
+			sta->tx_aqm_overlimit = st->tx_aqm_overlimit;
+			pos += sizeof(moal_stats_sta);
+		}
+	}
+	moal_vfree(handle, (t_u8 *)info);
+
+	snap->len = pos - snap->data;
+	hdr->total_len = snap->len;
+	moal_get_boot_ktime(handle, &end);
+	hdr->timestamp = end;
+	hdr->collect_ns = end - start;
+	return snap;
+}
+
+/**
+ *  @brief stats proc open function, takes the snapshot all reads of
+ *         this open file return
+ *
+ *  @param inode    pointer to inode
+ *  @param file     file pointer
+ *
+ *  @return         0 or negative error code
+ */
+static int woal_stats_proc_open(struct inode *inode, struct file *file)
+{
+	moal_handle *handle;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 16, 0)
+	handle = (moal_handle *)pde_data(inode);
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(3, 10, 0)
+	handle = (moal_handle *)PDE_DATA(inode);
+#else
+	handle = (moal_handle *)PDE(inode)->data;
+#endif
+	if (!handle)
+		return -ENODEV;
+	if (!MODULE_GET)
+		return -EFAULT;
+	file->private_data = woal_stats_snapshot(handle);
+	if (!file->private_data) {
+		MODULE_PUT;
+		return -ENOMEM;
+	}
+	return 0;
+}
+
+/**
+ *  @brief stats proc read function
+ *
+ *  @param file     file pointer
+ *  @param buf      pointer to user buffer
+ *  @param count    number of bytes to read
+ *  @param ppos     file position
+ *
+ *  @return         number of bytes read or negative error code
+ */
+static ssize_t woal_stats_proc_read(struct file *file, char __user *buf,
+				    size_t count, loff_t *ppos)
+{
+	woal_stats_snap *snap = file->private_data;
+
+	return simple_read_from_buffer(buf, count, ppos, snap->data,
+				       snap->len);
+}
+
+/**
+ *  @brief stats proc release function
+ *
+ *  @param inode    pointer to inode
+ *  @param file     file pointer
+ *
+ *  @return         0
+ */
+static int woal_stats_proc_release(struct inode *inode, struct file *file)
+{
+	woal_stats_snap *snap = file->private_data;
+
+	moal_vfree(snap->handle, (t_u8 *)snap);
+	MODULE_PUT;
+	return 0;
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0)
+static const struct proc_ops stats_proc_fops = {
+	.proc_open = woal_stats_proc_open,
+	.proc_read = woal_stats_proc_read,
+	.proc_lseek = default_llseek,
+	.proc_release = woal_stats_proc_release,
+};
+#else
+static const struct file_operations stats_proc_fops = {
+	.owner = THIS_MODULE,
+	.open = woal_stats_proc_open,
+	.read = woal_stats_proc_read,
+	.llseek = default_llseek,
+	.release = woal_stats_proc_release,
+};
+#endif
+
 #ifdef DUMP_TO_PROC
 static int woal_drv_dump_read(struct seq_file *sfp, void *data)
 {
@@ -1327,6 +2058,106 @@ static const struct file_operations wifi_status_proc_fops = {
 };
 #endif
 
+#ifdef MLAN_TRACE
+/**
+ *  @brief trace proc read function, dumps the MLAN trace ring one CPU
+ *  after the other, oldest record first
+ *
+ *  @param sfp      pointer to seq_file structure
+ *  @param data
+ *
+ *  @return         number of output data
+ */
+static int woal_trace_read(struct seq_file *sfp, void *data)
+{
+	mlan_trace_rec *prec = NULL;
+	t_u32 cpu, i, num, len;
+	t_u64 sec;
+	t_u32 nsec;
+
+	ENTER();
+
+	if (!MODULE_GET) {
+		LEAVE();
+		return 0;
+	}
+
+	prec = vmalloc(sizeof(mlan_trace_rec) * MLAN_TRACE_RING_SIZE);
+	if (!prec) {
+		MODULE_PUT;
+		LEAVE();
+		return -ENOMEM;
+	}
+	for_each_possible_cpu (cpu) {
+		num = mlan_trace_snapshot(cpu, prec, MLAN_TRACE_RING_SIZE);
+		for (i = 0; i < num; i++) {
+			sec = prec[i].ts;
+			nsec = do_div(sec, NSEC_PER_SEC);
+			seq_printf(sfp, "[%u] %llu.%06u 0x%08x %s", cpu,
+				   (unsigned long long)sec, nsec / 1000,
+				   prec[i].level, prec[i].msg);
+			len = strlen(prec[i].msg);
+			if (!len || prec[i].msg[len - 1] != '\n')
+				seq_putc(sfp, '\n');
+		}
+	}
+	vfree(prec);
+
+	MODULE_PUT;
+	LEAVE();
+	return 0;
+}
+
+/**
+ *  @brief trace proc write function, any write clears the trace ring
+ *
+ *  @param f        file pointer
+ *  @param buf      pointer to data buffer
+ *  @param count    data number to write
+ *  @param off      Offset
+ *
+ *  @return         number of data
+ */
+static ssize_t woal_trace_write(struct file *f, const char __user *buf,
+				size_t count, loff_t *off)
+{
+	ENTER();
+	mlan_trace_reset();
+	LEAVE();
+	return count;
+}
+
+static int woal_trace_proc_open(struct inode *inode, struct file *file)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 16, 0)
+	return single_open(file, woal_trace_read, pde_data(inode));
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(3, 10, 0)
+	return single_open(file, woal_trace_read, PDE_DATA(inode));
+#else
+	return single_open(file, woal_trace_read, PDE(inode)->data);
+#endif
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0)
+static const struct proc_ops trace_proc_fops = {
+	.proc_open = woal_trace_proc_open,
+	.proc_read = seq_read,
+	.proc_lseek = seq_lseek,
+	.proc_release = single_release,
+	.proc_write = woal_trace_write,
+};
+#else
+static const struct file_operations trace_proc_fops = {
+	.owner = THIS_MODULE,
+	.open = woal_trace_proc_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+	.write = woal_trace_write,
+};
+#endif
+#endif /* MLAN_TRACE */
+
 /********************************************************
 		Global Functions
 ********************************************************/
@@ -1390,6 +2221,14 @@ mlan_status woal_root_proc_init(void)
 	/* create /proc/mwlan/wifi_status */
 	proc_create_data(STATUS_PROC, 0666, proc_mwlan, &wifi_status_proc_fops,
 			 NULL);
+#ifdef MLAN_TRACE
+	/* create /proc/mwlan/trace */
+	if (mlan_trace_init(drvdbg) == MLAN_STATUS_SUCCESS)
+		proc_create_data(TRACE_PROC, 0644, proc_mwlan,
+				 &trace_proc_fops, NULL);
+	else
+		PRINTM(MERROR, "woal_root_proc_init: No trace ring\n");
+#endif
 
 	LEAVE();
 	return MLAN_STATUS_SUCCESS;
@@ -1406,6 +2245,10 @@ void woal_root_proc_remove(void)
 	ENTER();
 
 	remove_proc_entry(STATUS_PROC, proc_mwlan);
+#ifdef MLAN_TRACE
+	remove_proc_entry(TRACE_PROC, proc_mwlan);
+	mlan_trace_exit();
+#endif
 
 	remove_proc_entry(MWLAN_PROC, PROC_DIR);
 	proc_mwlan = NULL;
@@ -1486,6 +2329,45 @@ void woal_proc_init(moal_handle *handle)
 	if (!r)
 		PRINTM(MERROR, "Fail to create proc config\n");
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 26)
+	r = proc_create_data("tx_latency", 0644, handle->proc_wlan,
+			     &tx_lat_proc_fops, handle);
+#else
+	r = create_proc_entry("tx_latency", 0644, handle->proc_wlan);
+	if (r) {
+		r->data = handle;
+		r->proc_fops = &tx_lat_proc_fops;
+	}
+#endif
+	if (!r)
+		PRINTM(MERROR, "Fail to create proc tx_latency\n");
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 26)
+	r = proc_create_data("rx_latency", 0644, handle->proc_wlan,
+			     &rx_lat_proc_fops, handle);
+#else
+	r = create_proc_entry("rx_latency", 0644, handle->proc_wlan);
+	if (r) {
+		r->data = handle;
+		r->proc_fops = &rx_lat_proc_fops;
+	}
+#endif
+	if (!r)
+		PRINTM(MERROR, "Fail to create proc rx_latency\n");
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 26)
+	r = proc_create_data("stats", 0444, handle->proc_wlan,
+			     &stats_proc_fops, handle);
+#else
+	r = create_proc_entry("stats", 0444, handle->proc_wlan);
+	if (r) {
+		r->data = handle;
+		r->proc_fops = &stats_proc_fops;
+	}
+#endif
+	if (!r)
+		PRINTM(MERROR, "Fail to create proc stats\n");
+
 #ifdef DUMP_TO_PROC
 	strncpy(drv_dump_dir, "drv_dump", sizeof(drv_dump_dir));
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 26)
@@ -1541,6 +2423,9 @@ void woal_proc_exit(moal_handle *handle)
 	if (handle->proc_wlan) {
 		strncpy(config_proc_dir, "config", sizeof(config_proc_dir));
 		remove_proc_entry(config_proc_dir, handle->proc_wlan);
+		remove_proc_entry("tx_latency", handle->proc_wlan);
+		remove_proc_entry("rx_latency", handle->proc_wlan);
+		remove_proc_entry("stats", handle->proc_wlan);
 #ifdef DUMP_TO_PROC
 		strncpy(drv_dump_dir, "drv_dump", sizeof(drv_dump_dir));
 		remove_proc_entry(drv_dump_dir, handle->proc_wlan);
@@ -1663,6 +2548,9 @@ void woal_create_proc_entry(moal_private *priv)
 #endif
 			if (!r)
 				PRINTM(MMSG, "Fail to create proc info\n");
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 26)
+			woal_csi_proc_create(priv);
+#endif
 		}
 	}
 
@@ -1681,6 +2569,9 @@ void woal_proc_remove(moal_private *priv)
 	ENTER();
 	if (priv->phandle->proc_wlan && priv->proc_entry) {
 		remove_proc_entry("info", priv->proc_entry);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 26)
+		woal_csi_proc_remove(priv);
+#endif
 		remove_proc_entry(priv->proc_entry_name,
 				  priv->phandle->proc_wlan);
 #if LINUX_VERSION_CODE < KERNEL_VERSION(3, 10, 0)
@@ -327,6 +327,9 @@ static void woal_sdio_interrupt(struct sdio_func *func)
 	if (status == MLAN_STATUS_FAILURE) {
 		PRINTM(MINTR, "mlan main process exited with failure\n");
 	}
+#if defined(STA_CFG80211) && defined(UAP_CFG80211)
+	woal_mon_rx_flush(handle);
+#endif
 	handle->main_state = MOAL_END_MAIN_PROCESS;
 	LEAVE();
 }
@@ -2178,6 +2181,29 @@ done:
 #define DEBUG_FW_DONE 0xFF
 #define DEBUG_MEMDUMP_FINISH 0xFE
 #define MAX_POLL_TRIES 100
+/** Budget of the dump control register poll in us */
+#define DUMP_POLL_MAX_US (MAX_POLL_TRIES * 100)
+/** Longest delay between two dump control register polls in us */
+#define DUMP_POLL_MAX_DELAY_US 100
+
+/** Size of the DMA-safe dump window buffer */
+#define DUMP_WINDOW_MAX 64
+/** Dump window not read yet, CMD53 is checked against CMD52 */
+#define DUMP_READ_PROBE 0
+/** Dump window read with one CMD53 */
+#define DUMP_READ_CMD53 1
+/** Dump window read with one CMD52 per byte */
+#define DUMP_READ_CMD52 2
+
+/** Firmware dump window reader */
+typedef struct _sdio_dump_window {
+	/** DUMP_READ_* */
+	t_u8 mode;
+	/** DMA-safe buffer holding the last window */
+	t_u8 *buf;
+	/** Progress */
+	moal_dump_stat stat;
+} sdio_dump_window;
 
 #define HOST_TO_CARD_EVENT_REG 0x00
 #define HOST_TO_CARD_EVENT MBIT(3)
@@ -2243,7 +2269,7 @@ static rdwr_status woal_cmd52_rdwr_firmware(moal_handle *phandle, t_u8 doneflag,
 					    t_u8 trigger)
 {
 	int ret = 0;
-	int tries = 0;
+	t_u32 delay = 0, waited = 0;
 	t_u8 ctrl_data = 0;
 	t_u8 dbg_dump_ctrl_reg = phandle->card_info->dump_fw_ctrl_reg;
 	t_u8 debug_host_ready = phandle->card_info->dump_fw_host_ready;
@@ -2275,7 +2301,9 @@ static rdwr_status woal_cmd52_rdwr_firmware(moal_handle *phandle, t_u8 doneflag,
 			return RDWR_STATUS_SUCCESS;
 	}
 #endif
-	for (tries = 0; tries < MAX_POLL_TRIES; tries++) {
+	/* The firmware usually answers within a few us, so back off from
+	 * an immediate re-read to DUMP_POLL_MAX_DELAY_US */
+	while (waited < DUMP_POLL_MAX_US) {
 		ret = woal_sdio_readb(phandle, dbg_dump_ctrl_reg, &ctrl_data);
 		if (ret) {
 			PRINTM(MERROR, "SDIO READ ERR\n");
@@ -2295,15 +2323,90 @@ static rdwr_status woal_cmd52_rdwr_firmware(moal_handle *phandle, t_u8 doneflag,
 				return RDWR_STATUS_FAILURE;
 			}
 		}
-		udelay(100);
+		if (delay)
+			udelay(delay);
+		waited += delay;
+		delay = delay ? MIN(delay * 2, DUMP_POLL_MAX_DELAY_US) : 1;
 	}
-	if (ctrl_data == debug_host_ready || tries == MAX_POLL_TRIES) {
+	if (ctrl_data == debug_host_ready || waited >= DUMP_POLL_MAX_US) {
 		PRINTM(MERROR, "Fail to pull ctrl_data\n");
 		return RDWR_STATUS_FAILURE;
 	}
 	return RDWR_STATUS_SUCCESS;
 }
 
+/**
+ *  @brief This function prepares the firmware dump window reader
+ *
+ *  @param phandle   A pointer to moal_handle
+ *  @param win       A pointer to sdio_dump_window
+ *
+ *  @return         MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status woal_sdio_dump_window_init(moal_handle *phandle,
+					      sdio_dump_window *win)
+{
+	memset(win, 0, sizeof(*win));
+	win->buf = kzalloc(DUMP_WINDOW_MAX, GFP_KERNEL);
+	if (!win->buf)
+		return MLAN_STATUS_FAILURE;
+	win->mode = DUMP_READ_PROBE;
+	woal_dump_stat_start(phandle, &win->stat);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function reads one firmware dump window into win->buf.
+ *         The window is read with one CMD53 once the first window read
+ *         that way is seen to match CMD52.
+ *
+ *  @param phandle   A pointer to moal_handle
+ *  @param win       A pointer to sdio_dump_window
+ *  @param reg       First register of the window
+ *  @param len       Length of the window
+ *  @param name      Name of the memory being dumped
+ *
+ *  @return         MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status woal_sdio_read_dump_window(moal_handle *phandle,
+					      sdio_dump_window *win, t_u32 reg,
+					      t_u32 len, t_u8 *name)
+{
+	struct sdio_func *func = ((sdio_mmc_card *)phandle->card)->func;
+	t_u8 val[DUMP_WINDOW_MAX];
+	t_u32 i;
+	int ret;
+
+	if (len > DUMP_WINDOW_MAX)
+		return MLAN_STATUS_FAILURE;
+	if (win->mode != DUMP_READ_CMD52) {
+		sdio_claim_host(func);
+		ret = sdio_memcpy_fromio(func, win->buf, reg, len);
+		sdio_release_host(func);
+		if (ret) {
+			PRINTM(MMSG, "FW dump: CMD53 read failed %d\n", ret);
+			win->mode = DUMP_READ_CMD52;
+		} else if (win->mode == DUMP_READ_CMD53) {
+			woal_dump_stat_add(phandle, &win->stat, len, MTRUE,
+					   name);
+			return MLAN_STATUS_SUCCESS;
+		}
+	}
+	for (i = 0; i < len; i++) {
+		if (woal_sdio_readb(phandle, reg + i, &val[i]))
+			return MLAN_STATUS_FAILURE;
+	}
+	if (win->mode == DUMP_READ_PROBE) {
+		win->mode = memcmp(val, win->buf, len) ? DUMP_READ_CMD52 :
+							 DUMP_READ_CMD53;
+		PRINTM(MMSG, "FW dump: window read by %s\n",
+		       win->mode == DUMP_READ_CMD53 ? "CMD53" : "CMD52");
+	}
+	moal_memcpy_ext(phandle, win->buf, val, len, DUMP_WINDOW_MAX);
+	woal_dump_stat_add(phandle, &win->stat, len, MFALSE, name);
+	return MLAN_STATUS_SUCCESS;
+}
+
 #ifdef SD8801
 #define DEBUG_HOST_READY 0xEE
 #define DEBUG_FW_DONE 0xFF
@@ -2580,7 +2683,7 @@ done:
 void woal_dump_firmware_info_v2(moal_handle *phandle)
 {
 	int ret = 0;
-	unsigned int reg, reg_start, reg_end;
+	unsigned int reg;
 	t_u8 *dbg_ptr = NULL;
 	t_u32 sec, usec;
 	t_u8 dump_num = 0;
@@ -2597,6 +2700,8 @@ void woal_dump_firmware_info_v2(moal_handle *phandle)
 	t_u8 dbg_dump_start_reg = 0;
 	t_u8 dbg_dump_end_reg = 0;
 	t_u8 dbg_dump_ctrl_reg = 0;
+	sdio_dump_window win;
+	t_u32 win_len, copy;
 
 	if (!phandle) {
 		PRINTM(MERROR, "Could not dump firmwware info\n");
@@ -2606,6 +2711,11 @@ void woal_dump_firmware_info_v2(moal_handle *phandle)
 	dbg_dump_start_reg = phandle->card_info->dump_fw_start_reg;
 	dbg_dump_end_reg = phandle->card_info->dump_fw_end_reg;
 	dbg_dump_ctrl_reg = phandle->card_info->dump_fw_ctrl_reg;
+	win_len = dbg_dump_end_reg - dbg_dump_start_reg + 1;
+	if (woal_sdio_dump_window_init(phandle, &win)) {
+		PRINTM(MERROR, "Failed to alloc fw dump window\n");
+		return;
+	}
 
 #ifdef DUMP_TO_PROC
 	if (!phandle->fw_dump_buf) {
@@ -2613,6 +2723,7 @@ void woal_dump_firmware_info_v2(moal_handle *phandle)
 				   &(phandle->fw_dump_buf));
 		if (ret != MLAN_STATUS_SUCCESS || !phandle->fw_dump_buf) {
 			PRINTM(MERROR, "Failed to vmalloc fw dump bufffer\n");
+			kfree(win.buf);
 			return;
 		}
 	} else {
@@ -2695,26 +2806,29 @@ void woal_dump_firmware_info_v2(moal_handle *phandle)
 		moal_get_system_time(phandle, &sec, &usec);
 		PRINTM(MMSG, "Start %s output %u.%06u, please wait...\n",
 		       mem_type_mapping_tbl[idx].mem_name, sec, usec);
+		woal_dump_stat_start(phandle, &win.stat);
 		do {
 			stat = woal_cmd52_rdwr_firmware(phandle, doneflag,
 							MFALSE);
 			if (RDWR_STATUS_FAILURE == stat)
 				goto done;
-			reg_start = dbg_dump_start_reg;
-			reg_end = dbg_dump_end_reg;
-			for (reg = reg_start; reg <= reg_end; reg++) {
-				ret = woal_sdio_readb(phandle, reg, dbg_ptr);
-				if (ret) {
-					PRINTM(MMSG, "SDIO READ ERR\n");
-					goto done;
-				}
-				if (dbg_ptr < end_ptr)
-					dbg_ptr++;
-				else
-					PRINTM(MINFO,
-					       "pre-allocced buf is not enough\n");
+			if (woal_sdio_read_dump_window(
+				    phandle, &win, dbg_dump_start_reg, win_len,
+				    mem_type_mapping_tbl[idx].mem_name)) {
+				PRINTM(MMSG, "SDIO READ ERR\n");
+				goto done;
 			}
+			copy = MIN(win_len, (t_u32)(end_ptr - dbg_ptr));
+			if (copy < win_len)
+				PRINTM(MINFO,
+				       "pre-allocced buf is not enough\n");
+			moal_memcpy_ext(phandle, dbg_ptr, win.buf, copy,
+					end_ptr - dbg_ptr);
+			dbg_ptr += copy;
 			if (RDWR_STATUS_DONE == stat) {
+				woal_dump_stat_done(
+					phandle, &win.stat,
+					mem_type_mapping_tbl[idx].mem_name);
 #ifdef MLAN_64BIT
 				PRINTM(MMSG,
 				       "%s done:"
@@ -2778,6 +2892,7 @@ done:
 			mem_type_mapping_tbl[idx].mem_Ptr = NULL;
 		}
 	}
+	kfree(win.buf);
 	PRINTM(MMSG, "==== DEBUG MODE END ====\n");
 	return;
 }
@@ -2811,7 +2926,7 @@ void woal_dump_firmware_info_v3(moal_handle *phandle)
 {
 	int ret = 0;
 	int tries = 0;
-	unsigned int reg, reg_start, reg_end;
+	unsigned int reg;
 	t_u8 *dbg_ptr = NULL;
 	t_u8 *temp_Ptr = NULL;
 	t_u32 sec, usec;
@@ -2828,6 +2943,10 @@ void woal_dump_firmware_info_v3(moal_handle *phandle)
 	t_u8 dbg_dump_end_reg = 0;
 	memory_type_mapping *pmem_type_mapping_tbl =
 		&mem_type_mapping_tbl_8977_8997;
+	sdio_dump_window win;
+	t_u32 win_len, offset;
+
+	memset(&win, 0, sizeof(win));
 
 	if (!phandle) {
 		PRINTM(MERROR, "Could not dump firmwware info\n");
@@ -2914,6 +3033,11 @@ void woal_dump_firmware_info_v3(moal_handle *phandle)
 	dbg_ptr = pmem_type_mapping_tbl->mem_Ptr;
 	end_ptr = dbg_ptr + memory_size;
 	doneflag = pmem_type_mapping_tbl->done_flag;
+	win_len = dbg_dump_end_reg - dbg_dump_start_reg + 1;
+	if (woal_sdio_dump_window_init(phandle, &win)) {
+		PRINTM(MERROR, "Failed to alloc fw dump window\n");
+		goto done;
+	}
 	moal_get_system_time(phandle, &sec, &usec);
 	PRINTM(MMSG, "Start %s output %u.%06u, please wait...\n",
 	       pmem_type_mapping_tbl->mem_name, sec, usec);
@@ -2921,45 +3045,40 @@ void woal_dump_firmware_info_v3(moal_handle *phandle)
 		stat = woal_cmd52_rdwr_firmware(phandle, doneflag, MFALSE);
 		if (RDWR_STATUS_FAILURE == stat)
 			goto done;
-		reg_start = dbg_dump_start_reg;
-		reg_end = dbg_dump_end_reg;
-		for (reg = reg_start; reg <= reg_end; reg++) {
-			ret = woal_sdio_readb(phandle, reg, dbg_ptr);
-			if (ret) {
-				PRINTM(MMSG, "SDIO READ ERR\n");
+		if (dbg_ptr + win_len > end_ptr) {
+			PRINTM(MINFO, "pre-allocced buf is not enough\n");
+			/* Double the buffer rather than growing it by a fixed
+			 * step, which copies the whole dump again and again */
+			offset = dbg_ptr - pmem_type_mapping_tbl->mem_Ptr;
+			ret = moal_vmalloc(phandle, memory_size * 2 + 1,
+					   (t_u8 **)&temp_Ptr);
+			if ((ret != MLAN_STATUS_SUCCESS) || !temp_Ptr) {
+				PRINTM(MERROR,
+				       "Error: vmalloc  buffer failed!!!\n");
 				goto done;
 			}
-			dbg_ptr++;
-			if (dbg_ptr >= end_ptr) {
-				PRINTM(MINFO,
-				       "pre-allocced buf is not enough\n");
-
-				ret = moal_vmalloc(phandle,
-						   memory_size + 0x2000 + 1,
-						   (t_u8 **)&temp_Ptr);
-				if ((ret != MLAN_STATUS_SUCCESS) || !temp_Ptr) {
-					PRINTM(MERROR,
-					       "Error: vmalloc  buffer failed!!!\n");
-					goto done;
-				}
-
-				moal_memcpy_ext(phandle, temp_Ptr,
-						pmem_type_mapping_tbl->mem_Ptr,
-						memory_size,
-						memory_size + 0x2000);
-				moal_vfree(phandle,
-					   pmem_type_mapping_tbl->mem_Ptr);
-				pmem_type_mapping_tbl->mem_Ptr = temp_Ptr;
-				temp_Ptr = NULL;
-				dbg_ptr = pmem_type_mapping_tbl->mem_Ptr +
-					  memory_size;
-
-				memory_size += 0x2000;
-				end_ptr = pmem_type_mapping_tbl->mem_Ptr +
-					  memory_size;
-			}
+			moal_memcpy_ext(phandle, temp_Ptr,
+					pmem_type_mapping_tbl->mem_Ptr, offset,
+					memory_size * 2);
+			moal_vfree(phandle, pmem_type_mapping_tbl->mem_Ptr);
+			pmem_type_mapping_tbl->mem_Ptr = temp_Ptr;
+			temp_Ptr = NULL;
+			memory_size *= 2;
+			dbg_ptr = pmem_type_mapping_tbl->mem_Ptr + offset;
+			end_ptr = pmem_type_mapping_tbl->mem_Ptr + memory_size;
+		}
+		if (woal_sdio_read_dump_window(phandle, &win,
+					       dbg_dump_start_reg, win_len,
+					       pmem_type_mapping_tbl->mem_name)) {
+			PRINTM(MMSG, "SDIO READ ERR\n");
+			goto done;
 		}
+		moal_memcpy_ext(phandle, dbg_ptr, win.buf, win_len,
+				end_ptr - dbg_ptr);
+		dbg_ptr += win_len;
 		if (RDWR_STATUS_DONE == stat) {
+			woal_dump_stat_done(phandle, &win.stat,
+					    pmem_type_mapping_tbl->mem_name);
 #ifdef MLAN_64BIT
 			PRINTM(MMSG,
 			       "%s done:"
@@ -3018,6 +3137,7 @@ done:
 		moal_vfree(phandle, pmem_type_mapping_tbl->mem_Ptr);
 		pmem_type_mapping_tbl->mem_Ptr = NULL;
 	}
+	kfree(win.buf);
 	PRINTM(MMSG, "==== DEBUG MODE END ====\n");
 	return;
 }
@@ -44,6 +44,7 @@ Change log:
 #include "moal_cfg80211_util.h"
 #endif
 #include <asm/div64.h>
+#include <linux/timex.h>
 
 #if defined(PCIE) || defined(SDIO)
 #if LINUX_VERSION_CODE < KERNEL_VERSION(5, 4, 70)
@@ -61,16 +62,12 @@ Change log:
 
 #define NXP_ETH_P_WAPI 0x88B4
 
+/* moal_lock is shared with the inline MLAN OS layer */
+#include "mlan_os.h"
+
 /********************************************************
 		Local Variables
 ********************************************************/
-/** moal_lock */
-typedef struct _moal_lock {
-	/** Lock */
-	spinlock_t lock;
-	/** Flags */
-	unsigned long flags;
-} moal_lock;
 
 /********************************************************
 		Global Variables
@@ -695,6 +692,104 @@ mlan_status moal_spin_unlock(t_void *pmoal, t_void *plock)
 	return MLAN_STATUS_SUCCESS;
 }
 
+/** Number of lock/unlock pairs timed by moal_tp_lock_calibrate */
+#define TP_LOCK_CALIBRATE_OPS 1000
+
+/**
+ *  @brief Measure the cost of an MLAN lock/unlock pair through the
+ *         callback table and through the inline OS layer, so the tp
+ *         accounting can turn lock op counts into cycles per packet
+ *
+ *  @param handle   A pointer to moal_handle
+ *
+ *  @return         N/A
+ */
+void moal_tp_lock_calibrate(moal_handle *handle)
+{
+	mlan_status (*volatile lock_cb)(t_void *, t_void *) = moal_spin_lock;
+	mlan_status (*volatile unlock_cb)(t_void *, t_void *) =
+		moal_spin_unlock;
+	moal_lock lock;
+	cycles_t start;
+	int i;
+
+	spin_lock_init(&lock.lock);
+	start = get_cycles();
+	for (i = 0; i < TP_LOCK_CALIBRATE_OPS; i++) {
+		lock_cb(handle, &lock);
+		unlock_cb(handle, &lock);
+	}
+	handle->tp_acnt.lock_cycles_cb = get_cycles() - start;
+
+	start = get_cycles();
+	for (i = 0; i < TP_LOCK_CALIBRATE_OPS; i++) {
+		mlan_os_spin_lock(handle, &lock);
+		mlan_os_spin_unlock(handle, &lock);
+	}
+	handle->tp_acnt.lock_cycles_inline = get_cycles() - start;
+}
+
+/*
+ * mlan_scalar values are plain t_s32, which has the same layout as
+ * atomic_t, so the counter can be handed to the native atomics directly.
+ */
+
+/**
+ *  @brief Atomically add to a counter
+ *
+ *  @param pmoal Pointer to the MOAL context
+ *  @param pval     Pointer to the counter
+ *  @param i        Value to add
+ *
+ *  @return         New value of the counter
+ */
+t_s32 moal_atomic_add(t_void *pmoal, t_s32 *pval, t_s32 i)
+{
+	return atomic_add_return(i, (atomic_t *)pval);
+}
+
+/**
+ *  @brief Atomically subtract from a counter
+ *
+ *  @param pmoal Pointer to the MOAL context
+ *  @param pval     Pointer to the counter
+ *  @param i        Value to subtract
+ *
+ *  @return         New value of the counter
+ */
+t_s32 moal_atomic_sub(t_void *pmoal, t_s32 *pval, t_s32 i)
+{
+	return atomic_sub_return(i, (atomic_t *)pval);
+}
+
+/**
+ *  @brief Read a counter
+ *
+ *  @param pmoal Pointer to the MOAL context
+ *  @param pval     Pointer to the counter
+ *
+ *  @return         Value of the counter
+ */
+t_s32 moal_atomic_read(t_void *pmoal, t_s32 *pval)
+{
+	return atomic_read((atomic_t *)pval);
+}
+
+/**
+ *  @brief Atomically compare and exchange a counter
+ *
+ *  @param pmoal Pointer to the MOAL context
+ *  @param pval     Pointer to the counter
+ *  @param old      Expected value
+ *  @param new_val  Value to store if the counter equals old
+ *
+ *  @return         Value of the counter before the operation
+ */
+t_s32 moal_atomic_cmpxchg(t_void *pmoal, t_s32 *pval, t_s32 old, t_s32 new_val)
+{
+	return atomic_cmpxchg((atomic_t *)pval, old, new_val);
+}
+
 /**
  *  @brief  This function collects AMSDU TP statistics.
  *
@@ -717,6 +812,162 @@ void moal_amsdu_tp_accounting(t_void *pmoal, t_s32 amsdu_process_delay,
 		handle->tp_acnt.rx_amsdu_index = 0;
 }
 
+/**
+ *  @brief Add a sample to a latency histogram
+ *
+ *  @param hist     Pointer to the histogram
+ *  @param ns       Latency in ns
+ *
+ *  @return         N/A
+ */
+void moal_lat_hist_add(moal_lat_hist *hist, t_u64 ns)
+{
+	t_u32 idx, exp;
+
+	if (ns < LAT_HIST_SUB) {
+		idx = (t_u32)ns;
+	} else {
+		exp = fls64(ns) - 1;
+		if (exp > LAT_HIST_MAX_EXP)
+			idx = LAT_HIST_BUCKETS - 1;
+		else
+			idx = (exp - LAT_HIST_SUB_BITS + 1) * LAT_HIST_SUB +
+			      (t_u32)((ns >> (exp - LAT_HIST_SUB_BITS)) &
+				      (LAT_HIST_SUB - 1));
+	}
+	hist->bucket[idx]++;
+	hist->count++;
+	hist->sum += ns;
+	if (ns > hist->max)
+		hist->max = ns;
+}
+
+/**
+ *  @brief Add the samples of one latency histogram to another
+ *
+ *  @param dst      Pointer to the histogram to add to
+ *  @param src      Pointer to the histogram to add
+ *
+ *  @return         N/A
+ */
+void moal_lat_hist_merge(moal_lat_hist *dst, moal_lat_hist *src)
+{
+	t_u32 i;
+
+	for (i = 0; i < LAT_HIST_BUCKETS; i++)
+		dst->bucket[i] += READ_ONCE(src->bucket[i]);
+	dst->count += READ_ONCE(src->count);
+	dst->sum += READ_ONCE(src->sum);
+	dst->max = MAX(dst->max, READ_ONCE(src->max));
+}
+
+/**
+ *  @brief Get a percentile of a latency histogram, the upper bound of
+ *  the bucket it falls in, so at most 1/8 above the real value
+ *
+ *  @param hist     Pointer to the histogram
+ *  @param permille Percentile in 1/1000, e.g. 990 for p99
+ *
+ *  @return         Latency in ns
+ */
+t_u64 moal_lat_hist_percentile(moal_lat_hist *hist, t_u32 permille)
+{
+	t_u64 rank, seen = 0, bound;
+	t_u32 i, group;
+
+	if (!hist->count)
+		return 0;
+	rank = moal_do_div(hist->count * permille + 999, 1000);
+	for (i = 0; i < LAT_HIST_BUCKETS; i++) {
+		seen += hist->bucket[i];
+		if (seen < rank)
+			continue;
+		group = i / LAT_HIST_SUB;
+		if (!group)
+			bound = i + 1;
+		else
+			bound = (t_u64)(LAT_HIST_SUB + i % LAT_HIST_SUB + 1)
+				<< (group - 1);
+		return MIN(bound, hist->max);
+	}
+	return hist->max;
+}
+
+/** 802.1D user priority to AC index in the BK, BE, VI, VO order */
+static const t_u8 tx_lat_up_to_ac[] = {1, 0, 0, 1, 2, 2, 3, 3};
+
+/**
+ *  @brief Record the latency of a traced packet at TX done
+ *
+ *  @param handle   Pointer to the moal_handle
+ *  @param pmbuf    Pointer to the mlan_buffer
+ *
+ *  @return         N/A
+ */
+static void moal_tx_lat_record(moal_handle *handle, pmlan_buffer pmbuf)
+{
+	moal_tx_lat *tx_lat = handle->tx_lat;
+	t_u64 *ts = pmbuf->tx_lat_ts;
+	moal_lat_hist *hist;
+	t_u64 now = 0, end;
+	unsigned long flags;
+	int i;
+
+	if (!tx_lat || !tx_lat->on)
+		return;
+	moal_get_boot_ktime(handle, &now);
+	/* Each CPU has its own histograms, only irqs can race with us */
+	local_irq_save(flags);
+	hist = tx_lat->cpu[smp_processor_id()]
+		       .hist[tx_lat_up_to_ac[pmbuf->priority & 0x7]];
+	/* Trace points the packet skipped are 0, their intervals too */
+	for (i = 0; i < MLAN_TX_LAT_STAGES; i++) {
+		end = (i + 1 < MLAN_TX_LAT_STAGES) ? ts[i + 1] : now;
+		if (ts[i] && end >= ts[i])
+			moal_lat_hist_add(&hist[i], end - ts[i]);
+	}
+	if (now >= ts[MLAN_TX_LAT_XMIT])
+		moal_lat_hist_add(&hist[TX_LAT_TOTAL],
+				  now - ts[MLAN_TX_LAT_XMIT]);
+	local_irq_restore(flags);
+}
+
+/**
+ *  @brief Record the latency of a traced packet handed to the stack
+ *
+ *  @param handle   Pointer to the moal_handle
+ *  @param pmbuf    Pointer to the mlan_buffer
+ *
+ *  @return         N/A
+ */
+static void moal_rx_lat_record(moal_handle *handle, pmlan_buffer pmbuf)
+{
+	moal_rx_lat *rx_lat = handle->rx_lat;
+	t_u64 *ts = pmbuf->rx_lat_ts;
+	moal_lat_hist *hist;
+	t_u64 now = 0, end;
+	unsigned long flags;
+	int i;
+
+	if (!rx_lat || !rx_lat->on)
+		return;
+	moal_get_boot_ktime(handle, &now);
+	/* Each CPU has its own histograms, only irqs can race with us */
+	local_irq_save(flags);
+	hist = rx_lat->cpu[smp_processor_id()]
+		       .hist[pmbuf->rx_lat_tid & (MAX_NUM_TID - 1)];
+	/* Trace points the packet skipped are 0, their intervals too */
+	for (i = 0; i < MLAN_RX_LAT_STAGES; i++) {
+		end = (i + 1 < MLAN_RX_LAT_STAGES) ? ts[i + 1] : now;
+		if (ts[i] && end >= ts[i])
+			moal_lat_hist_add(&hist[i], end - ts[i]);
+	}
+	if (ts[MLAN_RX_LAT_INT] && now >= ts[MLAN_RX_LAT_INT])
+		moal_lat_hist_add(&hist[RX_LAT_TOTAL],
+				  now - ts[MLAN_RX_LAT_INT]);
+	local_irq_restore(flags);
+}
+
 /**
  *  @brief  This function collects TP statistics.
  *
@@ -801,6 +1052,8 @@ void moal_tp_accounting(t_void *pmoal, void *buf, t_u32 drop_point)
 		handle->tp_acnt.tx_index++;
 		if (handle->tp_acnt.tx_index >= TXRX_MAX_SAMPLE)
 			handle->tp_acnt.tx_index = 0;
+	} else if (drop_point == TX_LAT_PKT) {
+		moal_tx_lat_record(handle, pmbuf);
 	}
 }
 
@@ -838,12 +1091,79 @@ void moal_tp_accounting_rx_param(t_void *pmoal, unsigned int type,
 	case 8: // tx stop queue count
 		phandle->tp_acnt.tx_stop_queue_cnt++;
 		break;
+	case 9: // mlan data path lock ops
+		phandle->tp_acnt.lock_ops += rsvd1;
+		break;
 
 	default:
 		break;
 	}
 }
 
+/**
+ *  @brief This function checks if MLAN may rewrite the head of a tx
+ *         buffer in place: the skb data must not be shared with a
+ *         clone that still reads it
+ *
+ *  @param pmoal        Pointer to the MOAL context
+ *  @param pmbuf        Pointer to the mlan buffer structure
+ *  @param len          Bytes from the data offset MLAN writes to
+ *
+ *  @return             MTRUE or MFALSE
+ */
+t_u8 moal_buf_writable(t_void *pmoal, pmlan_buffer pmbuf, t_u32 len)
+{
+	struct sk_buff *skb = (struct sk_buff *)pmbuf->pdesc;
+
+	if (!skb || skb_headlen(skb) < len)
+		return MFALSE;
+	if (skb_cloned(skb) && !skb_clone_writable(skb, len))
+		return MFALSE;
+	return MTRUE;
+}
+
+/**
+ *  @brief This function queues a reordered rx packet to the shard
+ *         owning its flow; the shard worker runs the late rx stage
+ *
+ *  @param pmoal        Pointer to the MOAL context
+ *  @param flow         Flow id derived from TA/TID
+ *  @param pmbuf        Pointer to the mlan buffer structure
+ *
+ *  @return             MLAN_STATUS_SUCCESS, MLAN_STATUS_RESOURCE if the
+ *                      shard is full and MLAN must drop the packet, or
+ *                      MLAN_STATUS_FAILURE to have MLAN process it inline
+ */
+mlan_status moal_rx_late_queue(t_void *pmoal, t_u32 flow, pmlan_buffer pmbuf)
+{
+	moal_handle *handle = (moal_handle *)pmoal;
+	struct moal_rx_shard *shard;
+	unsigned long flags;
+
+	if (!handle->rx_shard_workqueue || !handle->rx_shard_num)
+		return MLAN_STATUS_FAILURE;
+
+	shard = &handle->rx_shard[flow % handle->rx_shard_num];
+	pmbuf->pnext = NULL;
+	spin_lock_irqsave(&shard->lock, flags);
+	if (shard->pending >= RX_SHARD_MAX_PENDING) {
+		/* The worker is not keeping up, bound the list. Running the
+		 * packet inline would let it overtake the queued ones. */
+		shard->rx_overflow++;
+		spin_unlock_irqrestore(&shard->lock, flags);
+		return MLAN_STATUS_RESOURCE;
+	}
+	shard->pending++;
+	if (shard->ptail)
+		shard->ptail->pnext = pmbuf;
+	else
+		shard->phead = pmbuf;
+	shard->ptail = pmbuf;
+	spin_unlock_irqrestore(&shard->lock, flags);
+	queue_work_on(shard->cpu, handle->rx_shard_workqueue, &shard->work);
+	return MLAN_STATUS_SUCCESS;
+}
+
 /**
  *  @brief This function reads one block of firmware data from MOAL
  *
@@ -861,6 +1181,10 @@ mlan_status moal_get_fw_data(t_void *pmoal, t_u32 offset, t_u32 len, t_u8 *pbuf)
 	if (!pbuf || !len || !handle->firmware)
 		return MLAN_STATUS_FAILURE;
 
+#ifdef FW_XZ
+	if (handle->fw_xz)
+		return woal_fw_xz_read(handle, offset, len, pbuf);
+#endif
 	if (offset + len > handle->firmware->size)
 		return MLAN_STATUS_FAILURE;
 
@@ -884,26 +1208,47 @@ mlan_status moal_get_vdll_data(t_void *pmoal, t_u32 len, t_u8 *pbuf)
 	moal_handle *handle = (moal_handle *)pmoal;
 	mlan_status status = MLAN_STATUS_FAILURE;
 	t_u32 offset = 0;
+	t_u32 fw_len;
 	t_u8 req_fw = MFALSE;
 
 	if (!handle->firmware) {
 		req_fw = MTRUE;
-		woal_vdll_req_fw(handle);
+		handle->firmware =
+			woal_fw_cache_get(handle->drv_mode.fw_name);
+		if (!handle->firmware) {
+			woal_vdll_req_fw(handle);
+			woal_fw_cache_add(handle->drv_mode.fw_name,
+					  handle->firmware);
+		}
 	}
 
 	if (handle->firmware) {
-		if (len < handle->firmware->size) {
-			offset = handle->firmware->size - len;
-			moal_memcpy_ext(handle, pbuf,
-					handle->firmware->data + offset, len,
-					len);
-			status = MLAN_STATUS_SUCCESS;
+		fw_len = handle->firmware->size;
+#ifdef FW_XZ
+		/* VDLL is the tail of the decompressed image */
+		if (woal_fw_is_xz(handle->firmware))
+			fw_len = woal_fw_xz_len(handle->firmware);
+#endif
+		if (len < fw_len) {
+			offset = fw_len - len;
+#ifdef FW_XZ
+			if (woal_fw_is_xz(handle->firmware))
+				status = woal_fw_xz_copy(handle->firmware,
+							 offset, len, pbuf);
+			else
+#endif
+			{
+				moal_memcpy_ext(handle, pbuf,
+						handle->firmware->data + offset,
+						len, len);
+				status = MLAN_STATUS_SUCCESS;
+			}
 		} else {
 			PRINTM(MERROR, "Invalid VDLL length = %d, fw_len=%d\n",
-			       len, (int)handle->firmware->size);
+			       len, (int)fw_len);
 		}
 		if (req_fw) {
-			release_firmware(handle->firmware);
+			woal_release_fw(handle->firmware);
 			handle->firmware = NULL;
 		}
 	}
@@ -1199,7 +1544,10 @@ mlan_status moal_send_packet_complete(t_void *pmoal, pmlan_buffer pmbuf,
 		if (priv) {
 			woal_set_trans_start(priv->netdev);
 			if (skb) {
-				if (status == MLAN_STATUS_SUCCESS) {
+				if (pmbuf->flags &
+				    MLAN_BUF_FLAG_TCP_ACK_COALESCED) {
+					woal_tcp_ack_coalesced(priv, skb);
+				} else if (status == MLAN_STATUS_SUCCESS) {
 					priv->stats.tx_packets++;
 					priv->stats.tx_bytes += skb->len;
 #if defined(STA_CFG80211) || defined(UAP_CFG80211)
@@ -1230,10 +1578,19 @@ mlan_status moal_send_packet_complete(t_void *pmoal, pmlan_buffer pmbuf,
 #if LINUX_VERSION_CODE > KERNEL_VERSION(2, 6, 29)
 				index = skb_get_queue_mapping(skb);
 				if (index < 4) {
+					int pending;
+
 					atomic_dec(&handle->tx_pending);
-					if (atomic_dec_return(
-						    &priv->wmm_tx_pending[index]) ==
-					    priv->low_tx_pending) {
+					pending = atomic_dec_return(
+						&priv->wmm_tx_pending[index]);
+					/* Below the low mark, retry a queue
+					 * a station over its tx_aqm limit
+					 * holds until the station drains */
+					if ((pending == priv->low_tx_pending ||
+					     (pending < priv->low_tx_pending &&
+					      woal_tx_aqm_overlimit(priv,
+								    index))) &&
+					    woal_tx_aqm_can_wake(priv, index)) {
 						struct netdev_queue *txq =
 							netdev_get_tx_queue(
 								priv->netdev,
@@ -1504,6 +1861,60 @@ t_u8 ru_signal_106[14][9] = {
 	{0xff, 0x01, 0xff, 0x01, 0xff, 0x01, 0xff, 0x01, 0x04}};
 
 t_u8 ru_signal_52[9] = {0xff, 0x01, 0xff, 0x01, 0xff, 0x01, 0xff, 0x01, 0x04};
+
+/**
+ *  @brief This function rebuilds the cached radiotap channel field of the
+ * monitor interface
+ *
+ *  @param mon_if   A pointer to monitor_iface
+ *  @param chan_num Channel number
+ *  @param band     IEEE80211_BAND_2GHZ or IEEE80211_BAND_5GHZ
+ *
+ *  @return         N/A
+ */
+static void moal_mon_update_rt_channel(monitor_iface *mon_if, t_u8 chan_num,
+				       t_u8 band)
+{
+	struct ieee80211_channel *chan = mon_if->chandef.chan;
+	t_u16 flags;
+
+	if (band == IEEE80211_BAND_2GHZ)
+		flags = CHANNEL_FLAGS_2GHZ | CHANNEL_FLAGS_DYNAMIC_CCK_OFDM;
+	else
+		flags = CHANNEL_FLAGS_5GHZ | CHANNEL_FLAGS_OFDM;
+	if (chan && (chan->flags &
+		     (IEEE80211_CHAN_PASSIVE_SCAN | IEEE80211_CHAN_RADAR)))
+		flags |= CHANNEL_FLAGS_ONLY_PASSIVSCAN_ALLOW;
+	mon_if->rt_channel.frequency =
+		woal_cpu_to_le16(ieee80211_channel_to_frequency(chan_num, band));
+	mon_if->rt_channel.flags = woal_cpu_to_le16(flags);
+	mon_if->rt_chan_num = chan_num;
+	mon_if->rt_band = band;
+	mon_if->rt_chan = chan;
+	mon_if->rt_chan_flags = chan ? chan->flags : 0;
+}
+
+/**
+ *  @brief This function checks if the cached radiotap channel field of the
+ * monitor interface is still valid
+ *
+ *  @param mon_if   A pointer to monitor_iface
+ *  @param chan_num Channel number
+ *  @param band     IEEE80211_BAND_2GHZ or IEEE80211_BAND_5GHZ
+ *
+ *  @return         MTRUE or MFALSE
+ */
+static t_u8 moal_mon_rt_channel_valid(monitor_iface *mon_if, t_u8 chan_num,
+				      t_u8 band)
+{
+	struct ieee80211_channel *chan = mon_if->chandef.chan;
+
+	/* Regulatory and DFS updates change the flags of the same channel */
+	return mon_if->rt_chan_num == chan_num && mon_if->rt_band == band &&
+	       mon_if->rt_chan == chan &&
+	       (!chan || mon_if->rt_chan_flags == chan->flags);
+}
+
 /**
  *  @brief This function uploads the packet to the network stack monitor
  * interface
@@ -1575,19 +1986,13 @@ static mlan_status moal_recv_packet_to_mon_if(moal_handle *handle,
 			mcs = rt_info.rate_info.mcs_index;
 			nss = rt_info.rate_info.nss_index;
 
+			/* Build the header in the headroom in front of the
+			 * frame, starting from the template of the format */
 			skb_push(skb, sizeof(*rth));
 			rth = (struct radiotap_header *)skb->data;
-			memset(skb->data, 0, sizeof(*rth));
-			rth->hdr.it_version = PKTHDR_RADIOTAP_VERSION;
-			rth->hdr.it_pad = 0;
-			rth->hdr.it_len = cpu_to_le16(sizeof(*rth));
-			rth->hdr.it_present = cpu_to_le32(
-				(1 << IEEE80211_RADIOTAP_TSFT) |
-				(1 << IEEE80211_RADIOTAP_FLAGS) |
-				(1 << IEEE80211_RADIOTAP_CHANNEL) |
-				(1 << IEEE80211_RADIOTAP_DBM_ANTSIGNAL) |
-				(1 << IEEE80211_RADIOTAP_DBM_ANTNOISE) |
-				(1 << IEEE80211_RADIOTAP_ANTENNA));
+			moal_memcpy_ext(handle, rth,
+					&handle->mon_if->rt_tmpl[format],
+					sizeof(*rth), sizeof(*rth));
 			/** Timstamp */
 			rth->body.timestamp = woal_cpu_to_le64(jiffies);
 			/** Flags */
@@ -1624,13 +2029,9 @@ static mlan_status moal_recv_packet_to_mon_if(moal_handle *handle,
 						RADIOTAP_FLAGS_WEP_ENCRYPTION;
 			}
 			/** Rate, t_u8 only apply for LG mode */
-			if (format == MLAN_RATE_FORMAT_LG) {
-				rth->hdr.it_present |= cpu_to_le32(
-					1 << IEEE80211_RADIOTAP_RATE);
+			if (format == MLAN_RATE_FORMAT_LG)
 				rth->body.rate = rt_info.rate_info.bitrate;
-			}
 			/** Channel */
-			rth->body.channel.flags = 0;
 			if (rt_info.chan_num &&
 			    (handle->mon_if->band_chan_cfg.channel !=
 			     rt_info.chan_num))
@@ -1644,25 +2045,11 @@ static mlan_status moal_recv_packet_to_mon_if(moal_handle *handle,
 			if (handle->mon_if->band_chan_cfg.band != band)
 				handle->mon_if->band_chan_cfg.band = band;
 
-			rth->body.channel.frequency = woal_cpu_to_le16(
-				ieee80211_channel_to_frequency(chan_num, band));
-			rth->body.channel.flags |=
-				woal_cpu_to_le16((band == IEEE80211_BAND_2GHZ) ?
-							 CHANNEL_FLAGS_2GHZ :
-							 CHANNEL_FLAGS_5GHZ);
-			if (rth->body.channel.flags &
-			    woal_cpu_to_le16(CHANNEL_FLAGS_2GHZ))
-				rth->body.channel.flags |= woal_cpu_to_le16(
-					CHANNEL_FLAGS_DYNAMIC_CCK_OFDM);
-			else
-				rth->body.channel.flags |=
-					woal_cpu_to_le16(CHANNEL_FLAGS_OFDM);
-			if (handle->mon_if->chandef.chan &&
-			    (handle->mon_if->chandef.chan->flags &
-			     (IEEE80211_CHAN_PASSIVE_SCAN |
-			      IEEE80211_CHAN_RADAR)))
-				rth->body.channel.flags |= woal_cpu_to_le16(
-					CHANNEL_FLAGS_ONLY_PASSIVSCAN_ALLOW);
+			if (!moal_mon_rt_channel_valid(handle->mon_if,
+						       chan_num, band))
+				moal_mon_update_rt_channel(handle->mon_if,
+							   chan_num, band);
+			rth->body.channel = handle->mon_if->rt_channel;
 			/** Antenna */
 			rth->body.antenna_signal = -(rt_info.nf - rt_info.snr);
 			rth->body.antenna_noise = -rt_info.nf;
@@ -1670,8 +2057,6 @@ static mlan_status moal_recv_packet_to_mon_if(moal_handle *handle,
 			rth->body.antenna = (t_u16)rt_info.antenna >> 1;
 			/** MCS */
 			if (format == MLAN_RATE_FORMAT_HT) {
-				rth->hdr.it_present |= cpu_to_le32(
-					1 << IEEE80211_RADIOTAP_MCS);
 				rth->body.u.mcs.known =
 					rt_info.extra_info.mcs_known;
 				rth->body.u.mcs.flags =
@@ -1704,45 +2089,30 @@ static mlan_status moal_recv_packet_to_mon_if(moal_handle *handle,
 			if (format == MLAN_RATE_FORMAT_VHT) {
 				vht_sig1 = rt_info.extra_info.vht_he_sig1;
 				vht_sig2 = rt_info.extra_info.vht_he_sig2;
-				/** Present Flag */
-				rth->hdr.it_present |= cpu_to_le32(
-					1 << IEEE80211_RADIOTAP_VHT);
 				/** STBC */
-				rth->body.u.vht.known |=
-					woal_cpu_to_le16(VHT_KNOWN_STBC);
 				if (vht_sig1 & MBIT(3))
 					rth->body.u.vht.flags |= VHT_FLAG_STBC;
 				/** TXOP_PS_NA */
 				/** TODO: Not support now */
 				/** GI */
-				rth->body.u.vht.known |=
-					woal_cpu_to_le16(VHT_KNOWN_GI);
 				if (vht_sig2 & MBIT(0))
 					rth->body.u.vht.flags |= VHT_FLAG_SGI;
 				/** SGI NSYM DIS */
-				rth->body.u.vht.known |= woal_cpu_to_le16(
-					VHT_KNOWN_SGI_NSYM_DIS);
 				if (vht_sig2 & MBIT(1))
 					rth->body.u.vht.flags |=
 						VHT_FLAG_SGI_NSYM_M10_9;
 				/** LDPC_EXTRA_OFDM_SYM */
 				/** TODO: Not support now */
 				/** BEAMFORMED */
-				rth->body.u.vht.known |=
-					woal_cpu_to_le16(VHT_KNOWN_BEAMFORMED);
 				if (vht_sig2 & MBIT(8))
 					rth->body.u.vht.flags |=
 						VHT_FLAG_BEAMFORMED;
 				/** BANDWIDTH */
-				rth->body.u.vht.known |=
-					woal_cpu_to_le16(VHT_KNOWN_BANDWIDTH);
 				if (bw == 1)
 					rth->body.u.vht.bandwidth = RX_BW_40;
 				else if (bw == 2)
 					rth->body.u.vht.bandwidth = RX_BW_80;
 				/** GROUP_ID */
-				rth->body.u.vht.known |=
-					woal_cpu_to_le16(VHT_KNOWN_GROUP_ID);
 				rth->body.u.vht.group_id =
 					(vht_sig1 & (0x3F0)) >> 4;
 				/** PARTIAL_AID */
@@ -1753,8 +2123,6 @@ static mlan_status moal_recv_packet_to_mon_if(moal_handle *handle,
 				rth->body.u.vht.mcs_nss[0] |=
 					((vht_sig1 & (0x1C00)) >> 10) + 1;
 				/** gi */
-				rth->body.u.vht.known |=
-					woal_cpu_to_le16(VHT_KNOWN_GI);
 				if (gi)
 					rth->body.u.vht.flags |= VHT_FLAG_SGI;
 				/** coding */
@@ -1766,13 +2134,9 @@ static mlan_status moal_recv_packet_to_mon_if(moal_handle *handle,
 				he_sig1 = rt_info.extra_info.vht_he_sig1;
 				he_sig2 = rt_info.extra_info.vht_he_sig2;
 				usr_idx = rt_info.extra_info.user_idx;
-				rth->hdr.it_present |=
-					cpu_to_le32(1 << IEEE80211_RADIOTAP_HE);
-				rth->body.u.he.data1 |= (HE_CODING_KNOWN);
 				if (ldpc)
 					rth->body.u.he.data3 |=
 						HE_CODING_LDPC_USER0;
-				rth->body.u.he.data1 |= (HE_BW_KNOWN);
 				if (he_sig1)
 					rth->body.u.he.data1 |= (HE_MU_DATA);
 				if (bw == 1) {
@@ -1904,13 +2268,10 @@ static mlan_status moal_recv_packet_to_mon_if(moal_handle *handle,
 					}
 				}
 
-				rth->body.u.he.data2 |= (HE_DATA_GI_KNOWN);
 				rth->body.u.he.data5 |= ((gi & 3) << 4);
-				rth->body.u.he.data1 |= (HE_MCS_KNOWN);
 
 				rth->body.u.he.data3 |= (mcs << 8);
 				rth->body.u.he.data6 |= nss;
-				rth->body.u.he.data1 |= (HE_DCM_KNOWN);
 				rth->body.u.he.data1 =
 					cpu_to_le16(rth->body.u.he.data1);
 				rth->body.u.he.data5 |= (dcm << 12);
@@ -1927,17 +2288,22 @@ static mlan_status moal_recv_packet_to_mon_if(moal_handle *handle,
 		memset(skb->cb, 0, sizeof(skb->cb));
 		skb->dev = handle->mon_if->mon_ndev;
 
+		/* woal_mon_close purges mon_rx_q once the device is down,
+		 * so a frame queued after that would sit there until the
+		 * next open */
+		if (!netif_running(handle->mon_if->mon_ndev)) {
+			status = MLAN_STATUS_FAILURE;
+			handle->mon_if->stats.rx_dropped++;
+			goto done;
+		}
 		handle->mon_if->stats.rx_bytes += skb->len;
 		handle->mon_if->stats.rx_packets++;
 
-		if (in_interrupt())
-			netif_rx(skb);
-		else
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 17, 0)
-			netif_rx(skb);
-#else
-			netif_rx_ni(skb);
-#endif
+		/* Delivered at the end of the Rx pass, or once a batch is
+		 * full */
+		skb_queue_tail(&handle->mon_rx_q, skb);
+		if (skb_queue_len(&handle->mon_rx_q) >= MON_RX_BATCH)
+			woal_mon_rx_flush(handle);
 
 		status = MLAN_STATUS_PENDING;
 	}
@@ -1977,6 +2343,34 @@ static struct net_device *moal_get_netdev_from_stalist(moal_private *priv,
 #endif
 #endif
 
+/**
+ *  @brief This function builds an skb for a subframe sharing the data
+ *         of its parent AMSDU buffer
+ *
+ *  @param pmbuf    Pointer to the mlan buffer structure of the subframe
+ *
+ *  @return         skb cloned from the parent or NULL
+ */
+static struct sk_buff *woal_clone_rx_view(pmlan_buffer pmbuf)
+{
+	struct sk_buff *pskb = NULL;
+	struct sk_buff *skb = NULL;
+	t_u8 *start = pmbuf->pbuf + pmbuf->data_offset;
+
+	if (pmbuf->pparent)
+		pskb = (struct sk_buff *)pmbuf->pparent->pdesc;
+	/* the parent skb is still empty, its data is the mlan pbuf */
+	if (!pskb || pskb->len || start < pskb->data ||
+	    (start - pskb->data) + pmbuf->data_len > skb_tailroom(pskb))
+		return NULL;
+	skb = skb_clone(pskb, GFP_ATOMIC);
+	if (!skb)
+		return NULL;
+	skb_reserve(skb, start - pskb->data);
+	skb_put(skb, pmbuf->data_len);
+	return skb;
+}
+
 /**
  *  @brief This function uploads amsdu packet to the network stack
  *
@@ -2192,6 +2586,7 @@ mlan_status moal_recv_packet(t_void *pmoal, pmlan_buffer pmbuf)
 	mlan_status status = MLAN_STATUS_SUCCESS;
 	moal_private *priv = NULL;
 	struct sk_buff *skb = NULL;
+	struct sk_buff *rx_view = NULL;
 	moal_handle *handle = (moal_handle *)pmoal;
 #if defined(USB) || defined(PCIE)
 	t_u32 max_rx_data_size = MLAN_RX_DATA_BUF_SIZE;
@@ -2209,6 +2604,8 @@ mlan_status moal_recv_packet(t_void *pmoal, pmlan_buffer pmbuf)
 
 	ENTER();
 	if (pmbuf) {
+		if (pmbuf->rx_lat_ts[MLAN_RX_LAT_BUS])
+			moal_rx_lat_record(handle, pmbuf);
 #ifdef USB
 #ifdef STA_SUPPORT
 		if (IS_USB(handle->card_type)) {
@@ -2235,6 +2632,10 @@ mlan_status moal_recv_packet(t_void *pmoal, pmlan_buffer pmbuf)
 		priv = woal_bss_index_to_priv(pmoal, pmbuf->bss_index);
 		skb = (struct sk_buff *)pmbuf->pdesc;
 		if (priv) {
+			/* An rx view whose parent skb can't be cloned is
+			 * copied below like any buffer without an skb */
+			if (!skb && (pmbuf->flags & MLAN_BUF_FLAG_RX_VIEW))
+				rx_view = woal_clone_rx_view(pmbuf);
 			if (skb) {
 				skb_reserve(skb, pmbuf->data_offset);
 				if (skb_tailroom(skb) < (int)pmbuf->data_len) {
@@ -2266,9 +2667,14 @@ mlan_status moal_recv_packet(t_void *pmoal, pmlan_buffer pmbuf)
 				 * free by mlan*/
 				status = MLAN_STATUS_PENDING;
 				atomic_dec(&handle->mbufalloc_count);
+			} else if (rx_view) {
+				/* shares the parent data, mlan frees pmbuf */
+				skb = rx_view;
 			} else {
-				PRINTM(MERROR, "%s without skb attach!!!\n",
-				       __func__);
+				if (!(pmbuf->flags & MLAN_BUF_FLAG_RX_VIEW))
+					PRINTM(MERROR,
+					       "%s without skb attach!!!\n",
+					       __func__);
 #if defined(STA_CFG80211) && defined(UAP_CFG80211)
 #if CFG80211_VERSION_CODE >= KERNEL_VERSION(3, 8, 0)
 				/** drop the packet without skb in
@@ -2358,7 +2764,7 @@ mlan_status moal_recv_packet(t_void *pmoal, pmlan_buffer pmbuf)
 					woal_get_dhcp_discover_transation_id(
 						skb);
 				if (transaction_id &&
-				    woal_get_dhcp_discover_info(
+				    woal_find_dhcp_discover_node(
 					    priv, transaction_id)) {
 					PRINTM(MDATA,
 					       "Drop dhcp pkt, transation_id=%x\n",
@@ -2403,20 +2809,12 @@ mlan_status moal_recv_packet(t_void *pmoal, pmlan_buffer pmbuf)
 #endif
 */
 				hash_key = woal_generate_arp_request_hash(skb);
-				// TODO: Drop too old entry
-				if (hash_key) {
-					struct arp_entry *node;
-					hash_for_each_possible (priv->hlist,
-								node, arp_hlist,
-								hash_key) {
-						if (node->hash_key ==
-						    hash_key) {
-							PRINTM(MDATA,
-							       "ARP entry exists, drop pkt\n");
-							dev_kfree_skb(skb);
-							goto done;
-						}
-					}
+				if (hash_key &&
+				    woal_find_arp_request_node(priv, hash_key)) {
+					PRINTM(MDATA,
+					       "ARP entry exists, drop pkt\n");
+					dev_kfree_skb(skb);
+					goto done;
 				}
 			}
 			if (!netdev)
@@ -2515,6 +2913,10 @@ mlan_status moal_recv_packet(t_void *pmoal, pmlan_buffer pmbuf)
 						rx_info_flag = MTRUE;
 				}
 			}
+			/* rx view shares data with other subframes */
+			if (rx_info_flag && skb_cloned(skb) &&
+			    pskb_expand_head(skb, 0, 0, GFP_ATOMIC))
+				rx_info_flag = MFALSE;
 			if (rx_info_flag &&
 			    (skb_tailroom(skb) > (int)sizeof(rxcontrol))) {
 				memset(&rxcontrol, 0, sizeof(dot11_rxcontrol));
@@ -2829,23 +3231,24 @@ static mlan_status wlan_process_defer_event(moal_handle *handle,
 
 	case MLAN_EVENT_ID_DRV_FLUSH_RX_WORK:
 		status = MLAN_STATUS_SUCCESS;
-		if (moal_extflg_isset(handle, EXT_NAPI)) {
+		if (moal_extflg_isset(handle, EXT_NAPI))
 			napi_synchronize(&handle->napi_rx);
-			break;
-		}
 #ifdef PCIE
-		if (IS_PCIE(handle->card_type)) {
+		else if (IS_PCIE(handle->card_type)) {
 #ifdef TASKLET_SUPPORT
 			tasklet_kill(&handle->pcie_rx_task);
 #else
 			flush_workqueue(handle->pcie_rx_workqueue);
 #endif
-			break;
 		}
 #endif
 #if defined(SDIO) || defined(USB)
-		flush_workqueue(handle->rx_workqueue);
+		else
+			flush_workqueue(handle->rx_workqueue);
 #endif
+		/* Last, the rx stages above may still queue to the shards */
+		if (handle->rx_shard_workqueue)
+			flush_workqueue(handle->rx_shard_workqueue);
 		break;
 	case MLAN_EVENT_ID_DRV_FLUSH_MAIN_WORK:
 		status = MLAN_STATUS_SUCCESS;
@@ -2968,14 +3371,237 @@ static t_void woal_process_event_tx_status(moal_private *priv,
 #endif
 
 /**
- *  @brief This function handles event receive
+ *  @brief This function handles the deferred work and flush events
+ *
+ *  @param handle   Pointer to the moal_handle
+ *  @param pmevent  Pointer to the mlan event structure
+ *
+ *  @return         N/A
+ */
+static void woal_defer_event_handler(moal_handle *handle, pmlan_event pmevent)
+{
+	wlan_process_defer_event(handle, pmevent->event_id);
+}
+
+#if defined(STA_CFG80211) || defined(UAP_CFG80211)
+/**
+ *  @brief This function handles the tx status event
+ *
+ *  @param handle   Pointer to the moal_handle
+ *  @param pmevent  Pointer to the mlan event structure
+ *
+ *  @return         N/A
+ */
+static void woal_tx_status_event_handler(moal_handle *handle,
+					 pmlan_event pmevent)
+{
+	moal_private *priv = woal_bss_index_to_priv(handle, pmevent->bss_index);
+	moal_private *remain_priv = NULL;
+	t_u8 channel_status;
+	unsigned long flag;
+	tx_status_event *tx_status =
+		(tx_status_event *)(pmevent->event_buf + 4);
+	struct tx_status_info *tx_info = NULL;
+
+	if (!priv || !priv->netdev)
+		return;
+	PRINTM(MEVENT,
+	       "Wlan: Tx status: tx_token=%d, pkt_type=0x%x, status=%d priv->tx_seq_num=%d\n",
+	       tx_status->tx_token_id, tx_status->packet_type,
+	       tx_status->status, priv->tx_seq_num);
+	spin_lock_irqsave(&priv->tx_stat_lock, flag);
+	tx_info = woal_get_tx_info(priv, tx_status->tx_token_id);
+	if (tx_info) {
+		bool ack;
+		struct sk_buff *skb = (struct sk_buff *)tx_info->tx_skb;
+		list_del(&tx_info->link);
+		spin_unlock_irqrestore(&priv->tx_stat_lock, flag);
+		if (!tx_status->status)
+			ack = true;
+		else
+			ack = false;
+#if defined(STA_CFG80211) || defined(UAP_CFG80211)
+		if (priv->phandle->remain_on_channel &&
+		    tx_info->cancel_remain_on_channel) {
+			remain_priv =
+				priv->phandle->priv
+					[priv->phandle->remain_bss_index];
+			if (remain_priv) {
+				if (woal_cfg80211_remain_on_channel_cfg(
+					    remain_priv, MOAL_NO_WAIT,
+					    MTRUE, &channel_status,
+					    NULL, 0, 0))
+					PRINTM(MERROR,
+					       "remain_on_channel: Failed to cancel\n");
+
+				priv->phandle->remain_on_channel =
+					MFALSE;
+			}
+		}
+#endif
+		PRINTM(MEVENT, "Wlan: Tx status=%d\n", ack);
+#if defined(STA_CFG80211) || defined(UAP_CFG80211)
+		if (tx_info->tx_cookie) {
+#if CFG80211_VERSION_CODE >= KERNEL_VERSION(2, 6, 37)
+#if CFG80211_VERSION_CODE < KERNEL_VERSION(3, 6, 0)
+			cfg80211_mgmt_tx_status(priv->netdev,
+						tx_info->tx_cookie,
+						skb->data, skb->len,
+						ack, GFP_ATOMIC);
+#else
+			cfg80211_mgmt_tx_status(priv->wdev,
+						tx_info->tx_cookie,
+						skb->data, skb->len,
+						ack, GFP_ATOMIC);
+#endif
+#if CFG80211_VERSION_CODE >= KERNEL_VERSION(5, 3, 0)
+			if (tx_info->send_tx_expired) {
+				PRINTM(MINFO,
+				       "NAN: send tx duration expired for cookie=%llx\n",
+				       tx_info->tx_cookie);
+				cfg80211_tx_mgmt_expired(
+					priv->wdev, tx_info->tx_cookie,
+					&priv->phandle->chan,
+					GFP_ATOMIC);
+			}
+#endif
+#endif
+		}
+#if defined(STA_CFG80211) || defined(UAP_CFG80211)
+#if CFG80211_VERSION_CODE >= KERNEL_VERSION(3, 14, 0)
+		if (drvdbg & MDAT_D)
+			woal_packet_fate_monitor(
+				priv, PACKET_TYPE_TX,
+				ack ? TX_PKT_FATE_ACKED :
+				      TX_PKT_FATE_SENT,
+				FRAME_TYPE_80211_MGMT, 0, 0, skb->data,
+				skb->len);
+#endif
+#endif
+#endif
+		dev_kfree_skb_any(skb);
+		kfree(tx_info);
+	} else {
+		spin_unlock_irqrestore(&priv->tx_stat_lock, flag);
+	}
+}
+
+/**
+ *  @brief This function handles the bulk tx status event
+ *
+ *  @param handle   Pointer to the moal_handle
+ *  @param pmevent  Pointer to the mlan event structure
+ *
+ *  @return         N/A
+ */
+static void woal_tx_bulk_status_event_handler(moal_handle *handle,
+					      pmlan_event pmevent)
+{
+	moal_private *priv = woal_bss_index_to_priv(handle, pmevent->bss_index);
+	tx_bulk_status_event *tx_status =
+		(tx_bulk_status_event *)(pmevent->event_buf + 4);
+	t_u8 curID = 0, num_of_events = 0, payload_len = 0;
+
+	if (!priv || !priv->netdev)
+		return;
+	payload_len = (pmevent->event_len - 4);
+	num_of_events =
+		((payload_len) / (sizeof(tx_mgmt_status_event)));
+
+	PRINTM(MEVENT,
+	       "Wlan: Bulk Tx status total_len=%d num_of_events=%d\n",
+	       payload_len, num_of_events);
+	while (curID < num_of_events) {
+		woal_process_event_tx_status(
+			priv, &(tx_status->bulk_events[curID++]));
+	}
+}
+#endif
+
+/**
+ *  @brief This function handles the CSI event
+ *
+ *  @param handle   Pointer to the moal_handle
+ *  @param pmevent  Pointer to the mlan event structure
+ *
+ *  @return         N/A
+ */
+static void woal_csi_event_handler(moal_handle *handle, pmlan_event pmevent)
+{
+	moal_private *priv = woal_bss_index_to_priv(handle, pmevent->bss_index);
+	int custom_len;
+	t_u16 csi_len;
+
+	if (!priv || !priv->netdev)
+		return;
+	DBG_HEXDUMP(MEVT_D, "CSI dump", pmevent->event_buf, pmevent->event_len);
+#ifdef STA_CFG80211
+#if CFG80211_VERSION_CODE >= KERNEL_VERSION(3, 14, 0)
+	if (priv->csi_enable)
+		woal_cfg80211_event_csi_dump(priv, pmevent->event_buf,
+					     pmevent->event_len);
+#endif
+#endif
+#ifdef CONFIG_PROC_FS
+	/* A reader of the CSI ring takes the record instead of netlink */
+	if (woal_csi_ring_push(priv, pmevent->event_buf, pmevent->event_len)) {
+		priv->csi_seq++;
+		return;
+	}
+#endif
+	/* Send Netlink event */
+	custom_len = strlen(CUS_EVT_CSI) + sizeof(priv->csi_seq);
+	csi_len = pmevent->event_len;
+	memmove(pmevent->event_buf + custom_len, pmevent->event_buf, csi_len);
+	moal_memcpy_ext(priv->phandle, pmevent->event_buf, CUS_EVT_CSI,
+			strlen(CUS_EVT_CSI), strlen(CUS_EVT_CSI));
+	moal_memcpy_ext(priv->phandle, pmevent->event_buf + strlen(CUS_EVT_CSI),
+			(t_u8 *)(&(priv->csi_seq)), sizeof(priv->csi_seq),
+			sizeof(priv->csi_seq));
+	woal_broadcast_event(priv, pmevent->event_buf, custom_len + csi_len);
+	priv->csi_seq++;
+}
+
+/**
+ *  @brief This function wakes the kernel queues MLAN released from a
+ *         station over its tx_aqm limit on dequeue
+ *
+ *  @param priv     A pointer to moal_private structure
+ *  @param mask     Bitmap of the released wmm queues
+ *
+ *  @return         N/A
+ */
+static void woal_tx_aqm_wake(moal_private *priv, t_u8 mask)
+{
+#if LINUX_VERSION_CODE > KERNEL_VERSION(2, 6, 29)
+	struct netdev_queue *txq;
+	int i;
+
+	for (i = 0; i < MAX_AC_QUEUES; i++) {
+		if (!(mask & MBIT(i)))
+			continue;
+		/* Still held by the tx pending high mark */
+		if (atomic_read(&priv->wmm_tx_pending[i]) >=
+		    priv->max_tx_pending)
+			continue;
+		txq = netdev_get_tx_queue(priv->netdev, i);
+		if (netif_tx_queue_stopped(txq)) {
+			netif_tx_wake_queue(txq);
+			PRINTM(MINFO, "AQM: wakeup Kernel Queue:%d\n", i);
+		}
+	}
+#endif
+}
+
+/**
+ *  @brief This function handles events without a dispatch table handler
  *
  *  @param pmoal Pointer to the MOAL context
  *  @param pmevent  Pointer to the mlan event structure
  *
  *  @return         MLAN_STATUS_SUCCESS
  */
-mlan_status moal_recv_event(t_void *pmoal, pmlan_event pmevent)
+static mlan_status woal_process_event(t_void *pmoal, pmlan_event pmevent)
 {
 #ifdef STA_SUPPORT
 	int custom_len = 0;
@@ -3022,11 +3648,6 @@ mlan_status moal_recv_event(t_void *pmoal, pmlan_event pmevent)
 #if CFG80211_VERSION_CODE >= KERNEL_VERSION(4, 12, 0)
 	struct cfg80211_roam_info *roam_info = NULL;
 #endif
-#endif
-	t_u16 csi_len;
-#ifdef STA_CFG80211
-	t_u8 channel_status;
-	moal_private *remain_priv = NULL;
 #endif
 #if defined(UAP_CFG80211) || defined(STA_CFG80211)
 	chan_band_info *pchan_info = NULL;
@@ -4783,112 +5404,6 @@ mlan_status moal_recv_event(t_void *pmoal, pmlan_event pmevent)
 #endif
 #endif
 		break;
-	case MLAN_EVENT_ID_FW_TX_STATUS: {
-#if defined(STA_CFG80211) || defined(UAP_CFG80211)
-		unsigned long flag;
-		tx_status_event *tx_status =
-			(tx_status_event *)(pmevent->event_buf + 4);
-		struct tx_status_info *tx_info = NULL;
-		PRINTM(MEVENT,
-		       "Wlan: Tx status: tx_token=%d, pkt_type=0x%x, status=%d priv->tx_seq_num=%d\n",
-		       tx_status->tx_token_id, tx_status->packet_type,
-		       tx_status->status, priv->tx_seq_num);
-		spin_lock_irqsave(&priv->tx_stat_lock, flag);
-		tx_info = woal_get_tx_info(priv, tx_status->tx_token_id);
-		if (tx_info) {
-			bool ack;
-			struct sk_buff *skb = (struct sk_buff *)tx_info->tx_skb;
-			list_del(&tx_info->link);
-			spin_unlock_irqrestore(&priv->tx_stat_lock, flag);
-			if (!tx_status->status)
-				ack = true;
-			else
-				ack = false;
-#if defined(STA_CFG80211) || defined(UAP_CFG80211)
-			if (priv->phandle->remain_on_channel &&
-			    tx_info->cancel_remain_on_channel) {
-				remain_priv =
-					priv->phandle->priv
-						[priv->phandle->remain_bss_index];
-				if (remain_priv) {
-					if (woal_cfg80211_remain_on_channel_cfg(
-						    remain_priv, MOAL_NO_WAIT,
-						    MTRUE, &channel_status,
-						    NULL, 0, 0))
-						PRINTM(MERROR,
-						       "remain_on_channel: Failed to cancel\n");
-
-					priv->phandle->remain_on_channel =
-						MFALSE;
-				}
-			}
-#endif
-			PRINTM(MEVENT, "Wlan: Tx status=%d\n", ack);
-#if defined(STA_CFG80211) || defined(UAP_CFG80211)
-			if (tx_info->tx_cookie) {
-#if CFG80211_VERSION_CODE >= KERNEL_VERSION(2, 6, 37)
-#if CFG80211_VERSION_CODE < KERNEL_VERSION(3, 6, 0)
-				cfg80211_mgmt_tx_status(priv->netdev,
-							tx_info->tx_cookie,
-							skb->data, skb->len,
-							ack, GFP_ATOMIC);
-#else
-				cfg80211_mgmt_tx_status(priv->wdev,
-							tx_info->tx_cookie,
-							skb->data, skb->len,
-							ack, GFP_ATOMIC);
-#endif
-#if CFG80211_VERSION_CODE >= KERNEL_VERSION(5, 3, 0)
-				if (tx_info->send_tx_expired) {
-					PRINTM(MINFO,
-					       "NAN: send tx duration expired for cookie=%llx\n",
-					       tx_info->tx_cookie);
-					cfg80211_tx_mgmt_expired(
-						priv->wdev, tx_info->tx_cookie,
-						&priv->phandle->chan,
-						GFP_ATOMIC);
-				}
-#endif
-#endif
-			}
-#if defined(STA_CFG80211) || defined(UAP_CFG80211)
-#if CFG80211_VERSION_CODE >= KERNEL_VERSION(3, 14, 0)
-			if (drvdbg & MDAT_D)
-				woal_packet_fate_monitor(
-					priv, PACKET_TYPE_TX,
-					ack ? TX_PKT_FATE_ACKED :
-					      TX_PKT_FATE_SENT,
-					FRAME_TYPE_80211_MGMT, 0, 0, skb->data,
-					skb->len);
-#endif
-#endif
-#endif
-			dev_kfree_skb_any(skb);
-			kfree(tx_info);
-		} else {
-			spin_unlock_irqrestore(&priv->tx_stat_lock, flag);
-		}
-#endif
-	} break;
-	case MLAN_EVENT_ID_FW_TX_BULK_STATUS: {
-#if defined(STA_CFG80211) || defined(UAP_CFG80211)
-		tx_bulk_status_event *tx_status =
-			(tx_bulk_status_event *)(pmevent->event_buf + 4);
-		t_u8 curID = 0, num_of_events = 0, payload_len = 0;
-
-		payload_len = (pmevent->event_len - 4);
-		num_of_events =
-			((payload_len) / (sizeof(tx_mgmt_status_event)));
-
-		PRINTM(MEVENT,
-		       "Wlan: Bulk Tx status total_len=%d num_of_events=%d\n",
-		       payload_len, num_of_events);
-		while (curID < num_of_events) {
-			woal_process_event_tx_status(
-				priv, &(tx_status->bulk_events[curID++]));
-		}
-#endif
-	} break;
 	case MLAN_EVENT_ID_DRV_FT_RESPONSE:
 		if (priv->phandle->fw_roam_enable)
 			break;
@@ -5042,35 +5557,14 @@ mlan_status moal_recv_event(t_void *pmoal, pmlan_event pmevent)
 #endif
 #endif
 		break;
-	case MLAN_EVENT_ID_CSI:
-		DBG_HEXDUMP(MEVT_D, "CSI dump", pmevent->event_buf,
-			    pmevent->event_len);
-#ifdef STA_CFG80211
-#if CFG80211_VERSION_CODE >= KERNEL_VERSION(3, 14, 0)
-		if (priv->csi_enable)
-			woal_cfg80211_event_csi_dump(priv, pmevent->event_buf,
-						     pmevent->event_len);
-#endif
-#endif
-		/* Send Netlink event */
-		custom_len = strlen(CUS_EVT_CSI) + sizeof(priv->csi_seq);
-		csi_len = pmevent->event_len;
-		memmove(pmevent->event_buf + custom_len, pmevent->event_buf,
-			csi_len);
-		moal_memcpy_ext(priv->phandle, pmevent->event_buf, CUS_EVT_CSI,
-				strlen(CUS_EVT_CSI), strlen(CUS_EVT_CSI));
-		moal_memcpy_ext(priv->phandle,
-				pmevent->event_buf + strlen(CUS_EVT_CSI),
-				(t_u8 *)(&(priv->csi_seq)),
-				sizeof(priv->csi_seq), sizeof(priv->csi_seq));
-		woal_broadcast_event(priv, pmevent->event_buf,
-				     custom_len + csi_len);
-		priv->csi_seq++;
-		break;
 	case MLAN_EVENT_ID_DRV_RGPWR_KEY_MISMATCH:
 		if (handle->sec_rgpower)
 			woal_rgpower_key_mismatch_event(priv);
 		break;
+	case MLAN_EVENT_ID_DRV_TX_QUEUE_WAKE:
+		if (priv->media_connected)
+			woal_tx_aqm_wake(priv, pmevent->event_buf[0]);
+		break;
 	default:
 		break;
 	}
@@ -5079,6 +5573,221 @@ done:
 	return MLAN_STATUS_SUCCESS;
 }
 
+/**
+ *  @brief This function registers a handler in the event dispatch table.
+ *          Events with a registered handler bypass woal_process_event.
+ *
+ *  @param handle   Pointer to the moal_handle
+ *  @param event_id Event id
+ *  @param ctx      Handler context, enum woal_event_ctx
+ *  @param handler  Event handler
+ *
+ *  @return         0 --success, otherwise fail
+ */
+int woal_register_event_handler(moal_handle *handle, mlan_event_id event_id,
+				t_u8 ctx, woal_event_handler handler)
+{
+	struct woal_event_dispatch *entry =
+		&handle->evt_dispatch[MOAL_EVENT_SLOT(event_id)];
+
+	if (!handler || ctx > WOAL_EVT_CTX_WORKQ)
+		return -EINVAL;
+	if (entry->handler && entry->event_id != event_id) {
+		PRINTM(MERROR, "Event 0x%x: dispatch slot used by 0x%x\n",
+		       event_id, entry->event_id);
+		return -EBUSY;
+	}
+	entry->event_id = event_id;
+	entry->ctx = ctx;
+	entry->handler = handler;
+	return 0;
+}
+
+/**
+ *  @brief This function removes a handler from the event dispatch table
+ *
+ *  @param handle   Pointer to the moal_handle
+ *  @param event_id Event id
+ *
+ *  @return         N/A
+ */
+void woal_unregister_event_handler(moal_handle *handle, mlan_event_id event_id)
+{
+	struct woal_event_dispatch *entry =
+		&handle->evt_dispatch[MOAL_EVENT_SLOT(event_id)];
+
+	if (entry->event_id == event_id)
+		entry->handler = NULL;
+}
+
+/**
+ *  @brief This function registers the built-in event handlers.
+ *          Deferred work events only kick a work item and stay inline,
+ *          TX status runs with bottom halves disabled and CSI, which
+ *          may dump to a file, runs from evt_workqueue.
+ *
+ *  @param handle   Pointer to the moal_handle
+ *
+ *  @return         N/A
+ */
+void woal_init_event_dispatch(moal_handle *handle)
+{
+	static const mlan_event_id defer_events[] = {
+#ifdef PCIE
+		MLAN_EVENT_ID_DRV_DEFER_RX_DATA,
+		MLAN_EVENT_ID_DRV_DEFER_CMDRESP,
+		MLAN_EVENT_ID_DRV_DEFER_TX_COMPLTE,
+		MLAN_EVENT_ID_DRV_DELAY_TX_COMPLETE,
+#endif
+		MLAN_EVENT_ID_DRV_FLUSH_RX_WORK,
+		MLAN_EVENT_ID_DRV_FLUSH_MAIN_WORK,
+		MLAN_EVENT_ID_DRV_DEFER_HANDLING,
+		MLAN_EVENT_ID_DRV_DEFER_RX_WORK,
+	};
+	unsigned int i;
+
+	memset(handle->evt_dispatch, 0, sizeof(handle->evt_dispatch));
+	memset(handle->evt_stats, 0, sizeof(handle->evt_stats));
+	for (i = 0; i < ARRAY_SIZE(defer_events); i++)
+		woal_register_event_handler(handle, defer_events[i],
+					    WOAL_EVT_CTX_ATOMIC,
+					    woal_defer_event_handler);
+#if defined(STA_CFG80211) || defined(UAP_CFG80211)
+	woal_register_event_handler(handle, MLAN_EVENT_ID_FW_TX_STATUS,
+				    WOAL_EVT_CTX_SOFTIRQ,
+				    woal_tx_status_event_handler);
+	woal_register_event_handler(handle, MLAN_EVENT_ID_FW_TX_BULK_STATUS,
+				    WOAL_EVT_CTX_SOFTIRQ,
+				    woal_tx_bulk_status_event_handler);
+#endif
+	woal_register_event_handler(handle, MLAN_EVENT_ID_CSI,
+				    WOAL_EVT_CTX_WORKQ, woal_csi_event_handler);
+}
+
+/**
+ *  @brief This function records count and latency of an event
+ *
+ *  @param handle   Pointer to the moal_handle
+ *  @param event_id Event id
+ *  @param start    Time the event was received
+ *
+ *  @return         N/A
+ */
+static void woal_update_event_stats(moal_handle *handle,
+				    mlan_event_id event_id, wifi_timeval start)
+{
+	struct woal_event_stats *stats =
+		&handle->evt_stats[MOAL_EVENT_SLOT(event_id)];
+	wifi_timeval now;
+	t_u32 lat;
+	t_u32 idx = 0;
+
+	woal_get_monotonic_time(&now);
+	lat = (t_u32)(timeval_to_usec(now) - timeval_to_usec(start));
+	/* Buckets grow by powers of 4: <4us, <16us, <64us, ... */
+	if (lat)
+		idx = (fls(lat) - 1) / 2;
+	if (idx >= EVENT_LAT_HIST_NUM)
+		idx = EVENT_LAT_HIST_NUM - 1;
+	stats->count++;
+	stats->lat_hist[idx]++;
+	if (lat > stats->max_lat)
+		stats->max_lat = lat;
+}
+
+/**
+ *  @brief This function queues an event for a WOAL_EVT_CTX_WORKQ handler
+ *
+ *  @param handle   Pointer to the moal_handle
+ *  @param pmevent  Pointer to the mlan event structure
+ *  @param start    Time the event was received
+ *
+ *  @return         N/A
+ */
+static void woal_queue_dispatch_event(moal_handle *handle, pmlan_event pmevent,
+				      wifi_timeval start)
+{
+	struct woal_event *evt;
+	unsigned long flags;
+	t_u32 len = sizeof(mlan_event) + pmevent->event_len;
+
+	/* The event copy follows the woal_event in the same allocation */
+	evt = kzalloc(sizeof(struct woal_event) + len + EVENT_DISPATCH_HEADROOM,
+		      GFP_ATOMIC);
+	if (!evt) {
+		PRINTM(MERROR, "Fail to queue event 0x%x\n", pmevent->event_id);
+		return;
+	}
+	evt->type = WOAL_EVENT_DISPATCH;
+	evt->tstamp = start;
+	evt->dispatch_evt = (mlan_event *)(evt + 1);
+	moal_memcpy_ext(handle, evt->dispatch_evt, pmevent, len, len);
+	INIT_LIST_HEAD(&evt->link);
+	spin_lock_irqsave(&handle->evt_lock, flags);
+	list_add_tail(&evt->link, &handle->evt_queue);
+	spin_unlock_irqrestore(&handle->evt_lock, flags);
+	queue_work(handle->evt_workqueue, &handle->evt_work);
+}
+
+/**
+ *  @brief This function runs the handler of a queued WOAL_EVENT_DISPATCH
+ *          event from evt_workqueue
+ *
+ *  @param handle   Pointer to the moal_handle
+ *  @param evt      Pointer to the woal_event
+ *
+ *  @return         N/A
+ */
+void woal_dispatch_queued_event(moal_handle *handle, struct woal_event *evt)
+{
+	pmlan_event pmevent = evt->dispatch_evt;
+	struct woal_event_dispatch *entry =
+		&handle->evt_dispatch[MOAL_EVENT_SLOT(pmevent->event_id)];
+
+	if (entry->handler && entry->event_id == pmevent->event_id)
+		entry->handler(handle, pmevent);
+	else
+		woal_process_event(handle, pmevent);
+	woal_update_event_stats(handle, pmevent->event_id, evt->tstamp);
+}
+
+/**
+ *  @brief This function handles event receive
+ *
+ *  @param pmoal Pointer to the MOAL context
+ *  @param pmevent  Pointer to the mlan event structure
+ *
+ *  @return         MLAN_STATUS_SUCCESS
+ */
+mlan_status moal_recv_event(t_void *pmoal, pmlan_event pmevent)
+{
+	moal_handle *handle = (moal_handle *)pmoal;
+	mlan_event_id event_id = pmevent->event_id;
+	struct woal_event_dispatch *entry =
+		&handle->evt_dispatch[MOAL_EVENT_SLOT(event_id)];
+	wifi_timeval start;
+
+	ENTER();
+	woal_get_monotonic_time(&start);
+	if (!entry->handler || entry->event_id != event_id) {
+		woal_process_event(handle, pmevent);
+	} else if (entry->ctx == WOAL_EVT_CTX_WORKQ) {
+		/* Stats are updated once the work item has run */
+		woal_queue_dispatch_event(handle, pmevent, start);
+		LEAVE();
+		return MLAN_STATUS_SUCCESS;
+	} else if (entry->ctx == WOAL_EVT_CTX_SOFTIRQ && !in_interrupt()) {
+		local_bh_disable();
+		entry->handler(handle, pmevent);
+		local_bh_enable();
+	} else {
+		entry->handler(handle, pmevent);
+	}
+	woal_update_event_stats(handle, event_id, start);
+	LEAVE();
+	return MLAN_STATUS_SUCCESS;
+}
+
 /**
  *  @brief This function prints the debug message in mlan
  *
@@ -95,6 +95,10 @@ mlan_status moal_init_lock(t_void *pmoal, t_void **pplock);
 mlan_status moal_free_lock(t_void *pmoal, t_void *plock);
 mlan_status moal_spin_lock(t_void *pmoal, t_void *plock);
 mlan_status moal_spin_unlock(t_void *pmoal, t_void *plock);
+t_s32 moal_atomic_add(t_void *pmoal, t_s32 *pval, t_s32 i);
+t_s32 moal_atomic_sub(t_void *pmoal, t_s32 *pval, t_s32 i);
+t_s32 moal_atomic_read(t_void *pmoal, t_s32 *pval);
+t_s32 moal_atomic_cmpxchg(t_void *pmoal, t_s32 *pval, t_s32 old, t_s32 new_val);
 t_void moal_print(t_void *pmoal, t_u32 level, char *pformat, IN...);
 t_void moal_print_netintf(t_void *pmoal, t_u32 bss_index, t_u32 level);
 t_void moal_assert(t_void *pmoal, t_u32 cond);
@@ -118,6 +122,9 @@ void moal_tp_accounting_rx_param(t_void *pmoal, unsigned int type,
 				 unsigned int rsvd1);
 void moal_amsdu_tp_accounting(t_void *pmoal, t_s32 amsdu_process_delay,
 			      t_s32 amsdu_copy_delay);
+mlan_status moal_rx_late_queue(t_void *pmoal, t_u32 flow, pmlan_buffer pmbuf);
+t_u8 moal_buf_writable(t_void *pmoal, pmlan_buffer pmbuf, t_u32 len);
+void moal_tp_lock_calibrate(moal_handle *handle);
 
 void moal_connection_status_check_pmqos(t_void *pmoal);
 #if defined(PCIE) || defined(SDIO)
@@ -0,0 +1,278 @@
+/** @file moal_stats.h
+ *
+ * @brief This file contains the layout of the binary stats snapshot
+ * read from /proc/mwlan/adapterX/stats
+ *
+ *
+ * Copyright 2026 NXP
+ *
+ * This software file (the File) is distributed by NXP
+ * under the terms of the GNU General Public License Version 2, June 1991
+ * (the License).  You may use, redistribute and/or modify the File in
+ * accordance with the terms and conditions of the License, a copy of which
+ * is available by writing to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA or on the
+ * worldwide web at http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ * THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE
+ * ARE EXPRESSLY DISCLAIMED.  The License provides additional details about
+ * this warranty disclaimer.
+ *
+ */
+
+/********************************************************
+Change log:
+    10/18/2026: initial version
+********************************************************/
+
+#ifndef _MOAL_STATS_H
+#define _MOAL_STATS_H
+
+/*
+ * The snapshot is a moal_stats_hdr followed by hdr.num_sections
+ * sections. Each section is a moal_stats_section followed by
+ * sec.count records of sec.len / sec.count bytes each. All fields are
+ * host endian and all records are multiples of 8 bytes.
+ *
+ * DRV, TP and MLAN appear once. NETDEV appears once per interface,
+ * followed by a STA section when the interface has stations.
+ *
+ * Compatibility: fields are only ever appended to a record, so a
+ * reader must step over records with sec.len / sec.count, not with
+ * its own sizeof. Readers skip section types they do not know.
+ * hdr.version changes only when an existing field changes meaning.
+ *
+ * Consistency: the station list of an interface is copied under its
+ * lock, so a STA section holds one set of stations. The counters
+ * themselves are read without stopping the data path, and interfaces
+ * and adapter counters are read one after the other, so the snapshot
+ * is not one point in time. hdr.generation tells a reader a snapshot
+ * is new, netdev.sta_list_gen tells it the stations of an interface
+ * changed since the snapshot before.
+ */
+
+/** Snapshot magic, "MWST" */
+#define MOAL_STATS_MAGIC 0x5453574d
+/** Snapshot layout version */
+#define MOAL_STATS_VERSION 1
+
+/** Snapshot header */
+typedef MLAN_PACK_START struct _moal_stats_hdr {
+	/** MOAL_STATS_MAGIC */
+	t_u32 magic;
+	/** MOAL_STATS_VERSION */
+	t_u16 version;
+	/** Length of this header */
+	t_u16 hdr_len;
+	/** Length of the snapshot, header included */
+	t_u32 total_len;
+	/** Number of sections */
+	t_u32 num_sections;
+	/** Boot time of the snapshot in ns */
+	t_u64 timestamp;
+	/** Time spent taking the snapshot in ns */
+	t_u64 collect_ns;
+	/** Snapshot sequence number of the adapter, +1 per snapshot */
+	t_u32 generation;
+	/** Reserved */
+	t_u32 rsvd;
+} MLAN_PACK_END moal_stats_hdr;
+
+/** Section types */
+enum _moal_stats_sec_type {
+	/** One moal_stats_drv */
+	MOAL_STATS_SEC_DRV = 1,
+	/** One moal_stats_mlan */
+	MOAL_STATS_SEC_MLAN,
+	/** One moal_stats_tp, valid when tp accounting is on */
+	MOAL_STATS_SEC_TP,
+	/** One moal_stats_netdev */
+	MOAL_STATS_SEC_NETDEV,
+	/** One moal_stats_sta per station of the interface before */
+	MOAL_STATS_SEC_STA,
+};
+
+/** Section header */
+typedef MLAN_PACK_START struct _moal_stats_section {
+	/** MOAL_STATS_SEC_* */
+	t_u16 type;
+	/** Number of records */
+	t_u16 count;
+	/** Length of the records, this header excluded */
+	t_u32 len;
+} MLAN_PACK_END moal_stats_section;
+
+/** MOAL_STATS_SEC_DRV: MOAL handle counters */
+typedef MLAN_PACK_START struct _moal_stats_drv {
+	/** Tx packets pending in MLAN */
+	t_u32 tx_pending;
+	/** Rx packets pending in MLAN */
+	t_u32 rx_pending;
+	/** IOCTLs pending in MLAN */
+	t_u32 ioctl_pending;
+	/** Locks allocated */
+	t_u32 lock_count;
+	/** Buffers allocated by kmalloc */
+	t_u32 malloc_count;
+	/** Buffers allocated by vmalloc */
+	t_u32 vmalloc_count;
+	/** mlan_buffers allocated */
+	t_u32 mbufalloc_count;
+	/** Buffers allocated by dma_alloc_coherent */
+	t_u32 malloc_cons_count;
+	/** Host sleep skip count */
+	t_u32 hs_skip_count;
+	/** Host sleep force count */
+	t_u32 hs_force_count;
+} MLAN_PACK_END moal_stats_drv;
+
+/** SDIO aggregation histogram size in moal_stats_mlan */
+#define MOAL_STATS_MPA_NUM 16
+
+/** MOAL_STATS_SEC_MLAN: MLAN adapter counters */
+typedef MLAN_PACK_START struct _moal_stats_mlan {
+	/** Rx packets queued in rx_data_queue */
+	t_u32 rx_pkts_queued;
+	/** Packets sent on the bypass queue */
+	t_u32 bypass_pkt_count;
+	/** Host to card command failures */
+	t_u32 num_cmd_host_to_card_failure;
+	/** Host to card Tx failures */
+	t_u32 num_tx_host_to_card_failure;
+	/** Card to host command/event failures, SDIO only */
+	t_u32 num_cmdevt_card_to_host_failure;
+	/** Card to host Rx failures, SDIO only */
+	t_u32 num_rx_card_to_host_failure;
+	/** Interrupt status read failures, SDIO only */
+	t_u32 num_int_read_failure;
+	/** Interrupts, SDIO only */
+	t_u32 num_of_irq;
+	/** Buffer allocation failures */
+	t_u32 num_alloc_buffer_failure;
+	/** Packets dropped */
+	t_u32 num_pkt_dropped;
+	/** Deauthentication events */
+	t_u32 num_event_deauth;
+	/** Disassociation events */
+	t_u32 num_event_disassoc;
+	/** Link lost events */
+	t_u32 num_event_link_lost;
+	/** Command timeouts */
+	t_u32 num_cmd_timeout;
+	/** Tx aggregates of n + 1 packets, SDIO only */
+	t_u32 mpa_tx_count[MOAL_STATS_MPA_NUM];
+	/** Rx aggregates of n + 1 packets, SDIO only */
+	t_u32 mpa_rx_count[MOAL_STATS_MPA_NUM];
+} MLAN_PACK_END moal_stats_mlan;
+
+/** Drop points in moal_stats_tp */
+#define MOAL_STATS_TP_POINTS 5
+
+/** MOAL_STATS_SEC_TP: tp accounting counters */
+typedef MLAN_PACK_START struct _moal_stats_tp {
+	/** Tx packets per drop point */
+	t_u64 tx_packets[MOAL_STATS_TP_POINTS];
+	/** Tx bytes per drop point */
+	t_u64 tx_bytes[MOAL_STATS_TP_POINTS];
+	/** Rx packets per drop point */
+	t_u64 rx_packets[MOAL_STATS_TP_POINTS];
+	/** Rx bytes per drop point */
+	t_u64 rx_bytes[MOAL_STATS_TP_POINTS];
+	/** Tx AMSDUs */
+	t_u64 tx_amsdu_cnt;
+	/** Packets in Tx AMSDUs */
+	t_u64 tx_amsdu_pkt_cnt;
+	/** Tx done interrupts */
+	t_u64 tx_intr_cnt;
+	/** skbs reallocated in hard_start_xmit */
+	t_u64 tx_xmit_skb_realloc_cnt;
+	/** Tx queue stops */
+	t_u64 tx_stop_queue_cnt;
+	/** Rx AMSDUs */
+	t_u64 rx_amsdu_cnt;
+	/** Packets in Rx AMSDUs */
+	t_u64 rx_amsdu_pkt_cnt;
+	/** Rx interrupts */
+	t_u64 rx_intr_cnt;
+	/** Rx pauses */
+	t_u64 rx_paused_cnt;
+	/** Rx ring full */
+	t_u64 rx_rdptr_full_cnt;
+	/** MLAN data path lock operations */
+	t_u64 lock_ops;
+} MLAN_PACK_END moal_stats_tp;
+
+/** MOAL_STATS_SEC_NETDEV: interface counters */
+typedef MLAN_PACK_START struct _moal_stats_netdev {
+	/** Interface name */
+	char name[16];
+	/** BSS index */
+	t_u8 bss_index;
+	/** BSS role */
+	t_u8 bss_role;
+	/** Media connected */
+	t_u8 media_connected;
+	/** Reserved */
+	t_u8 rsvd;
+	/** Tx timeouts */
+	t_u32 num_tx_timeout;
+	/** Packets out per AC (BK, BE, VI, VO) */
+	t_u32 wmm_ac[4];
+	/** Rx packets */
+	t_u64 rx_packets;
+	/** Tx packets */
+	t_u64 tx_packets;
+	/** Rx bytes */
+	t_u64 rx_bytes;
+	/** Tx bytes */
+	t_u64 tx_bytes;
+	/** Rx dropped */
+	t_u64 rx_dropped;
+	/** Tx dropped */
+	t_u64 tx_dropped;
+	/** Tx errors */
+	t_u64 tx_errors;
+	/** Station list generation, changes on station add and delete */
+	t_u32 sta_list_gen;
+	/** Reserved */
+	t_u32 rsvd1;
+} MLAN_PACK_END moal_stats_netdev;
+
+/** MOAL_STATS_SEC_STA: station counters */
+typedef MLAN_PACK_START struct _moal_stats_sta {
+	/** Station MAC address */
+	t_u8 mac_addr[6];
+	/** BSS index of the interface */
+	t_u8 bss_index;
+	/** Reserved */
+	t_u8 rsvd;
+	/** SNR */
+	t_s8 snr;
+	/** Noise floor */
+	t_s8 nf;
+	/** Reserved */
+	t_u16 rsvd1;
+	/** Rx packets */
+	t_u32 rx_packets;
+	/** Tx packets */
+	t_u32 tx_packets;
+	/** Rx bytes */
+	t_u32 rx_bytes;
+	/** Tx bytes */
+	t_u32 tx_bytes;
+	/** Reserved */
+	t_u32 rsvd2;
+	/** Last Rx in ms */
+	t_u64 last_rx_in_msec;
+	/** Tx packets dropped by AQM */
+	t_u32 tx_aqm_drops;
+	/** Tx packets ECN marked by AQM */
+	t_u32 tx_aqm_marks;
+	/** Times the station queue limit stopped the AC queue */
+	t_u32 tx_aqm_overlimit;
+	/** Reserved */
+	t_u32 rsvd3;
+} MLAN_PACK_END moal_stats_sta;
+
+#endif /* _MOAL_STATS_H */
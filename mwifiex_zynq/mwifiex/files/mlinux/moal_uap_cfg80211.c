@@ -2019,17 +2019,15 @@ moal_private *woal_alloc_virt_interface(moal_handle *handle, t_u8 bss_index,
 	priv->bss_type = bss_type;
 	priv->bss_role = MLAN_BSS_ROLE_STA;
 
-	INIT_LIST_HEAD(&priv->tcp_sess_queue);
-	spin_lock_init(&priv->tcp_sess_lock);
+	woal_init_tcp_sess_queue(priv);
 
 	INIT_LIST_HEAD(&priv->tx_stat_queue);
 	spin_lock_init(&priv->tx_stat_lock);
-	INIT_LIST_HEAD(&priv->mcast_list);
-	spin_lock_init(&priv->mcast_lock);
+	woal_lru_init(&priv->mcast_table, MLAN_MAX_MULTICAST_LIST_SIZE);
 
 #ifdef STA_CFG80211
-	INIT_LIST_HEAD(&priv->dhcp_discover_queue);
-	spin_lock_init(&priv->dhcp_discover_lock);
+	woal_lru_init(&priv->dhcp_table, DHCP_DISCOVER_TABLE_MAX);
+	woal_lru_init(&priv->arp_table, ARP_REQ_TABLE_MAX);
 #endif
 
 #ifdef STA_CFG80211
@@ -2205,6 +2203,7 @@ int woal_cfg80211_add_virt_if(struct wiphy *wiphy,
 	if (ret) {
 		handle->priv[new_priv->bss_index] = NULL;
 		handle->priv_num--;
+		woal_free_tcp_sess_queue(new_priv);
 		if (ndev->reg_state == NETREG_REGISTERED) {
 #if CFG80211_VERSION_CODE >= KERNEL_VERSION(5, 12, 0)
 			cfg80211_unregister_netdevice(ndev);
@@ -2333,6 +2332,7 @@ int woal_cfg80211_del_virt_if(struct wiphy *wiphy, struct net_device *dev)
 		woal_cancel_scan(vir_priv, MOAL_IOCTL_WAIT);
 
 		woal_flush_tx_stat_queue(vir_priv);
+		woal_free_tcp_sess_queue(vir_priv);
 		woal_flush_mcast_list(vir_priv);
 
 #if CFG80211_VERSION_CODE >= KERNEL_VERSION(2, 6, 39)
@@ -2434,6 +2434,7 @@ void woal_remove_virtual_interface(moal_handle *handle)
 				woal_proc_remove(priv);
 #endif /* CONFIG_PROC_FS */
 				netif_device_detach(priv->netdev);
+				woal_free_tcp_sess_queue(priv);
 				if (priv->netdev->reg_state ==
 				    NETREG_REGISTERED)
 #if CFG80211_VERSION_CODE >= KERNEL_VERSION(5, 12, 0)